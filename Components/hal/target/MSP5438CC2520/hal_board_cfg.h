@@ -299,6 +299,16 @@
 #define HAL_UART TRUE
 #endif
 
+/* Set to TRUE to send the UART TX ring by DMA, FALSE for one TX interrupt per byte */
+#ifndef HAL_UART_DMA
+#define HAL_UART_DMA TRUE
+#endif
+
+/* Set to TRUE to move SPI blocks of usci_spi.c by DMA channels 0 and 1, FALSE to poll them */
+#ifndef HAL_SPI_DMA
+#define HAL_SPI_DMA TRUE
+#endif
+
 
 /* ------------------------------------------------------------------------------------------------
  *                                    Interrupt Configuration
@@ -312,6 +322,12 @@
 /* ----------- UART interrupts ---------- */
 #define INTERRUPT_UART()    HAL_ISR_FUNCTION( halBoardUart0Isr, USCI_A0_VECTOR /*USCIA0_VECTOR*/ )
 
+/* ----------- DMA interrupts ---------- */
+#define INTERRUPT_DMA()     HAL_ISR_FUNCTION( halBoardDmaIsr, DMA_VECTOR )
+
+/* ----------- ADC interrupts ---------- */
+#define INTERRUPT_ADC12()   HAL_ISR_FUNCTION( halBoardAdc12Isr, ADC12_VECTOR )
+
 /* ----------- key interrupts ---------- */
 #define INTERRUPT_KEYBD()             HAL_ISR_FUNCTION( halBoardPort1Isr, PORT2_VECTOR )
 
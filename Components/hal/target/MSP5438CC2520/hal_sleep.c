@@ -91,6 +91,9 @@
  */
 #define MAX_SLEEP_COUNT                  0xFFFF              /* maximum sleep count allowed by H/W */
 
+/* A DMA transfer is running: the UART and SPI it feeds are clocked by SMCLK, which LPM3 stops */
+#define HAL_SLEEP_DMA_BUSY()                ((DMA0CTL | DMA1CTL | DMA2CTL) & DMAEN)
+
 /* set MSP430 power mode */
 #define HAL_SLEEP_TIMER_SLEEP()             st( (macPib.beaconOrder == MAC_BO_NON_BEACON)? \
                                                  __low_power_mode_3() : __low_power_mode_1(); \
@@ -174,6 +177,10 @@ void halSleep( uint32 osal_timeout )
   if ( osal_timeout && (osal_timeout < MIN_SLEEP_TIME) )
     return;
 
+  /* Don't sleep before the DMA is done */
+  if ( HAL_SLEEP_DMA_BUSY() )
+    return;
+
   /* initialize the accumulated sleep time */
   halAccumulatedSleepTime = 0;
 
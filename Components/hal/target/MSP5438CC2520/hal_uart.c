@@ -108,6 +108,23 @@
 
 #define HAL_UART_FLOWCONTROL_INIT()   /* N/A */
 
+/* TX DMA - channel 2, triggered by UCA0TXIFG.  Channels 0 and 1 have the higher priority and are
+ * left to drivers with tighter deadlines.  A transfer starts on a rising edge of the trigger: if
+ * TXBUF is already empty UCTXIFG is cleared and set again, otherwise TXBUF emptying starts it. */
+#define HAL_UART_DMA_TRIGGER()        { DMACTL1 = (DMACTL1 & ~DMA2TSEL_31) | DMA2TSEL_17; }
+#define HAL_UART_DMA_SET_SRC(p)       { __data16_write_addr((unsigned short)&DMA2SA, (unsigned long)(p)); }
+#define HAL_UART_DMA_SET_DST()        { __data16_write_addr((unsigned short)&DMA2DA, (unsigned long)&UCA0TXBUF); }
+#define HAL_UART_DMA_SET_SIZE(n)      { DMA2SZ = (n); }
+#define HAL_UART_DMA_ENABLE()         { DMA2CTL = DMADT_0 | DMADSTINCR_0 | DMASRCINCR_3 | DMADSTBYTE | \
+                                                  DMASRCBYTE | DMAIE | DMAEN; }
+#define HAL_UART_DMA_DISABLE()        { DMA2CTL &= ~(DMAEN | DMAIE | DMAIFG); }
+#define HAL_UART_DMA_KICK()           { if (UCA0IFG & UCTXIFG) { UCA0IFG &= ~UCTXIFG; UCA0IFG |= UCTXIFG; } }
+#define HAL_UART_DMA_IV               DMAIV_DMA2IFG
+
+/* SPI DMA - channels 0 and 1 of usci_spi.c; the DMA vector is shared, the ISR below passes the
+ * end of an SPI transfer on to it */
+#define HAL_SPI_DMA_IV                DMAIV_DMA0IFG
+
 /*-------------------------------------------------------------------------------------------------
                                           GLOBAL VARIABLES
 -------------------------------------------------------------------------------------------------*/
@@ -121,7 +138,14 @@ uint16 UBRRTable[] = { HAL_GET_UBRR (9600),
                        HAL_GET_UBRR (19200),
                        HAL_GET_UBRR (38400),
                        HAL_GET_UBRR (57600),
-                       HAL_GET_UBRR (115200) };
+                       HAL_GET_UBRR (115200),
+                       HAL_GET_UBRR (230400),
+                       HAL_GET_UBRR (460800) };
+
+#if (HAL_UART_DMA == TRUE)
+/* Bytes of the segment the DMA is sending, starting at tx.bufferHead; 0 when it is idle */
+static volatile uint16 halUartDmaLen;
+#endif
 
 /*-------------------------------------------------------------------------------------------------
                                          FUNCTIONS - LOCAL
@@ -131,6 +155,12 @@ static void Hal_UART_BufferInit(void);
 static void Hal_UART_RxProcessEvent(void);
 static void Hal_UART_TxProcessEvent(void);
 static void Hal_UART_SendCallBack(uint8 port, uint8 event);
+#if (HAL_UART_DMA == TRUE)
+static void Hal_UART_TxDmaStart(void);
+#endif
+#if (HAL_SPI_DMA == TRUE)
+extern void usci_spi_dmaIsr(void);
+#endif
 
 /*-------------------------------------------------------------------------------------------------
                                   Application Level Functions
@@ -193,6 +223,9 @@ static void Hal_UART_BufferInit (void)
   uartRecord.tx.pBuffer        = (uint8 *)NULL;
   uartRecord.rxChRvdTime       = 0;
   uartRecord.intEnable         = FALSE;
+#if (HAL_UART_DMA == TRUE)
+  halUartDmaLen                = 0;
+#endif
 }
 
 /*************************************************************************************************
@@ -230,8 +263,9 @@ uint8 HalUARTOpen ( uint8 port, halUARTCfg_t *config )
   /* Set source clock */
   HAL_UART_SET_SRC_CLK();
 
-  /* Setup Baudrate */
-  if (config->baudRate > HAL_UART_BR_115200)
+  /* Setup Baudrate - above 115200 only the DMA keeps up while the radio is busy */
+  if ((config->baudRate > HAL_UART_BR_460800) ||
+      ((HAL_UART_DMA != TRUE) && (config->baudRate > HAL_UART_BR_115200)))
   {
     return HAL_UART_BAUDRATE_ERROR;
   }
@@ -276,7 +310,14 @@ uint8 HalUARTOpen ( uint8 port, halUARTCfg_t *config )
       HAL_UART_RX_INT_DISABLE();
     }
 
+#if (HAL_UART_DMA == TRUE)
+    /* UCTXIFG stays set while TXBUF is empty, it is the DMA trigger */
+    HAL_UART_DMA_DISABLE();
+    HAL_UART_DMA_TRIGGER();
+    HAL_UART_DMA_SET_DST();
+#else
     HAL_UART_CLR_TX_STATUS();
+#endif
 
     /* Mark record as "configured" */
     uartRecord.configured = TRUE;
@@ -317,10 +358,12 @@ void HalUARTPoll(void)
       Hal_UART_RxProcessEvent();
     }
 
+#if (HAL_UART_DMA != TRUE)
     if (HAL_UART_GET_TX_STATUS())
     {
       Hal_UART_TxProcessEvent();
     }
+#endif
   }
 
   if ((Hal_UART_RxBufLen(0) + 1) >= uartRecord.rx.maxBufSize)  // Report if Rx Buffer is full.
@@ -371,6 +414,10 @@ void HalUARTClose ( uint8 port )
   /* Disable RX */
   HAL_UART_RX_DISABLE();
 
+#if (HAL_UART_DMA == TRUE)
+  HAL_UART_DMA_DISABLE();
+#endif
+
   /* Deallocate Rx and Tx Buffers */
   if (uartRecord.configured)
   {
@@ -426,7 +473,10 @@ uint16 HalUARTRead ( uint8 port, uint8 *pBuffer, uint16 length )
 }
 
 /*************************************************************************************************
- * @brief   Write a buffer to the UART
+ * @brief   Write a buffer to the UART.  The bytes are copied into the TX ring in at most two
+ *          pieces, one on each side of the wrap.  With HAL_UART_DMA the DMA then sends each
+ *          contiguous piece of the ring in one transfer; otherwise the TX interrupt sends one
+ *          byte at a time.
  * @param   port    - UART port (not used.)
  *          pBuffer - pointer to the buffer that will be written
  *          length  - length of
@@ -458,25 +508,32 @@ uint16 HalUARTOutBuf (uint8 port, uint8 *pBuffer, uint16 length)
     cnt = idx - cnt;
   }
 
-  // Accept "all-or-none" on write request.
-  if (cnt < length)
+  // Accept "all-or-none" on write request; one slot stays free to tell full from empty.
+  if (cnt <= length)
   {
     return 0;
   }
 
   idx = uartRecord.tx.bufferTail;
 
-  for (cnt = 0; cnt < length; cnt++)
+  cnt = uartRecord.tx.maxBufSize - idx;
+  if (cnt > length)
   {
-    uartRecord.tx.pBuffer[idx++] = pBuffer[cnt];
-
-    if (idx >= uartRecord.tx.maxBufSize)
-    {
-      idx = 0;
-    }
+    cnt = length;
+  }
+  osal_memcpy(&uartRecord.tx.pBuffer[idx], pBuffer, cnt);
+  osal_memcpy(uartRecord.tx.pBuffer, &pBuffer[cnt], length - cnt);
+  idx += length;
+  if (idx >= uartRecord.tx.maxBufSize)
+  {
+    idx -= uartRecord.tx.maxBufSize;
   }
 
   HAL_ENTER_CRITICAL_SECTION(intState);  // Hold off interrupts.
+#if (HAL_UART_DMA == TRUE)
+  uartRecord.tx.bufferTail = idx;
+  Hal_UART_TxDmaStart();
+#else
   cnt = uartRecord.tx.bufferTail;
   if (cnt == uartRecord.tx.bufferHead)
   {
@@ -487,6 +544,7 @@ uint16 HalUARTOutBuf (uint8 port, uint8 *pBuffer, uint16 length)
     HAL_UART_PUTBYTE(uartRecord.tx.pBuffer[uartRecord.tx.bufferHead]);  // Send a char to UART.
   }
   uartRecord.tx.bufferTail = idx;
+#endif
   HAL_EXIT_CRITICAL_SECTION(intState);  // Restore interrupt enable.
 
   return length;  // Return the number of bytes actually put into the buffer.
@@ -683,6 +741,37 @@ static void Hal_UART_TxProcessEvent(void)
   }
 }
 
+#if (HAL_UART_DMA == TRUE)
+/*************************************************************************************************
+ * @fn      Hal_UART_TxDmaStart
+ *
+ * @brief   Send the ring from its head up to the tail, or up to the end of the buffer if the
+ *          data wraps, in one DMA transfer.  Nothing to do if a transfer is running; its
+ *          interrupt comes back here.  Called with interrupts disabled.
+ *
+ * @param   void
+ *
+ * @return  void
+ *************************************************************************************************/
+static void Hal_UART_TxDmaStart(void)
+{
+  uint16 head = uartRecord.tx.bufferHead;
+  uint16 tail = uartRecord.tx.bufferTail;
+
+  if ((halUartDmaLen != 0) || (head == tail))
+  {
+    return;
+  }
+
+  halUartDmaLen = (tail > head) ? (tail - head) : (uartRecord.tx.maxBufSize - head);
+
+  HAL_UART_DMA_SET_SRC(&uartRecord.tx.pBuffer[head]);
+  HAL_UART_DMA_SET_SIZE(halUartDmaLen);
+  HAL_UART_DMA_ENABLE();
+  HAL_UART_DMA_KICK();
+}
+#endif
+
 /*************************************************************************************************
  * @fn      Hal_UART_SetFlowControl
  *
@@ -720,10 +809,59 @@ INTERRUPT_UART()
       Hal_UART_RxProcessEvent();
     }
 
+#if (HAL_UART_DMA != TRUE)
     if (HAL_UART_GET_TX_STATUS())
     {
       Hal_UART_TxProcessEvent();
     }
+#endif
   } while (HAL_UART_GET_RXTX_STATUS());
 }
 
+#if (HAL_UART_DMA == TRUE) || (HAL_SPI_DMA == TRUE)
+/*************************************************************************************************
+ * @fn      DMA ISR
+ *
+ * @brief   UART TX: a segment of the TX ring has been handed to the UART, move the head past it
+ *          and start on the next one.  One interrupt per segment instead of one per byte.
+ *          SPI: the last byte of a transfer was received; the CPU may wait for it in LPM0, so
+ *          it is woken up.
+ *
+ * @param   void
+ *
+ * @return  void
+**************************************************************************************************/
+INTERRUPT_DMA()
+{
+  uint16 iv;
+#if (HAL_UART_DMA == TRUE)
+  uint16 head;
+#endif
+
+  while ((iv = DMAIV) != DMAIV_NONE)
+  {
+#if (HAL_SPI_DMA == TRUE)
+    if (iv == HAL_SPI_DMA_IV)
+    {
+      usci_spi_dmaIsr();
+      __low_power_mode_off_on_exit();
+    }
+#endif
+#if (HAL_UART_DMA == TRUE)
+    if (iv == HAL_UART_DMA_IV)
+    {
+      head = uartRecord.tx.bufferHead + halUartDmaLen;
+      if (head >= uartRecord.tx.maxBufSize)
+      {
+        head = 0;
+      }
+      uartRecord.tx.bufferHead = head;
+      halUartDmaLen = 0;
+
+      Hal_UART_TxDmaStart();
+    }
+#endif
+  }
+}
+#endif
+
@@ -67,12 +67,15 @@ extern "C"
 
   Note that when using interrupt service based UART configuration (as opposed to DMA)
   higher baudrate such as 115200bps may have problem when radio is operational at the same time.
+  230400 and 460800 are only accepted with HAL_UART_DMA.
 */
 #define HAL_UART_BR_9600   0x00
 #define HAL_UART_BR_19200  0x01
 #define HAL_UART_BR_38400  0x02
 #define HAL_UART_BR_57600  0x03
 #define HAL_UART_BR_115200 0x04
+#define HAL_UART_BR_230400 0x05
+#define HAL_UART_BR_460800 0x06
 
 /* Frame Format constant */
 
@@ -0,0 +1,212 @@
+/**************************************************************************************************
+  Filename:       hal_board_cfg.h
+
+  Description:    Board configuration for the POSIX host build.  Mirrors the MSP5438CC2520
+                  board file; LEDs and push buttons map onto the simulated port registers.
+**************************************************************************************************/
+
+#ifndef HAL_BOARD_CFG_H
+#define HAL_BOARD_CFG_H
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+
+#include "hal_mcu.h"
+#include "hal_defs.h"
+#include "hal_types.h"
+#include "hal_assert.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Board Indentifier
+ * ------------------------------------------------------------------------------------------------
+ */
+
+#define HAL_BOARD_F5438
+#define HAL_BOARD_POSIX
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Clock Speed
+ * ------------------------------------------------------------------------------------------------
+ */
+#define HAL_CPU_CLOCK_MHZ     12.0000
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       LED Configuration
+ * ------------------------------------------------------------------------------------------------
+ */
+#define HAL_NUM_LEDS            5
+#define HAL_LED_BLINK_DELAY()
+
+/* LED1 */
+#define LED1_BV           BV(1)
+#define LED1_PORT         P4OUT
+#define LED1_DDR          P4DIR
+/* LED2 */
+#define LED2_BV           BV(0)
+#define LED2_PORT         P4OUT
+#define LED2_DDR          P4DIR
+/* LED3 */
+#define LED3_BV           BV(6)
+#define LED3_PORT         P8OUT
+#define LED3_DDR          P8DIR
+/* LED4 */
+#define LED4_BV           BV(5)
+#define LED4_PORT         P8OUT
+#define LED4_DDR          P8DIR
+/* LED5 */
+#define LED5_BV           BV(4)
+#define LED5_PORT         P8OUT
+#define LED5_DDR          P8DIR
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                    Push Button Configuration
+ * ------------------------------------------------------------------------------------------------
+ */
+
+#define ACTIVE_LOW        !
+#define ACTIVE_HIGH       !!    /* double negation forces result to be '1' */
+
+/* USER1 */
+#define PUSH1_BV          BV(0)
+#define PUSH1_PORT        P2IN
+#define PUSH1_POLARITY    ACTIVE_LOW
+/* USER2 */
+#define PUSH2_BV          BV(1)
+#define PUSH2_PORT        P2IN
+#define PUSH2_POLARITY    ACTIVE_LOW
+/* KEY3 */
+#define PUSH3_BV          BV(2)
+#define PUSH3_PORT        P2IN
+#define PUSH3_POLARITY    ACTIVE_LOW
+/* KEY4 */
+#define PUSH4_BV          BV(3)
+#define PUSH4_PORT        P2IN
+#define PUSH4_POLARITY    ACTIVE_LOW
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                            Macros
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* ----------- Board Initialization ---------- */
+#define HAL_BOARD_INIT()                                         \
+{                                                                \
+  /* reset does not affect GPIO state */                         \
+  HAL_TURN_OFF_LED1();                                           \
+  HAL_TURN_OFF_LED2();                                           \
+  HAL_TURN_OFF_LED3();                                           \
+  HAL_TURN_OFF_LED4();                                           \
+  HAL_TURN_OFF_LED5();                                           \
+  /* set direction for GPIO outputs  */                          \
+  LED1_DDR |= LED1_BV;                                           \
+  LED2_DDR |= LED2_BV;                                           \
+  LED3_DDR |= LED3_BV;                                           \
+  LED4_DDR |= LED4_BV;                                           \
+  LED5_DDR |= LED5_BV;                                           \
+}
+
+/* ----------- Debounce ---------- */
+#define HAL_DEBOUNCE(expr)
+
+/* ----------- Push Buttons ---------- */
+#define HAL_PUSH_BUTTON1()        (PUSH1_POLARITY (PUSH1_PORT & PUSH1_BV))
+#define HAL_PUSH_BUTTON2()        (PUSH2_POLARITY (PUSH2_PORT & PUSH2_BV))
+#define HAL_PUSH_BUTTON3()        (PUSH3_POLARITY (PUSH3_PORT & PUSH3_BV))
+#define HAL_PUSH_BUTTON4()        (PUSH4_POLARITY (PUSH4_PORT & PUSH4_BV))
+
+
+/* ----------- LED's ---------- */
+#define HAL_TURN_OFF_LED1()       st( LED1_PORT &= ~LED1_BV; )
+#define HAL_TURN_OFF_LED2()       st( LED2_PORT &= ~LED2_BV; )
+#define HAL_TURN_OFF_LED3()       st( LED3_PORT &= ~LED3_BV; )
+#define HAL_TURN_OFF_LED4()       st( LED4_PORT &= ~LED4_BV; )
+#define HAL_TURN_OFF_LED5()       st( LED5_PORT &= ~LED5_BV; )
+
+#define HAL_TURN_ON_LED1()        st( LED1_PORT |=  LED1_BV; )
+#define HAL_TURN_ON_LED2()        st( LED2_PORT |=  LED2_BV; )
+#define HAL_TURN_ON_LED3()        st( LED3_PORT |=  LED3_BV; )
+#define HAL_TURN_ON_LED4()        st( LED4_PORT |=  LED4_BV; )
+#define HAL_TURN_ON_LED5()        st( LED5_PORT |=  LED5_BV; )
+
+#define HAL_TOGGLE_LED1()         st( LED1_PORT ^=  LED1_BV; )
+#define HAL_TOGGLE_LED2()         st( LED2_PORT ^=  LED2_BV; )
+#define HAL_TOGGLE_LED3()         st( LED3_PORT ^=  LED3_BV; )
+#define HAL_TOGGLE_LED4()         st( LED4_PORT ^=  LED4_BV; )
+#define HAL_TOGGLE_LED5()         st( LED5_PORT ^=  LED5_BV; )
+
+#define HAL_STATE_LED1()          (LED1_PORT & LED1_BV)
+#define HAL_STATE_LED2()          (LED2_PORT & LED2_BV)
+#define HAL_STATE_LED3()          (LED3_PORT & LED3_BV)
+#define HAL_STATE_LED4()          (LED4_PORT & LED4_BV)
+#define HAL_STATE_LED5()          (LED5_PORT & LED5_BV)
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                     Driver Configuration
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Set to TRUE enable H/W TIMER usage, FALSE disable it */
+#ifndef HAL_TIMER
+#define HAL_TIMER FALSE
+#endif
+
+/* Set to TRUE enable ADC usage, FALSE disable it */
+#ifndef HAL_ADC
+#define HAL_ADC FALSE
+#endif
+
+/* Set to TRUE enable LCD usage, FALSE disable it */
+#ifndef HAL_LCD
+#define HAL_LCD FALSE
+#endif
+
+/* Set to TRUE enable LED usage, FALSE disable it */
+#ifndef HAL_LED
+#define HAL_LED TRUE
+#endif
+#if (!defined BLINK_LEDS) && (HAL_LED == TRUE)
+#define BLINK_LEDS
+#endif
+
+/* Set to TRUE enable KEY usage, FALSE disable it */
+#ifndef HAL_KEY
+#define HAL_KEY TRUE
+#endif
+
+/* Set to TRUE enable UART usage, FALSE disable it */
+#ifndef HAL_UART
+#define HAL_UART TRUE
+#endif
+
+/* Set to TRUE to send the UART TX ring by DMA, FALSE for one TX interrupt per byte */
+#ifndef HAL_UART_DMA
+#define HAL_UART_DMA TRUE
+#endif
+
+/* The host has no DMA controller: usci_spi.c polls the SPI model of hal_sim_fram.c */
+#ifndef HAL_SPI_DMA
+#define HAL_SPI_DMA FALSE
+#endif
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                    Interrupt Configuration
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* ----------- ADC interrupts ---------- */
+/* Called by the ADC model of hal_sim.c at the end of a sequence */
+#define INTERRUPT_ADC12()   HAL_ISR_FUNCTION( halBoardAdc12Isr, ADC12_VECTOR )
+extern void halBoardAdc12Isr(void);
+
+
+#endif
+/*******************************************************************************************************
+*/
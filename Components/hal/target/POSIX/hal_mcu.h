@@ -0,0 +1,94 @@
+/**************************************************************************************************
+  Filename:       hal_mcu.h
+
+  Description:    MCU abstraction for the POSIX host build.  Interrupts are simulated events
+                  dispatched by the host kernel (hal_sim.h) between OSAL passes, so critical
+                  sections only have to track the global interrupt enable.
+**************************************************************************************************/
+
+#ifndef HAL_MCU_H
+#define HAL_MCU_H
+
+/*
+ *  Target : POSIX host simulation of the MSP430F5438 + CC2520 board
+ *
+ */
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "hal_defs.h"
+#include "hal_types.h"
+#include "hal_msp430_sfr.h"
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Target Defines
+ * ------------------------------------------------------------------------------------------------
+ */
+#define HAL_MCU_POSIX
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                     Compiler Abstraction
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* ---------------------- GNU Compiler ---------------------- */
+#ifdef __GNUC__
+#define HAL_COMPILER_GCC
+#define HAL_MCU_LITTLE_ENDIAN()   1
+#define HAL_ISR_FUNC_DECLARATION(f,v) void f(void)
+#define HAL_ISR_FUNC_PROTOTYPE(f,v)   void f(void)
+#define HAL_ISR_FUNCTION(f,v)         HAL_ISR_FUNC_PROTOTYPE(f,v); HAL_ISR_FUNC_DECLARATION(f,v)
+
+/* ------------------ Unrecognized Compiler ------------------ */
+#else
+#error "ERROR: Unknown compiler."
+#endif
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Interrupt Macros
+ * ------------------------------------------------------------------------------------------------
+ */
+extern volatile uint8 halSimIntEnabled;
+
+#define HAL_ENABLE_INTERRUPTS()         st( halSimIntEnabled = TRUE; )
+#define HAL_DISABLE_INTERRUPTS()        st( halSimIntEnabled = FALSE; )
+#define HAL_INTERRUPTS_ARE_ENABLED()    (halSimIntEnabled)
+
+typedef uint8 halIntState_t;
+#define HAL_ENTER_CRITICAL_SECTION(x)   st( x = halSimIntEnabled;  HAL_DISABLE_INTERRUPTS(); )
+#define HAL_EXIT_CRITICAL_SECTION(x)    st( halSimIntEnabled = x; )
+#define HAL_CRITICAL_STATEMENT(x)       st( halIntState_t s; HAL_ENTER_CRITICAL_SECTION(s); x; HAL_EXIT_CRITICAL_SECTION(s); )
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Reset Macro
+ * ------------------------------------------------------------------------------------------------
+ */
+extern void halSimReset(void);
+#define HAL_SYSTEM_RESET()              halSimReset()
+
+/* ------------------------------------------------------------------------------------------------
+ *                                     Simulated MCU real-time clock
+ * ------------------------------------------------------------------------------------------------
+ */
+extern uint32 macMcuPrecisionCount(void);
+#define MCU_SIMULATED_REAL_TIME_CLOCK(x) st(x = macMcuPrecisionCount();)
+
+/* ------------------------------------------------------------------------------------------------
+ *                                     Sleep macros
+ * ------------------------------------------------------------------------------------------------
+ */
+#if defined( POWER_SAVING )
+/* To be used in SoC only. Stub here. */
+#define ALLOW_SLEEP_MODE()
+#endif
+
+/**************************************************************************************************
+ */
+#endif
@@ -0,0 +1,153 @@
+/**************************************************************************************************
+  Filename:       hal_msp430_sfr.h
+
+  Description:    Simulated MSP430F5438 special function registers for the POSIX host build.
+
+                  Port and control registers are plain variables in the device image, so drivers
+                  written against the target headers (LEDs, SIM900 pins) compile and run
+                  unchanged.  Registers whose reads have side effects on silicon - the ADC12
+                  result and flag registers and the USCI_B1 SPI buffers - are mapped onto
+                  accessor functions in hal_sim.c and hal_sim_fram.c that model the peripheral,
+                  and so are ADC12CTL0, which starts conversion sequences, and P1OUT, which
+                  carries the chip select of the FRAM.
+**************************************************************************************************/
+
+#ifndef HAL_MSP430_SFR_H
+#define HAL_MSP430_SFR_H
+
+#include "hal_types.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                         Digital I/O
+ * ------------------------------------------------------------------------------------------------
+ */
+extern volatile uint8 P1IN, P1DIR, P1SEL, P1REN, P1IE, P1IES, P1IFG;
+extern volatile uint8 P2IN, P2OUT, P2DIR, P2SEL, P2REN, P2IE, P2IES, P2IFG;
+extern volatile uint8 P3IN, P3OUT, P3DIR, P3SEL, P3REN;
+extern volatile uint8 P4IN, P4OUT, P4DIR, P4SEL, P4REN;
+extern volatile uint8 P5IN, P5OUT, P5DIR, P5SEL, P5REN;
+extern volatile uint8 P6IN, P6OUT, P6DIR, P6SEL, P6REN;
+extern volatile uint8 P7IN, P7OUT, P7DIR, P7SEL, P7REN;
+extern volatile uint8 P8IN, P8OUT, P8DIR, P8SEL, P8REN;
+
+/* P1.0 selects the FRAM */
+extern volatile uint8 *halSimP1OutReg(void);
+#define P1OUT         (*halSimP1OutReg())
+
+/* ------------------------------------------------------------------------------------------------
+ *                                    USCI_B1 (SPI to the FRAM)
+ * ------------------------------------------------------------------------------------------------
+ */
+extern volatile uint8  UCB1CTL0, UCB1CTL1, UCB1IE;
+extern volatile uint16 UCB1BRW;
+
+/* Bytes move from the transmit buffer through the shift register as the driver accesses them */
+extern volatile uint8 *halSimSpiTxBuf(void);
+extern volatile uint8 *halSimSpiRxBuf(void);
+extern volatile uint8 *halSimSpiIfg(void);
+extern volatile uint8 *halSimSpiStat(void);
+#define UCB1TXBUF     (*halSimSpiTxBuf())
+#define UCB1RXBUF     (*halSimSpiRxBuf())
+#define UCB1IFG       (*halSimSpiIfg())
+#define UCB1STAT      (*halSimSpiStat())
+
+/* UCBxCTL0 */
+#define UCSYNC        0x01
+#define UCMODE_0      0x00
+#define UCMST         0x08
+#define UC7BIT        0x10
+#define UCMSB         0x20
+#define UCCKPL        0x40
+#define UCCKPH        0x80
+
+/* UCBxCTL1 */
+#define UCSWRST       0x01
+#define UCSSEL_1      0x40
+#define UCSSEL_2      0x80
+#define UCSSEL_3      0xC0
+
+/* UCBxSTAT */
+#define UCBUSY        0x01
+
+/* UCBxIE / UCBxIFG */
+#define UCRXIE        0x01
+#define UCTXIE        0x02
+#define UCRXIFG       0x01
+#define UCTXIFG       0x02
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       REF and ADC12_A
+ * ------------------------------------------------------------------------------------------------
+ */
+extern volatile uint16 REFCTL0;
+extern volatile uint16 ADC12CTL1, ADC12CTL2, ADC12IE;
+extern volatile uint8  ADC12MCTL0, ADC12MCTL1, ADC12MCTL2, ADC12MCTL3;
+
+/* A single conversion started by ADC12SC completes when the flag or result is first read.  A
+ * sequence (ADC12CONSEQ_1 or _3) is started after the access to ADC12CTL0 that set ADC12SC, and
+ * ends in virtual time with the ADC12 interrupt */
+extern volatile uint16 *halSimAdcCtl0(void);
+extern volatile uint16 *halSimAdcIfg(void);
+extern volatile uint16 *halSimAdcMem(uint8 n);
+#define ADC12CTL0     (*halSimAdcCtl0())
+#define ADC12IFG      (*halSimAdcIfg())
+#define ADC12MEM0     (*halSimAdcMem(0))
+#define ADC12MEM1     (*halSimAdcMem(1))
+#define ADC12MEM2     (*halSimAdcMem(2))
+#define ADC12MEM3     (*halSimAdcMem(3))
+
+/* REFCTL0 */
+#define REFMSTR       0x0080
+
+/* ADC12CTL0 */
+#define ADC12SC       0x0001
+#define ADC12ENC      0x0002
+#define ADC12ON       0x0010
+#define ADC12REFON    0x0020
+#define ADC12REF2_5V  0x0040
+#define ADC12MSC      0x0080
+#define ADC12SHT0_12  0x0C00
+#define ADC12SHT1_12  0xC000
+
+/* ADC12CTL1 */
+#define ADC12CONSEQ_0     0x0000
+#define ADC12CONSEQ_1     0x0002
+#define ADC12CONSEQ_2     0x0004
+#define ADC12CONSEQ_3     0x0006
+#define ADC12SSEL_0       0x0000
+#define ADC12SSEL_2       0x0010
+#define ADC12DIV_2        0x0040
+#define ADC12DIV_7        0x00E0
+#define ADC12SHP          0x0200
+#define ADC12SHS_0        0x0000
+#define ADC12CSTARTADD_0  0x0000
+
+/* ADC12CTL2 */
+#define ADC12REFOUT   0x0002
+#define ADC12RES_2    0x0020
+#define ADC12TCOFF    0x0080
+
+/* ADC12MCTLx */
+#define ADC12INCH_0   0x00
+#define ADC12INCH_1   0x01
+#define ADC12INCH_2   0x02
+#define ADC12INCH_3   0x03
+#define ADC12INCH_4   0x04
+#define ADC12INCH_5   0x05
+#define ADC12INCH_6   0x06
+#define ADC12INCH_7   0x07
+#define ADC12INCH_8   0x08
+#define ADC12INCH_9   0x09
+#define ADC12INCH_10  0x0A
+#define ADC12INCH_11  0x0B
+#define ADC12INCH_12  0x0C
+#define ADC12INCH_13  0x0D
+#define ADC12INCH_14  0x0E
+#define ADC12INCH_15  0x0F
+#define ADC12SREF_0   0x00
+#define ADC12SREF1    0x20
+#define ADC12EOS      0x80
+
+/**************************************************************************************************
+ */
+#endif
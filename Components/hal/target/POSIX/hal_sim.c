@@ -0,0 +1,542 @@
+/**************************************************************************************************
+  Filename:       hal_sim.c
+
+  Description:    Device side of the POSIX host simulation.  This file is linked into every
+                  device image and provides what the MSP430 startup, sleep, key and MAC timer
+                  code provide on the target: the simulated registers, the 320 usec MAC timer
+                  that drives the OSAL clock, low power mode entry and the entry points used by
+                  the kernel to boot and run the image.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "hal_types.h"
+#include "hal_mcu.h"
+#include "hal_board.h"
+#include "hal_key.h"
+#include "hal_sleep.h"
+#include "hal_sim.h"
+#include "OSAL.h"
+#include "OSAL_Memory.h"
+#include "OSAL_Timers.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+#ifndef HAL_SIM_IMAGE_NAME
+#define HAL_SIM_IMAGE_NAME          "device"
+#endif
+
+/* MAC backoff timer period */
+#define HAL_SIM_USEC_PER_TICK       320
+
+/* Flag polls without a conversion in progress before the ADC is declared stuck */
+#define HAL_SIM_ADC_MAX_IDLE_POLLS  1000
+
+/* ADC12MEMx modelled, enough for the sequence of sensing.c */
+#define HAL_SIM_ADC_MEMS            4
+
+/* One conversion with the 1024 clock sample time of sensing.c: (1024 + 13) ADC12CLK at MODOSC/3 */
+#define HAL_SIM_ADC_CONV_US         648
+
+/* Nominal readings, 12 bit with the 2.5V reference */
+#define HAL_SIM_ADC_VDD             2457    /* AVCC/2 at 3.0V */
+#define HAL_SIM_ADC_INT_TEMP        1206    /* 25C on the internal sensor */
+#define HAL_SIM_ADC_EXT_TEMP        1306    /* 22k NTC against 47k */
+#define HAL_SIM_ADC_PH              2048    /* pH 7 sits at Vref/2 */
+#define HAL_SIM_ADC_MAX             4095
+
+/* ------------------------------------------------------------------------------------------------
+ *                                      Simulated registers
+ * ------------------------------------------------------------------------------------------------
+ */
+volatile uint8 P1IN, P1DIR, P1SEL, P1REN, P1IE, P1IES, P1IFG;
+volatile uint8 P2IN = 0xFF, P2OUT, P2DIR, P2SEL, P2REN, P2IE, P2IES, P2IFG;
+volatile uint8 P3IN, P3OUT, P3DIR, P3SEL, P3REN;
+volatile uint8 P4IN, P4OUT, P4DIR, P4SEL, P4REN;
+volatile uint8 P5IN, P5OUT, P5DIR, P5SEL, P5REN;
+volatile uint8 P6IN, P6OUT, P6DIR, P6SEL, P6REN;
+volatile uint8 P7IN, P7OUT, P7DIR, P7SEL, P7REN;
+volatile uint8 P8IN, P8OUT, P8DIR, P8SEL, P8REN;
+
+volatile uint16 REFCTL0;
+volatile uint16 ADC12CTL1, ADC12CTL2, ADC12IE;
+volatile uint8  ADC12MCTL0, ADC12MCTL1, ADC12MCTL2, ADC12MCTL3;
+
+volatile uint8 halSimIntEnabled;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static halSimTime_t halSimBootTime;
+
+static volatile uint16 halSimAdc12Ctl0;
+static volatile uint16 halSimAdc12Ifg;
+static volatile uint16 halSimAdc12Mem[HAL_SIM_ADC_MEMS];
+static bool   halSimAdcKickPosted;
+static uint16 halSimAdcSeqGen;      /* sequence results of an older start are dropped */
+static uint16 halSimAdcIdlePolls;
+static bool   halSimAdcOn;
+static halSimTime_t halSimAdcOnSince;
+static int16  halSimAdcPhOffset;
+static bool   halSimAdcCalibrated;
+
+bool Hal_KeyIntEnable;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static void   halSimBootImage(void);
+static uint32 halSimRunImage(void);
+#if OSALMEM_TRACE
+static void halSimHeapTraceDrain(void);
+#endif
+static void   halSimAdcKick(void *arg);
+static void   halSimAdcSeqDone(void *arg);
+static uint8  halSimAdcSeqLen(void);
+static uint16 halSimAdcSample(uint8 channel);
+
+/* Bounds of this image's .sim_state section, see sim_image.ld */
+extern uint8 halSimStateBeg[];
+extern uint8 halSimStateEnd[];
+
+/* The application entry point; it returns after one OSAL pass when built with UBIT */
+extern int main(void);
+
+/* Bytes arriving on RXD, hal_uart.c */
+extern void halSimUartRx(void *arg);
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Image Descriptor
+ * ------------------------------------------------------------------------------------------------
+ */
+const halSimImage_t halSimImage =
+{
+  HAL_SIM_IMAGE_NAME,
+  halSimStateBeg,
+  halSimStateEnd,
+  halSimBootImage,
+  halSimRunImage,
+  halSimUartRx
+};
+
+/**************************************************************************************************
+ * @fn          halSimBootImage
+ *
+ * @brief       Power-on entry point.  The kernel has already restored the image's initial
+ *              .data/.bss, so this is the equivalent of the C startup calling main().
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+static void halSimBootImage(void)
+{
+  halSimBootTime = halSimNow();
+  (void)main();
+}
+
+/**************************************************************************************************
+ * @fn          halSimRunImage
+ *
+ * @brief       Run OSAL until no task has an event pending.  Called by the kernel after every
+ *              simulated interrupt and timer wake-up.
+ *
+ * @param       none
+ *
+ * @return      Milliseconds until the next OSAL timer expires, 0 if no timer is running.
+ **************************************************************************************************
+ */
+static uint32 halSimRunImage(void)
+{
+  do
+  {
+    osal_run_system();
+#if OSALMEM_TRACE
+    halSimHeapTraceDrain();
+#endif
+  } while (osal_events_pending());
+
+  return osal_next_timeout();
+}
+
+#if OSALMEM_TRACE
+/**************************************************************************************************
+ * @fn          halSimHeapTraceDrain
+ *
+ * @brief       Hand the records in the OSAL heap trace ring to the kernel.  Called after every
+ *              OSAL pass, so the ring only has to hold the records of osal_init_system() and
+ *              of the pass main() runs at boot.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+static void halSimHeapTraceDrain(void)
+{
+  osalMemTrace_t recs[8];
+  uint8 cnt;
+
+  while ((cnt = osal_mem_trace_read(recs, 8)) != 0)
+  {
+    halSimHeapTrace(recs, cnt * sizeof(osalMemTrace_t), osal_mem_trace_lost());
+  }
+}
+#endif
+
+/**************************************************************************************************
+ * @fn          macMcuPrecisionCount
+ *
+ * @brief       Free running count of 320 usec MAC backoff periods since power-on.
+ *
+ * @param       none
+ *
+ * @return      backoff count
+ **************************************************************************************************
+ */
+uint32 macMcuPrecisionCount(void)
+{
+  return (uint32)((halSimNow() - halSimBootTime) / HAL_SIM_USEC_PER_TICK);
+}
+
+/**************************************************************************************************
+ * @fn          TimerElapsed
+ *
+ * @brief       Sleep time is accounted for by macMcuPrecisionCount(), as on the MSP430.
+ *
+ * @param       none
+ *
+ * @return      0
+ **************************************************************************************************
+ */
+uint32 TimerElapsed(void)
+{
+  return 0;
+}
+
+/**************************************************************************************************
+ * @fn          halSleep
+ *
+ * @brief       Enter LPM3 until the next OSAL timer or simulated interrupt.  The kernel already
+ *              knows when the next timer expires, so only the transition is recorded.
+ *
+ * @param       osal_timeout - next OSAL timer expiry in milliseconds, 0 for none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halSleep(uint32 osal_timeout)
+{
+  halSimSleep(osal_timeout);
+}
+
+/**************************************************************************************************
+ * @fn          halRestoreSleepLevel
+ *
+ * @brief       Nothing to restore, the simulated MCU has a single sleep level.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halRestoreSleepLevel(void)
+{
+}
+
+/**************************************************************************************************
+ * @fn          halAssertHandler
+ *
+ * @brief       HAL_ASSERT() failed in this device; stop the simulation.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halAssertHandler(void)
+{
+  halSimAssert();
+}
+
+/**************************************************************************************************
+ * @fn          HalKeyInit / HalKeyConfig / HalKeyRead / HalKeyPoll
+ *
+ * @brief       The simulated board has no push buttons wired up; P2IN reads all released.
+ **************************************************************************************************
+ */
+void HalKeyInit(void)
+{
+  Hal_KeyIntEnable = FALSE;
+}
+
+void HalKeyConfig(bool interruptEnable, const halKeyCBack_t cback)
+{
+  (void)cback;
+  Hal_KeyIntEnable = interruptEnable;
+}
+
+uint8 HalKeyRead(void)
+{
+  return 0;
+}
+
+void HalKeyPoll(void)
+{
+}
+
+/**************************************************************************************************
+ * @fn          halSimAdcCtl0
+ *
+ * @brief       Access to ADC12CTL0.  What is written is only known once the access is over, so
+ *              a sequence started by it is looked for right after, in halSimAdcKick().
+ *
+ * @param       none
+ *
+ * @return      pointer to the control register
+ **************************************************************************************************
+ */
+volatile uint16 *halSimAdcCtl0(void)
+{
+  if (!halSimAdcKickPosted)
+  {
+    halSimAdcKickPosted = TRUE;
+    halSimPost(0, halSimAdcKick, NULL);
+  }
+  return &halSimAdc12Ctl0;
+}
+
+/**************************************************************************************************
+ * @fn          halSimAdcIfg
+ *
+ * @brief       Access to ADC12IFG.  A single conversion started with ADC12ENC + ADC12SC
+ *              completes on the first access, loading ADC12MEM0 from the channel selected in
+ *              ADC12MCTL0.
+ *
+ * @param       none
+ *
+ * @return      pointer to the interrupt flag register
+ **************************************************************************************************
+ */
+volatile uint16 *halSimAdcIfg(void)
+{
+  const uint16 start = ADC12ON | ADC12ENC | ADC12SC;
+
+  if ((ADC12CTL1 & ADC12CONSEQ_3) != ADC12CONSEQ_0)
+  {
+    /* Sequences end in virtual time, see halSimAdcSeqDone() */
+  }
+  else if ((halSimAdc12Ctl0 & start) == start)
+  {
+    halSimAdc12Mem[0] = halSimAdcSample(ADC12MCTL0 & 0x0F);
+    halSimAdc12Ifg |= BV(0);
+    halSimAdc12Ctl0 &= ~ADC12SC;
+    halSimAdcIdlePolls = 0;
+  }
+  else if (halSimAdc12Ifg == 0)
+  {
+    /* Busy-waiting on a flag that can never be set would hang the whole simulation */
+    if (++halSimAdcIdlePolls > HAL_SIM_ADC_MAX_IDLE_POLLS)
+    {
+      halSimAssert();
+    }
+  }
+
+  return &halSimAdc12Ifg;
+}
+
+/**************************************************************************************************
+ * @fn          halSimAdcMem
+ *
+ * @brief       Access to ADC12MEMx; reading the result clears its flag.
+ *
+ * @param       n - x, below HAL_SIM_ADC_MEMS
+ *
+ * @return      pointer to the conversion result
+ **************************************************************************************************
+ */
+volatile uint16 *halSimAdcMem(uint8 n)
+{
+  if (n >= HAL_SIM_ADC_MEMS)
+  {
+    halSimAssert();
+  }
+  if (n == 0)
+  {
+    (void)halSimAdcIfg();
+  }
+  halSimAdc12Ifg &= ~BV(n);
+  return &halSimAdc12Mem[n];
+}
+
+/**************************************************************************************************
+ * @fn          halSimAdcKick
+ *
+ * @brief       After an access to ADC12CTL0: ADC12ENC + ADC12SC in a sequence mode starts the
+ *              sequence, which ends after one conversion time per channel.  The time the ADC12
+ *              or its reference is on is counted in halSimStats().
+ *
+ * @param       arg - unused
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+static void halSimAdcKick(void *arg)
+{
+  const uint16 start = ADC12ON | ADC12ENC | ADC12SC;
+  bool on = ((halSimAdc12Ctl0 & (ADC12ON | ADC12REFON)) != 0);
+
+  (void)arg;
+  halSimAdcKickPosted = FALSE;
+
+  if (on && !halSimAdcOn)
+  {
+    halSimAdcOnSince = halSimNow();
+  }
+  else if (!on && halSimAdcOn)
+  {
+    halSimStats(halSimSelf())->adcOnMs += (uint32)((halSimNow() - halSimAdcOnSince) / 1000);
+  }
+  halSimAdcOn = on;
+
+  if (((ADC12CTL1 & ADC12CONSEQ_3) != ADC12CONSEQ_0) && ((halSimAdc12Ctl0 & start) == start))
+  {
+    halSimAdc12Ctl0 &= ~ADC12SC;
+    halSimAdcSeqGen++;
+    halSimPost(halSimAdcSeqLen() * HAL_SIM_ADC_CONV_US, halSimAdcSeqDone,
+               (void *)(unsigned long)halSimAdcSeqGen);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          halSimAdcSeqDone
+ *
+ * @brief       End of a sequence, unless ADC12ENC was cleared meanwhile: load the results, set
+ *              their flags and raise the ADC12 interrupt if one of them is enabled.  With
+ *              ADC12CONSEQ_3 and ADC12MSC the next sequence starts at once.
+ *
+ * @param       arg - generation of the start
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+static void halSimAdcSeqDone(void *arg)
+{
+  uint8 len = halSimAdcSeqLen();
+  volatile uint8 *pMctl[HAL_SIM_ADC_MEMS] = {&ADC12MCTL0, &ADC12MCTL1, &ADC12MCTL2, &ADC12MCTL3};
+  uint8 i;
+
+  if (((uint16)(unsigned long)arg != halSimAdcSeqGen) || !(halSimAdc12Ctl0 & ADC12ENC) ||
+      !(halSimAdc12Ctl0 & ADC12ON))
+  {
+    return;
+  }
+
+  for (i = 0; i < len; i++)
+  {
+    halSimAdc12Mem[i] = halSimAdcSample(*pMctl[i] & 0x0F);
+    halSimAdc12Ifg |= BV(i);
+  }
+
+  if (((ADC12CTL1 & ADC12CONSEQ_3) == ADC12CONSEQ_3) && (halSimAdc12Ctl0 & ADC12MSC))
+  {
+    halSimPost(len * HAL_SIM_ADC_CONV_US, halSimAdcSeqDone, arg);
+  }
+
+  if (ADC12IE & halSimAdc12Ifg)
+  {
+    halBoardAdc12Isr();
+  }
+}
+
+/**************************************************************************************************
+ * @fn          halSimAdcSeqLen
+ *
+ * @brief       Conversions in a sequence: from ADC12MEM0 up to the first ADC12EOS.
+ *
+ * @param       none
+ *
+ * @return      number of conversions
+ **************************************************************************************************
+ */
+static uint8 halSimAdcSeqLen(void)
+{
+  volatile uint8 *pMctl[HAL_SIM_ADC_MEMS] = {&ADC12MCTL0, &ADC12MCTL1, &ADC12MCTL2, &ADC12MCTL3};
+  uint8 i;
+
+  for (i = 0; i < HAL_SIM_ADC_MEMS - 1; i++)
+  {
+    if (*pMctl[i] & ADC12EOS)
+    {
+      break;
+    }
+  }
+  return i + 1;
+}
+
+/**************************************************************************************************
+ * @fn          halSimAdcSample
+ *
+ * @brief       Model one conversion: the nominal level of the sensor on 'channel', a few LSB of
+ *              noise and the odd spike the median filters in sensing.c are there to reject.
+ *
+ * @param       channel - ADC12INCH_x
+ *
+ * @return      12 bit result
+ **************************************************************************************************
+ */
+static uint16 halSimAdcSample(uint8 channel)
+{
+  int16 value;
+  uint8 i;
+
+  if (!halSimAdcCalibrated)
+  {
+    /* Every probe has its own zero offset, up to +/-40 LSB (about 0.4 pH) */
+    halSimAdcPhOffset = (int16)(halSimRand() % 81) - 40;
+    halSimAdcCalibrated = TRUE;
+  }
+
+  switch (channel)
+  {
+    case ADC12INCH_11: value = HAL_SIM_ADC_VDD;                      break;
+    case ADC12INCH_10: value = HAL_SIM_ADC_INT_TEMP;                 break;
+    case ADC12INCH_4:  value = HAL_SIM_ADC_EXT_TEMP;                 break;
+    case ADC12INCH_6:  value = HAL_SIM_ADC_PH + halSimAdcPhOffset;   break;
+    default:           value = 0;                                    break;
+  }
+
+  /* Roughly gaussian noise, sigma about 2 LSB */
+  for (i = 0; i < 4; i++)
+  {
+    value += (int16)(halSimRand() % 5) - 2;
+  }
+
+  /* One sample in 32 is a spike of 100 to 400 LSB either way */
+  if ((halSimRand() & 0x1F) == 0)
+  {
+    int16 spike = 100 + (int16)(halSimRand() % 301);
+    value += (halSimRand() & 1) ? spike : -spike;
+  }
+
+  if (value < 0)
+  {
+    value = 0;
+  }
+  else if (value > HAL_SIM_ADC_MAX)
+  {
+    value = HAL_SIM_ADC_MAX;
+  }
+
+  return (uint16)value;
+}
+
+/**************************************************************************************************
+ */
@@ -0,0 +1,161 @@
+/**************************************************************************************************
+  Filename:       hal_sim.h
+
+  Description:    Interface between a simulated device image and the host simulation kernel.
+
+                  Every application (gateway, node) is linked into a relocatable "image" whose
+                  .data/.bss live in one state section.  The kernel instantiates any number of
+                  devices per image by swapping that section in and out, and drives them from a
+                  single virtual clock.  Nothing in an image may keep state outside the section,
+                  so images only call the kernel services declared here and stateless libc.
+**************************************************************************************************/
+
+#ifndef HAL_SIM_H
+#define HAL_SIM_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "hal_types.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Device index returned when no image is running */
+#define HAL_SIM_NO_DEV            0xFFFF
+
+/* Virtual time helpers */
+#define HAL_SIM_USEC_PER_MSEC     1000ULL
+#define HAL_SIM_USEC_PER_SEC      1000000ULL
+
+/* FRAM on the SPI bus of every device (MB85RS2MT), kept by the kernel in pages */
+#define HAL_SIM_FRAM_SIZE         0x40000UL
+#define HAL_SIM_FRAM_PAGE_LEN     4096
+#define HAL_SIM_FRAM_PAGES        (HAL_SIM_FRAM_SIZE / HAL_SIM_FRAM_PAGE_LEN)
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Typedefs
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Virtual time in microseconds since the start of the simulation */
+typedef unsigned long long halSimTime_t;
+
+/* Handler executed in the context of the device that posted it */
+typedef void (*halSimHandler_t)(void *arg);
+
+/* Kernel handler; 'dev' is the device the event belongs to */
+typedef void (*halSimKernelFn_t)(uint16 dev, void *arg);
+
+/* Image descriptor, one per linked application */
+typedef struct
+{
+  const char  *name;
+  uint8       *stateBeg;      /* start of the swappable .data/.bss section */
+  uint8       *stateEnd;      /* end of the swappable section */
+  void        (*boot)(void);  /* runs main() up to the first OSAL pass */
+  uint32      (*run)(void);   /* runs OSAL until idle, returns ms to the next timer (0 = none) */
+  halSimHandler_t uartIn;     /* takes a halSimUartIn_t into the UART RX buffer */
+} halSimImage_t;
+
+/* Bytes arriving on RXD, see halSimUartIn() */
+typedef struct
+{
+  const uint8 *pBuf;
+  uint16      len;
+} halSimUartIn_t;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                    Services used by images
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Current virtual time */
+extern halSimTime_t halSimNow(void);
+
+/* Index of the device whose image is executing */
+extern uint16 halSimSelf(void);
+
+/* Call 'fn' in this device's context after 'delayUs' of virtual time */
+extern void halSimPost(uint32 delayUs, halSimHandler_t fn, void *arg);
+
+/* Deterministic pseudo random numbers shared by the whole simulation */
+extern uint16 halSimRand(void);
+
+/* Bytes leaving the UART shift register of this device */
+extern void halSimUartOut(uint8 port, const uint8 *pBuf, uint16 len);
+
+/* OSAL heap trace records read out of this device's ring (OSAL_Memory.h) */
+extern void halSimHeapTrace(const void *pBuf, uint16 len, uint16 lost);
+
+/* Page of this device's FRAM holding 'addr'; a page never written is allocated, zeroed, when
+ * 'write' is set and NULL otherwise */
+extern uint8 *halSimFramPage(uint32 addr, bool write);
+
+/* The device entered low power mode until its next event */
+extern void halSimSleep(uint32 timeout);
+
+/* Reboot this device; does not return */
+extern void halSimReset(void);
+
+/* HAL_ASSERT failure; stops the simulation */
+extern void halSimAssert(void);
+
+/* ------------------------------------------------------------------------------------------------
+ *                                    Services used by the host
+ * ------------------------------------------------------------------------------------------------
+ */
+
+extern void   halSimInit(uint16 maxDevs, uint32 seed);
+extern uint16 halSimAddDevice(const halSimImage_t *pImage, const char *name);
+extern void   halSimBoot(uint16 dev, halSimTime_t when);
+extern void   halSimRunUntil(halSimTime_t end);
+extern uint16 halSimNumDevices(void);
+extern const char *halSimDevName(uint16 dev);
+extern void   halSimUartEcho(uint16 dev, bool enable);
+
+/* Bytes arriving on the RXD of a device, taken in at once; call from kernel handlers only */
+extern void   halSimUartIn(uint16 dev, const uint8 *pBuf, uint16 len);
+
+/* Hand the UART output of a device to 'fn' instead of echoing it line by line */
+typedef void (*halSimUartTap_t)(uint16 dev, const uint8 *pBuf, uint16 len);
+extern void   halSimUartTap(uint16 dev, halSimUartTap_t fn);
+extern uint32 halSimStateSize(uint16 dev);
+
+/* Write the OSAL heap trace of one device to a file, see halSimHeapTrace() */
+extern bool   halSimHeapTraceOpen(uint16 dev, const char *path);
+extern void   halSimHeapTraceClose(void);
+
+/* Post a kernel event for 'dev' and run 'fn' in that device's context */
+extern void halSimSchedule(halSimTime_t when, uint16 dev, halSimKernelFn_t fn, void *arg);
+extern void halSimCall(uint16 dev, halSimHandler_t fn, void *arg);
+
+/* Per device counters */
+typedef struct
+{
+  uint32  boots;
+  uint32  wakeups;       /* times the image was entered */
+  uint32  sleeps;        /* low power mode entries */
+  uint32  uartBytes;     /* bytes shifted out of the UART */
+  uint32  uartDrops;     /* bytes refused by HalUARTOutBuf() */
+  uint32  framSelects;   /* FRAM commands */
+  uint32  framBytes;     /* SPI bytes clocked with the FRAM selected */
+  uint32  adcOnMs;       /* ms with the ADC12 or its reference on */
+} halSimDevStats_t;
+
+extern halSimDevStats_t *halSimStats(uint16 dev);
+extern uint32 halSimEventCount(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,340 @@
+/**************************************************************************************************
+  Filename:       hal_sim_fram.c
+
+  Description:    Device side of the POSIX host simulation: USCI_B1 in SPI master mode and the
+                  MB85RS2MT FRAM wired to it, chip select on P1.0.
+
+                  The USCI is modelled as on silicon: a byte written to UCB1TXBUF moves to the
+                  shift register, and it is shifted when the driver waits for it (UCB1IFG
+                  UCRXIFG, UCB1STAT UCBUSY, UCB1RXBUF), writes the next byte to UCB1TXBUF or
+                  touches P1OUT, which carries CS.  A driver that keeps TXBUF one byte ahead
+                  reads the same bytes back as one that waits for every byte.  The FRAM
+                  decodes WREN, WRDI, RDSR, READ, FSTRD, WRITE and RDID; like the real part it
+                  clears the write enable latch when CS rises after a WRITE.  Its memory is held
+                  by the kernel (halSimFramPage), so it survives resets of the device.  Every
+                  select and every byte clocked while selected is counted in halSimStats().
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "hal_types.h"
+#include "hal_mcu.h"
+#include "hal_sim.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+#define HAL_SIM_FRAM_CS           0x01      /* P1.0 */
+
+/* Opcodes */
+#define HAL_SIM_FRAM_WREN         0x06
+#define HAL_SIM_FRAM_WRDI         0x04
+#define HAL_SIM_FRAM_RDSR         0x05
+#define HAL_SIM_FRAM_READ         0x03
+#define HAL_SIM_FRAM_WRITE        0x02
+#define HAL_SIM_FRAM_RDID         0x9F
+#define HAL_SIM_FRAM_FSTRD        0x0B
+
+#define HAL_SIM_FRAM_SR_WEL       0x02
+
+/* ------------------------------------------------------------------------------------------------
+ *                                      Simulated registers
+ * ------------------------------------------------------------------------------------------------
+ */
+volatile uint8  UCB1CTL0, UCB1CTL1, UCB1IE;
+volatile uint16 UCB1BRW;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static volatile uint8 halSimP1Out;
+static volatile uint8 halSimSpiTx;
+static volatile uint8 halSimSpiRx;
+static volatile uint8 halSimSpiFlags;
+static volatile uint8 halSimSpiStatus;
+static bool   halSimSpiTxWritten;   /* UCB1TXBUF was written, the byte is not in the shifter yet */
+static bool   halSimSpiBusy;        /* a byte is in the shift register */
+static uint8  halSimSpiShifter;
+static bool   halSimSpiRxFull;
+
+static bool   halSimFramSelected;
+static uint8  halSimFramCmd;
+static uint8  halSimFramPos;        /* bytes of the command clocked so far */
+static uint32 halSimFramAddr;
+static bool   halSimFramWel;
+
+static const uint8 halSimFramId[4] = {0x04, 0x7F, 0x28, 0x03};
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static void  halSimSpiLoad(void);
+static void  halSimSpiShift(void);
+static void  halSimFramSelect(void);
+static uint8 halSimFramXfer(uint8 mosi);
+
+/**************************************************************************************************
+ * @fn          halSimSpiTxBuf
+ *
+ * @brief       Access to UCB1TXBUF.  A byte written before moves to the shift register, where
+ *              it pushes out the one still there; the byte about to be written waits in TXBUF.
+ *
+ * @param       none
+ *
+ * @return      pointer to the transmit buffer
+ **************************************************************************************************
+ */
+volatile uint8 *halSimSpiTxBuf(void)
+{
+  halSimSpiLoad();
+  halSimSpiTxWritten = TRUE;
+  return &halSimSpiTx;
+}
+
+/**************************************************************************************************
+ * @fn          halSimSpiRxBuf
+ *
+ * @brief       Read access to UCB1RXBUF, which clears UCRXIFG.  If no byte was received since
+ *              the last read, the one in the shift register completes first.  MISO floats
+ *              high unless the FRAM drives it.
+ *
+ * @param       none
+ *
+ * @return      pointer to the receive buffer
+ **************************************************************************************************
+ */
+volatile uint8 *halSimSpiRxBuf(void)
+{
+  halSimSpiLoad();
+  if (!halSimSpiRxFull)
+  {
+    halSimSpiShift();
+  }
+  halSimSpiRxFull = FALSE;
+  return &halSimSpiRx;
+}
+
+/**************************************************************************************************
+ * @fn          halSimSpiIfg
+ *
+ * @brief       Access to UCB1IFG.  UCTXIFG is always set, TXBUF empties at once; polling for
+ *              UCRXIFG completes the byte in the shift register.
+ *
+ * @param       none
+ *
+ * @return      pointer to the interrupt flag register
+ **************************************************************************************************
+ */
+volatile uint8 *halSimSpiIfg(void)
+{
+  halSimSpiLoad();
+  if (!halSimSpiRxFull)
+  {
+    halSimSpiShift();
+  }
+  halSimSpiFlags = UCTXIFG | (halSimSpiRxFull ? UCRXIFG : 0);
+  return &halSimSpiFlags;
+}
+
+/**************************************************************************************************
+ * @fn          halSimSpiStat
+ *
+ * @brief       Access to UCB1STAT.  Polling UCBUSY completes every byte in flight.
+ *
+ * @param       none
+ *
+ * @return      pointer to the status register
+ **************************************************************************************************
+ */
+volatile uint8 *halSimSpiStat(void)
+{
+  halSimSpiLoad();
+  halSimSpiShift();
+  halSimSpiStatus = 0;
+  return &halSimSpiStatus;
+}
+
+/**************************************************************************************************
+ * @fn          halSimP1OutReg
+ *
+ * @brief       Access to P1OUT.  Bytes in flight are shifted before CS can change, and the
+ *              value last written is looked at for a select or deselect of the FRAM.
+ *
+ * @param       none
+ *
+ * @return      pointer to the output register
+ **************************************************************************************************
+ */
+volatile uint8 *halSimP1OutReg(void)
+{
+  halSimSpiLoad();
+  halSimSpiShift();
+  halSimFramSelect();
+  return &halSimP1Out;
+}
+
+/**************************************************************************************************
+ * @fn          halSimSpiLoad
+ *
+ * @brief       Move a byte written to UCB1TXBUF into the shift register, completing the byte
+ *              that was there.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+static void halSimSpiLoad(void)
+{
+  if (halSimSpiTxWritten)
+  {
+    halSimSpiTxWritten = FALSE;
+    halSimSpiShift();
+    halSimSpiShifter = halSimSpiTx;
+    halSimSpiBusy = TRUE;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          halSimSpiShift
+ *
+ * @brief       Complete the byte in the shift register, if any, into UCB1RXBUF.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+static void halSimSpiShift(void)
+{
+  if (halSimSpiBusy)
+  {
+    halSimSpiBusy = FALSE;
+    halSimFramSelect();
+    halSimSpiRx = halSimFramXfer(halSimSpiShifter);
+    halSimSpiRxFull = TRUE;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          halSimFramSelect
+ *
+ * @brief       Follow the chip select.  A falling edge starts a command, a rising edge ends
+ *              it and, after a WRITE, clears the write enable latch.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+static void halSimFramSelect(void)
+{
+  bool selected = ((halSimP1Out & HAL_SIM_FRAM_CS) == 0);
+
+  if (selected && !halSimFramSelected)
+  {
+    halSimFramPos = 0;
+    halSimStats(halSimSelf())->framSelects++;
+  }
+  else if (!selected && halSimFramSelected)
+  {
+    if ((halSimFramCmd == HAL_SIM_FRAM_WRITE) && (halSimFramPos > 0))
+    {
+      halSimFramWel = FALSE;
+    }
+  }
+  halSimFramSelected = selected;
+}
+
+/**************************************************************************************************
+ * @fn          halSimFramXfer
+ *
+ * @brief       One byte on the bus.
+ *
+ * @param       mosi - byte sent by the master
+ *
+ * @return      byte on MISO
+ **************************************************************************************************
+ */
+static uint8 halSimFramXfer(uint8 mosi)
+{
+  uint8 pos = halSimFramPos;
+  uint8 *pPage;
+  uint8 miso = 0xFF;
+
+  if (!halSimFramSelected)
+  {
+    return miso;
+  }
+  halSimStats(halSimSelf())->framBytes++;
+  if (halSimFramPos < 0xFF)
+  {
+    halSimFramPos++;
+  }
+
+  if (pos == 0)
+  {
+    halSimFramCmd = mosi;
+    if (mosi == HAL_SIM_FRAM_WREN)
+    {
+      halSimFramWel = TRUE;
+    }
+    else if (mosi == HAL_SIM_FRAM_WRDI)
+    {
+      halSimFramWel = FALSE;
+    }
+    return miso;
+  }
+
+  switch (halSimFramCmd)
+  {
+    case HAL_SIM_FRAM_RDSR:
+      miso = halSimFramWel ? HAL_SIM_FRAM_SR_WEL : 0;
+      break;
+
+    case HAL_SIM_FRAM_RDID:
+      miso = halSimFramId[(pos <= 4) ? pos - 1 : 3];
+      break;
+
+    case HAL_SIM_FRAM_READ:
+    case HAL_SIM_FRAM_FSTRD:
+    case HAL_SIM_FRAM_WRITE:
+      if (pos <= 3)
+      {
+        halSimFramAddr = ((halSimFramAddr << 8) | mosi) & (HAL_SIM_FRAM_SIZE - 1);
+      }
+      else if ((halSimFramCmd == HAL_SIM_FRAM_FSTRD) && (pos == 4))
+      {
+        /* dummy byte */
+      }
+      else if (halSimFramCmd == HAL_SIM_FRAM_WRITE)
+      {
+        if (halSimFramWel)
+        {
+          pPage = halSimFramPage(halSimFramAddr, TRUE);
+          pPage[halSimFramAddr % HAL_SIM_FRAM_PAGE_LEN] = mosi;
+        }
+        halSimFramAddr = (halSimFramAddr + 1) & (HAL_SIM_FRAM_SIZE - 1);
+      }
+      else
+      {
+        pPage = halSimFramPage(halSimFramAddr, FALSE);
+        miso = (pPage != NULL) ? pPage[halSimFramAddr % HAL_SIM_FRAM_PAGE_LEN] : 0x00;
+        halSimFramAddr = (halSimFramAddr + 1) & (HAL_SIM_FRAM_SIZE - 1);
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  return miso;
+}
+
+/**************************************************************************************************
+ */
@@ -0,0 +1,826 @@
+/**************************************************************************************************
+  Filename:       hal_sim_kernel.c
+
+  Description:    Discrete event kernel of the POSIX host simulation.
+
+                  Devices are instances of a linked image (hal_sim.h).  Each device owns a copy
+                  of its image's state section; the copy is swapped into the image only when a
+                  different device of the same image has to run, so a device that handles a
+                  burst of events pays for one swap.  Time is virtual: the kernel jumps straight
+                  from one event to the next, and a sleeping device costs nothing until its next
+                  OSAL timer or radio event.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hal_types.h"
+#include "hal_sim.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+#define HAL_SIM_MAX_IMAGES        4
+#define HAL_SIM_NAME_LEN          16
+#define HAL_SIM_LINE_LEN          256
+
+/* Heap trace file: magic, version, record size, 2 reserved bytes, then the records */
+#define HAL_SIM_HEAP_TRACE_VER    1
+#define HAL_SIM_HEAP_TRACE_REC    8
+
+/* One MAC backoff of slack so that OSAL's 320 usec clock has passed the timer's expiry */
+#define HAL_SIM_WAKE_SLACK_US     320
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Typedefs
+ * ------------------------------------------------------------------------------------------------
+ */
+typedef struct
+{
+  halSimTime_t      when;
+  uint32            seq;        /* FIFO order among events due at the same time */
+  uint32            epoch;      /* boot count of 'dev' when a device handler was posted */
+  uint16            dev;
+  halSimKernelFn_t  kfn;
+  halSimHandler_t   fn;         /* device handler, runs in the context of 'dev' */
+  void              *arg;
+} halSimEvent_t;
+
+typedef struct
+{
+  const halSimImage_t *pImage;
+  uint32              stateLen;
+  uint8               *pInitial;  /* .data/.bss as linked, restored on every boot */
+  uint16              liveDev;    /* device whose state is in the image right now */
+} halSimImageRec_t;
+
+typedef struct
+{
+  halSimImageRec_t  *pRec;
+  uint8             *pState;
+  char              name[HAL_SIM_NAME_LEN];
+  bool              powered;
+  bool              echo;
+  halSimUartTap_t   tap;
+  uint32            wakeGen;      /* invalidates superseded wake-up events */
+  char              line[HAL_SIM_LINE_LEN];
+  uint16            lineLen;
+  halSimDevStats_t  stats;
+  uint8             *fram[HAL_SIM_FRAM_PAGES];
+} halSimDev_t;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static halSimTime_t      halSimClock;
+static unsigned long long halSimSeed;
+
+static halSimEvent_t     *halSimHeap;
+static uint32            halSimHeapLen;
+static uint32            halSimHeapMax;
+static uint32            halSimSeq;
+static uint32            halSimEvents;
+
+static halSimImageRec_t  halSimImages[HAL_SIM_MAX_IMAGES];
+static uint8             halSimNumImages;
+
+static halSimDev_t       *halSimDevs;
+static uint16            halSimNumDevs;
+static uint16            halSimMaxDevs;
+
+static uint16            halSimCur = HAL_SIM_NO_DEV;
+static jmp_buf           *halSimResetJmp;
+
+static FILE              *halSimHeapFile;
+static uint16            halSimHeapDev = HAL_SIM_NO_DEV;
+static uint32            halSimHeapRecs;
+static uint16            halSimHeapLost;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static bool halSimBefore(const halSimEvent_t *a, const halSimEvent_t *b);
+static void halSimPush(const halSimEvent_t *pEvt);
+static void halSimPop(halSimEvent_t *pEvt);
+static void halSimSwitch(uint16 dev);
+static void halSimExec(uint16 dev, halSimHandler_t fn, void *arg, bool boot);
+static void halSimWake(uint16 dev, void *arg);
+static void halSimPowerOn(uint16 dev, void *arg);
+
+/**************************************************************************************************
+ * @fn          halSimInit
+ *
+ * @brief       Reset the kernel.
+ *
+ * @param       maxDevs - number of devices that will be added
+ *              seed    - seed of the shared random number generator
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halSimInit(uint16 maxDevs, uint32 seed)
+{
+  halSimClock = 0;
+  halSimSeed = ((unsigned long long)seed << 1) | 1;
+  halSimHeapLen = 0;
+  halSimSeq = 0;
+  halSimEvents = 0;
+  halSimNumDevs = 0;
+  halSimMaxDevs = maxDevs;
+  halSimDevs = calloc(maxDevs, sizeof(halSimDev_t));
+  halSimHeapMax = 4 * (uint32)maxDevs + 64;
+  halSimHeap = malloc(halSimHeapMax * sizeof(halSimEvent_t));
+
+  if ((halSimDevs == NULL) || (halSimHeap == NULL))
+  {
+    fprintf(stderr, "sim: out of memory\n");
+    exit(1);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          halSimAddDevice
+ *
+ * @brief       Create a powered-off device running 'pImage'.
+ *
+ * @param       pImage - image descriptor exported by the linked image
+ *              name   - label used in logs
+ *
+ * @return      device index
+ **************************************************************************************************
+ */
+uint16 halSimAddDevice(const halSimImage_t *pImage, const char *name)
+{
+  halSimImageRec_t *pRec = NULL;
+  halSimDev_t *pDev;
+  uint8 i;
+
+  if (halSimNumDevs >= halSimMaxDevs)
+  {
+    fprintf(stderr, "sim: too many devices\n");
+    exit(1);
+  }
+
+  for (i = 0; i < halSimNumImages; i++)
+  {
+    if (halSimImages[i].pImage == pImage)
+    {
+      pRec = &halSimImages[i];
+    }
+  }
+
+  if (pRec == NULL)
+  {
+    if (halSimNumImages == HAL_SIM_MAX_IMAGES)
+    {
+      fprintf(stderr, "sim: too many images\n");
+      exit(1);
+    }
+
+    /* Nothing has run in this image yet, so its state section holds the linked values */
+    pRec = &halSimImages[halSimNumImages++];
+    pRec->pImage = pImage;
+    pRec->stateLen = (uint32)(pImage->stateEnd - pImage->stateBeg);
+    pRec->pInitial = malloc(pRec->stateLen);
+    pRec->liveDev = HAL_SIM_NO_DEV;
+    memcpy(pRec->pInitial, pImage->stateBeg, pRec->stateLen);
+  }
+
+  pDev = &halSimDevs[halSimNumDevs];
+  pDev->pRec = pRec;
+  pDev->pState = malloc(pRec->stateLen);
+  if ((pRec->pInitial == NULL) || (pDev->pState == NULL))
+  {
+    fprintf(stderr, "sim: out of memory\n");
+    exit(1);
+  }
+  memcpy(pDev->pState, pRec->pInitial, pRec->stateLen);
+  snprintf(pDev->name, sizeof(pDev->name), "%s", name);
+
+  return halSimNumDevs++;
+}
+
+/**************************************************************************************************
+ * @fn          halSimBoot
+ *
+ * @brief       Power the device on at 'when'.
+ *
+ * @param       dev  - device index
+ *              when - virtual time of power-on
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halSimBoot(uint16 dev, halSimTime_t when)
+{
+  halSimSchedule(when, dev, halSimPowerOn, NULL);
+}
+
+/**************************************************************************************************
+ * @fn          halSimRunUntil
+ *
+ * @brief       Dispatch every event due up to and including 'end', then advance the clock to it.
+ *
+ * @param       end - virtual time to stop at
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halSimRunUntil(halSimTime_t end)
+{
+  halSimEvent_t evt;
+
+  while ((halSimHeapLen != 0) && (halSimHeap[0].when <= end))
+  {
+    halSimPop(&evt);
+    halSimClock = evt.when;
+    halSimEvents++;
+
+    if (evt.fn != NULL)
+    {
+      /* A handler posted before the device rebooted belongs to a previous life */
+      if (evt.epoch == halSimDevs[evt.dev].stats.boots)
+      {
+        halSimExec(evt.dev, evt.fn, evt.arg, FALSE);
+      }
+    }
+    else
+    {
+      evt.kfn(evt.dev, evt.arg);
+    }
+  }
+
+  if (end > halSimClock)
+  {
+    halSimClock = end;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          halSimSchedule
+ *
+ * @brief       Queue a kernel handler.
+ *
+ * @param       when - virtual time, never earlier than now
+ *              dev  - device the event concerns
+ *              fn   - handler
+ *              arg  - handler argument
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halSimSchedule(halSimTime_t when, uint16 dev, halSimKernelFn_t fn, void *arg)
+{
+  halSimEvent_t evt;
+
+  evt.when = (when < halSimClock) ? halSimClock : when;
+  evt.epoch = 0;
+  evt.dev = dev;
+  evt.kfn = fn;
+  evt.fn = NULL;
+  evt.arg = arg;
+  halSimPush(&evt);
+}
+
+/**************************************************************************************************
+ * @fn          halSimCall
+ *
+ * @brief       Run 'fn' in the context of 'dev' now, as an interrupt would, then let the device
+ *              run until it is idle again.  Must be called from kernel handlers only.
+ *
+ * @param       dev - device index
+ *              fn  - device handler, may be NULL to only run pending work
+ *              arg - handler argument
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halSimCall(uint16 dev, halSimHandler_t fn, void *arg)
+{
+  halSimExec(dev, fn, arg, FALSE);
+}
+
+/**************************************************************************************************
+ * @fn          halSimNow / halSimSelf / halSimNumDevices / halSimDevName / halSimStats
+ *
+ * @brief       Accessors.
+ **************************************************************************************************
+ */
+halSimTime_t halSimNow(void)
+{
+  return halSimClock;
+}
+
+uint16 halSimSelf(void)
+{
+  return halSimCur;
+}
+
+uint16 halSimNumDevices(void)
+{
+  return halSimNumDevs;
+}
+
+const char *halSimDevName(uint16 dev)
+{
+  return (dev < halSimNumDevs) ? halSimDevs[dev].name : "kernel";
+}
+
+halSimDevStats_t *halSimStats(uint16 dev)
+{
+  return &halSimDevs[dev].stats;
+}
+
+uint32 halSimStateSize(uint16 dev)
+{
+  return halSimDevs[dev].pRec->stateLen;
+}
+
+uint32 halSimEventCount(void)
+{
+  return halSimEvents;
+}
+
+void halSimUartEcho(uint16 dev, bool enable)
+{
+  halSimDevs[dev].echo = enable;
+}
+
+void halSimUartTap(uint16 dev, halSimUartTap_t fn)
+{
+  halSimDevs[dev].tap = fn;
+}
+
+/**************************************************************************************************
+ * @fn          halSimUartIn
+ *
+ * @brief       Host service: bytes arrive on the RXD of a device.  Its UART takes them into the
+ *              RX buffer and calls back the application, as the receive timeout would.
+ *
+ * @param       dev  - device index
+ *              pBuf - bytes
+ *              len  - number of bytes
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halSimUartIn(uint16 dev, const uint8 *pBuf, uint16 len)
+{
+  halSimUartIn_t in;
+
+  in.pBuf = pBuf;
+  in.len = len;
+  halSimExec(dev, halSimDevs[dev].pRec->pImage->uartIn, &in, FALSE);
+}
+
+/**************************************************************************************************
+ * @fn          halSimPost
+ *
+ * @brief       Image service: run 'fn' in the calling device's context after 'delayUs'.
+ *
+ * @param       delayUs - delay in virtual microseconds
+ *              fn      - handler
+ *              arg     - handler argument
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halSimPost(uint32 delayUs, halSimHandler_t fn, void *arg)
+{
+  halSimEvent_t evt;
+
+  evt.when = halSimClock + delayUs;
+  evt.epoch = halSimDevs[halSimCur].stats.boots;
+  evt.dev = halSimCur;
+  evt.kfn = NULL;
+  evt.fn = fn;
+  evt.arg = arg;
+  halSimPush(&evt);
+}
+
+/**************************************************************************************************
+ * @fn          halSimRand
+ *
+ * @brief       xorshift64* generator shared by all devices; the whole run is reproducible from
+ *              the seed given to halSimInit().
+ *
+ * @param       none
+ *
+ * @return      16 bit pseudo random number
+ **************************************************************************************************
+ */
+uint16 halSimRand(void)
+{
+  halSimSeed ^= halSimSeed >> 12;
+  halSimSeed ^= halSimSeed << 25;
+  halSimSeed ^= halSimSeed >> 27;
+  return (uint16)((halSimSeed * 2685821657736338717ULL) >> 48);
+}
+
+/**************************************************************************************************
+ * @fn          halSimFramPage
+ *
+ * @brief       Image service: memory of the FRAM of the calling device.  Pages are allocated
+ *              on their first write, so a device pays only for what its FRAM holds.
+ *
+ * @param       addr  - FRAM address
+ *              write - TRUE to allocate the page if it was never written
+ *
+ * @return      start of the page, NULL if it was never written and 'write' is FALSE
+ **************************************************************************************************
+ */
+uint8 *halSimFramPage(uint32 addr, bool write)
+{
+  uint8 **ppPage = &halSimDevs[halSimCur].fram[(addr % HAL_SIM_FRAM_SIZE) / HAL_SIM_FRAM_PAGE_LEN];
+
+  if ((*ppPage == NULL) && write)
+  {
+    if ((*ppPage = calloc(1, HAL_SIM_FRAM_PAGE_LEN)) == NULL)
+    {
+      fprintf(stderr, "sim: out of memory\n");
+      exit(1);
+    }
+  }
+  return *ppPage;
+}
+
+/**************************************************************************************************
+ * @fn          halSimUartOut
+ *
+ * @brief       Image service: bytes shifted out of a UART.  They go to the tap of the device
+ *              if it has one.  Otherwise complete lines of devices with echo enabled are
+ *              written to stdout prefixed with the time and device name.
+ *
+ * @param       port - UART port
+ *              pBuf - bytes
+ *              len  - number of bytes
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halSimUartOut(uint8 port, const uint8 *pBuf, uint16 len)
+{
+  halSimDev_t *pDev = &halSimDevs[halSimCur];
+  uint16 i;
+
+  (void)port;
+  pDev->stats.uartBytes += len;
+
+  if (pDev->tap != NULL)
+  {
+    pDev->tap(halSimCur, pBuf, len);
+    return;
+  }
+
+  for (i = 0; i < len; i++)
+  {
+    if ((pBuf[i] == '\n') || (pDev->lineLen == HAL_SIM_LINE_LEN - 1))
+    {
+      if (pDev->echo && (pDev->lineLen != 0))
+      {
+        pDev->line[pDev->lineLen] = '\0';
+        printf("%10.3f %-8s %s\n", (double)halSimClock / HAL_SIM_USEC_PER_SEC, pDev->name, pDev->line);
+      }
+      pDev->lineLen = 0;
+    }
+
+    if (pBuf[i] != '\n')
+    {
+      pDev->line[pDev->lineLen++] = (char)pBuf[i];
+    }
+  }
+}
+
+/**************************************************************************************************
+ * @fn          halSimHeapTrace
+ *
+ * @brief       Image service: OSAL heap trace records read out of the ring.  Only the device
+ *              given to halSimHeapTraceOpen() has its records written.
+ *
+ * @param       pBuf - records
+ *              len  - number of bytes
+ *              lost - records the ring has overwritten so far
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halSimHeapTrace(const void *pBuf, uint16 len, uint16 lost)
+{
+  if ((halSimCur != halSimHeapDev) || (halSimHeapFile == NULL))
+  {
+    return;
+  }
+
+  fwrite(pBuf, 1, len, halSimHeapFile);
+  halSimHeapRecs += len / HAL_SIM_HEAP_TRACE_REC;
+  halSimHeapLost = lost;
+}
+
+/**************************************************************************************************
+ * @fn          halSimHeapTraceOpen
+ *
+ * @brief       Write the OSAL heap trace of 'dev' to a file.  The image must be built with
+ *              OSALMEM_TRACE.
+ *
+ * @param       dev  - device index
+ *              path - file name
+ *
+ * @return      TRUE if the file could be created
+ **************************************************************************************************
+ */
+bool halSimHeapTraceOpen(uint16 dev, const char *path)
+{
+  const uint8 hdr[8] = {'O', 'S', 'M', 'T', HAL_SIM_HEAP_TRACE_VER, HAL_SIM_HEAP_TRACE_REC, 0, 0};
+
+  halSimHeapFile = fopen(path, "wb");
+  if (halSimHeapFile == NULL)
+  {
+    return FALSE;
+  }
+
+  fwrite(hdr, 1, sizeof(hdr), halSimHeapFile);
+  halSimHeapDev = dev;
+  halSimHeapRecs = 0;
+  halSimHeapLost = 0;
+  return TRUE;
+}
+
+/**************************************************************************************************
+ * @fn          halSimHeapTraceClose
+ *
+ * @brief       Close the heap trace file and report how many records it holds.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halSimHeapTraceClose(void)
+{
+  if (halSimHeapFile == NULL)
+  {
+    return;
+  }
+
+  fclose(halSimHeapFile);
+  halSimHeapFile = NULL;
+  printf("sim: heap trace of %s: %u records, %u lost\n", halSimDevName(halSimHeapDev),
+         halSimHeapRecs, halSimHeapLost);
+  halSimHeapDev = HAL_SIM_NO_DEV;
+}
+
+/**************************************************************************************************
+ * @fn          halSimSleep
+ *
+ * @brief       Image service: the device entered low power mode.
+ *
+ * @param       timeout - ms to the next OSAL timer
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halSimSleep(uint32 timeout)
+{
+  (void)timeout;
+  halSimDevs[halSimCur].stats.sleeps++;
+}
+
+/**************************************************************************************************
+ * @fn          halSimReset
+ *
+ * @brief       Image service: reboot the calling device.  Unwinds to halSimExec(), which reloads
+ *              the initial state and runs the image from main() again.
+ *
+ * @param       none
+ *
+ * @return      does not return
+ **************************************************************************************************
+ */
+void halSimReset(void)
+{
+  longjmp(*halSimResetJmp, 1);
+}
+
+/**************************************************************************************************
+ * @fn          halSimAssert
+ *
+ * @brief       Image service: an assertion failed.
+ *
+ * @param       none
+ *
+ * @return      does not return
+ **************************************************************************************************
+ */
+void halSimAssert(void)
+{
+  fflush(stdout);
+  fprintf(stderr, "sim: assert in %s at %.6f s\n", halSimDevName(halSimCur),
+          (double)halSimClock / HAL_SIM_USEC_PER_SEC);
+  abort();
+}
+
+/**************************************************************************************************
+ * @fn          halSimExec
+ *
+ * @brief       Enter a device.  Optionally (re)boot it, run 'fn', run OSAL until idle and arm
+ *              the wake-up for its next timer.
+ *
+ * @param       dev  - device index
+ *              fn   - handler to run first, may be NULL
+ *              arg  - handler argument
+ *              boot - TRUE to power the device on instead of running 'fn'
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+static void halSimExec(uint16 dev, halSimHandler_t fn, void *arg, bool boot)
+{
+  halSimDev_t *pDev = &halSimDevs[dev];
+  const halSimImage_t *pImage = pDev->pRec->pImage;
+  jmp_buf resetJmp;
+  uint32 next;
+
+  if (!pDev->powered || (halSimCur != HAL_SIM_NO_DEV))
+  {
+    return;
+  }
+
+  halSimSwitch(dev);
+  halSimCur = dev;
+  halSimResetJmp = &resetJmp;
+  pDev->stats.wakeups++;
+
+  if ((setjmp(resetJmp) != 0) || boot)
+  {
+    /* Power-on or HAL_SYSTEM_RESET(): start over from the linked .data/.bss */
+    memcpy(pImage->stateBeg, pDev->pRec->pInitial, pDev->pRec->stateLen);
+    pDev->stats.boots++;
+    pDev->lineLen = 0;
+    pImage->boot();
+  }
+  else if (fn != NULL)
+  {
+    fn(arg);
+  }
+
+  next = pImage->run();
+  halSimCur = HAL_SIM_NO_DEV;
+
+  pDev->wakeGen++;
+  if (next != 0)
+  {
+    halSimSchedule(halSimClock + next * HAL_SIM_USEC_PER_MSEC + HAL_SIM_WAKE_SLACK_US,
+                   dev, halSimWake, (void *)(unsigned long)pDev->wakeGen);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          halSimWake
+ *
+ * @brief       OSAL timer wake-up, ignored if the device armed a newer one since.
+ *
+ * @param       dev - device index
+ *              arg - wake generation
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+static void halSimWake(uint16 dev, void *arg)
+{
+  if ((uint32)(unsigned long)arg == halSimDevs[dev].wakeGen)
+  {
+    halSimExec(dev, NULL, NULL, FALSE);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          halSimPowerOn
+ *
+ * @brief       Power-on event queued by halSimBoot().
+ *
+ * @param       dev - device index
+ *              arg - unused
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+static void halSimPowerOn(uint16 dev, void *arg)
+{
+  (void)arg;
+  halSimDevs[dev].powered = TRUE;
+  halSimExec(dev, NULL, NULL, TRUE);
+}
+
+/**************************************************************************************************
+ * @fn          halSimSwitch
+ *
+ * @brief       Make 'dev' the live instance of its image.
+ *
+ * @param       dev - device index
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+static void halSimSwitch(uint16 dev)
+{
+  halSimImageRec_t *pRec = halSimDevs[dev].pRec;
+
+  if (pRec->liveDev != dev)
+  {
+    if (pRec->liveDev != HAL_SIM_NO_DEV)
+    {
+      memcpy(halSimDevs[pRec->liveDev].pState, pRec->pImage->stateBeg, pRec->stateLen);
+    }
+    memcpy(pRec->pImage->stateBeg, halSimDevs[dev].pState, pRec->stateLen);
+    pRec->liveDev = dev;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          halSimBefore / halSimPush / halSimPop
+ *
+ * @brief       Binary min-heap of pending events ordered by time, then by insertion.
+ **************************************************************************************************
+ */
+static bool halSimBefore(const halSimEvent_t *a, const halSimEvent_t *b)
+{
+  return (a->when < b->when) || ((a->when == b->when) && ((int32)(a->seq - b->seq) < 0));
+}
+
+static void halSimPush(const halSimEvent_t *pEvt)
+{
+  uint32 i, parent;
+
+  if (halSimHeapLen == halSimHeapMax)
+  {
+    halSimHeapMax *= 2;
+    halSimHeap = realloc(halSimHeap, halSimHeapMax * sizeof(halSimEvent_t));
+    if (halSimHeap == NULL)
+    {
+      fprintf(stderr, "sim: out of memory\n");
+      exit(1);
+    }
+  }
+
+  i = halSimHeapLen++;
+  halSimHeap[i] = *pEvt;
+  halSimHeap[i].seq = halSimSeq++;
+
+  while (i != 0)
+  {
+    parent = (i - 1) / 2;
+    if (!halSimBefore(&halSimHeap[i], &halSimHeap[parent]))
+    {
+      break;
+    }
+    {
+      halSimEvent_t tmp = halSimHeap[i];
+      halSimHeap[i] = halSimHeap[parent];
+      halSimHeap[parent] = tmp;
+    }
+    i = parent;
+  }
+}
+
+static void halSimPop(halSimEvent_t *pEvt)
+{
+  uint32 i = 0, child;
+
+  *pEvt = halSimHeap[0];
+  halSimHeap[0] = halSimHeap[--halSimHeapLen];
+
+  for (;;)
+  {
+    child = 2 * i + 1;
+    if (child >= halSimHeapLen)
+    {
+      break;
+    }
+    if ((child + 1 < halSimHeapLen) && halSimBefore(&halSimHeap[child + 1], &halSimHeap[child]))
+    {
+      child++;
+    }
+    if (!halSimBefore(&halSimHeap[child], &halSimHeap[i]))
+    {
+      break;
+    }
+    {
+      halSimEvent_t tmp = halSimHeap[i];
+      halSimHeap[i] = halSimHeap[child];
+      halSimHeap[child] = tmp;
+    }
+    i = child;
+  }
+}
+
+/**************************************************************************************************
+ */
@@ -0,0 +1,73 @@
+/**************************************************************************************************
+  Filename:       hal_types.h
+
+  Description:    Basic types for the POSIX host build.  The widths match the MSP430 target so
+                  that OSAL and the applications compile unchanged on a 64-bit host.
+**************************************************************************************************/
+
+#ifndef HAL_TYPES_H
+#define HAL_TYPES_H
+
+/* POSIX host (GCC / Clang) */
+
+/* ------------------------------------------------------------------------------------------------
+ *                                               Types
+ * ------------------------------------------------------------------------------------------------
+ */
+typedef signed   char   int8;
+typedef unsigned char   uint8;
+
+typedef signed   short  int16;
+typedef unsigned short  uint16;
+
+/* 'long' is 64 bits on LP64 hosts, 'int' keeps these at 32 bits like the target */
+typedef signed   int    int32;
+typedef unsigned int    uint32;
+
+typedef unsigned char   bool;
+
+/* Heap blocks must be able to hold host pointers */
+typedef unsigned long long halDataAlign_t;
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                Memory Attributes and Compiler Macros
+ * ------------------------------------------------------------------------------------------------
+ */
+#define  XDATA
+#define  CODE
+
+/* ----------- GNU Compiler ----------- */
+#if defined __GNUC__
+#define ASM_NOP    __asm__ __volatile__ ("nop")
+
+/* IAR segment placement keywords have no meaning on the host */
+#define __no_init
+#define __near_func
+
+/* ----------- Unrecognized Compiler ----------- */
+#else
+#error "ERROR: Unknown compiler."
+#endif
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Standard Defines
+ * ------------------------------------------------------------------------------------------------
+ */
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#ifndef NULL
+#define NULL 0
+#endif
+
+
+/**************************************************************************************************
+ */
+#endif
@@ -0,0 +1,573 @@
+/**************************************************************************************************
+  Filename:       hal_uart.c
+
+  Description:    UART driver for the POSIX host build.
+
+                  Same buffering as the MSP430 driver - an OSAL allocated TX ring with the
+                  all-or-none write rule - but the shift register is a virtual time model: the
+                  ring drains at the configured baud rate (10 bit times per character) and the
+                  characters that leave it are handed to the simulation kernel, which prints
+                  complete lines.  A slow port therefore fills up and refuses writes exactly
+                  where the real one would.  Whatever is queued is shifted out as one chunk,
+                  which is what HAL_UART_DMA does on the MSP430, so the rates above 115200 are
+                  accepted under the same condition.  The host drives RX with halSimUartIn():
+                  the bytes go into the RX ring, what does not fit is lost as on the real port,
+                  and the application is called back with HAL_UART_RX_TIMEOUT.
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <string.h>
+
+#include "hal_types.h"
+#include "hal_uart.h"
+#include "hal_sim.h"
+#include "OSAL.h"
+
+/*-------------------------------------------------------------------------------------------------
+                                             CONSTANTS
+ ------------------------------------------------------------------------------------------------*/
+
+/* Start bit, 8 data bits, stop bit */
+#define HAL_UART_BITS_PER_CHAR    10
+
+/*-------------------------------------------------------------------------------------------------
+                                          GLOBAL VARIABLES
+-------------------------------------------------------------------------------------------------*/
+
+halUARTCfg_t uartRecord;
+
+/* Baud rate table, indexed by HAL_UART_BR_xxx */
+static const uint32 halUartBaudTable[] = { 9600, 19200, 38400, 57600, 115200, 230400, 460800 };
+
+/* Characters being shifted out: 'chunk' characters starting at txStart, 'sent' of them done */
+static halSimTime_t halUartTxStart;
+static uint16 halUartTxChunk;
+static uint16 halUartTxSent;
+
+/*-------------------------------------------------------------------------------------------------
+                                         FUNCTIONS - LOCAL
+-------------------------------------------------------------------------------------------------*/
+static void MyItoa(uint32 num, uint8 outStr[], uint8 radix );
+static void Hal_UART_BufferInit(void);
+static void Hal_UART_TxUpdate(void);
+static void Hal_UART_TxStart(void);
+static void Hal_UART_TxDone(void *arg);
+static void Hal_UART_SendCallBack(uint8 port, uint8 event);
+void halSimUartRx(void *arg);
+
+/*-------------------------------------------------------------------------------------------------
+                                  Application Level Functions
+-------------------------------------------------------------------------------------------------*/
+void MyItoa(uint32 num, uint8 outStr[], uint8 radix){
+  uint32 quotient, remainder;
+  char     storageStr[33];
+  int      count, index; //must int type, uint is incorrect
+
+  remainder = num;
+  count     = 0;
+  do{
+    quotient    = remainder % radix;
+    remainder   = remainder / radix;
+    if (quotient < 10){
+      storageStr[count++]  = 0x30 | ((uint8) quotient);
+    }
+    else{
+      storageStr[count++]  = (uint8) (quotient+55);
+    }
+  }while (remainder !=0);
+  for(index=0; index<count; index++){
+    outStr[index] = storageStr[count-index-1];
+  }
+  outStr[index] = '\0';
+}
+
+
+/*************************************************************************************************
+ * @fn      HalUARTInit()
+ *
+ * @brief   Initialize the UART
+ *
+ * @param   none
+ *
+ * @return  none
+ *************************************************************************************************/
+void HalUARTInit ( void )
+{
+  Hal_UART_BufferInit();
+}
+
+/*************************************************************************************************
+ * @fn      HalBufferInit()
+ *
+ * @brief   Initialize the UART Buffers
+ *
+ * @param   none
+ *
+ * @return  none
+ *************************************************************************************************/
+static void Hal_UART_BufferInit (void)
+{
+  uartRecord.configured        = FALSE;
+  uartRecord.rx.bufferHead     = 0;
+  uartRecord.rx.bufferTail     = 0;
+  uartRecord.rx.pBuffer        = (uint8 *)NULL;
+  uartRecord.tx.bufferHead     = 0;
+  uartRecord.tx.bufferTail     = 0;
+  uartRecord.tx.pBuffer        = (uint8 *)NULL;
+  uartRecord.rxChRvdTime       = 0;
+  uartRecord.intEnable         = FALSE;
+  halUartTxChunk               = 0;
+  halUartTxSent                = 0;
+}
+
+/*************************************************************************************************
+ * @fn      HalUARTOpen()
+ *
+ * @brief   Open a port based on the configuration
+ *
+ * @param   port   - UART port
+ *          config - contains configuration information
+ *
+ * @return  Status of the function call
+ *************************************************************************************************/
+uint8 HalUARTOpen ( uint8 port, halUARTCfg_t *config )
+{
+  (void)port;
+
+  if ((config->baudRate > HAL_UART_BR_460800) ||
+      ((HAL_UART_DMA != TRUE) && (config->baudRate > HAL_UART_BR_115200)))
+  {
+    return HAL_UART_BAUDRATE_ERROR;
+  }
+
+  uartRecord.baudRate             = config->baudRate;
+  uartRecord.flowControl          = config->flowControl;
+  uartRecord.rx.maxBufSize        = config->rx.maxBufSize;
+  uartRecord.tx.maxBufSize        = config->tx.maxBufSize;
+  uartRecord.idleTimeout          = config->idleTimeout;
+  uartRecord.intEnable            = config->intEnable;
+  uartRecord.callBackFunc         = config->callBackFunc;
+
+  if (config->flowControlThreshold > config->rx.maxBufSize)
+    uartRecord.flowControlThreshold = 0;
+  else
+    uartRecord.flowControlThreshold = config->flowControlThreshold;
+
+  uartRecord.rx.pBuffer = osal_mem_alloc (uartRecord.rx.maxBufSize);
+  uartRecord.tx.pBuffer = osal_mem_alloc (uartRecord.tx.maxBufSize);
+
+  if ((uartRecord.rx.pBuffer) && (uartRecord.tx.pBuffer))
+  {
+    uartRecord.configured = TRUE;
+    return HAL_UART_SUCCESS;
+  }
+  else
+  {
+    uartRecord.configured = FALSE;
+    return HAL_UART_MEM_FAIL;
+  }
+}
+
+/*************************************************************************************************
+ * @fn      Hal_UARTPoll
+ *
+ * @brief   Bring the TX ring up to date with the virtual clock.
+ *
+ * @param   void
+ *
+ * @return  void
+ *************************************************************************************************/
+void HalUARTPoll(void)
+{
+  if (!uartRecord.configured)
+  {
+    return;
+  }
+
+  Hal_UART_TxUpdate();
+}
+
+/*************************************************************************************************
+ * @fn      HalUARTClose()
+ *
+ * @brief   Close the UART
+ *
+ * @param   port - UART port (not used.)
+ *
+ * @return  none
+ *************************************************************************************************/
+void HalUARTClose ( uint8 port )
+{
+  (void)port;
+
+  if (uartRecord.configured)
+  {
+    osal_mem_free (uartRecord.rx.pBuffer);
+    osal_mem_free (uartRecord.tx.pBuffer);
+    Hal_UART_BufferInit();
+  }
+}
+
+/*************************************************************************************************
+ * @fn      HalUARTRead()
+ *
+ * @brief   Read a buffer from the UART
+ *
+ * @param   port - UART port (not used.)
+ *          pBuffer - buffer to read into
+ *          length - length of the requested buffer
+ *
+ * @return  length of buffer that was read
+ *************************************************************************************************/
+uint16 HalUARTRead ( uint8 port, uint8 *pBuffer, uint16 length )
+{
+  uint16 cnt = 0;
+
+  (void)port;
+  if (!uartRecord.configured)
+  {
+    return 0;
+  }
+
+  while ((cnt < length) && (uartRecord.rx.bufferHead != uartRecord.rx.bufferTail))
+  {
+    pBuffer[cnt++] = uartRecord.rx.pBuffer[uartRecord.rx.bufferHead];
+    if (++uartRecord.rx.bufferHead >= uartRecord.rx.maxBufSize)
+    {
+      uartRecord.rx.bufferHead = 0;
+    }
+  }
+
+  return cnt;
+}
+
+/*************************************************************************************************
+ * @brief   Write a buffer to the UART
+ * @param   port    - UART port (not used.)
+ *          pBuffer - pointer to the buffer that will be written
+ *          length  - length of
+ * @return  length of the buffer that was sent, 0 if it did not fit
+ *************************************************************************************************/
+uint16 HalUARTOutBuf (uint8 port, uint8 *pBuffer, uint16 length)
+{
+  uint16 cnt, idx;
+
+  (void)port;
+
+  if (!uartRecord.configured)
+  {
+    return 0;
+  }
+
+  Hal_UART_TxUpdate();
+
+  // Accept "all-or-none" on write request; one slot stays free to tell full from empty.
+  if ((uint32)Hal_UART_TxBufLen(0) + length >= uartRecord.tx.maxBufSize)
+  {
+    halSimStats(halSimSelf())->uartDrops += length;
+    return 0;
+  }
+
+  idx = uartRecord.tx.bufferTail;
+  for (cnt = 0; cnt < length; cnt++)
+  {
+    uartRecord.tx.pBuffer[idx++] = pBuffer[cnt];
+
+    if (idx >= uartRecord.tx.maxBufSize)
+    {
+      idx = 0;
+    }
+  }
+  uartRecord.tx.bufferTail = idx;
+
+  if (halUartTxChunk == 0)
+  {
+    Hal_UART_TxStart();
+  }
+
+  return length;
+}
+
+
+//==================================================================
+uint16 HalUARTPrintStr ( uint8 port, char* str ){
+  return HalUARTOutBuf(port, (unsigned char*) str, strlen(str));
+}
+
+
+//==================================================================
+uint16 HalUARTPrintUInt ( uint8 port, uint32 num, uint8 radix ){
+  uint8 buf[33];
+
+  MyItoa( num, &buf[0], radix );
+  return HalUARTPrintStr( port, (char*) buf );
+}
+
+
+//==================================================================
+uint16 HalUARTPrintInt ( uint8 port, int32 num, uint8 radix ){
+  if (num >0){
+    return HalUARTPrintUInt(port, (uint32) num, radix);
+  }
+  else{
+    HalUARTPrintStr(port, "-");
+    return HalUARTPrintUInt(port, (uint32) (-num), radix);
+  }
+}
+
+
+//=================================================================
+uint16 HalUARTPrintStrAndUInt(uint8 port, char *title, uint32 value, uint8 radix){
+  HalUARTPrintStr(port, title);
+  return HalUARTPrintUInt(port, value, radix);
+}
+
+
+//=================================================================
+uint16 HalUARTPrintStrAndInt(uint8 port, char *title, int32 value, uint8 radix){
+  HalUARTPrintStr(port, title);
+  return HalUARTPrintInt(port, value, radix);
+}
+
+
+//==================================================================
+uint16 HalUARTPrintnlStr ( uint8 port, char* str ){
+  HalUARTPrintStr(port, str);
+  return HalUARTPrintStr(port, "\n");
+}
+
+
+//==================================================================
+uint16 HalUARTPrintnlUInt (uint8 port, uint32 num, uint8 radix){
+  HalUARTPrintUInt (port, num, radix);
+  return HalUARTPrintStr(port, "\n");
+}
+
+
+//==================================================================
+uint16 HalUARTPrintnlInt (uint8 port, int32 num, uint8 radix){
+  HalUARTPrintInt (port, num, radix);
+  return HalUARTPrintStr(port, "\n");
+}
+
+
+//==================================================================
+uint16 HalUARTPrintnlStrAndUInt (uint8 port, char *title, uint32 value, uint8 radix){
+  HalUARTPrintStrAndUInt (port, title, value, radix);
+  return HalUARTPrintStr(port, "\n");
+}
+
+
+//==================================================================
+uint16 HalUARTPrintnlStrAndInt (uint8 port, char *title, int32 value, uint8 radix){
+  HalUARTPrintStrAndInt (port, title, value, radix);
+  return HalUARTPrintStr(port, "\n");
+}
+
+
+/*************************************************************************************************
+ * @fn      Hal_UART_RxBufLen()
+ *
+ * @brief   Calculate Rx Buffer length of a port
+ *
+ * @param   port - UART port (not used.)
+ *
+ * @return  length of current Rx Buffer
+ *************************************************************************************************/
+uint16 Hal_UART_RxBufLen (uint8 port)
+{
+  int16 length = uartRecord.rx.bufferTail;
+
+  (void)port;
+  length -= uartRecord.rx.bufferHead;
+  if  (length < 0)
+    length += uartRecord.rx.maxBufSize;
+
+  return (uint16)length;
+}
+
+/*************************************************************************************************
+ * @fn      Hal_UART_TxBufLen()
+ *
+ * @brief   Calculate Tx Buffer length of a port
+ *
+ * @param   port - UART port (not used.)
+ *
+ * @return  length of current Tx buffer
+ *************************************************************************************************/
+uint16 Hal_UART_TxBufLen ( uint8 port )
+{
+  int16 length = uartRecord.tx.bufferTail;
+
+  (void)port;
+  length -= uartRecord.tx.bufferHead;
+  if  (length < 0)
+    length += uartRecord.tx.maxBufSize;
+
+  return (uint16)length;
+}
+
+/*************************************************************************************************
+ * @fn      Hal_UART_SetFlowControl
+ *
+ * @brief   Set UART Rx flow control
+ *
+ * @param   port: serial port (not used.)
+ *          on:   0=OFF, !0=ON
+ *
+ * @return  none
+ *
+ *************************************************************************************************/
+void Hal_UART_FlowControlSet( uint8 port, uint8 status )
+{
+  (void)port;
+  (void)status;
+}
+
+/*-------------------------------------------------------------------------------------------------
+                                           HELP FUNCTIONS
+-------------------------------------------------------------------------------------------------*/
+
+/*************************************************************************************************
+ * @fn      HalUARTSendCallBack
+ *
+ * @brief   Send Callback back to the caller
+ *
+ * @param   port - UART port
+ *          event - event that causes the call back
+ *
+ * @return  None
+ *************************************************************************************************/
+static void Hal_UART_SendCallBack(uint8 port, uint8 event)
+{
+  if (uartRecord.callBackFunc)
+  {
+    (uartRecord.callBackFunc)(port, event);
+  }
+}
+
+/*************************************************************************************************
+ * @fn      halSimUartRx
+ *
+ * @brief   Bytes arrived on RXD (halSimUartIn()).  The ring keeps one slot free to tell full
+ *          from empty; the bytes beyond are lost.
+ *
+ * @param   arg - halSimUartIn_t
+ *
+ * @return  void
+ *************************************************************************************************/
+void halSimUartRx(void *arg)
+{
+  const halSimUartIn_t *pIn = (const halSimUartIn_t *)arg;
+  uint16 idx, next;
+
+  if (!uartRecord.configured)
+  {
+    return;
+  }
+
+  for (idx = 0; idx < pIn->len; idx++)
+  {
+    next = (uartRecord.rx.bufferTail + 1 >= uartRecord.rx.maxBufSize) ? 0 : uartRecord.rx.bufferTail + 1;
+    if (next == uartRecord.rx.bufferHead)
+    {
+      break;
+    }
+    uartRecord.rx.pBuffer[uartRecord.rx.bufferTail] = pIn->pBuf[idx];
+    uartRecord.rx.bufferTail = next;
+  }
+
+  Hal_UART_SendCallBack(HAL_UART_PORT_0, HAL_UART_RX_TIMEOUT);
+}
+
+/*************************************************************************************************
+ * @fn      Hal_UART_TxUpdate
+ *
+ * @brief   Retire the characters of the current chunk that the shift register has finished
+ *          with by now and hand them to the kernel.
+ *
+ * @param   void
+ *
+ * @return  void
+ *************************************************************************************************/
+static void Hal_UART_TxUpdate(void)
+{
+  uint32 shifted;
+  uint16 head;
+
+  if (halUartTxChunk == 0)
+  {
+    return;
+  }
+
+  shifted = (uint32)((halSimNow() - halUartTxStart) * halUartBaudTable[uartRecord.baudRate]
+                     / (HAL_UART_BITS_PER_CHAR * HAL_SIM_USEC_PER_SEC));
+  if (shifted > halUartTxChunk)
+  {
+    shifted = halUartTxChunk;
+  }
+
+  while (halUartTxSent < shifted)
+  {
+    head = uartRecord.tx.bufferHead;
+    halSimUartOut(HAL_UART_PORT_0, &uartRecord.tx.pBuffer[head], 1);
+    uartRecord.tx.bufferHead = (head + 1 >= uartRecord.tx.maxBufSize) ? 0 : head + 1;
+    halUartTxSent++;
+  }
+}
+
+/*************************************************************************************************
+ * @fn      Hal_UART_TxStart
+ *
+ * @brief   Start shifting out everything queued right now and schedule the TX empty interrupt.
+ *
+ * @param   void
+ *
+ * @return  void
+ *************************************************************************************************/
+static void Hal_UART_TxStart(void)
+{
+  uint32 baud = halUartBaudTable[uartRecord.baudRate];
+
+  halUartTxChunk = Hal_UART_TxBufLen(0);
+  halUartTxSent = 0;
+  halUartTxStart = halSimNow();
+
+  if (halUartTxChunk != 0)
+  {
+    halSimPost((uint32)(((unsigned long long)halUartTxChunk * HAL_UART_BITS_PER_CHAR * HAL_SIM_USEC_PER_SEC
+                         + baud - 1) / baud), Hal_UART_TxDone, NULL);
+  }
+}
+
+/*************************************************************************************************
+ * @fn      Hal_UART_TxDone
+ *
+ * @brief   The last character of the chunk left the shift register.
+ *
+ * @param   arg - unused
+ *
+ * @return  void
+ *************************************************************************************************/
+static void Hal_UART_TxDone(void *arg)
+{
+  (void)arg;
+
+  if (!uartRecord.configured)
+  {
+    return;
+  }
+
+  Hal_UART_TxUpdate();
+  Hal_UART_TxStart();
+
+  if (halUartTxChunk == 0)
+  {
+    Hal_UART_SendCallBack(HAL_UART_PORT_0, HAL_UART_TX_EMPTY);
+  }
+}
+
+/**************************************************************************************************
+ */
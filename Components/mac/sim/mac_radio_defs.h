@@ -0,0 +1,33 @@
+/**************************************************************************************************
+  Filename:       mac_radio_defs.h
+
+  Description:    Radio definitions of the simulated MAC used by the POSIX host build.  Only
+                  what the applications and OnBoard.c use of the low level MAC is provided.
+**************************************************************************************************/
+
+#ifndef MAC_RADIO_DEFS_H
+#define MAC_RADIO_DEFS_H
+
+/* ------------------------------------------------------------------------------------------------
+ *                                             Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "hal_types.h"
+#include "hal_sim.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Random Generator
+ * ------------------------------------------------------------------------------------------------
+ */
+#define MAC_RADIO_RANDOM_WORD()                       halSimRand()
+#define MAC_RADIO_RANDOM_BYTE()                       ((uint8)halSimRand())
+
+/* ------------------------------------------------------------------------------------------------
+ *                                         Prototypes
+ * ------------------------------------------------------------------------------------------------
+ */
+extern uint32 macMcuPrecisionCount(void);
+
+/**************************************************************************************************
+ */
+#endif
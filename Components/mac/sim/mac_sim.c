@@ -0,0 +1,811 @@
+/**************************************************************************************************
+  Filename:       mac_sim.c
+
+  Description:    MAC API of the POSIX host simulation.  Linked into every device image in place
+                  of the MAC library; keeps the device's PIB, forwards requests to the simulated
+                  radio channel and turns its indications into MAC_CbackEvent() calls with the
+                  same buffers and ownership rules as the TIMAC.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stddef.h>
+
+#include "hal_types.h"
+#include "hal_sim.h"
+#include "OSAL.h"
+#include "mac_api.h"
+#include "mac_main.h"
+#include "mac_radio_defs.h"
+#include "mac_sim.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* PIB defaults, as in the 802.15.4-2006 tables */
+#define MAC_SIM_DEFAULT_CHANNEL             11
+#define MAC_SIM_DEFAULT_MAX_FRAME_RETRIES   3
+#define MAC_SIM_DEFAULT_MAX_CSMA_BACKOFFS   4
+#define MAC_SIM_DEFAULT_MIN_BE              3
+#define MAC_SIM_DEFAULT_MAX_BE              5
+#define MAC_SIM_DEFAULT_RESPONSE_WAIT_TIME  32
+#define MAC_SIM_DEFAULT_PERSISTENCE_TIME    0x01F4
+#define MAC_SIM_DEFAULT_TOTAL_WAIT_TIME     1220
+#define MAC_SIM_DEFAULT_ORDER               15
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Typedefs
+ * ------------------------------------------------------------------------------------------------
+ */
+typedef struct
+{
+  uint8   attr;
+  uint8   offset;
+  uint8   len;
+} macSimPibTbl_t;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static macSimPib_t  macSimPib;
+
+/* Data requests handed to the channel and not confirmed yet */
+static uint8        macSimDataPending;
+
+/* Result buffers of the scan in progress */
+static uint8        *macSimScanEnergy;
+static macPanDesc_t *macSimScanPanDesc;
+
+uint8 macTaskId;
+
+/* Attributes stored in macSimPib */
+static const macSimPibTbl_t macSimPibTbl[] =
+{
+  {MAC_ASSOCIATION_PERMIT,           offsetof(macSimPib_t, assocPermit),                sizeof(bool)},
+  {MAC_AUTO_REQUEST,                 offsetof(macSimPib_t, autoRequest),                sizeof(bool)},
+  {MAC_BEACON_PAYLOAD_LENGTH,        offsetof(macSimPib_t, beaconPayloadLength),        sizeof(uint8)},
+  {MAC_BEACON_ORDER,                 offsetof(macSimPib_t, beaconOrder),                sizeof(uint8)},
+  {MAC_COORD_EXTENDED_ADDRESS,       offsetof(macSimPib_t, coordExtAddr),               sizeof(sAddrExt_t)},
+  {MAC_COORD_SHORT_ADDRESS,          offsetof(macSimPib_t, coordShortAddr),             sizeof(uint16)},
+  {MAC_DSN,                          offsetof(macSimPib_t, dsn),                        sizeof(uint8)},
+  {MAC_MAX_CSMA_BACKOFFS,            offsetof(macSimPib_t, maxCsmaBackoffs),            sizeof(uint8)},
+  {MAC_MIN_BE,                       offsetof(macSimPib_t, minBe),                      sizeof(uint8)},
+  {MAC_PAN_ID,                       offsetof(macSimPib_t, panId),                      sizeof(uint16)},
+  {MAC_RX_ON_WHEN_IDLE,              offsetof(macSimPib_t, rxOnWhenIdle),               sizeof(bool)},
+  {MAC_SHORT_ADDRESS,                offsetof(macSimPib_t, shortAddr),                  sizeof(uint16)},
+  {MAC_SUPERFRAME_ORDER,             offsetof(macSimPib_t, superframeOrder),            sizeof(uint8)},
+  {MAC_TRANSACTION_PERSISTENCE_TIME, offsetof(macSimPib_t, transactionPersistenceTime), sizeof(uint16)},
+  {MAC_ASSOCIATED_PAN_COORD,         offsetof(macSimPib_t, associatedPanCoord),         sizeof(bool)},
+  {MAC_MAX_BE,                       offsetof(macSimPib_t, maxBe),                      sizeof(uint8)},
+  {MAC_MAX_FRAME_TOTAL_WAIT_TIME,    offsetof(macSimPib_t, maxFrameTotalWaitTime),      sizeof(uint16)},
+  {MAC_MAX_FRAME_RETRIES,            offsetof(macSimPib_t, maxFrameRetries),            sizeof(uint8)},
+  {MAC_RESPONSE_WAIT_TIME,           offsetof(macSimPib_t, responseWaitTime),           sizeof(uint8)},
+  {MAC_SECURITY_ENABLED,             offsetof(macSimPib_t, securityEnabled),            sizeof(bool)},
+  {MAC_PHY_TRANSMIT_POWER_SIGNED,    offsetof(macSimPib_t, txPower),                    sizeof(int8)},
+  {MAC_LOGICAL_CHANNEL,              offsetof(macSimPib_t, logicalChannel),             sizeof(uint8)},
+  {MAC_EXTENDED_ADDRESS,             offsetof(macSimPib_t, extAddr),                    sizeof(sAddrExt_t)}
+};
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static void macSimPibDefaults(void);
+static const macSimPibTbl_t *macSimPibLookup(uint8 pibAttribute);
+static void macSimDataCnfPost(macMcpsDataReq_t *pData, uint8 status);
+static void macSimDataCnfPosted(void *arg);
+static void macSimIndication(void *arg);
+static void macSimDataInd(const macSimInd_t *pInd);
+static void macSimDataCnf(const macSimInd_t *pInd);
+
+/**************************************************************************************************
+ * @fn          MAC_Init
+ *
+ * @brief       Initialize the MAC and attach this device to the simulated radio channel.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void MAC_Init(void)
+{
+  macSimPibDefaults();
+  osal_memset(macSimPib.extAddr, 0, sizeof(sAddrExt_t));
+  macSimDataPending = 0;
+
+  macSimChanAttach(macSimIndication);
+  macSimChanSetPib(&macSimPib);
+}
+
+/**************************************************************************************************
+ * @fn          MAC_InitDevice / MAC_InitCoord / MAC_InitBeaconDevice / MAC_InitBeaconCoord
+ *
+ * @brief       Feature selection.  The simulated MAC always has the device and non beacon-enabled
+ *              coordinator features; beacon-enabled operation is not modelled.
+ **************************************************************************************************
+ */
+void MAC_InitDevice(void)
+{
+}
+
+void MAC_InitCoord(void)
+{
+}
+
+void MAC_InitBeaconDevice(void)
+{
+}
+
+void MAC_InitBeaconCoord(void)
+{
+}
+
+/**************************************************************************************************
+ * @fn          macTaskInit
+ *
+ * @brief       MAC OSAL task initialization.
+ *
+ * @param       taskId - OSAL task ID of the MAC
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void macTaskInit(uint8 taskId)
+{
+  macTaskId = taskId;
+}
+
+/**************************************************************************************************
+ * @fn          macEventLoop
+ *
+ * @brief       MAC OSAL task event handler.  The simulated MAC does its work in the channel, so
+ *              there is never an event to process.
+ *
+ * @param       taskId - OSAL task ID
+ *              events - pending events
+ *
+ * @return      events not processed
+ **************************************************************************************************
+ */
+uint16 macEventLoop(uint8 taskId, uint16 events)
+{
+  (void)taskId;
+  (void)events;
+
+  return 0;
+}
+
+/**************************************************************************************************
+ * @fn          MAC_MlmeResetReq
+ *
+ * @brief       Reset the MAC.  Pending requests are dropped without confirm.
+ *
+ * @param       setDefaultPib - TRUE to restore the PIB defaults
+ *
+ * @return      MAC_SUCCESS
+ **************************************************************************************************
+ */
+uint8 MAC_MlmeResetReq(bool setDefaultPib)
+{
+  macSimChanReset();
+  macSimDataPending = 0;
+
+  if (setDefaultPib)
+  {
+    macSimPibDefaults();
+  }
+  macSimChanSetPib(&macSimPib);
+
+  return MAC_SUCCESS;
+}
+
+/**************************************************************************************************
+ * @fn          MAC_MlmeSetReq
+ *
+ * @brief       Set a MAC PIB attribute.
+ *
+ * @param       pibAttribute - attribute identifier
+ *              pValue       - new value
+ *
+ * @return      MAC_SUCCESS, MAC_UNSUPPORTED_ATTRIBUTE or MAC_INVALID_PARAMETER
+ **************************************************************************************************
+ */
+uint8 MAC_MlmeSetReq(uint8 pibAttribute, void *pValue)
+{
+  const macSimPibTbl_t *pEntry;
+
+  if (pibAttribute == MAC_BEACON_PAYLOAD)
+  {
+    osal_memcpy(macSimPib.beaconPayload, pValue, macSimPib.beaconPayloadLength);
+  }
+  else if ((pEntry = macSimPibLookup(pibAttribute)) != NULL)
+  {
+    if ((pibAttribute == MAC_BEACON_PAYLOAD_LENGTH) && (*(uint8 *)pValue > MAC_SIM_BEACON_PAYLOAD_MAX))
+    {
+      return MAC_INVALID_PARAMETER;
+    }
+    osal_memcpy((uint8 *)&macSimPib + pEntry->offset, pValue, pEntry->len);
+  }
+  else
+  {
+    return MAC_UNSUPPORTED_ATTRIBUTE;
+  }
+
+  macSimChanSetPib(&macSimPib);
+  return MAC_SUCCESS;
+}
+
+/**************************************************************************************************
+ * @fn          MAC_MlmeGetReq
+ *
+ * @brief       Read a MAC PIB attribute.
+ *
+ * @param       pibAttribute - attribute identifier
+ *              pValue       - output
+ *
+ * @return      MAC_SUCCESS or MAC_UNSUPPORTED_ATTRIBUTE
+ **************************************************************************************************
+ */
+uint8 MAC_MlmeGetReq(uint8 pibAttribute, void *pValue)
+{
+  const macSimPibTbl_t *pEntry;
+
+  if (pibAttribute == MAC_BEACON_PAYLOAD)
+  {
+    osal_memcpy(pValue, macSimPib.beaconPayload, macSimPib.beaconPayloadLength);
+  }
+  else if ((pEntry = macSimPibLookup(pibAttribute)) != NULL)
+  {
+    osal_memcpy(pValue, (uint8 *)&macSimPib + pEntry->offset, pEntry->len);
+  }
+  else
+  {
+    return MAC_UNSUPPORTED_ATTRIBUTE;
+  }
+
+  return MAC_SUCCESS;
+}
+
+/**************************************************************************************************
+ * @fn          MAC_MlmeScanReq
+ *
+ * @brief       Start an energy detect, active, passive or orphan scan.  The result buffer must
+ *              stay valid until MAC_MLME_SCAN_CNF.
+ *
+ * @param       pData - scan request
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void MAC_MlmeScanReq(macMlmeScanReq_t *pData)
+{
+  if (pData->scanType == MAC_SCAN_ED)
+  {
+    macSimScanEnergy = pData->result.pEnergyDetect;
+    macSimScanPanDesc = NULL;
+  }
+  else
+  {
+    macSimScanEnergy = NULL;
+    macSimScanPanDesc = pData->result.pPanDescriptor;
+  }
+
+  macSimChanScan(pData->scanType, pData->scanChannels, pData->scanDuration,
+                 (macSimScanPanDesc != NULL) ? pData->maxResults : 0);
+}
+
+/**************************************************************************************************
+ * @fn          MAC_MlmeStartReq
+ *
+ * @brief       Start a network.  Only non beacon-enabled PAN coordinators are supported.  With
+ *              coordRealignment a started coordinator tells its devices first, on the channel
+ *              it leaves.
+ *
+ * @param       pData - start request
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void MAC_MlmeStartReq(macMlmeStartReq_t *pData)
+{
+  macSimPib.beaconOrder = pData->beaconOrder;
+  macSimPib.superframeOrder = pData->superframeOrder;
+  macSimPib.panCoordinator = pData->panCoordinator;
+  if (pData->coordRealignment)
+  {
+    macSimChanRealign(pData->panId, pData->logicalChannel);
+  }
+  if (pData->panCoordinator)
+  {
+    macSimPib.panId = pData->panId;
+    macSimPib.logicalChannel = pData->logicalChannel;
+  }
+  macSimChanSetPib(&macSimPib);
+
+  macSimChanStart(macSimPib.panId, macSimPib.logicalChannel);
+}
+
+/**************************************************************************************************
+ * @fn          MAC_MlmeAssociateReq
+ *
+ * @brief       Associate with a coordinator.  Sets the channel, PAN ID and coordinator address
+ *              in the PIB like the TIMAC does.
+ *
+ * @param       pData - associate request
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void MAC_MlmeAssociateReq(macMlmeAssociateReq_t *pData)
+{
+  macSimPib.logicalChannel = pData->logicalChannel;
+  macSimPib.panId = pData->coordPanId;
+  if (pData->coordAddress.addrMode == SADDR_MODE_EXT)
+  {
+    sAddrExtCpy(macSimPib.coordExtAddr, pData->coordAddress.addr.extAddr);
+  }
+  else
+  {
+    macSimPib.coordShortAddr = pData->coordAddress.addr.shortAddr;
+  }
+  macSimChanSetPib(&macSimPib);
+
+  macSimChanAssociate(pData->logicalChannel, &pData->coordAddress, pData->coordPanId,
+                      pData->capabilityInformation);
+}
+
+/**************************************************************************************************
+ * @fn          MAC_MlmeAssociateRsp
+ *
+ * @brief       Answer an association request.  The response is held until the device polls.
+ *
+ * @param       pData - associate response
+ *
+ * @return      MAC_SUCCESS
+ **************************************************************************************************
+ */
+uint8 MAC_MlmeAssociateRsp(macMlmeAssociateRsp_t *pData)
+{
+  macSimChanAssociateRsp(pData->deviceAddress, pData->assocShortAddress, pData->status);
+
+  return MAC_SUCCESS;
+}
+
+/**************************************************************************************************
+ * @fn          MAC_MlmeOrphanRsp
+ *
+ * @brief       Answer an orphan notification.  A member is sent the coordinator realignment
+ *              command; MAC_MLME_COMM_STATUS_IND tells how it went.
+ *
+ * @param       pData - orphan response
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void MAC_MlmeOrphanRsp(macMlmeOrphanRsp_t *pData)
+{
+  macSimChanOrphanRsp(pData->orphanAddress, pData->shortAddress, pData->associatedMember);
+}
+
+/**************************************************************************************************
+ * @fn          MAC_MlmePollReq
+ *
+ * @brief       Request pending data from the coordinator.
+ *
+ * @param       pData - poll request
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void MAC_MlmePollReq(macMlmePollReq_t *pData)
+{
+  macSimChanPoll(&pData->coordAddress, pData->coordPanId);
+}
+
+/**************************************************************************************************
+ * @fn          MAC_McpsDataAlloc
+ *
+ * @brief       Allocate a data request with room for the MAC header in front of the MSDU.
+ *
+ * @param       len           - MSDU length
+ *              securityLevel - security level
+ *              keyIdMode     - key identifier mode
+ *
+ * @return      data request, NULL if out of memory or 'len' is too long
+ **************************************************************************************************
+ */
+macMcpsDataReq_t *MAC_McpsDataAlloc(uint8 len, uint8 securityLevel, uint8 keyIdMode)
+{
+  macMcpsDataReq_t *pData;
+
+  if (len > MAC_MAX_FRAME_SIZE)
+  {
+    return NULL;
+  }
+
+  pData = (macMcpsDataReq_t *)osal_msg_allocate(sizeof(macMcpsDataReq_t) + MAC_DATA_OFFSET + len);
+  if (pData != NULL)
+  {
+    osal_memset(pData, 0, sizeof(macMcpsDataReq_t));
+    pData->msdu.p = (uint8 *)(pData + 1) + MAC_DATA_OFFSET;
+    pData->msdu.len = len;
+    pData->sec.securityLevel = securityLevel;
+    pData->sec.keyIdMode = keyIdMode;
+  }
+
+  return pData;
+}
+
+/**************************************************************************************************
+ * @fn          MAC_McpsDataReq
+ *
+ * @brief       Send a data frame.  The buffer comes back in the MAC_MCPS_DATA_CNF.
+ *
+ * @param       pData - data request from MAC_McpsDataAlloc()
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void MAC_McpsDataReq(macMcpsDataReq_t *pData)
+{
+  if (pData->msdu.len > MAC_SIM_MAX_MSDU)
+  {
+    macSimDataCnfPost(pData, MAC_FRAME_TOO_LONG);
+  }
+  else if (macSimDataPending >= macCfg.txDataMax)
+  {
+    macSimDataCnfPost(pData, MAC_TRANSACTION_OVERFLOW);
+  }
+  else
+  {
+    macSimDataPending++;
+    macSimChanDataReq(pData);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          MAC_McpsPurgeReq
+ *
+ * @brief       Purging queued frames is not modelled; the confirm reports an invalid handle.
+ *
+ * @param       msduHandle - handle of the frame to purge
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void MAC_McpsPurgeReq(uint8 msduHandle)
+{
+  macMcpsPurgeCnf_t purgeCnf;
+
+  purgeCnf.hdr.event = MAC_MCPS_PURGE_CNF;
+  purgeCnf.hdr.status = MAC_INVALID_HANDLE;
+  purgeCnf.msduHandle = msduHandle;
+  MAC_CbackEvent((macCbackEvent_t *)&purgeCnf);
+}
+
+/**************************************************************************************************
+ * @fn          MAC_PwrOffReq / MAC_PwrOnReq
+ *
+ * @brief       The simulated radio draws no power while idle, so powering it down always
+ *              succeeds and there is nothing to do on power up.
+ **************************************************************************************************
+ */
+uint8 MAC_PwrOffReq(uint8 mode)
+{
+  (void)mode;
+
+  return MAC_SUCCESS;
+}
+
+void MAC_PwrOnReq(void)
+{
+}
+
+/**************************************************************************************************
+ * @fn          MAC_RandomByte
+ *
+ * @brief       Random byte from the simulation's generator.
+ *
+ * @param       none
+ *
+ * @return      random byte
+ **************************************************************************************************
+ */
+uint8 MAC_RandomByte(void)
+{
+  return MAC_RADIO_RANDOM_BYTE();
+}
+
+/**************************************************************************************************
+ * @fn          mac_msg_deallocate
+ *
+ * @brief       Free a buffer the MAC handed to the application and clear the pointer.
+ *
+ * @param       msg_ptr - pointer to the buffer pointer
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void mac_msg_deallocate(uint8 **msg_ptr)
+{
+  if (*msg_ptr != NULL)
+  {
+    (void)osal_msg_deallocate(*msg_ptr);
+    *msg_ptr = NULL;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          macSimPibDefaults
+ *
+ * @brief       Restore the PIB defaults; the extended address is kept.
+ **************************************************************************************************
+ */
+static void macSimPibDefaults(void)
+{
+  sAddrExt_t extAddr;
+
+  sAddrExtCpy(extAddr, macSimPib.extAddr);
+  osal_memset(&macSimPib, 0, sizeof(macSimPib));
+  sAddrExtCpy(macSimPib.extAddr, extAddr);
+
+  macSimPib.shortAddr = MAC_SHORT_ADDR_NONE;
+  macSimPib.panId = 0xFFFF;
+  macSimPib.coordShortAddr = 0;
+  macSimPib.logicalChannel = MAC_SIM_DEFAULT_CHANNEL;
+  macSimPib.maxFrameRetries = MAC_SIM_DEFAULT_MAX_FRAME_RETRIES;
+  macSimPib.maxCsmaBackoffs = MAC_SIM_DEFAULT_MAX_CSMA_BACKOFFS;
+  macSimPib.minBe = MAC_SIM_DEFAULT_MIN_BE;
+  macSimPib.maxBe = MAC_SIM_DEFAULT_MAX_BE;
+  macSimPib.responseWaitTime = MAC_SIM_DEFAULT_RESPONSE_WAIT_TIME;
+  macSimPib.transactionPersistenceTime = MAC_SIM_DEFAULT_PERSISTENCE_TIME;
+  macSimPib.maxFrameTotalWaitTime = MAC_SIM_DEFAULT_TOTAL_WAIT_TIME;
+  macSimPib.beaconOrder = MAC_SIM_DEFAULT_ORDER;
+  macSimPib.superframeOrder = MAC_SIM_DEFAULT_ORDER;
+  macSimPib.dsn = MAC_RADIO_RANDOM_BYTE();
+}
+
+/**************************************************************************************************
+ * @fn          macSimPibLookup
+ *
+ * @brief       Find the table entry of a PIB attribute.
+ **************************************************************************************************
+ */
+static const macSimPibTbl_t *macSimPibLookup(uint8 pibAttribute)
+{
+  uint8 i;
+
+  for (i = 0; i < sizeof(macSimPibTbl) / sizeof(macSimPibTbl[0]); i++)
+  {
+    if (macSimPibTbl[i].attr == pibAttribute)
+    {
+      return &macSimPibTbl[i];
+    }
+  }
+
+  return NULL;
+}
+
+/**************************************************************************************************
+ * @fn          macSimDataCnfPost / macSimDataCnfPosted
+ *
+ * @brief       Reject a data request.  The confirm is delivered from a later event, never from
+ *              within MAC_McpsDataReq().
+ **************************************************************************************************
+ */
+static void macSimDataCnfPost(macMcpsDataReq_t *pData, uint8 status)
+{
+  pData->hdr.event = MAC_MCPS_DATA_CNF;
+  pData->hdr.status = status;
+  halSimPost(0, macSimDataCnfPosted, pData);
+}
+
+static void macSimDataCnfPosted(void *arg)
+{
+  macMcpsDataReq_t *pData = arg;
+  macSimInd_t ind;
+
+  osal_memset(&ind, 0, sizeof(ind));
+  ind.event = MAC_MCPS_DATA_CNF;
+  ind.status = pData->hdr.status;
+  ind.msduHandle = pData->mac.msduHandle;
+  ind.cookie = pData;
+
+  /* Not counted in macSimDataPending */
+  macSimDataPending++;
+  macSimDataCnf(&ind);
+}
+
+/**************************************************************************************************
+ * @fn          macSimIndication
+ *
+ * @brief       Handler attached to the radio channel.
+ *
+ * @param       arg - macSimInd_t *
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+static void macSimIndication(void *arg)
+{
+  macSimInd_t *pInd = arg;
+  macCbackEvent_t evt;
+
+  osal_memset(&evt, 0, sizeof(evt));
+  evt.hdr.event = pInd->event;
+  evt.hdr.status = pInd->status;
+
+  switch (pInd->event)
+  {
+    case MAC_MCPS_DATA_IND:
+      macSimDataInd(pInd);
+      return;
+
+    case MAC_MCPS_DATA_CNF:
+      macSimDataCnf(pInd);
+      return;
+
+    case MAC_SIM_POLL_CHECK:
+      pInd->pending = MAC_CbackCheckPending();
+      if (macCfg.appPendingQueue)
+      {
+        /* The requester listens for a frame only if the pending bit was set */
+        evt.hdr.event = MAC_MLME_POLL_IND;
+        evt.pollInd.srcAddr = pInd->srcAddr;
+        evt.pollInd.srcPanId = pInd->srcPanId;
+        evt.pollInd.noRsp = (pInd->pending == 0);
+        break;
+      }
+      return;
+
+    case MAC_SIM_REALIGN:
+      macSimPib.panId = pInd->dstPanId;
+      macSimPib.logicalChannel = pInd->logicalChannel;
+      macSimChanSetPib(&macSimPib);
+      return;
+
+    case MAC_MLME_SCAN_CNF:
+      evt.scanCnf.scanType = pInd->scanType;
+      evt.scanCnf.unscannedChannels = pInd->unscannedChannels;
+      evt.scanCnf.resultListSize = pInd->resultListSize;
+      if (pInd->scanType == MAC_SCAN_ED)
+      {
+        if (macSimScanEnergy != NULL)
+        {
+          osal_memcpy(macSimScanEnergy, pInd->pEnergyDetect, pInd->resultListSize);
+        }
+        evt.scanCnf.result.pEnergyDetect = macSimScanEnergy;
+      }
+      else if (pInd->scanType == MAC_SCAN_ORPHAN)
+      {
+        /* The coordinator realignment command the scan ended with */
+        if (pInd->status == MAC_SUCCESS)
+        {
+          macSimPib.panId = pInd->dstPanId;
+          macSimPib.logicalChannel = pInd->logicalChannel;
+          macSimPib.coordShortAddr = pInd->srcAddr.addr.shortAddr;
+          macSimPib.shortAddr = pInd->shortAddr;
+          macSimChanSetPib(&macSimPib);
+        }
+      }
+      else
+      {
+        if (macSimScanPanDesc != NULL)
+        {
+          osal_memcpy(macSimScanPanDesc, pInd->pPanDesc, pInd->resultListSize * sizeof(macPanDesc_t));
+        }
+        evt.scanCnf.result.pPanDescriptor = macSimScanPanDesc;
+      }
+      break;
+
+    case MAC_MLME_ASSOCIATE_IND:
+      sAddrExtCpy(evt.associateInd.deviceAddress, pInd->deviceAddress);
+      evt.associateInd.capabilityInformation = pInd->capability;
+      break;
+
+    case MAC_MLME_ORPHAN_IND:
+      sAddrExtCpy(evt.orphanInd.orphanAddress, pInd->deviceAddress);
+      break;
+
+    case MAC_MLME_ASSOCIATE_CNF:
+      evt.associateCnf.assocShortAddress = pInd->shortAddr;
+      if (pInd->status == MAC_SUCCESS)
+      {
+        macSimPib.shortAddr = pInd->shortAddr;
+        macSimChanSetPib(&macSimPib);
+      }
+      break;
+
+    case MAC_MLME_COMM_STATUS_IND:
+      evt.commStatusInd.srcAddr = pInd->srcAddr;
+      evt.commStatusInd.dstAddr = pInd->dstAddr;
+      evt.commStatusInd.panId = pInd->srcPanId;
+      break;
+
+    default:
+      break;
+  }
+
+  MAC_CbackEvent(&evt);
+}
+
+/**************************************************************************************************
+ * @fn          macSimDataInd
+ *
+ * @brief       Received data frame.  Like the TIMAC, the indication is an OSAL message the
+ *              application may forward and must free with mac_msg_deallocate().
+ **************************************************************************************************
+ */
+static void macSimDataInd(const macSimInd_t *pInd)
+{
+  macMcpsDataInd_t *pData;
+
+  pData = (macMcpsDataInd_t *)osal_msg_allocate(sizeof(macMcpsDataInd_t) + macCfg.dataIndOffset + pInd->msduLen);
+  if (pData == NULL)
+  {
+    return;
+  }
+
+  osal_memset(pData, 0, sizeof(macMcpsDataInd_t));
+  pData->hdr.event = MAC_MCPS_DATA_IND;
+  pData->hdr.status = MAC_SUCCESS;
+  pData->msdu.p = (uint8 *)(pData + 1) + macCfg.dataIndOffset;
+  pData->msdu.len = pInd->msduLen;
+  osal_memcpy(pData->msdu.p, pInd->pMsdu, pInd->msduLen);
+
+  pData->mac.srcAddr = pInd->srcAddr;
+  pData->mac.dstAddr = pInd->dstAddr;
+  pData->mac.timestamp = macMcuPrecisionCount();
+  pData->mac.srcPanId = pInd->srcPanId;
+  pData->mac.dstPanId = pInd->dstPanId;
+  pData->mac.mpduLinkQuality = pInd->lqi;
+  pData->mac.rssi = pInd->rssi;
+  pData->mac.dsn = pInd->dsn;
+
+  MAC_CbackEvent((macCbackEvent_t *)pData);
+}
+
+/**************************************************************************************************
+ * @fn          macSimDataCnf
+ *
+ * @brief       Outcome of a data request.  The request buffer goes back to the application
+ *              unless it asked for no confirm.
+ **************************************************************************************************
+ */
+static void macSimDataCnf(const macSimInd_t *pInd)
+{
+  macMcpsDataReq_t *pData = pInd->cookie;
+  macCbackEvent_t evt;
+
+  if (macSimDataPending > 0)
+  {
+    macSimDataPending--;
+  }
+
+  if (pData->mac.txOptions & MAC_TXOPTION_NO_CNF)
+  {
+    mac_msg_deallocate((uint8 **)&pData);
+    return;
+  }
+
+  osal_memset(&evt, 0, sizeof(evt));
+  evt.dataCnf.hdr.event = MAC_MCPS_DATA_CNF;
+  evt.dataCnf.hdr.status = pInd->status;
+  evt.dataCnf.msduHandle = pInd->msduHandle;
+  evt.dataCnf.pDataReq = pData;
+  evt.dataCnf.timestamp = macMcuPrecisionCount();
+  evt.dataCnf.retries = pInd->retries;
+  evt.dataCnf.mpduLinkQuality = pInd->lqi;
+  evt.dataCnf.rssi = pInd->rssi;
+
+  MAC_CbackEvent(&evt);
+}
+
+/**************************************************************************************************
+ */
@@ -0,0 +1,171 @@
+/**************************************************************************************************
+  Filename:       mac_sim.h
+
+  Description:    Simulated 802.15.4 MAC for the POSIX host build.
+
+                  mac_sim.c implements the MAC API (mac_api.h) inside every device image and
+                  forwards requests to the shared radio channel in mac_sim_chan.c, which runs in
+                  the simulation kernel.  The channel models unslotted CSMA-CA, acknowledgements
+                  and retries, link budget and frame loss between placed devices, scans,
+                  association, orphan scans and coordinator realignment, interferers on the
+                  channels and the indirect (polled) transaction queue of a coordinator, and
+                  reports back to the image through the indication handler it attached.
+
+                  Only non beacon-enabled operation without security is modelled.
+**************************************************************************************************/
+
+#ifndef MAC_SIM_H
+#define MAC_SIM_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "hal_types.h"
+#include "hal_sim.h"
+#include "mac_api.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Channels 11 to 26 of the 2.4 GHz band */
+#define MAC_SIM_CHAN_FIRST              11
+#define MAC_SIM_CHAN_NUM                16
+
+/* Largest MSDU of a data frame with short addresses (aMaxMACSafePayloadSize) */
+#define MAC_SIM_MAX_MSDU                102
+
+#define MAC_SIM_BEACON_PAYLOAD_MAX      16
+#define MAC_SIM_MAX_PAN_DESC            18
+
+/* Channel to image only: a data request the transaction queue has nothing for arrived at this
+ * coordinator.  The image fills in 'pending' with MAC_CbackCheckPending(), the number of frames
+ * its application holds, which sets the frame pending bit of the acknowledgement, and with
+ * macCfg.appPendingQueue tells its application in a MAC_MLME_POLL_IND.
+ */
+#define MAC_SIM_POLL_CHECK              0xF0
+
+/* Channel to image only: the coordinator realignment command of the PAN coordinator was
+ * received; the device takes the PAN in 'dstPanId' and the channel in 'logicalChannel'.
+ */
+#define MAC_SIM_REALIGN                 0xF1
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Typedefs
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* MAC PIB attributes the simulation supports */
+typedef struct
+{
+  sAddrExt_t  extAddr;
+  uint16      shortAddr;
+  uint16      panId;
+  uint16      coordShortAddr;
+  sAddrExt_t  coordExtAddr;
+  uint8       logicalChannel;
+  int8        txPower;                    /* dBm */
+  bool        rxOnWhenIdle;
+  bool        assocPermit;
+  bool        panCoordinator;
+  bool        associatedPanCoord;
+  bool        autoRequest;
+  bool        securityEnabled;
+  uint8       maxFrameRetries;
+  uint8       maxCsmaBackoffs;
+  uint8       minBe;
+  uint8       maxBe;
+  uint8       responseWaitTime;           /* aBaseSuperframeDuration periods */
+  uint16      transactionPersistenceTime; /* aBaseSuperframeDuration periods */
+  uint16      maxFrameTotalWaitTime;      /* symbols */
+  uint8       dsn;
+  uint8       beaconOrder;
+  uint8       superframeOrder;
+  uint8       beaconPayloadLength;
+  uint8       beaconPayload[MAC_SIM_BEACON_PAYLOAD_MAX];
+} macSimPib_t;
+
+/* Indication passed from the channel to the attached handler of an image */
+typedef struct
+{
+  uint8           event;            /* MAC_MLME_xxx, MAC_MCPS_xxx or MAC_SIM_xxx */
+  uint8           status;
+
+  /* MAC_MLME_SCAN_CNF */
+  uint8           scanType;
+  uint8           resultListSize;
+  uint32          unscannedChannels;
+  const uint8     *pEnergyDetect;
+  const macPanDesc_t *pPanDesc;
+
+  /* Frame related indications */
+  sAddr_t         srcAddr;
+  sAddr_t         dstAddr;
+  uint16          srcPanId;
+  uint16          dstPanId;
+  int8            rssi;
+  uint8           lqi;
+  uint8           dsn;
+  const uint8     *pMsdu;
+  uint8           msduLen;
+
+  /* Confirms of data requests */
+  void            *cookie;
+  uint8           msduHandle;
+  uint8           retries;
+
+  /* MAC_MLME_ASSOCIATE_IND / _CNF and MAC_MLME_COMM_STATUS_IND */
+  sAddrExt_t      deviceAddress;
+  uint16          shortAddr;
+  uint8           capability;
+
+  /* MAC_SIM_POLL_CHECK reply */
+  uint8           pending;
+
+  /* MAC_SIM_REALIGN, and MAC_MLME_SCAN_CNF of an orphan scan with the PAN in 'dstPanId', the
+   * coordinator in 'srcAddr' and the short address of the device in 'shortAddr' */
+  uint8           logicalChannel;
+} macSimInd_t;
+
+/* ------------------------------------------------------------------------------------------------
+ *                            Channel services used by device images
+ * ------------------------------------------------------------------------------------------------
+ */
+extern void macSimChanAttach(halSimHandler_t indication);
+extern void macSimChanReset(void);
+extern void macSimChanSetPib(const macSimPib_t *pPib);
+extern void macSimChanScan(uint8 scanType, uint32 scanChannels, uint8 scanDuration, uint8 maxResults);
+extern void macSimChanStart(uint16 panId, uint8 logicalChannel);
+extern void macSimChanRealign(uint16 panId, uint8 logicalChannel);
+extern void macSimChanOrphanRsp(const sAddrExt_t orphanAddress, uint16 shortAddr, bool associatedMember);
+extern void macSimChanAssociate(uint8 logicalChannel, const sAddr_t *pCoordAddr, uint16 coordPanId,
+                                uint8 capability);
+extern void macSimChanAssociateRsp(const sAddrExt_t deviceAddress, uint16 shortAddr, uint8 status);
+extern void macSimChanDataReq(const macMcpsDataReq_t *pReq);
+extern void macSimChanPoll(const sAddr_t *pCoordAddr, uint16 coordPanId);
+
+/* ------------------------------------------------------------------------------------------------
+ *                              Channel services used by the host
+ * ------------------------------------------------------------------------------------------------
+ */
+extern void macSimChanInit(uint16 maxDevs);
+extern void macSimChanPlace(uint16 dev, double x, double y);
+extern void macSimChanNoise(uint8 logicalChannel, int8 noiseDbm);
+extern void macSimChanInterf(uint8 logicalChannel, int8 levelDbm, uint8 dutyPct);
+extern uint8 macSimChanOf(uint16 dev);
+extern uint16 macSimChanShortOf(uint16 dev);
+extern void macSimChanPrintStats(void);
+extern void macSimChanRadioTime(uint16 dev, halSimTime_t *pRx, halSimTime_t *pTx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
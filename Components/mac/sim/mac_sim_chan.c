@@ -0,0 +1,1954 @@
+/**************************************************************************************************
+  Filename:       mac_sim_chan.c
+
+  Description:    Shared 802.15.4 radio channel of the POSIX host simulation.
+
+                  Runs in the simulation kernel, not in a device image.  Every device has a radio
+                  record holding a copy of its MAC PIB, its position and its transmit queue.
+                  Frames go through unslotted CSMA-CA (macMinBE..macMaxBE, macMaxCSMABackoffs),
+                  occupy the channel for their airtime and are received with a probability given
+                  by a log-distance path loss model with log-normal fading.  Acknowledgements are
+                  lost independently of the frame, so a retry can deliver a duplicate just like
+                  on air.
+
+                  The channel is a single collision domain per logical channel with ideal CCA:
+                  a transmission starts only when no other one is on the air, so frames never
+                  overlap and there is no collision or capture model.
+
+                  A logical channel may carry an interferer, a Wi-Fi network say, that is on
+                  for a share of the time in bursts of MAC_SIM_BURST_US.  Each CCA and
+                  reception sees it on with that probability, an energy detect reading, the
+                  peak over the scan of the channel, if any burst of the scan time is on: it
+                  raises the energy read, makes CCA fail when it is above the CCA threshold
+                  and lowers the margin of a frame to its signal to interference ratio.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hal_types.h"
+#include "hal_sim.h"
+#include "mac_sim.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* PHY timing, 2.4 GHz O-QPSK */
+#define MAC_SIM_SYMBOL_US               16
+#define MAC_SIM_BYTE_US                 32
+#define MAC_SIM_BACKOFF_US              320     /* aUnitBackoffPeriod */
+#define MAC_SIM_CCA_US                  128     /* 8 symbols */
+#define MAC_SIM_TURNAROUND_US           192     /* aTurnaroundTime */
+#define MAC_SIM_PHY_HDR_LEN             6       /* preamble, SFD, PHR */
+#define MAC_SIM_FCS_LEN                 2
+#define MAC_SIM_ACK_LEN                 5
+#define MAC_SIM_ACK_US                  ((MAC_SIM_PHY_HDR_LEN + MAC_SIM_ACK_LEN) * MAC_SIM_BYTE_US)
+#define MAC_SIM_ACK_WAIT_US             (54 * MAC_SIM_SYMBOL_US)      /* macAckWaitDuration */
+#define MAC_SIM_BASE_SUPERFRAME_US      (960 * MAC_SIM_SYMBOL_US)     /* aBaseSuperframeDuration */
+
+/* MAC header plus command payload of each frame type */
+#define MAC_SIM_MHR_SHORT               9       /* FCF, DSN, PAN ID, short dst and src */
+#define MAC_SIM_MHR_EXT_SRC             17      /* short dst, PAN ID 0xFFFF, extended src */
+#define MAC_SIM_MHR_EXT_EXT             21      /* extended dst and src */
+#define MAC_SIM_ASSOC_REQ_PAYLOAD       2
+#define MAC_SIM_DATA_REQ_PAYLOAD        1
+#define MAC_SIM_ASSOC_RSP_PAYLOAD       4
+#define MAC_SIM_BEACON_REQ_LEN          10
+#define MAC_SIM_BEACON_LEN              13
+#define MAC_SIM_REALIGN_PAYLOAD         8
+#define MAC_SIM_REALIGN_LEN             (MAC_SIM_MHR_EXT_SRC + MAC_SIM_REALIGN_PAYLOAD + MAC_SIM_FCS_LEN)
+#define MAC_SIM_ORPHAN_LEN              (MAC_SIM_MHR_EXT_SRC + 1 + MAC_SIM_FCS_LEN)
+#define MAC_SIM_ORPHAN_RSP_LEN          (MAC_SIM_MHR_EXT_EXT + MAC_SIM_REALIGN_PAYLOAD + MAC_SIM_FCS_LEN)
+
+/* Link budget */
+#define MAC_SIM_PATH_LOSS_1M            40.0    /* dB at 1 m, 2.4 GHz */
+#define MAC_SIM_PATH_LOSS_SLOPE         25.0    /* dB per decade, exponent 2.5 */
+#define MAC_SIM_FADING_DB               2.0     /* sigma of the per frame fading */
+#define MAC_SIM_SENSITIVITY_DBM         (-97)
+#define MAC_SIM_LQI_RANGE_DB            60      /* margin mapped onto LQI 0..255 */
+#define MAC_SIM_PER_STEEPNESS           1.5     /* per dB of margin, 20 byte frame */
+#define MAC_SIM_CCA_THRESHOLD_DBM       (-77)   /* energy above which CCA reports busy */
+#define MAC_SIM_SIR_MIN_DB              5.0     /* O-QPSK, signal over interference */
+#define MAC_SIM_BURST_US                10000   /* interferer bursts, as an energy detect sees */
+
+/* Frame types */
+#define MAC_SIM_FRAME_DATA              0
+#define MAC_SIM_FRAME_ASSOC_REQ         1
+#define MAC_SIM_FRAME_DATA_REQ          2
+#define MAC_SIM_FRAME_ASSOC_RSP         3
+
+/* ------------------------------------------------------------------------------------------------
+ *                                            Macros
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* The kernel does not link the OSAL based address services */
+#define macSimExtCpy(dst, src)          memcpy((dst), (src), SADDR_EXT_LEN)
+#define macSimExtEq(a, b)               (memcmp((a), (b), SADDR_EXT_LEN) == 0)
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Typedefs
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Transaction held by a coordinator until the addressed device polls for it */
+typedef struct macSimPend_s
+{
+  struct macSimPend_s *pNext;
+  uint32      id;
+  uint8       kind;
+  sAddr_t     dstAddr;
+  uint16      dstPanId;
+  uint8       msduHandle;
+  void        *cookie;
+  uint16      shortAddr;        /* association response */
+  uint8       status;           /* association response */
+  uint8       len;
+  uint8       msdu[MAC_SIM_MAX_MSDU];
+} macSimPend_t;
+
+/* Frame in a transmit queue */
+typedef struct macSimTx_s
+{
+  struct macSimTx_s *pNext;
+  uint16      src;
+  uint32      epoch;            /* radio epoch at queuing, stale after a MAC reset */
+  uint8       kind;
+  bool        indirect;         /* sent from the transaction queue */
+  uint16      polledBy;         /* device that requested an indirect frame */
+  sAddr_t     srcAddr;
+  uint16      srcPanId;
+  sAddr_t     dstAddr;
+  uint16      dstPanId;
+  uint8       channel;
+  uint8       dsn;
+  bool        ackReq;
+  uint8       maxRetries;
+  uint8       retries;
+  uint8       nb;
+  uint8       be;
+  uint8       status;
+  int8        rssi;
+  uint8       lqi;
+  uint8       msduHandle;
+  void        *cookie;
+  uint16      shortAddr;        /* association response */
+  uint8       assocStatus;      /* association response */
+  uint8       capability;       /* association request */
+  uint8       frameLen;         /* MPDU length */
+  uint8       len;
+  uint8       msdu[MAC_SIM_MAX_MSDU];
+  halSimTime_t started;         /* first backoff at the head of the queue */
+  halSimTime_t airtime;         /* of all its attempts */
+} macSimTx_t;
+
+typedef struct
+{
+  uint32      frames;
+  uint32      retries;
+  uint32      accessFailures;
+  uint32      noAcks;
+  uint32      delivered;
+  uint32      lost;
+  uint32      acksLost;
+  uint32      expired;
+  halSimTime_t airtime;
+  halSimTime_t rxTime;          /* receiver on: backoffs, CCA, ACK waits, receive windows, scans */
+} macSimStats_t;
+
+/* Per device radio */
+typedef struct
+{
+  macSimPib_t     pib;
+  halSimHandler_t indication;
+  double          x;
+  double          y;
+  uint32          epoch;
+  bool            started;      /* coordinator started with MAC_MlmeStartReq() */
+  bool            scanning;
+  uint8           scanType;
+  uint8           scanMaxResults;
+  uint32          scanChannels;
+  uint32          scanPerChannel;  /* us */
+  uint32          scanGen;         /* the events of an earlier scan are stale */
+  uint8           orphanChannel;   /* orphan scan: channel of the last notification */
+  macSimTx_t      *pTxHead;
+  macSimTx_t      *pTxTail;
+  macSimPend_t    *pPend;
+  halSimTime_t    rxUntil;      /* receiver kept on for a requested frame */
+  halSimTime_t    rxSince;
+  uint32          waitGen;
+  bool            waitAssoc;    /* the requested frame is an association response */
+  sAddr_t         assocCoord;
+  uint16          assocPanId;
+  uint8           dsn;
+  macSimStats_t   stats;
+} macSimRadio_t;
+
+/* Interferer on a logical channel */
+typedef struct
+{
+  int8        levelDbm;
+  uint8       dutyPct;          /* share of the time it is on, 0 for none */
+} macSimInterf_t;
+
+/* Indication delivered from a later kernel event */
+typedef struct
+{
+  uint32      epoch;
+  macSimInd_t ind;
+} macSimDeferred_t;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static macSimRadio_t  *macSimRadios;
+static uint16         macSimNumRadios;
+static halSimTime_t   macSimBusyUntil[MAC_SIM_CHAN_NUM];
+static int8           macSimNoise[MAC_SIM_CHAN_NUM];
+static macSimInterf_t macSimInterf[MAC_SIM_CHAN_NUM];
+static uint32         macSimPendId;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static macSimRadio_t *macSimSelf(void);
+static void   macSimIndicate(uint16 dev, macSimInd_t *pInd);
+static void   macSimDefer(uint16 dev, uint32 delayUs, const macSimInd_t *pInd);
+static void   macSimDeferredEvt(uint16 dev, void *arg);
+static double macSimUniform(void);
+static double macSimGauss(void);
+static bool   macSimLink(uint16 from, uint16 to, uint8 frameLen, int8 *pRssi, uint8 *pLqi);
+static uint32 macSimAirtime(uint8 frameLen);
+static uint8  macSimChanIdx(uint8 logicalChannel);
+static bool   macSimInterfOn(uint8 idx);
+static bool   macSimAddrMatch(const sAddr_t *pAddr, const macSimPib_t *pPib);
+static macSimTx_t *macSimTxAlloc(uint16 src, uint8 kind);
+static void   macSimTxQueue(macSimTx_t *pTx);
+static void   macSimTxStart(macSimTx_t *pTx);
+static void   macSimTxBackoff(macSimTx_t *pTx, uint32 delayUs);
+static void   macSimTxRetire(macSimTx_t *pTx);
+static bool   macSimTxStale(const macSimTx_t *pTx);
+static void   macSimTxCca(uint16 dev, void *arg);
+static void   macSimTxEnd(uint16 dev, void *arg);
+static void   macSimTxConfirm(uint16 dev, void *arg);
+static uint16 macSimRxFind(const macSimTx_t *pTx);
+static bool   macSimRxFrame(macSimTx_t *pTx, uint16 dst);
+static void   macSimWaitStart(uint16 dev, uint32 durationUs);
+static void   macSimWaitEnd(uint16 dev);
+static void   macSimWaitExpire(uint16 dev, void *arg);
+static void   macSimAssocPoll(uint16 dev, void *arg);
+static void   macSimPendAdd(macSimPend_t *pPend);
+static void   macSimPendExpire(uint16 dev, void *arg);
+static void   macSimScanDone(uint16 dev, void *arg);
+static void   macSimOrphanNext(uint16 dev, void *arg);
+static void   macSimFlush(macSimRadio_t *pRadio);
+
+/**************************************************************************************************
+ * @fn          macSimChanInit
+ *
+ * @brief       Create the radio records.  Call after halSimInit(), the noise floor of each
+ *              channel is drawn from the simulation's random numbers.
+ *
+ * @param       maxDevs - number of devices
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void macSimChanInit(uint16 maxDevs)
+{
+  uint8 i;
+
+  macSimRadios = calloc(maxDevs, sizeof(macSimRadio_t));
+  if (macSimRadios == NULL)
+  {
+    fprintf(stderr, "sim: out of memory\n");
+    exit(1);
+  }
+  macSimNumRadios = maxDevs;
+
+  for (i = 0; i < MAC_SIM_CHAN_NUM; i++)
+  {
+    macSimBusyUntil[i] = 0;
+    macSimNoise[i] = (int8)(-100 + (int)(halSimRand() % 8));
+    macSimInterf[i].dutyPct = 0;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          macSimChanPlace
+ *
+ * @brief       Set the position of a device.
+ *
+ * @param       dev  - device index
+ *              x, y - position in metres
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void macSimChanPlace(uint16 dev, double x, double y)
+{
+  macSimRadios[dev].x = x;
+  macSimRadios[dev].y = y;
+}
+
+/**************************************************************************************************
+ * @fn          macSimChanNoise
+ *
+ * @brief       Set the noise floor of a channel as seen by energy detect scans.
+ *
+ * @param       logicalChannel - 11 to 26
+ *              noiseDbm       - noise floor in dBm
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void macSimChanNoise(uint8 logicalChannel, int8 noiseDbm)
+{
+  macSimNoise[macSimChanIdx(logicalChannel)] = noiseDbm;
+}
+
+/**************************************************************************************************
+ * @fn          macSimChanInterf
+ *
+ * @brief       Put an interferer on a channel, or take it off with a duty of 0.
+ *
+ * @param       logicalChannel - 11 to 26
+ *              levelDbm       - its power at every device
+ *              dutyPct        - share of the time it is on, 0 to 100
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void macSimChanInterf(uint8 logicalChannel, int8 levelDbm, uint8 dutyPct)
+{
+  macSimInterf_t *pInterf = &macSimInterf[macSimChanIdx(logicalChannel)];
+
+  pInterf->levelDbm = levelDbm;
+  pInterf->dutyPct = (dutyPct > 100) ? 100 : dutyPct;
+}
+
+/**************************************************************************************************
+ * @fn          macSimChanOf
+ *
+ * @brief       Logical channel a device is on.
+ *
+ * @param       dev - device index
+ *
+ * @return      11 to 26
+ **************************************************************************************************
+ */
+uint8 macSimChanOf(uint16 dev)
+{
+  return macSimRadios[dev].pib.logicalChannel;
+}
+
+/**************************************************************************************************
+ * @fn          macSimChanShortOf
+ *
+ * @brief       Short address of a device.
+ *
+ * @param       dev - device index
+ *
+ * @return      the short address, MAC_SHORT_ADDR_NONE or above if it has none
+ **************************************************************************************************
+ */
+uint16 macSimChanShortOf(uint16 dev)
+{
+  return macSimRadios[dev].pib.shortAddr;
+}
+
+/**************************************************************************************************
+ * @fn          macSimChanPrintStats
+ *
+ * @brief       Print the channel totals.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void macSimChanPrintStats(void)
+{
+  macSimStats_t total;
+  uint16 i;
+
+  memset(&total, 0, sizeof(total));
+  for (i = 0; i < macSimNumRadios; i++)
+  {
+    macSimStats_t *p = &macSimRadios[i].stats;
+
+    total.frames += p->frames;
+    total.retries += p->retries;
+    total.accessFailures += p->accessFailures;
+    total.noAcks += p->noAcks;
+    total.delivered += p->delivered;
+    total.lost += p->lost;
+    total.acksLost += p->acksLost;
+    total.expired += p->expired;
+    total.airtime += p->airtime;
+  }
+
+  printf("radio: frames %u delivered %u lost %u retries %u no-ack %u acks-lost %u "
+         "access-fail %u expired %u airtime %.3f s\n",
+         total.frames, total.delivered, total.lost, total.retries, total.noAcks,
+         total.acksLost, total.accessFailures, total.expired,
+         (double)total.airtime / HAL_SIM_USEC_PER_SEC);
+}
+
+/**************************************************************************************************
+ * @fn          macSimChanRadioTime
+ *
+ * @brief       Time the radio of a device spent transmitting and with its receiver on, for the
+ *              current the host works out.  A device with macRxOnWhenIdle set listens all the
+ *              time, which is not counted here.
+ *
+ * @param       dev - device index
+ *              pRx - receiver on
+ *              pTx - transmitting
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void macSimChanRadioTime(uint16 dev, halSimTime_t *pRx, halSimTime_t *pTx)
+{
+  *pRx = macSimRadios[dev].stats.rxTime;
+  *pTx = macSimRadios[dev].stats.airtime;
+}
+
+/**************************************************************************************************
+ * @fn          macSimChanAttach
+ *
+ * @brief       Image service: register the indication handler of the calling device's MAC.
+ *
+ * @param       indication - handler, called with a macSimInd_t *
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void macSimChanAttach(halSimHandler_t indication)
+{
+  macSimRadio_t *pRadio = macSimSelf();
+
+  macSimFlush(pRadio);
+  pRadio->indication = indication;
+}
+
+/**************************************************************************************************
+ * @fn          macSimChanReset
+ *
+ * @brief       Image service: MAC reset.  Pending transmissions and transactions are dropped
+ *              without confirms.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void macSimChanReset(void)
+{
+  macSimFlush(macSimSelf());
+}
+
+/**************************************************************************************************
+ * @fn          macSimChanSetPib
+ *
+ * @brief       Image service: the MAC PIB of the calling device changed.
+ *
+ * @param       pPib - new PIB
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void macSimChanSetPib(const macSimPib_t *pPib)
+{
+  macSimSelf()->pib = *pPib;
+}
+
+/**************************************************************************************************
+ * @fn          macSimChanScan
+ *
+ * @brief       Image service: start a scan.  MAC_MLME_SCAN_CNF follows after the scan time,
+ *              aBaseSuperframeDuration * (2^scanDuration + 1) on each channel, or for an orphan
+ *              scan macResponseWaitTime on each channel until a coordinator answers.
+ *
+ * @param       scanType     - MAC_SCAN_xxx
+ *              scanChannels - channel mask
+ *              scanDuration - 0 to 14
+ *              maxResults   - maximum number of PAN descriptors
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void macSimChanScan(uint8 scanType, uint32 scanChannels, uint8 scanDuration, uint8 maxResults)
+{
+  macSimRadio_t *pRadio = macSimSelf();
+  macSimInd_t ind;
+  uint32 perChannel;
+  uint8 channels = 0;
+  uint8 ch;
+
+  memset(&ind, 0, sizeof(ind));
+  ind.event = MAC_MLME_SCAN_CNF;
+  ind.scanType = scanType;
+
+  for (ch = MAC_SIM_CHAN_FIRST; ch < MAC_SIM_CHAN_FIRST + MAC_SIM_CHAN_NUM; ch++)
+  {
+    if (scanChannels & ((uint32)1 << ch))
+    {
+      channels++;
+    }
+  }
+
+  if (pRadio->scanning)
+  {
+    ind.status = MAC_SCAN_IN_PROGRESS;
+    macSimDefer(halSimSelf(), 0, &ind);
+    return;
+  }
+
+  if ((scanDuration > 14) || (channels == 0))
+  {
+    ind.status = MAC_INVALID_PARAMETER;
+    macSimDefer(halSimSelf(), 0, &ind);
+    return;
+  }
+
+  pRadio->scanning = TRUE;
+  pRadio->scanType = scanType;
+  pRadio->scanChannels = scanChannels;
+  pRadio->scanMaxResults = maxResults;
+  pRadio->scanGen++;
+
+  if (scanType == MAC_SCAN_ORPHAN)
+  {
+    /* One channel after the other, from a kernel event since coordinators are told */
+    pRadio->orphanChannel = 0;
+    halSimSchedule(halSimNow(), halSimSelf(), macSimOrphanNext, (void *)(unsigned long)pRadio->scanGen);
+    return;
+  }
+
+  perChannel = MAC_SIM_BASE_SUPERFRAME_US * (((uint32)1 << scanDuration) + 1);
+  pRadio->scanPerChannel = perChannel;
+  pRadio->stats.rxTime += (halSimTime_t)perChannel * channels;
+  halSimSchedule(halSimNow() + (halSimTime_t)perChannel * channels, halSimSelf(), macSimScanDone,
+                 (void *)(unsigned long)pRadio->scanGen);
+}
+
+/**************************************************************************************************
+ * @fn          macSimChanStart
+ *
+ * @brief       Image service: start a non beacon-enabled network as PAN coordinator.
+ *
+ * @param       panId          - PAN identifier
+ *              logicalChannel - channel
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void macSimChanStart(uint16 panId, uint8 logicalChannel)
+{
+  macSimRadio_t *pRadio = macSimSelf();
+  macSimInd_t ind;
+
+  pRadio->pib.panId = panId;
+  pRadio->pib.logicalChannel = logicalChannel;
+  pRadio->pib.panCoordinator = TRUE;
+  pRadio->started = TRUE;
+
+  memset(&ind, 0, sizeof(ind));
+  ind.event = MAC_MLME_START_CNF;
+  ind.status = MAC_SUCCESS;
+  macSimDefer(halSimSelf(), 0, &ind);
+}
+
+/**************************************************************************************************
+ * @fn          macSimChanRealign
+ *
+ * @brief       Image service: a started coordinator broadcasts a coordinator realignment command
+ *              on its channel, without CSMA, before it moves.  The devices of its PAN that have
+ *              their receiver on and get the frame take the new PAN and channel; sleeping
+ *              devices miss it.
+ *
+ * @param       panId          - new PAN identifier
+ *              logicalChannel - new channel
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void macSimChanRealign(uint16 panId, uint8 logicalChannel)
+{
+  macSimRadio_t *pRadio = macSimSelf();
+  uint16 self = halSimSelf();
+  uint32 airtime = macSimAirtime(MAC_SIM_REALIGN_LEN);
+  macSimInd_t ind;
+  int8 rssi;
+  uint8 lqi;
+  uint16 i;
+
+  if (!pRadio->started)
+  {
+    return;
+  }
+  pRadio->stats.frames++;
+  pRadio->stats.airtime += airtime;
+  macSimBusyUntil[macSimChanIdx(pRadio->pib.logicalChannel)] = halSimNow() + airtime;
+
+  memset(&ind, 0, sizeof(ind));
+  ind.event = MAC_SIM_REALIGN;
+  ind.dstPanId = panId;
+  ind.logicalChannel = logicalChannel;
+  for (i = 0; i < macSimNumRadios; i++)
+  {
+    const macSimRadio_t *pDev = &macSimRadios[i];
+
+    if ((i == self) || (pDev->indication == NULL) || pDev->scanning || pDev->started ||
+        (pDev->pib.logicalChannel != pRadio->pib.logicalChannel) ||
+        (pDev->pib.panId != pRadio->pib.panId) ||
+        (!pDev->pib.rxOnWhenIdle && (pDev->rxUntil < halSimNow())))
+    {
+      continue;
+    }
+    if (macSimLink(self, i, MAC_SIM_REALIGN_LEN, &rssi, &lqi))
+    {
+      pRadio->stats.delivered++;
+      macSimDefer(i, airtime, &ind);
+    }
+    else
+    {
+      pRadio->stats.lost++;
+    }
+  }
+}
+
+/**************************************************************************************************
+ * @fn          macSimChanOrphanRsp
+ *
+ * @brief       Image service: a coordinator answers an orphan notification.  For a member it
+ *              sends the coordinator realignment command to the device, which ends its orphan
+ *              scan with MAC_SUCCESS and takes the PAN, channel, coordinator and its short
+ *              address from it; MAC_MLME_COMM_STATUS_IND tells the coordinator whether it got
+ *              through.  For a device that is not a member nothing is sent.
+ *
+ * @param       orphanAddress    - extended address of the device
+ *              shortAddr        - its short address
+ *              associatedMember - TRUE if it is associated with this coordinator
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void macSimChanOrphanRsp(const sAddrExt_t orphanAddress, uint16 shortAddr, bool associatedMember)
+{
+  macSimRadio_t *pRadio = macSimSelf();
+  uint16 self = halSimSelf();
+  uint32 airtime = macSimAirtime(MAC_SIM_ORPHAN_RSP_LEN);
+  macSimInd_t ind;
+  macSimInd_t cnf;
+  int8 rssi;
+  uint8 lqi;
+  uint16 i;
+
+  if (!associatedMember || !pRadio->started)
+  {
+    return;
+  }
+
+  for (i = 0; i < macSimNumRadios; i++)
+  {
+    const macSimRadio_t *pDev = &macSimRadios[i];
+
+    if ((i != self) && pDev->scanning && (pDev->scanType == MAC_SCAN_ORPHAN) &&
+        (pDev->orphanChannel == pRadio->pib.logicalChannel) &&
+        macSimExtEq(pDev->pib.extAddr, orphanAddress))
+    {
+      break;
+    }
+  }
+
+  pRadio->stats.frames++;
+  pRadio->stats.airtime += airtime;
+  memset(&ind, 0, sizeof(ind));
+  ind.event = MAC_MLME_COMM_STATUS_IND;
+  ind.srcAddr.addrMode = SADDR_MODE_EXT;
+  macSimExtCpy(ind.srcAddr.addr.extAddr, pRadio->pib.extAddr);
+  ind.dstAddr.addrMode = SADDR_MODE_EXT;
+  macSimExtCpy(ind.dstAddr.addr.extAddr, orphanAddress);
+  ind.srcPanId = pRadio->pib.panId;
+
+  if ((i == macSimNumRadios) || !macSimLink(self, i, MAC_SIM_ORPHAN_RSP_LEN, &rssi, &lqi))
+  {
+    pRadio->stats.lost += (i != macSimNumRadios);
+    pRadio->stats.noAcks++;
+    ind.status = MAC_NO_ACK;
+    macSimDefer(self, airtime + MAC_SIM_ACK_WAIT_US, &ind);
+    return;
+  }
+  pRadio->stats.delivered++;
+  macSimRadios[i].scanning = FALSE;
+
+  memset(&cnf, 0, sizeof(cnf));
+  cnf.event = MAC_MLME_SCAN_CNF;
+  cnf.status = MAC_SUCCESS;
+  cnf.scanType = MAC_SCAN_ORPHAN;
+  cnf.srcAddr.addrMode = SADDR_MODE_SHORT;
+  cnf.srcAddr.addr.shortAddr = pRadio->pib.shortAddr;
+  cnf.dstPanId = pRadio->pib.panId;
+  cnf.logicalChannel = pRadio->pib.logicalChannel;
+  cnf.shortAddr = shortAddr;
+  macSimDefer(i, airtime, &cnf);
+
+  ind.status = MAC_SUCCESS;
+  macSimDefer(self, airtime + MAC_SIM_TURNAROUND_US + MAC_SIM_ACK_US, &ind);
+}
+
+/**************************************************************************************************
+ * @fn          macSimChanAssociate
+ *
+ * @brief       Image service: send an association request.  When it is acknowledged the
+ *              device polls for the response after macResponseWaitTime.
+ *
+ * @param       logicalChannel - channel of the coordinator
+ *              pCoordAddr     - coordinator address
+ *              coordPanId     - PAN to join
+ *              capability     - capability information
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void macSimChanAssociate(uint8 logicalChannel, const sAddr_t *pCoordAddr, uint16 coordPanId,
+                         uint8 capability)
+{
+  macSimRadio_t *pRadio = macSimSelf();
+  macSimTx_t *pTx;
+
+  pRadio->pib.logicalChannel = logicalChannel;
+  pRadio->pib.panId = coordPanId;
+  pRadio->assocCoord = *pCoordAddr;
+  pRadio->assocPanId = coordPanId;
+
+  pTx = macSimTxAlloc(halSimSelf(), MAC_SIM_FRAME_ASSOC_REQ);
+  pTx->dstAddr = *pCoordAddr;
+  pTx->dstPanId = coordPanId;
+  pTx->srcAddr.addrMode = SADDR_MODE_EXT;
+  macSimExtCpy(pTx->srcAddr.addr.extAddr, pRadio->pib.extAddr);
+  pTx->srcPanId = 0xFFFF;
+  pTx->capability = capability;
+  pTx->frameLen = ((pCoordAddr->addrMode == SADDR_MODE_EXT) ? MAC_SIM_MHR_EXT_EXT : MAC_SIM_MHR_EXT_SRC)
+                  + MAC_SIM_ASSOC_REQ_PAYLOAD + MAC_SIM_FCS_LEN;
+  macSimTxQueue(pTx);
+}
+
+/**************************************************************************************************
+ * @fn          macSimChanAssociateRsp
+ *
+ * @brief       Image service: queue an association response until the device polls for it.
+ *
+ * @param       deviceAddress - extended address of the device
+ *              shortAddr     - allocated short address
+ *              status        - association status
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void macSimChanAssociateRsp(const sAddrExt_t deviceAddress, uint16 shortAddr, uint8 status)
+{
+  macSimPend_t *pPend = calloc(1, sizeof(macSimPend_t));
+
+  if (pPend == NULL)
+  {
+    return;
+  }
+
+  pPend->kind = MAC_SIM_FRAME_ASSOC_RSP;
+  pPend->dstAddr.addrMode = SADDR_MODE_EXT;
+  macSimExtCpy(pPend->dstAddr.addr.extAddr, deviceAddress);
+  pPend->dstPanId = macSimSelf()->pib.panId;
+  pPend->shortAddr = shortAddr;
+  pPend->status = status;
+  macSimPendAdd(pPend);
+}
+
+/**************************************************************************************************
+ * @fn          macSimChanDataReq
+ *
+ * @brief       Image service: send a data frame, directly or through the transaction queue.
+ *              The MSDU is copied; 'pReq' is only used as the cookie of the confirm.
+ *
+ * @param       pReq - data request
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void macSimChanDataReq(const macMcpsDataReq_t *pReq)
+{
+  macSimRadio_t *pRadio = macSimSelf();
+  uint8 mhrLen = MAC_SIM_MHR_SHORT;
+
+  if (pReq->mac.dstAddr.addrMode == SADDR_MODE_EXT)
+  {
+    mhrLen += 6;
+  }
+  if (pReq->mac.srcAddrMode == SADDR_MODE_EXT)
+  {
+    mhrLen += 6;
+  }
+
+  if (pReq->mac.txOptions & MAC_TXOPTION_INDIRECT)
+  {
+    macSimPend_t *pPend = calloc(1, sizeof(macSimPend_t));
+
+    if (pPend == NULL)
+    {
+      return;
+    }
+    pPend->kind = MAC_SIM_FRAME_DATA;
+    pPend->dstAddr = pReq->mac.dstAddr;
+    pPend->dstPanId = pReq->mac.dstPanId;
+    pPend->msduHandle = pReq->mac.msduHandle;
+    pPend->cookie = (void *)pReq;
+    pPend->len = pReq->msdu.len;
+    memcpy(pPend->msdu, pReq->msdu.p, pReq->msdu.len);
+    macSimPendAdd(pPend);
+  }
+  else
+  {
+    macSimTx_t *pTx = macSimTxAlloc(halSimSelf(), MAC_SIM_FRAME_DATA);
+
+    pTx->dstAddr = pReq->mac.dstAddr;
+    pTx->dstPanId = pReq->mac.dstPanId;
+    pTx->srcAddr.addrMode = pReq->mac.srcAddrMode;
+    if (pReq->mac.srcAddrMode == SADDR_MODE_EXT)
+    {
+      macSimExtCpy(pTx->srcAddr.addr.extAddr, pRadio->pib.extAddr);
+    }
+    else
+    {
+      pTx->srcAddr.addr.shortAddr = pRadio->pib.shortAddr;
+    }
+    pTx->srcPanId = pRadio->pib.panId;
+    pTx->ackReq = ((pReq->mac.txOptions & MAC_TXOPTION_ACK) != 0) &&
+                  !((pReq->mac.dstAddr.addrMode == SADDR_MODE_SHORT) &&
+                    (pReq->mac.dstAddr.addr.shortAddr == MAC_SHORT_ADDR_BROADCAST));
+    pTx->maxRetries = (pReq->mac.txOptions & MAC_TXOPTION_NO_RETRANS) ? 0 : pRadio->pib.maxFrameRetries;
+    pTx->msduHandle = pReq->mac.msduHandle;
+    pTx->cookie = (void *)pReq;
+    pTx->len = pReq->msdu.len;
+    memcpy(pTx->msdu, pReq->msdu.p, pReq->msdu.len);
+    pTx->frameLen = mhrLen + pTx->len + MAC_SIM_FCS_LEN;
+    macSimTxQueue(pTx);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          macSimChanPoll
+ *
+ * @brief       Image service: send a data request to the coordinator.
+ *
+ * @param       pCoordAddr - coordinator address
+ *              coordPanId - coordinator PAN
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void macSimChanPoll(const sAddr_t *pCoordAddr, uint16 coordPanId)
+{
+  macSimRadio_t *pRadio = macSimSelf();
+  macSimTx_t *pTx = macSimTxAlloc(halSimSelf(), MAC_SIM_FRAME_DATA_REQ);
+
+  pRadio->waitAssoc = FALSE;
+  pTx->dstAddr = *pCoordAddr;
+  pTx->dstPanId = coordPanId;
+  pTx->srcPanId = pRadio->pib.panId;
+  if (pRadio->pib.shortAddr < MAC_ADDR_USE_EXT)
+  {
+    pTx->srcAddr.addrMode = SADDR_MODE_SHORT;
+    pTx->srcAddr.addr.shortAddr = pRadio->pib.shortAddr;
+    pTx->frameLen = MAC_SIM_MHR_SHORT + MAC_SIM_DATA_REQ_PAYLOAD + MAC_SIM_FCS_LEN;
+  }
+  else
+  {
+    pTx->srcAddr.addrMode = SADDR_MODE_EXT;
+    macSimExtCpy(pTx->srcAddr.addr.extAddr, pRadio->pib.extAddr);
+    pTx->frameLen = MAC_SIM_MHR_EXT_SRC + MAC_SIM_DATA_REQ_PAYLOAD + MAC_SIM_FCS_LEN;
+  }
+  macSimTxQueue(pTx);
+}
+
+/**************************************************************************************************
+ * @fn          macSimSelf
+ *
+ * @brief       Radio of the device whose image is calling.
+ **************************************************************************************************
+ */
+static macSimRadio_t *macSimSelf(void)
+{
+  return &macSimRadios[halSimSelf()];
+}
+
+/**************************************************************************************************
+ * @fn          macSimIndicate
+ *
+ * @brief       Deliver an indication to a device's MAC now.
+ *
+ * @param       dev  - device index
+ *              pInd - indication
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+static void macSimIndicate(uint16 dev, macSimInd_t *pInd)
+{
+  if (macSimRadios[dev].indication != NULL)
+  {
+    halSimCall(dev, macSimRadios[dev].indication, pInd);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          macSimDefer / macSimDeferredEvt
+ *
+ * @brief       Deliver an indication from a later kernel event, as needed for confirms of
+ *              requests made by an image (images must not be re-entered).
+ **************************************************************************************************
+ */
+static void macSimDefer(uint16 dev, uint32 delayUs, const macSimInd_t *pInd)
+{
+  macSimDeferred_t *pDef = malloc(sizeof(macSimDeferred_t));
+
+  if (pDef != NULL)
+  {
+    pDef->epoch = macSimRadios[dev].epoch;
+    pDef->ind = *pInd;
+    halSimSchedule(halSimNow() + delayUs, dev, macSimDeferredEvt, pDef);
+  }
+}
+
+static void macSimDeferredEvt(uint16 dev, void *arg)
+{
+  macSimDeferred_t *pDef = arg;
+
+  if (pDef->epoch == macSimRadios[dev].epoch)
+  {
+    macSimIndicate(dev, &pDef->ind);
+  }
+  free(pDef);
+}
+
+/**************************************************************************************************
+ * @fn          macSimUniform / macSimGauss
+ *
+ * @brief       Random variates from the simulation's generator.
+ **************************************************************************************************
+ */
+static double macSimUniform(void)
+{
+  return ((double)halSimRand() + 0.5) / 65536.0;
+}
+
+static double macSimGauss(void)
+{
+  return sqrt(-2.0 * log(macSimUniform())) * cos(2.0 * M_PI * macSimUniform());
+}
+
+/**************************************************************************************************
+ * @fn          macSimLink
+ *
+ * @brief       Decide whether one frame gets through.  Path loss is log-distance, the
+ *              received power varies per frame, and the packet error rate rises steeply as
+ *              the margin over the sensitivity shrinks and grows with frame length.  The
+ *              frame is on the channel of the side that is not scanning: a scanning radio is
+ *              tuned to the channel it scans, not to the one in its PIB.
+ *
+ * @param       from     - transmitting device
+ *              to       - receiving device
+ *              frameLen - MPDU length
+ *              pRssi    - output, received power in dBm
+ *              pLqi     - output, link quality
+ *
+ * @return      TRUE if the frame was received
+ **************************************************************************************************
+ */
+static bool macSimLink(uint16 from, uint16 to, uint8 frameLen, int8 *pRssi, uint8 *pLqi)
+{
+  const macSimRadio_t *pTx = &macSimRadios[from];
+  const macSimRadio_t *pRx = &macSimRadios[to];
+  double dx = pTx->x - pRx->x;
+  double dy = pTx->y - pRx->y;
+  double dist = sqrt(dx * dx + dy * dy);
+  uint8 idx = macSimChanIdx(pRx->scanning ? pTx->pib.logicalChannel : pRx->pib.logicalChannel);
+  double rssi, margin, sir, per;
+  int lqi;
+
+  if (dist < 1.0)
+  {
+    dist = 1.0;
+  }
+
+  rssi = pTx->pib.txPower - (MAC_SIM_PATH_LOSS_1M + MAC_SIM_PATH_LOSS_SLOPE * log10(dist))
+         + MAC_SIM_FADING_DB * macSimGauss();
+  margin = rssi - MAC_SIM_SENSITIVITY_DBM;
+  if (macSimInterfOn(idx))
+  {
+    sir = rssi - macSimInterf[idx].levelDbm - MAC_SIM_SIR_MIN_DB;
+    if (sir < margin)
+    {
+      margin = sir;
+    }
+  }
+
+  lqi = (int)(margin * 255 / MAC_SIM_LQI_RANGE_DB);
+  *pLqi = (uint8)((lqi < 0) ? 0 : (lqi > 255) ? 255 : lqi);
+  *pRssi = (int8)((rssi < -128) ? -128 : (rssi > 127) ? 127 : rssi);
+
+  per = 1.0 / (1.0 + exp(MAC_SIM_PER_STEEPNESS * margin));
+  per = 1.0 - pow(1.0 - per, frameLen / 20.0);
+
+  return (macSimUniform() >= per);
+}
+
+/**************************************************************************************************
+ * @fn          macSimAirtime
+ *
+ * @brief       Time on air of a PPDU.
+ **************************************************************************************************
+ */
+static uint32 macSimAirtime(uint8 frameLen)
+{
+  return (uint32)(MAC_SIM_PHY_HDR_LEN + frameLen) * MAC_SIM_BYTE_US;
+}
+
+static uint8 macSimChanIdx(uint8 logicalChannel)
+{
+  if ((logicalChannel < MAC_SIM_CHAN_FIRST) || (logicalChannel >= MAC_SIM_CHAN_FIRST + MAC_SIM_CHAN_NUM))
+  {
+    return 0;
+  }
+  return logicalChannel - MAC_SIM_CHAN_FIRST;
+}
+
+/**************************************************************************************************
+ * @fn          macSimInterfOn
+ *
+ * @brief       Is the interferer of a channel on now?  Drawn afresh at each look.
+ **************************************************************************************************
+ */
+static bool macSimInterfOn(uint8 idx)
+{
+  return (macSimInterf[idx].dutyPct != 0) && (macSimUniform() * 100.0 < macSimInterf[idx].dutyPct);
+}
+
+/**************************************************************************************************
+ * @fn          macSimAddrMatch
+ *
+ * @brief       Does a destination address select the device with this PIB?
+ **************************************************************************************************
+ */
+static bool macSimAddrMatch(const sAddr_t *pAddr, const macSimPib_t *pPib)
+{
+  if (pAddr->addrMode == SADDR_MODE_EXT)
+  {
+    return macSimExtEq(pAddr->addr.extAddr, pPib->extAddr);
+  }
+
+  return (pAddr->addr.shortAddr == MAC_SHORT_ADDR_BROADCAST) || (pAddr->addr.shortAddr == pPib->shortAddr);
+}
+
+/**************************************************************************************************
+ * @fn          macSimTxAlloc
+ *
+ * @brief       New frame for the transmit queue of 'src', using its current PIB.
+ **************************************************************************************************
+ */
+static macSimTx_t *macSimTxAlloc(uint16 src, uint8 kind)
+{
+  macSimRadio_t *pRadio = &macSimRadios[src];
+  macSimTx_t *pTx = calloc(1, sizeof(macSimTx_t));
+
+  if (pTx == NULL)
+  {
+    fprintf(stderr, "sim: out of memory\n");
+    exit(1);
+  }
+
+  pTx->src = src;
+  pTx->epoch = pRadio->epoch;
+  pTx->kind = kind;
+  pTx->channel = pRadio->pib.logicalChannel;
+  pTx->dsn = pRadio->dsn++;
+  pTx->ackReq = TRUE;
+  pTx->maxRetries = pRadio->pib.maxFrameRetries;
+  pTx->polledBy = HAL_SIM_NO_DEV;
+
+  return pTx;
+}
+
+/**************************************************************************************************
+ * @fn          macSimTxQueue
+ *
+ * @brief       Append a frame to its radio's transmit queue; start it if the radio is idle.
+ **************************************************************************************************
+ */
+static void macSimTxQueue(macSimTx_t *pTx)
+{
+  macSimRadio_t *pRadio = &macSimRadios[pTx->src];
+
+  if (pRadio->pTxTail == NULL)
+  {
+    pRadio->pTxHead = pRadio->pTxTail = pTx;
+    macSimTxStart(pTx);
+  }
+  else
+  {
+    pRadio->pTxTail->pNext = pTx;
+    pRadio->pTxTail = pTx;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          macSimTxStart
+ *
+ * @brief       The frame got to the head of its queue: CSMA-CA starts, and the radio is on
+ *              until its confirm.
+ **************************************************************************************************
+ */
+static void macSimTxStart(macSimTx_t *pTx)
+{
+  pTx->be = macSimRadios[pTx->src].pib.minBe;
+  pTx->started = halSimNow();
+  macSimTxBackoff(pTx, 0);
+}
+
+/**************************************************************************************************
+ * @fn          macSimTxBackoff
+ *
+ * @brief       Wait a random number of backoff periods, then perform CCA.
+ **************************************************************************************************
+ */
+static void macSimTxBackoff(macSimTx_t *pTx, uint32 delayUs)
+{
+  delayUs += (halSimRand() & ((1u << pTx->be) - 1)) * MAC_SIM_BACKOFF_US + MAC_SIM_CCA_US;
+  halSimSchedule(halSimNow() + delayUs, pTx->src, macSimTxCca, pTx);
+}
+
+/**************************************************************************************************
+ * @fn          macSimTxStale
+ *
+ * @brief       Was the sender's MAC reset since the frame was queued?
+ **************************************************************************************************
+ */
+static bool macSimTxStale(const macSimTx_t *pTx)
+{
+  return (pTx->epoch != macSimRadios[pTx->src].epoch);
+}
+
+/**************************************************************************************************
+ * @fn          macSimTxRetire
+ *
+ * @brief       Remove the frame at the head of its queue and start the next one.
+ **************************************************************************************************
+ */
+static void macSimTxRetire(macSimTx_t *pTx)
+{
+  macSimRadio_t *pRadio = &macSimRadios[pTx->src];
+
+  if (pRadio->pTxHead == pTx)
+  {
+    pRadio->pTxHead = pTx->pNext;
+    if (pRadio->pTxHead == NULL)
+    {
+      pRadio->pTxTail = NULL;
+    }
+    else
+    {
+      macSimTxStart(pRadio->pTxHead);
+    }
+  }
+  free(pTx);
+}
+
+/**************************************************************************************************
+ * @fn          macSimTxCca
+ *
+ * @brief       Clear channel assessment at the end of a backoff.
+ **************************************************************************************************
+ */
+static void macSimTxCca(uint16 dev, void *arg)
+{
+  macSimTx_t *pTx = arg;
+  macSimRadio_t *pRadio = &macSimRadios[dev];
+  uint8 idx = macSimChanIdx(pTx->channel);
+  halSimTime_t start, end;
+
+  if (macSimTxStale(pTx))
+  {
+    macSimTxRetire(pTx);
+    return;
+  }
+
+  if ((macSimBusyUntil[idx] > halSimNow()) ||
+      ((macSimInterf[idx].levelDbm >= MAC_SIM_CCA_THRESHOLD_DBM) && macSimInterfOn(idx)))
+  {
+    pTx->nb++;
+    if (pTx->be < pRadio->pib.maxBe)
+    {
+      pTx->be++;
+    }
+
+    if (pTx->nb > pRadio->pib.maxCsmaBackoffs)
+    {
+      pRadio->stats.accessFailures++;
+      pTx->status = MAC_CHANNEL_ACCESS_FAILURE;
+      halSimSchedule(halSimNow(), dev, macSimTxConfirm, pTx);
+    }
+    else
+    {
+      macSimTxBackoff(pTx, 0);
+    }
+    return;
+  }
+
+  /* Claim the channel from CCA until the acknowledgement is over */
+  start = halSimNow() + MAC_SIM_TURNAROUND_US;
+  end = start + macSimAirtime(pTx->frameLen);
+  macSimBusyUntil[idx] = end + (pTx->ackReq ? MAC_SIM_TURNAROUND_US + MAC_SIM_ACK_US : 0);
+
+  pRadio->stats.frames++;
+  pRadio->stats.airtime += end - start;
+  pTx->airtime += end - start;
+  halSimSchedule(end, dev, macSimTxEnd, pTx);
+}
+
+/**************************************************************************************************
+ * @fn          macSimTxEnd
+ *
+ * @brief       The last byte of a frame left the antenna: deliver it, then decide on the
+ *              acknowledgement.
+ **************************************************************************************************
+ */
+static void macSimTxEnd(uint16 dev, void *arg)
+{
+  macSimTx_t *pTx = arg;
+  macSimRadio_t *pRadio = &macSimRadios[dev];
+  uint16 dst;
+  bool received = FALSE;
+  int8 rssi;
+  uint8 lqi;
+
+  if (macSimTxStale(pTx))
+  {
+    macSimTxRetire(pTx);
+    return;
+  }
+
+  dst = macSimRxFind(pTx);
+  if (dst != HAL_SIM_NO_DEV)
+  {
+    received = macSimRxFrame(pTx, dst);
+  }
+
+  if (!pTx->ackReq)
+  {
+    pTx->status = MAC_SUCCESS;
+    halSimSchedule(halSimNow(), dev, macSimTxConfirm, pTx);
+  }
+  else if (received && macSimLink(dst, dev, MAC_SIM_ACK_LEN, &rssi, &lqi))
+  {
+    pTx->status = MAC_SUCCESS;
+    pTx->rssi = rssi;
+    pTx->lqi = lqi;
+    halSimSchedule(halSimNow() + MAC_SIM_TURNAROUND_US + MAC_SIM_ACK_US, dev, macSimTxConfirm, pTx);
+  }
+  else
+  {
+    if (received)
+    {
+      pRadio->stats.acksLost++;
+    }
+
+    if (pTx->retries < pTx->maxRetries)
+    {
+      pTx->retries++;
+      pRadio->stats.retries++;
+      pTx->nb = 0;
+      pTx->be = pRadio->pib.minBe;
+      macSimTxBackoff(pTx, MAC_SIM_ACK_WAIT_US);
+    }
+    else
+    {
+      pRadio->stats.noAcks++;
+      pTx->status = MAC_NO_ACK;
+      halSimSchedule(halSimNow() + MAC_SIM_ACK_WAIT_US, dev, macSimTxConfirm, pTx);
+    }
+  }
+}
+
+/**************************************************************************************************
+ * @fn          macSimTxConfirm
+ *
+ * @brief       Report the outcome of a frame to its sender and start the next one.
+ **************************************************************************************************
+ */
+static void macSimTxConfirm(uint16 dev, void *arg)
+{
+  macSimTx_t *pTx = arg;
+  macSimTx_t *pNext = pTx->pNext;
+  macSimRadio_t *pRadio = &macSimRadios[dev];
+  macSimInd_t ind;
+
+  if (macSimTxStale(pTx))
+  {
+    macSimTxRetire(pTx);
+    return;
+  }
+
+  pRadio->stats.rxTime += halSimNow() - pTx->started - pTx->airtime;
+
+  /* Unlink first: the sender may queue more frames from its confirm */
+  pRadio->pTxHead = pTx->pNext;
+  if (pRadio->pTxHead == NULL)
+  {
+    pRadio->pTxTail = NULL;
+  }
+  pTx->pNext = NULL;
+
+  memset(&ind, 0, sizeof(ind));
+  ind.status = pTx->status;
+
+  switch (pTx->kind)
+  {
+    case MAC_SIM_FRAME_DATA:
+      ind.event = MAC_MCPS_DATA_CNF;
+      ind.msduHandle = pTx->msduHandle;
+      ind.cookie = pTx->cookie;
+      ind.retries = pTx->retries;
+      ind.rssi = pTx->rssi;
+      ind.lqi = pTx->lqi;
+      macSimIndicate(dev, &ind);
+      break;
+
+    case MAC_SIM_FRAME_ASSOC_REQ:
+      if (pTx->status == MAC_SUCCESS)
+      {
+        pRadio->waitGen++;
+        halSimSchedule(halSimNow() + (halSimTime_t)pRadio->pib.responseWaitTime * MAC_SIM_BASE_SUPERFRAME_US,
+                       dev, macSimAssocPoll, (void *)(unsigned long)pRadio->waitGen);
+      }
+      else
+      {
+        ind.event = MAC_MLME_ASSOCIATE_CNF;
+        ind.shortAddr = MAC_SHORT_ADDR_NONE;
+        macSimIndicate(dev, &ind);
+      }
+      break;
+
+    case MAC_SIM_FRAME_DATA_REQ:
+      if ((pTx->status == MAC_SUCCESS) && (pRadio->rxUntil > halSimNow()))
+      {
+        /* Frame pending: the requested frame or the wait timeout completes the poll */
+        break;
+      }
+      if (pTx->status == MAC_SUCCESS)
+      {
+        ind.status = MAC_NO_DATA;
+      }
+      if (pRadio->waitAssoc)
+      {
+        ind.event = MAC_MLME_ASSOCIATE_CNF;
+        ind.shortAddr = MAC_SHORT_ADDR_NONE;
+        pRadio->waitAssoc = FALSE;
+      }
+      else
+      {
+        ind.event = MAC_MLME_POLL_CNF;
+      }
+      macSimIndicate(dev, &ind);
+      break;
+
+    case MAC_SIM_FRAME_ASSOC_RSP:
+      ind.event = MAC_MLME_COMM_STATUS_IND;
+      ind.srcAddr.addrMode = SADDR_MODE_EXT;
+      macSimExtCpy(ind.srcAddr.addr.extAddr, pRadio->pib.extAddr);
+      ind.dstAddr = pTx->dstAddr;
+      ind.srcPanId = pRadio->pib.panId;
+      macSimIndicate(dev, &ind);
+      break;
+  }
+
+  /* The indication may have reset the MAC and flushed the queue.  A frame it queued on the
+     empty queue was started by macSimTxQueue(), only the one that waited behind is started here */
+  free(pTx);
+  if ((pNext != NULL) && (pRadio->pTxHead == pNext) && (pNext->nb == 0) && (pNext->retries == 0))
+  {
+    macSimTxStart(pNext);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          macSimRxFind
+ *
+ * @brief       Find the device a frame is addressed to and that is listening for it.
+ *
+ * @return      device index or HAL_SIM_NO_DEV
+ **************************************************************************************************
+ */
+static uint16 macSimRxFind(const macSimTx_t *pTx)
+{
+  uint16 i;
+
+  if (pTx->indirect)
+  {
+    const macSimRadio_t *pRadio = &macSimRadios[pTx->polledBy];
+
+    if ((pRadio->rxUntil >= halSimNow()) && (pRadio->pib.logicalChannel == pTx->channel))
+    {
+      return pTx->polledBy;
+    }
+    return HAL_SIM_NO_DEV;
+  }
+
+  for (i = 0; i < macSimNumRadios; i++)
+  {
+    const macSimRadio_t *pRadio = &macSimRadios[i];
+
+    if ((i == pTx->src) || (pRadio->indication == NULL) || pRadio->scanning ||
+        (pRadio->pib.logicalChannel != pTx->channel))
+    {
+      continue;
+    }
+    if (!pRadio->pib.rxOnWhenIdle && (pRadio->rxUntil < halSimNow()))
+    {
+      continue;
+    }
+    if ((pTx->dstPanId != MAC_SHORT_ADDR_BROADCAST) && (pTx->dstPanId != pRadio->pib.panId))
+    {
+      continue;
+    }
+    if (!macSimAddrMatch(&pTx->dstAddr, &pRadio->pib))
+    {
+      continue;
+    }
+    if ((pTx->kind == MAC_SIM_FRAME_ASSOC_REQ) && !(pRadio->started && pRadio->pib.assocPermit))
+    {
+      continue;
+    }
+    return i;
+  }
+
+  return HAL_SIM_NO_DEV;
+}
+
+/**************************************************************************************************
+ * @fn          macSimRxFrame
+ *
+ * @brief       Attempt reception of a frame at 'dst' and act on it there.
+ *
+ * @return      TRUE if 'dst' received the frame (and will acknowledge it)
+ **************************************************************************************************
+ */
+static bool macSimRxFrame(macSimTx_t *pTx, uint16 dst)
+{
+  macSimRadio_t *pSrc = &macSimRadios[pTx->src];
+  macSimRadio_t *pDst = &macSimRadios[dst];
+  macSimInd_t ind;
+  macSimPend_t **ppPend;
+  bool polled;
+  int8 rssi;
+  uint8 lqi;
+
+  if (!macSimLink(pTx->src, dst, pTx->frameLen, &rssi, &lqi))
+  {
+    pSrc->stats.lost++;
+    return FALSE;
+  }
+  pSrc->stats.delivered++;
+
+  memset(&ind, 0, sizeof(ind));
+  ind.status = MAC_SUCCESS;
+  ind.srcAddr = pTx->srcAddr;
+  ind.dstAddr = pTx->dstAddr;
+  ind.srcPanId = pTx->srcPanId;
+  ind.dstPanId = pTx->dstPanId;
+  ind.rssi = rssi;
+  ind.lqi = lqi;
+  ind.dsn = pTx->dsn;
+
+  switch (pTx->kind)
+  {
+    case MAC_SIM_FRAME_DATA:
+      /* A device waiting after a poll takes a frame sent to it directly as the polled one too,
+       * which is how an application answers a MAC_MLME_POLL_IND */
+      polled = pTx->indirect || ((pDst->rxUntil != 0) && !pDst->pib.rxOnWhenIdle && !pDst->waitAssoc);
+      ind.event = MAC_MCPS_DATA_IND;
+      ind.pMsdu = pTx->msdu;
+      ind.msduLen = pTx->len;
+      if (polled)
+      {
+        macSimWaitEnd(dst);
+      }
+      macSimIndicate(dst, &ind);
+      if (polled)
+      {
+        memset(&ind, 0, sizeof(ind));
+        ind.event = MAC_MLME_POLL_CNF;
+        ind.status = MAC_SUCCESS;
+        macSimIndicate(dst, &ind);
+      }
+      break;
+
+    case MAC_SIM_FRAME_ASSOC_REQ:
+      ind.event = MAC_MLME_ASSOCIATE_IND;
+      macSimExtCpy(ind.deviceAddress, pTx->srcAddr.addr.extAddr);
+      ind.capability = pTx->capability;
+      macSimIndicate(dst, &ind);
+      break;
+
+    case MAC_SIM_FRAME_DATA_REQ:
+      for (ppPend = &pDst->pPend; *ppPend != NULL; ppPend = &(*ppPend)->pNext)
+      {
+        const sAddr_t *pAddr = &(*ppPend)->dstAddr;
+
+        if ((pAddr->addrMode == pTx->srcAddr.addrMode) &&
+            ((pAddr->addrMode == SADDR_MODE_EXT) ?
+             macSimExtEq(pAddr->addr.extAddr, pTx->srcAddr.addr.extAddr) :
+             (pAddr->addr.shortAddr == pTx->srcAddr.addr.shortAddr)))
+        {
+          break;
+        }
+      }
+
+      if (*ppPend != NULL)
+      {
+        macSimPend_t *pPend = *ppPend;
+        macSimTx_t *pRsp = macSimTxAlloc(dst, pPend->kind);
+
+        *ppPend = pPend->pNext;
+
+        pRsp->indirect = TRUE;
+        pRsp->polledBy = pTx->src;
+        pRsp->dstAddr = pPend->dstAddr;
+        pRsp->dstPanId = pPend->dstPanId;
+        pRsp->srcPanId = pDst->pib.panId;
+        pRsp->msduHandle = pPend->msduHandle;
+        pRsp->cookie = pPend->cookie;
+        pRsp->shortAddr = pPend->shortAddr;
+        pRsp->assocStatus = pPend->status;
+        pRsp->len = pPend->len;
+        memcpy(pRsp->msdu, pPend->msdu, pPend->len);
+
+        if (pPend->kind == MAC_SIM_FRAME_ASSOC_RSP)
+        {
+          pRsp->srcAddr.addrMode = SADDR_MODE_EXT;
+          macSimExtCpy(pRsp->srcAddr.addr.extAddr, pDst->pib.extAddr);
+          pRsp->frameLen = MAC_SIM_MHR_EXT_EXT + MAC_SIM_ASSOC_RSP_PAYLOAD + MAC_SIM_FCS_LEN;
+        }
+        else
+        {
+          pRsp->srcAddr.addrMode = SADDR_MODE_SHORT;
+          pRsp->srcAddr.addr.shortAddr = pDst->pib.shortAddr;
+          pRsp->frameLen = MAC_SIM_MHR_SHORT + pRsp->len + MAC_SIM_FCS_LEN +
+                           ((pRsp->dstAddr.addrMode == SADDR_MODE_EXT) ? 6 : 0);
+        }
+        free(pPend);
+
+        macSimWaitStart(pTx->src, MAC_SIM_TURNAROUND_US + MAC_SIM_ACK_US +
+                        (uint32)pSrc->pib.maxFrameTotalWaitTime * MAC_SIM_SYMBOL_US);
+        macSimTxQueue(pRsp);
+        break;
+      }
+
+      /* Nothing queued: let the coordinator's application say whether it holds data */
+      ind.event = MAC_SIM_POLL_CHECK;
+      macSimIndicate(dst, &ind);
+      if (ind.pending != 0)
+      {
+        /* Pending bit set on the application's word; nothing may come */
+        macSimWaitStart(pTx->src, MAC_SIM_TURNAROUND_US + MAC_SIM_ACK_US +
+                        (uint32)pSrc->pib.maxFrameTotalWaitTime * MAC_SIM_SYMBOL_US);
+      }
+      break;
+
+    case MAC_SIM_FRAME_ASSOC_RSP:
+      macSimWaitEnd(dst);
+      pDst->waitAssoc = FALSE;
+      ind.event = MAC_MLME_ASSOCIATE_CNF;
+      ind.status = pTx->assocStatus;
+      ind.shortAddr = pTx->shortAddr;
+      macSimIndicate(dst, &ind);
+      break;
+  }
+
+  return TRUE;
+}
+
+/**************************************************************************************************
+ * @fn          macSimWaitStart / macSimWaitEnd / macSimWaitExpire
+ *
+ * @brief       Receive window of a device that was told a frame is pending for it.
+ **************************************************************************************************
+ */
+static void macSimWaitStart(uint16 dev, uint32 durationUs)
+{
+  macSimRadio_t *pRadio = &macSimRadios[dev];
+
+  pRadio->rxSince = halSimNow();
+  pRadio->rxUntil = pRadio->rxSince + durationUs;
+  pRadio->waitGen++;
+  halSimSchedule(pRadio->rxUntil, dev, macSimWaitExpire, (void *)(unsigned long)pRadio->waitGen);
+}
+
+static void macSimWaitEnd(uint16 dev)
+{
+  if (macSimRadios[dev].rxUntil != 0)
+  {
+    macSimRadios[dev].stats.rxTime += halSimNow() - macSimRadios[dev].rxSince;
+  }
+  macSimRadios[dev].rxUntil = 0;
+  macSimRadios[dev].waitGen++;
+}
+
+static void macSimWaitExpire(uint16 dev, void *arg)
+{
+  macSimRadio_t *pRadio = &macSimRadios[dev];
+  macSimInd_t ind;
+
+  if ((uint32)(unsigned long)arg != pRadio->waitGen)
+  {
+    return;
+  }
+  pRadio->stats.rxTime += halSimNow() - pRadio->rxSince;
+  pRadio->rxUntil = 0;
+
+  memset(&ind, 0, sizeof(ind));
+  ind.status = MAC_NO_DATA;
+  if (pRadio->waitAssoc)
+  {
+    pRadio->waitAssoc = FALSE;
+    ind.event = MAC_MLME_ASSOCIATE_CNF;
+    ind.shortAddr = MAC_SHORT_ADDR_NONE;
+  }
+  else
+  {
+    ind.event = MAC_MLME_POLL_CNF;
+  }
+  macSimIndicate(dev, &ind);
+}
+
+/**************************************************************************************************
+ * @fn          macSimAssocPoll
+ *
+ * @brief       macResponseWaitTime after an acknowledged association request: ask the
+ *              coordinator for the response.
+ **************************************************************************************************
+ */
+static void macSimAssocPoll(uint16 dev, void *arg)
+{
+  macSimRadio_t *pRadio = &macSimRadios[dev];
+  macSimTx_t *pTx;
+
+  if ((uint32)(unsigned long)arg != pRadio->waitGen)
+  {
+    return;
+  }
+
+  pRadio->waitAssoc = TRUE;
+  pTx = macSimTxAlloc(dev, MAC_SIM_FRAME_DATA_REQ);
+  pTx->dstAddr = pRadio->assocCoord;
+  pTx->dstPanId = pRadio->assocPanId;
+  pTx->srcPanId = pRadio->assocPanId;
+  pTx->srcAddr.addrMode = SADDR_MODE_EXT;
+  macSimExtCpy(pTx->srcAddr.addr.extAddr, pRadio->pib.extAddr);
+  pTx->frameLen = MAC_SIM_MHR_EXT_SRC + MAC_SIM_DATA_REQ_PAYLOAD + MAC_SIM_FCS_LEN;
+  macSimTxQueue(pTx);
+}
+
+/**************************************************************************************************
+ * @fn          macSimPendAdd / macSimPendExpire
+ *
+ * @brief       Transaction queue of the calling coordinator.  A transaction not collected
+ *              within macTransactionPersistenceTime expires.
+ **************************************************************************************************
+ */
+static void macSimPendAdd(macSimPend_t *pPend)
+{
+  macSimRadio_t *pRadio = macSimSelf();
+  macSimPend_t **ppLast = &pRadio->pPend;
+
+  while (*ppLast != NULL)
+  {
+    ppLast = &(*ppLast)->pNext;
+  }
+  *ppLast = pPend;
+  pPend->pNext = NULL;
+  pPend->id = ++macSimPendId;
+
+  halSimSchedule(halSimNow() + (halSimTime_t)pRadio->pib.transactionPersistenceTime * MAC_SIM_BASE_SUPERFRAME_US,
+                 halSimSelf(), macSimPendExpire, (void *)(unsigned long)pPend->id);
+}
+
+static void macSimPendExpire(uint16 dev, void *arg)
+{
+  macSimRadio_t *pRadio = &macSimRadios[dev];
+  macSimPend_t **ppPend;
+  macSimPend_t *pPend;
+  macSimInd_t ind;
+
+  for (ppPend = &pRadio->pPend; *ppPend != NULL; ppPend = &(*ppPend)->pNext)
+  {
+    if ((*ppPend)->id == (uint32)(unsigned long)arg)
+    {
+      break;
+    }
+  }
+  if (*ppPend == NULL)
+  {
+    return;
+  }
+
+  pPend = *ppPend;
+  *ppPend = pPend->pNext;
+  pRadio->stats.expired++;
+
+  memset(&ind, 0, sizeof(ind));
+  ind.status = MAC_TRANSACTION_EXPIRED;
+  if (pPend->kind == MAC_SIM_FRAME_DATA)
+  {
+    ind.event = MAC_MCPS_DATA_CNF;
+    ind.msduHandle = pPend->msduHandle;
+    ind.cookie = pPend->cookie;
+  }
+  else
+  {
+    ind.event = MAC_MLME_COMM_STATUS_IND;
+    ind.srcAddr.addrMode = SADDR_MODE_EXT;
+    macSimExtCpy(ind.srcAddr.addr.extAddr, pRadio->pib.extAddr);
+    ind.dstAddr = pPend->dstAddr;
+    ind.srcPanId = pRadio->pib.panId;
+  }
+  free(pPend);
+  macSimIndicate(dev, &ind);
+}
+
+/**************************************************************************************************
+ * @fn          macSimScanDone
+ *
+ * @brief       End of a scan: measure each channel or collect the coordinators that answered
+ *              the beacon request.
+ **************************************************************************************************
+ */
+static void macSimScanDone(uint16 dev, void *arg)
+{
+  macSimRadio_t *pRadio = &macSimRadios[dev];
+  uint8 energy[MAC_SIM_CHAN_NUM];
+  macPanDesc_t panDesc[MAC_SIM_MAX_PAN_DESC];
+  macSimInd_t ind;
+  uint8 ch;
+  uint16 i;
+
+  if (((uint32)(unsigned long)arg != pRadio->scanGen) || !pRadio->scanning)
+  {
+    return;
+  }
+
+  memset(&ind, 0, sizeof(ind));
+  ind.event = MAC_MLME_SCAN_CNF;
+  ind.status = MAC_SUCCESS;
+  ind.scanType = pRadio->scanType;
+  ind.pEnergyDetect = energy;
+  ind.pPanDesc = panDesc;
+
+  for (ch = MAC_SIM_CHAN_FIRST; ch < MAC_SIM_CHAN_FIRST + MAC_SIM_CHAN_NUM; ch++)
+  {
+    if (!(pRadio->scanChannels & ((uint32)1 << ch)))
+    {
+      continue;
+    }
+
+    if (pRadio->scanType == MAC_SCAN_ED)
+    {
+      uint8 idx = macSimChanIdx(ch);
+      double level = macSimNoise[idx] + macSimGauss();
+      double quiet;
+      int ed;
+
+      if (macSimInterf[idx].dutyPct != 0)
+      {
+        quiet = pow(1.0 - macSimInterf[idx].dutyPct / 100.0,
+                    (double)pRadio->scanPerChannel / MAC_SIM_BURST_US);
+        if ((macSimUniform() >= quiet) && (macSimInterf[idx].levelDbm > level))
+        {
+          level = macSimInterf[idx].levelDbm + macSimGauss();
+        }
+      }
+      ed = (int)((level - MAC_SIM_SENSITIVITY_DBM) * 255 / MAC_SIM_LQI_RANGE_DB);
+
+      energy[ind.resultListSize++] = (uint8)((ed < 0) ? 0 : (ed > 255) ? 255 : ed);
+    }
+    else if (pRadio->scanType == MAC_SCAN_ACTIVE)
+    {
+      for (i = 0; (i < macSimNumRadios) && (ind.resultListSize < pRadio->scanMaxResults) &&
+                  (ind.resultListSize < MAC_SIM_MAX_PAN_DESC); i++)
+      {
+        const macSimRadio_t *pCoord = &macSimRadios[i];
+        macPanDesc_t *pDesc = &panDesc[ind.resultListSize];
+        int8 rssi;
+        uint8 lqi;
+
+        if ((i == dev) || !pCoord->started || (pCoord->pib.logicalChannel != ch) ||
+            !macSimLink(dev, i, MAC_SIM_BEACON_REQ_LEN, &rssi, &lqi) ||
+            !macSimLink(i, dev, MAC_SIM_BEACON_LEN + pCoord->pib.beaconPayloadLength, &rssi, &lqi))
+        {
+          continue;
+        }
+
+        memset(pDesc, 0, sizeof(macPanDesc_t));
+        if (pCoord->pib.shortAddr < MAC_ADDR_USE_EXT)
+        {
+          pDesc->coordAddress.addrMode = SADDR_MODE_SHORT;
+          pDesc->coordAddress.addr.shortAddr = pCoord->pib.shortAddr;
+        }
+        else
+        {
+          pDesc->coordAddress.addrMode = SADDR_MODE_EXT;
+          macSimExtCpy(pDesc->coordAddress.addr.extAddr, pCoord->pib.extAddr);
+        }
+        pDesc->coordPanId = pCoord->pib.panId;
+        pDesc->superframeSpec = (uint16)(pCoord->pib.beaconOrder | (pCoord->pib.superframeOrder << 4) |
+                                         0x0F00 | (pCoord->pib.panCoordinator ? 0x4000 : 0) |
+                                         (pCoord->pib.assocPermit ? 0x8000 : 0));
+        pDesc->logicalChannel = ch;
+        pDesc->linkQuality = lqi;
+        pDesc->timestamp = (uint32)(halSimNow() / MAC_SIM_BACKOFF_US);
+        ind.resultListSize++;
+      }
+    }
+  }
+
+  if ((pRadio->scanType != MAC_SCAN_ED) && (ind.resultListSize == 0))
+  {
+    ind.status = MAC_NO_BEACON;
+  }
+
+  pRadio->scanning = FALSE;             /* after the beacons, heard on the channels scanned */
+  macSimIndicate(dev, &ind);
+}
+
+/**************************************************************************************************
+ * @fn          macSimOrphanNext
+ *
+ * @brief       Orphan scan: send the orphan notification on the next channel of the scan, to
+ *              the coordinators started there, and wait macResponseWaitTime for one to answer
+ *              with macSimChanOrphanRsp().  After the last channel the scan ends with
+ *              MAC_NO_BEACON.
+ **************************************************************************************************
+ */
+static void macSimOrphanNext(uint16 dev, void *arg)
+{
+  macSimRadio_t *pRadio = &macSimRadios[dev];
+  uint32 airtime = macSimAirtime(MAC_SIM_ORPHAN_LEN);
+  uint32 wait = (uint32)pRadio->pib.responseWaitTime * MAC_SIM_BASE_SUPERFRAME_US;
+  macSimInd_t ind;
+  int8 rssi;
+  uint8 lqi;
+  uint8 ch;
+  uint16 i;
+
+  if (((uint32)(unsigned long)arg != pRadio->scanGen) || !pRadio->scanning)
+  {
+    return;
+  }
+
+  ch = (pRadio->orphanChannel == 0) ? MAC_SIM_CHAN_FIRST : pRadio->orphanChannel + 1;
+  while ((ch < MAC_SIM_CHAN_FIRST + MAC_SIM_CHAN_NUM) && !(pRadio->scanChannels & ((uint32)1 << ch)))
+  {
+    ch++;
+  }
+  if (ch == MAC_SIM_CHAN_FIRST + MAC_SIM_CHAN_NUM)
+  {
+    macSimScanDone(dev, arg);
+    return;
+  }
+  pRadio->orphanChannel = ch;
+  pRadio->stats.frames++;
+  pRadio->stats.airtime += airtime;
+  pRadio->stats.rxTime += wait;
+
+  memset(&ind, 0, sizeof(ind));
+  ind.event = MAC_MLME_ORPHAN_IND;
+  macSimExtCpy(ind.deviceAddress, pRadio->pib.extAddr);
+  for (i = 0; i < macSimNumRadios; i++)
+  {
+    const macSimRadio_t *pCoord = &macSimRadios[i];
+
+    if ((i == dev) || !pCoord->started || pCoord->scanning || (pCoord->pib.logicalChannel != ch))
+    {
+      continue;
+    }
+    if (macSimLink(dev, i, MAC_SIM_ORPHAN_LEN, &rssi, &lqi))
+    {
+      pRadio->stats.delivered++;
+      macSimIndicate(i, &ind);
+    }
+    else
+    {
+      pRadio->stats.lost++;
+    }
+  }
+
+  halSimSchedule(halSimNow() + airtime + wait, dev, macSimOrphanNext, arg);
+}
+
+/**************************************************************************************************
+ * @fn          macSimFlush
+ *
+ * @brief       Forget everything the radio was doing.  The frame on the air, if any, still has
+ *              an event pointing at it and is released by that event.
+ **************************************************************************************************
+ */
+static void macSimFlush(macSimRadio_t *pRadio)
+{
+  macSimTx_t *pTx;
+  macSimPend_t *pPend;
+
+  pRadio->epoch++;
+  pRadio->started = FALSE;
+  pRadio->scanning = FALSE;
+  if (pRadio->rxUntil != 0)
+  {
+    pRadio->stats.rxTime += halSimNow() - pRadio->rxSince;
+  }
+  pRadio->rxUntil = 0;
+  pRadio->waitGen++;
+  pRadio->waitAssoc = FALSE;
+
+  if (pRadio->pTxHead != NULL)
+  {
+    pTx = pRadio->pTxHead->pNext;
+    while (pTx != NULL)
+    {
+      macSimTx_t *pNext = pTx->pNext;
+      free(pTx);
+      pTx = pNext;
+    }
+    pRadio->pTxHead->pNext = NULL;
+    pRadio->pTxTail = pRadio->pTxHead;
+  }
+
+  while ((pPend = pRadio->pPend) != NULL)
+  {
+    pRadio->pPend = pPend->pNext;
+    free(pPend);
+  }
+}
+
+/**************************************************************************************************
+ */
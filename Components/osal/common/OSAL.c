@@ -67,6 +67,13 @@
  * MACROS
  */
 
+// Bit of a task in osalTasksReady, the highest priority task is the MSB
+#define OSAL_TASK_BIT(idx)  (0x8000 >> (idx))
+
+#if ( OSAL_TASK_STATS ) && !defined ( OSAL_TASK_STATS_CLOCK )
+  #define OSAL_TASK_STATS_CLOCK()  osal_GetSystemClock()
+#endif
+
 /*********************************************************************
  * CONSTANTS
  */
@@ -79,8 +86,9 @@
  * GLOBAL VARIABLES
  */
 
-// Message Pool Definitions
-osal_msg_q_t osal_qHead;
+// Message Pool Definitions: one queue per task, with its tail for O(1) appends
+osal_msg_q_t osal_qHead[OSAL_MAX_TASKS];
+static void *osal_qTail[OSAL_MAX_TASKS];
 
 /*********************************************************************
  * EXTERNAL VARIABLES
@@ -97,11 +105,19 @@ osal_msg_q_t osal_qHead;
 // Index of active task
 static uint8 activeTaskID = TASK_NO_TASK;
 
+// Tasks with events pending, kept in step with tasksEvents[]
+static uint16 osalTasksReady;
+
+#if ( OSAL_TASK_STATS )
+static osalTaskStats_t osalTaskStats[OSAL_MAX_TASKS];
+#endif
+
 /*********************************************************************
  * LOCAL FUNCTION PROTOTYPES
  */
 
 static uint8 osal_msg_enqueue_push( uint8 destination_task, uint8 *msg_ptr, uint8 urgent );
+static uint8 osalTaskFirst( uint16 ready );
 
 /*********************************************************************
  * HELPER FUNCTIONS
@@ -503,7 +519,7 @@ uint8 osal_msg_send( uint8 destination_task, uint8 *msg_ptr )
  * @brief
  *
  *    This function is called by a task to push a command message
- *    to the head of the OSAL queue. The destination_task field
+ *    to the head of the destination task's queue. The destination_task field
  *    must refer to a valid task, since the task ID will be used to
  *    send the message to. This function will also set a message
  *    ready event in the destination task's event list.
@@ -524,8 +540,8 @@ uint8 osal_msg_push_front( uint8 destination_task, uint8 *msg_ptr )
  * @brief
  *
  *    This function is called by a task to either enqueue (append to
- *    queue) or push (prepend to queue) a command message to the OSAL
- *    queue. The destination_task field must refer to a valid task,
+ *    queue) or push (prepend to queue) a command message to the queue
+ *    of the destination task. The destination_task field must refer to a valid task,
  *    since the task ID will be used to send the message to. This 
  *    function will also set a message ready event in the destination
  *    task's event list.
@@ -538,6 +554,8 @@ uint8 osal_msg_push_front( uint8 destination_task, uint8 *msg_ptr )
  */
 static uint8 osal_msg_enqueue_push( uint8 destination_task, uint8 *msg_ptr, uint8 push )
 {
+  halIntState_t intState;
+
   if ( msg_ptr == NULL )
   {
     return ( INVALID_MSG_POINTER );
@@ -559,20 +577,34 @@ static uint8 osal_msg_enqueue_push( uint8 destination_task, uint8 *msg_ptr, uint
 
   OSAL_MSG_ID( msg_ptr ) = destination_task;
 
-  if ( push == TRUE )
+  // Hold off interrupts
+  HAL_ENTER_CRITICAL_SECTION(intState);
+
+  if ( osal_qHead[destination_task] == NULL )
+  {
+    // first message of the task
+    osal_qHead[destination_task] = msg_ptr;
+    osal_qTail[destination_task] = msg_ptr;
+  }
+  else if ( push == TRUE )
   {
     // prepend the message
-    osal_msg_push( &osal_qHead, msg_ptr );
+    OSAL_MSG_NEXT( msg_ptr ) = osal_qHead[destination_task];
+    osal_qHead[destination_task] = msg_ptr;
   }
   else
   {
     // append the message
-    osal_msg_enqueue( &osal_qHead, msg_ptr );
+    OSAL_MSG_NEXT( osal_qTail[destination_task] ) = msg_ptr;
+    osal_qTail[destination_task] = msg_ptr;
   }
 
   // Signal the task that a message is waiting
   osal_set_event( destination_task, SYS_EVENT_MSG );
 
+  // Release interrupts
+  HAL_EXIT_CRITICAL_SECTION(intState);
+
   return ( SUCCESS );
 }
 
@@ -582,8 +614,9 @@ static uint8 osal_msg_enqueue_push( uint8 destination_task, uint8 *msg_ptr, uint
  * @brief
  *
  *    This function is called by a task to retrieve a received command
- *    message. The calling task must deallocate the message buffer after
- *    processing the message using the osal_msg_deallocate() call.
+ *    message from the head of its queue. The calling task must deallocate
+ *    the message buffer after processing the message using the
+ *    osal_msg_deallocate() call.
  *
  * @param   uint8 task_id - receiving tasks ID
  *
@@ -591,42 +624,31 @@ static uint8 osal_msg_enqueue_push( uint8 destination_task, uint8 *msg_ptr, uint
  */
 uint8 *osal_msg_receive( uint8 task_id )
 {
-  osal_msg_hdr_t *listHdr;
-  osal_msg_hdr_t *prevHdr = NULL;
   osal_msg_hdr_t *foundHdr = NULL;
   halIntState_t   intState;
 
+  if ( task_id >= tasksCnt )
+  {
+    return ( NULL );
+  }
+
   // Hold off interrupts
   HAL_ENTER_CRITICAL_SECTION(intState);
 
-  // Point to the top of the queue
-  listHdr = osal_qHead;
+  // The first message of the task's own queue
+  foundHdr = osal_qHead[task_id];
 
-  // Look through the queue for a message that belongs to the asking task
-  while ( listHdr != NULL )
+  // Did we find a message?
+  if ( foundHdr != NULL )
   {
-    if ( (listHdr - 1)->dest_id == task_id )
-    {
-      if ( foundHdr == NULL )
-      {
-        // Save the first one
-        foundHdr = listHdr;
-      }
-      else
-      {
-        // Second msg found, stop looking
-        break;
-      }
-    }
-    if ( foundHdr == NULL )
-    {
-      prevHdr = listHdr;
-    }
-    listHdr = OSAL_MSG_NEXT( listHdr );
+    // Take it off the queue
+    osal_qHead[task_id] = OSAL_MSG_NEXT( foundHdr );
+    OSAL_MSG_NEXT( foundHdr ) = NULL;
+    OSAL_MSG_ID( foundHdr ) = TASK_NO_TASK;
   }
 
-  // Is there more than one?
-  if ( listHdr != NULL )
+  // Is there another one?
+  if ( osal_qHead[task_id] != NULL )
   {
     // Yes, Signal the task that a message is waiting
     osal_set_event( task_id, SYS_EVENT_MSG );
@@ -637,13 +659,6 @@ uint8 *osal_msg_receive( uint8 task_id )
     osal_clear_event( task_id, SYS_EVENT_MSG );
   }
 
-  // Did we find a message?
-  if ( foundHdr != NULL )
-  {
-    // Take out of the link list
-    osal_msg_extract( &osal_qHead, foundHdr, prevHdr );
-  }
-
   // Release interrupts
   HAL_EXIT_CRITICAL_SECTION(intState);
 
@@ -673,14 +688,19 @@ osal_event_hdr_t *osal_msg_find(uint8 task_id, uint8 event)
   osal_msg_hdr_t *pHdr;
   halIntState_t intState;
 
+  if (task_id >= tasksCnt)
+  {
+    return NULL;
+  }
+
   HAL_ENTER_CRITICAL_SECTION(intState);  // Hold off interrupts.
 
-  pHdr = osal_qHead;  // Point to the top of the queue.
+  pHdr = osal_qHead[task_id];  // Point to the top of the task's queue.
 
-  // Look through the queue for a message that matches the task_id and event parameters.
+  // Look through the queue for a message that matches the event parameter.
   while (pHdr != NULL)
   {
-    if (((pHdr-1)->dest_id == task_id) && (((osal_event_hdr_t *)pHdr)->event == event))
+    if (((osal_event_hdr_t *)pHdr)->event == event)
     {
       break;
     }
@@ -906,6 +926,10 @@ uint8 osal_set_event( uint8 task_id, uint16 event_flag )
     halIntState_t   intState;
     HAL_ENTER_CRITICAL_SECTION(intState);    // Hold off interrupts
     tasksEvents[task_id] |= event_flag;  // Stuff the event bit(s)
+    if ( event_flag )
+    {
+      osalTasksReady |= OSAL_TASK_BIT( task_id );
+    }
     HAL_EXIT_CRITICAL_SECTION(intState);     // Release interrupts
     return ( SUCCESS );
   }
@@ -935,6 +959,10 @@ uint8 osal_clear_event( uint8 task_id, uint16 event_flag )
     halIntState_t   intState;
     HAL_ENTER_CRITICAL_SECTION(intState);    // Hold off interrupts
     tasksEvents[task_id] &= ~(event_flag);   // Clear the event bit(s)
+    if ( tasksEvents[task_id] == 0 )
+    {
+      osalTasksReady &= ~OSAL_TASK_BIT( task_id );
+    }
     HAL_EXIT_CRITICAL_SECTION(intState);     // Release interrupts
     return ( SUCCESS );
   }
@@ -1043,8 +1071,8 @@ uint8 osal_init_system( void )
   // Initialize the Memory Allocation System
   osal_mem_init();
 
-  // Initialize the message queue
-  osal_qHead = NULL;
+  // Initialize the message queues
+  (void)osal_memset( osal_qHead, 0, sizeof( osal_qHead ) );
 
   // Initialize the timers
   osalTimerInit();
@@ -1052,6 +1080,13 @@ uint8 osal_init_system( void )
   // Initialize the Power Management System
   osal_pwrmgr_init();
 
+  // Initialize the ready bitmap before the tasks can set events.
+  HAL_ASSERT( tasksCnt <= OSAL_MAX_TASKS );
+  osalTasksReady = 0;
+#if ( OSAL_TASK_STATS )
+  osal_task_stats_reset();
+#endif
+
   // Initialize the system tasks.
   osalInitTasks();
 
@@ -1089,9 +1124,11 @@ void osal_start_system( void )
  * @brief
  *
  *   This function will make one pass through the OSAL taskEvents table
- *   and call the task_event_processor() function for the first task that
- *   is found with at least one event pending. If there are no pending
- *   events (all tasks), this function puts the processor into Sleep.
+ *   and call the task_event_processor() function for the highest
+ *   priority task with at least one event pending, which it finds in
+ *   the ready bitmap without scanning the table. If there are no
+ *   pending events (all tasks), this function puts the processor into
+ *   Sleep.
  *
  * @param   void
  *
@@ -1099,37 +1136,48 @@ void osal_start_system( void )
  */
 void osal_run_system( void )
 {
-  uint8 idx = 0;
-
 #ifndef HAL_BOARD_CC2538
   osalTimeUpdate();
 #endif
   
   Hal_ProcessPoll();
 
-  do {
-    if (tasksEvents[idx])  // Task is highest priority that is ready.
-    {
-      break;
-    }
-  } while (++idx < tasksCnt);
-
-  if (idx < tasksCnt)
+  if (osalTasksReady)
   {
+    uint8 idx = osalTaskFirst(osalTasksReady);  // Task is highest priority that is ready.
     uint16 events;
     halIntState_t intState;
+#if ( OSAL_TASK_STATS )
+    uint32 start, run;
+#endif
 
     HAL_ENTER_CRITICAL_SECTION(intState);
     events = tasksEvents[idx];
     tasksEvents[idx] = 0;  // Clear the Events for this task.
+    osalTasksReady &= ~OSAL_TASK_BIT(idx);
     HAL_EXIT_CRITICAL_SECTION(intState);
 
     activeTaskID = idx;
+#if ( OSAL_TASK_STATS )
+    start = OSAL_TASK_STATS_CLOCK();
+#endif
     events = (tasksArr[idx])( idx, events );
+#if ( OSAL_TASK_STATS )
+    run = OSAL_TASK_STATS_CLOCK() - start;
+    osalTaskStats[idx].dispatches++;
+    if (run > osalTaskStats[idx].worst)
+    {
+      osalTaskStats[idx].worst = (run < 0xFFFF) ? (uint16)run : 0xFFFF;
+    }
+#endif
     activeTaskID = TASK_NO_TASK;
 
     HAL_ENTER_CRITICAL_SECTION(intState);
     tasksEvents[idx] |= events;  // Add back unprocessed events to the current task.
+    if (events)
+    {
+      osalTasksReady |= OSAL_TASK_BIT(idx);
+    }
     HAL_EXIT_CRITICAL_SECTION(intState);
   }
 #if defined( POWER_SAVING )
@@ -1241,5 +1289,117 @@ uint8 osal_self( void )
   return ( activeTaskID );
 }
 
+/*********************************************************************
+ * @fn      osal_events_pending
+ *
+ * @brief
+ *
+ *   This function checks if any task has an event pending, that is
+ *   if the next osal_run_system() will call a task.
+ *
+ * @param   void
+ *
+ * @return  TRUE if an event is pending, FALSE otherwise
+ */
+uint8 osal_events_pending( void )
+{
+  return ( osalTasksReady != 0 );
+}
+
+#if ( OSAL_TASK_STATS )
+/*********************************************************************
+ * @fn      osal_task_stats
+ *
+ * @brief
+ *
+ *   This function copies the statistics of a task: how many times its
+ *   event handler was called and its longest run, in
+ *   OSAL_TASK_STATS_CLOCK() units.
+ *
+ * @param   uint8 task_id - task to report
+ * @param   osalTaskStats_t *pStats - where to copy the statistics
+ *
+ * @return  SUCCESS, INVALID_TASK
+ */
+uint8 osal_task_stats( uint8 task_id, osalTaskStats_t *pStats )
+{
+  if ( task_id < tasksCnt )
+  {
+    halIntState_t intState;
+    HAL_ENTER_CRITICAL_SECTION(intState);    // Hold off interrupts
+    *pStats = osalTaskStats[task_id];
+    HAL_EXIT_CRITICAL_SECTION(intState);     // Release interrupts
+    return ( SUCCESS );
+  }
+  else
+  {
+    return ( INVALID_TASK );
+  }
+}
+
+/*********************************************************************
+ * @fn      osal_task_stats_reset
+ *
+ * @brief
+ *
+ *   This function clears the statistics of all tasks.
+ *
+ * @param   void
+ *
+ * @return  none
+ */
+void osal_task_stats_reset( void )
+{
+  halIntState_t intState;
+  HAL_ENTER_CRITICAL_SECTION(intState);    // Hold off interrupts
+  (void)osal_memset( osalTaskStats, 0, sizeof( osalTaskStats ) );
+  HAL_EXIT_CRITICAL_SECTION(intState);     // Release interrupts
+}
+#endif
+
+/*********************************************************************
+ * @fn      osalTaskFirst
+ *
+ * @brief
+ *
+ *   This function finds the highest priority task of a non-empty
+ *   ready bitmap by counting its leading zeros. Without a compiler
+ *   builtin, a binary search does it in four steps.
+ *
+ * @param   uint16 ready - ready bitmap, not 0
+ *
+ * @return  index of the task
+ */
+static uint8 osalTaskFirst( uint16 ready )
+{
+#if defined ( __GNUC__ )
+  return (uint8)( __builtin_clz( ready ) - ( sizeof( unsigned int ) * 8 - 16 ) );
+#else
+  uint8 idx = 0;
+
+  if ( !(ready & 0xFF00) )
+  {
+    idx += 8;
+    ready <<= 8;
+  }
+  if ( !(ready & 0xF000) )
+  {
+    idx += 4;
+    ready <<= 4;
+  }
+  if ( !(ready & 0xC000) )
+  {
+    idx += 2;
+    ready <<= 2;
+  }
+  if ( !(ready & 0x8000) )
+  {
+    idx += 1;
+  }
+
+  return ( idx );
+#endif
+}
+
 /*********************************************************************
  */
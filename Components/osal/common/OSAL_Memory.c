@@ -59,6 +59,10 @@
 #error MAXMEMHEAP is too big to manage!
 #endif
 
+#if (OSALMEM_TRACE && (OSALMEM_TRACE_LEN > 255))
+#error OSALMEM_TRACE_LEN is too big for the trace ring indices!
+#endif
+
 #define OSALMEM_HDRSZ              sizeof(osalMemHdr_t)
 
 // Round a value up to the ceiling of OSALMEM_HDRSZ for critical dependencies on even multiples.
@@ -102,7 +106,7 @@
 
 /* Adjust accordingly to attempt to accomodate the block sizes of the vast majority of
  * very high frequency allocations/frees by profiling the system runtime.
- * This default of 16 accomodates the OSAL timers block, osalTimerRec_t, and many others.
+ * This default of 16 accomodates many of them.
  * Ensure that this size is an even multiple of OSALMEM_MIN_BLKSZ for run-time efficiency.
  */
 #if !defined OSALMEM_SMALL_BLKSZ
@@ -132,6 +136,24 @@
 // fast comparisons with zero to determine the end of the heap.
 #define OSALMEM_LASTBLK_IDX      ((MAXMEMHEAP / OSALMEM_HDRSZ) - 1)
 
+/* Segregated-fit size classes for the allocations above OSALMEM_SMALL_BLKSZ, such as OSAL messages
+ * and MAC RX buffers. When enabled, such a request is rounded up to the smallest class that holds it
+ * and a freed block of a class size is kept on the free list of its class rather than returned to
+ * the heap, so a steady load is served in O(1) without walking the heap. The class blocks stay
+ * marked in-use to the first-fit walk. Only when the walk fails are they all given back to the heap
+ * to be coalesced, and the walk tried once more for the size asked without the rounding.
+ * The sizes include the block header, must be even multiples of OSALMEM_HDRSZ and in ascending
+ * order; sizes up to OSALMEM_SMALL_BLKSZ are left to the small-block bucket and not used. Profile
+ * the application to set them.
+ */
+#if !defined OSALMEM_SEGREGATED
+#define OSALMEM_SEGREGATED         FALSE
+#endif
+#if !defined OSALMEM_SEG_CLASSES
+#define OSALMEM_SEG_CLASSES        OSALMEM_ROUND(32), OSALMEM_ROUND(48), OSALMEM_ROUND(64), \
+                                   OSALMEM_ROUND(96), OSALMEM_ROUND(128), OSALMEM_ROUND(176)
+#endif
+
 // For information about memory profiling, refer to SWRA204 "Heap Memory Management", section 1.5.
 #if !defined OSALMEM_PROFILER
 #define OSALMEM_PROFILER           FALSE  // Enable/disable the memory usage profiling buckets.
@@ -185,6 +207,19 @@ static uint16 memAlo;  // Current total memory allocated.
 static uint16 memMax;  // Max total memory ever allocated at once.
 #endif
 
+#if OSALMEM_TRACE
+static osalMemTrace_t osalMemTraceRing[OSALMEM_TRACE_LEN];
+static uint8 osalMemTraceHead;       // Oldest record.
+static uint8 osalMemTraceCnt;
+static uint16 osalMemTraceLost;      // Records overwritten before they were read.
+#endif
+
+#if OSALMEM_SEGREGATED
+static const uint16 osalMemClassLen[] = { OSALMEM_SEG_CLASSES };
+#define OSALMEM_SEG_CNT  (sizeof(osalMemClassLen) / sizeof(osalMemClassLen[0]))
+static osalMemHdr_t *osalMemClassFree[OSALMEM_SEG_CNT];  // Free blocks kept per size class.
+#endif
+
 #if OSALMEM_PROFILER
 #define OSALMEM_PROMAX  8
 /* The profiling buckets must differ by at least OSALMEM_MIN_BLKSZ; the
@@ -208,6 +243,20 @@ static uint16 proSmallBlkMiss;
 extern int dprintf(const char *fmt, ...);
 #endif /* DPRINTF_HEAPTRACE */
 
+/* ------------------------------------------------------------------------------------------------
+ *                                           Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+
+static osalMemHdr_t *osalMemFirstFit(uint16 size);
+#if OSALMEM_TRACE
+static void osalMemTraceAdd(uint16 size, unsigned tag, osalMemHdr_t *hdr);
+#endif
+#if OSALMEM_SEGREGATED
+static uint8 osalMemClass(uint16 len);
+static uint8 osalMemClassFlush(void);
+#endif
+
 /**************************************************************************************************
  * @fn          osal_mem_init
  *
@@ -228,6 +277,18 @@ void osal_mem_init(void)
   HAL_ASSERT(((OSALMEM_MIN_BLKSZ % OSALMEM_HDRSZ) == 0));
   HAL_ASSERT(((OSALMEM_LL_BLKSZ % OSALMEM_HDRSZ) == 0));
   HAL_ASSERT(((OSALMEM_SMALL_BLKSZ % OSALMEM_HDRSZ) == 0));
+#if OSALMEM_SEGREGATED
+  {
+    uint8 idx;
+
+    for (idx = 0; idx < OSALMEM_SEG_CNT; idx++)
+    {
+      HAL_ASSERT(((osalMemClassLen[idx] % OSALMEM_HDRSZ) == 0));
+      HAL_ASSERT(((idx == 0) || (osalMemClassLen[idx] > osalMemClassLen[idx-1])));
+      osalMemClassFree[idx] = NULL;
+    }
+  }
+#endif
 
 #if OSALMEM_PROFILER
   (void)osal_memset(theHeap, OSALMEM_INIT, MAXMEMHEAP);
@@ -252,6 +313,10 @@ void osal_mem_init(void)
    */
   blkCnt = blkFree = 2;
 #endif
+
+#if OSALMEM_TRACE
+  osalMemTraceAdd(OSALMEM_TRACE_INIT, __LINE__, NULL);
+#endif
 }
 
 /**************************************************************************************************
@@ -287,6 +352,9 @@ void osal_mem_kick(void)
   ff1 = tmp - 1;       // Set 'ff1' to point to the first available memory after the LL block.
   osal_mem_free(tmp);
   osalMemStat = 0x01;  // Set 'osalMemStat' after the free because it enables memory profiling.
+#if OSALMEM_TRACE
+  osalMemTraceAdd(OSALMEM_TRACE_KICK, __LINE__, NULL);
+#endif
 
   HAL_EXIT_CRITICAL_SECTION(intState);  // Re-enable interrupts.
 }
@@ -306,16 +374,21 @@ void osal_mem_kick(void)
  *
  * @return      None.
  */
-#ifdef DPRINTF_OSALHEAPTRACE
+#ifdef OSALMEM_CALLER_INFO
 void *osal_mem_alloc_dbg( uint16 size, const char *fname, unsigned lnum )
-#else /* DPRINTF_OSALHEAPTRACE */
+#else /* OSALMEM_CALLER_INFO */
 void *osal_mem_alloc( uint16 size )
-#endif /* DPRINTF_OSALHEAPTRACE */
+#endif /* OSALMEM_CALLER_INFO */
 {
-  osalMemHdr_t *prev = NULL;
   osalMemHdr_t *hdr;
   halIntState_t intState;
-  uint8 coal = 0;
+#if OSALMEM_SEGREGATED
+  uint8 cls = OSALMEM_SEG_CNT;
+  uint16 need;
+#endif
+#if OSALMEM_TRACE
+  const uint16 asked = (size < OSALMEM_TRACE_MARK) ? size : (OSALMEM_TRACE_MARK - 1);
+#endif
 
   size += OSALMEM_HDRSZ;
 
@@ -334,63 +407,44 @@ void *osal_mem_alloc( uint16 size )
     }
   }
 
+#if OSALMEM_SEGREGATED
+  // Round a size class request up to the class, long-lived allocations are left as they are.
+  need = size;
+  if (osalMemStat != 0)
+  {
+    cls = osalMemClass(size);
+    if (cls < OSALMEM_SEG_CNT)
+    {
+      size = osalMemClassLen[cls];
+    }
+  }
+#endif
+
   HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
 
-  // Smaller allocations are first attempted in the small-block bucket, and all long-lived
-  // allocations are channeled into the LL block reserved within this bucket.
-  if ((osalMemStat == 0) || (size <= OSALMEM_SMALL_BLKSZ))
+#if OSALMEM_SEGREGATED
+  if ((cls < OSALMEM_SEG_CNT) && (osalMemClassFree[cls] != NULL))
   {
-    hdr = ff1;
+    // Take the first block of the class free list - it is still marked in-use and fits exactly.
+    hdr = osalMemClassFree[cls];
+    osalMemClassFree[cls] = *(osalMemHdr_t **)(hdr + 1);
   }
   else
   {
-    hdr = (theHeap + OSALMEM_BIGBLK_IDX);
-  }
+    hdr = osalMemFirstFit(size);
 
-  do
-  {
-    if ( hdr->hdr.inUse )
+    // Give the blocks kept by the size classes back to the heap and try once more, without the
+    // rounding up to the class.
+    if ((hdr == NULL) && (osalMemClassFlush() || (need != size)))
     {
-      coal = 0;
+      size = need;
+      hdr = osalMemFirstFit(size);
     }
-    else
-    {
-      if ( coal != 0 )
-      {
-#if ( OSALMEM_METRICS )
-        blkCnt--;
-        blkFree--;
+  }
+#else
+  hdr = osalMemFirstFit(size);
 #endif
 
-        prev->hdr.len += hdr->hdr.len;
-
-        if ( prev->hdr.len >= size )
-        {
-          hdr = prev;
-          break;
-        }
-      }
-      else
-      {
-        if ( hdr->hdr.len >= size )
-        {
-          break;
-        }
-
-        coal = 1;
-        prev = hdr;
-      }
-    }
-
-    hdr = (osalMemHdr_t *)((uint8 *)hdr + hdr->hdr.len);
-
-    if ( hdr->val == 0 )
-    {
-      hdr = NULL;
-      break;
-    }
-  } while (1);
-
   if ( hdr != NULL )
   {
     uint16 tmp = hdr->hdr.len - size;
@@ -475,6 +529,10 @@ void *osal_mem_alloc( uint16 size )
     hdr++;
   }
 
+#if OSALMEM_TRACE
+  osalMemTraceAdd(OSALMEM_TRACE_ALLOC | asked, lnum, (hdr != NULL) ? (hdr - 1) : NULL);
+#endif
+
   HAL_EXIT_CRITICAL_SECTION( intState );  // Re-enable interrupts.
 #pragma diag_suppress=Pe767
   HAL_ASSERT(((halDataAlign_t)hdr % sizeof(halDataAlign_t)) == 0);
@@ -501,14 +559,18 @@ void *osal_mem_alloc( uint16 size )
  *
  * @return      None.
  */
-#ifdef DPRINTF_OSALHEAPTRACE
+#ifdef OSALMEM_CALLER_INFO
 void osal_mem_free_dbg(void *ptr, const char *fname, unsigned lnum)
-#else /* DPRINTF_OSALHEAPTRACE */
+#else /* OSALMEM_CALLER_INFO */
 void osal_mem_free(void *ptr)
-#endif /* DPRINTF_OSALHEAPTRACE */
+#endif /* OSALMEM_CALLER_INFO */
 {
   osalMemHdr_t *hdr = (osalMemHdr_t *)ptr - 1;
   halIntState_t intState;
+#if OSALMEM_SEGREGATED
+  uint8 keep = FALSE;
+  uint8 cls;
+#endif
 
 #ifdef DPRINTF_OSALHEAPTRACE
   dprintf("osal_mem_free(%lx):%s:%u\n", (unsigned) ptr, fname, lnum);
@@ -518,11 +580,28 @@ void osal_mem_free(void *ptr)
   HAL_ASSERT(hdr->hdr.inUse);
 
   HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
-  hdr->hdr.inUse = FALSE;
 
-  if (ff1 > hdr)
+#if OSALMEM_TRACE
+  osalMemTraceAdd(OSALMEM_TRACE_FREE | hdr->hdr.len, lnum, hdr);
+#endif
+
+#if OSALMEM_SEGREGATED
+  // A block of a class size is kept for its class, still marked in-use to the first-fit walk.
+  if (osalMemStat != 0)
+  {
+    cls = osalMemClass(hdr->hdr.len);
+    keep = ((cls < OSALMEM_SEG_CNT) && (hdr->hdr.len == osalMemClassLen[cls]));
+  }
+
+  if (!keep)
+#endif
   {
-    ff1 = hdr;
+    hdr->hdr.inUse = FALSE;
+
+    if (ff1 > hdr)
+    {
+      ff1 = hdr;
+    }
   }
 
 #if OSALMEM_PROFILER
@@ -549,6 +628,13 @@ void osal_mem_free(void *ptr)
   memAlo -= hdr->hdr.len;
   blkFree++;
 #endif
+#if OSALMEM_SEGREGATED
+  if (keep)
+  {
+    *(osalMemHdr_t **)(hdr + 1) = osalMemClassFree[cls];
+    osalMemClassFree[cls] = hdr;
+  }
+#endif
 
   HAL_EXIT_CRITICAL_SECTION( intState );  // Re-enable interrupts.
 }
@@ -609,6 +695,126 @@ uint16 osal_heap_mem_used( void )
 {
   return memAlo;
 }
+
+/*********************************************************************
+ * @fn      osal_heap_mem_free
+ *
+ * @brief   Walk the heap and add up the free blocks, long-lived bucket
+ *          included. For diagnostics only, it holds off interrupts
+ *          for the whole walk.
+ *
+ * @param   none
+ *
+ * @return  Bytes in free blocks, headers included.
+ */
+uint16 osal_heap_mem_free( void )
+{
+  halIntState_t intState;
+  osalMemHdr_t *hdr = theHeap;
+  uint16 total = 0;
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+  while ( hdr->val != 0 )
+  {
+    if ( !hdr->hdr.inUse )
+    {
+      total += hdr->hdr.len;
+    }
+    hdr = (osalMemHdr_t *)((uint8 *)hdr + hdr->hdr.len);
+  }
+  HAL_EXIT_CRITICAL_SECTION( intState );  // Re-enable interrupts.
+
+  return total;
+}
+
+/*********************************************************************
+ * @fn      osal_heap_mem_largest
+ *
+ * @brief   Walk the heap for the largest block an allocation could
+ *          get, adjacent free blocks taken together as the allocation
+ *          would coalesce them. For diagnostics only, it holds off
+ *          interrupts for the whole walk.
+ *
+ * @param   none
+ *
+ * @return  Bytes in the largest free run, headers included.
+ */
+uint16 osal_heap_mem_largest( void )
+{
+  halIntState_t intState;
+  osalMemHdr_t *hdr = theHeap;
+  uint16 largest = 0;
+  uint16 run = 0;
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+  while ( hdr->val != 0 )
+  {
+    if ( hdr->hdr.inUse )
+    {
+      run = 0;
+    }
+    else
+    {
+      run += hdr->hdr.len;
+      if ( largest < run )
+      {
+        largest = run;
+      }
+    }
+    hdr = (osalMemHdr_t *)((uint8 *)hdr + hdr->hdr.len);
+  }
+  HAL_EXIT_CRITICAL_SECTION( intState );  // Re-enable interrupts.
+
+  return largest;
+}
+#endif
+
+#if OSALMEM_TRACE
+/*********************************************************************
+ * @fn      osal_mem_trace_read
+ *
+ * @brief   Move the oldest allocation trace records out of the ring,
+ *          to be streamed over a UART or stored in FRAM.
+ *
+ * @param   pBuf - where to copy the records
+ * @param   max - room in pBuf, in records
+ *
+ * @return  Number of records copied.
+ */
+uint8 osal_mem_trace_read( osalMemTrace_t *pBuf, uint8 max )
+{
+  halIntState_t intState;
+  uint8 cnt = 0;
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+  while ( (cnt < max) && (osalMemTraceCnt != 0) )
+  {
+    pBuf[cnt++] = osalMemTraceRing[osalMemTraceHead];
+    if ( ++osalMemTraceHead == OSALMEM_TRACE_LEN )
+    {
+      osalMemTraceHead = 0;
+    }
+    osalMemTraceCnt--;
+  }
+  HAL_EXIT_CRITICAL_SECTION( intState );  // Re-enable interrupts.
+
+  return cnt;
+}
+
+/*********************************************************************
+ * @fn      osal_mem_trace_lost
+ *
+ * @brief   Return the number of trace records overwritten because the
+ *          ring was not read out in time.
+ *
+ * @param   none
+ *
+ * @return  Number of records lost.
+ */
+uint16 osal_mem_trace_lost( void )
+{
+  return osalMemTraceLost;
+}
 #endif
 
 #if defined (ZTOOL_P1) || defined (ZTOOL_P2)
@@ -631,5 +837,212 @@ uint16 osal_heap_high_water( void )
 }
 #endif
 
+/**************************************************************************************************
+ * @fn          osalMemFirstFit
+ *
+ * @brief       Find the first free block that fits, coalescing free blocks on the way.
+ *              Ints must be disabled.
+ *
+ * input parameters
+ *
+ * @param size - the block size needed, including the header.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      The block found, or NULL.
+ */
+static osalMemHdr_t *osalMemFirstFit(uint16 size)
+{
+  osalMemHdr_t *prev = NULL;
+  osalMemHdr_t *hdr;
+  uint8 coal = 0;
+
+  // Smaller allocations are first attempted in the small-block bucket, and all long-lived
+  // allocations are channeled into the LL block reserved within this bucket.
+  if ((osalMemStat == 0) || (size <= OSALMEM_SMALL_BLKSZ))
+  {
+    hdr = ff1;
+  }
+  else
+  {
+    hdr = (theHeap + OSALMEM_BIGBLK_IDX);
+  }
+
+  do
+  {
+    if ( hdr->hdr.inUse )
+    {
+      coal = 0;
+    }
+    else
+    {
+      if ( coal != 0 )
+      {
+#if ( OSALMEM_METRICS )
+        blkCnt--;
+        blkFree--;
+#endif
+
+        prev->hdr.len += hdr->hdr.len;
+
+        if ( prev->hdr.len >= size )
+        {
+          hdr = prev;
+          break;
+        }
+      }
+      else
+      {
+        if ( hdr->hdr.len >= size )
+        {
+          break;
+        }
+
+        coal = 1;
+        prev = hdr;
+      }
+    }
+
+    hdr = (osalMemHdr_t *)((uint8 *)hdr + hdr->hdr.len);
+
+    if ( hdr->val == 0 )
+    {
+      hdr = NULL;
+      break;
+    }
+  } while (1);
+
+  return hdr;
+}
+
+#if OSALMEM_TRACE
+/**************************************************************************************************
+ * @fn          osalMemTraceAdd
+ *
+ * @brief       Add a record to the allocation trace ring, overwriting the oldest one when it is
+ *              full. Ints must be disabled.
+ *
+ * input parameters
+ *
+ * @param size - OSALMEM_TRACE_ALLOC/FREE and the size, or OSALMEM_TRACE_INIT/KICK.
+ * @param tag - the source line of the caller.
+ * @param hdr - the block, or NULL.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ */
+static void osalMemTraceAdd(uint16 size, unsigned tag, osalMemHdr_t *hdr)
+{
+  osalMemTrace_t *rec;
+  uint8 idx = osalMemTraceHead + osalMemTraceCnt;
+
+  if (idx >= OSALMEM_TRACE_LEN)
+  {
+    idx -= OSALMEM_TRACE_LEN;
+  }
+
+  if (osalMemTraceCnt == OSALMEM_TRACE_LEN)
+  {
+    // Full - drop the oldest record.
+    osalMemTraceLost++;
+    if (++osalMemTraceHead == OSALMEM_TRACE_LEN)
+    {
+      osalMemTraceHead = 0;
+    }
+  }
+  else
+  {
+    osalMemTraceCnt++;
+  }
+
+  rec = &osalMemTraceRing[idx];
+  rec->tick = (uint16)osal_GetSystemClock();
+  rec->size = size;
+  rec->tag = (uint16)tag;
+  rec->block = (hdr == NULL) ? OSALMEM_TRACE_FAILED : (uint16)((uint8 *)hdr - (uint8 *)theHeap);
+}
+#endif
+
+#if OSALMEM_SEGREGATED
+/**************************************************************************************************
+ * @fn          osalMemClass
+ *
+ * @brief       Find the smallest size class that holds a block.
+ *
+ * input parameters
+ *
+ * @param len - the block size, including the header.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      The index of the class, or OSALMEM_SEG_CNT if the block belongs to none.
+ */
+static uint8 osalMemClass(uint16 len)
+{
+  uint8 idx;
+
+  if (len <= OSALMEM_SMALL_BLKSZ)
+  {
+    return OSALMEM_SEG_CNT;
+  }
+
+  for (idx = 0; idx < OSALMEM_SEG_CNT; idx++)
+  {
+    if (len <= osalMemClassLen[idx])
+    {
+      break;
+    }
+  }
+
+  return idx;
+}
+
+/**************************************************************************************************
+ * @fn          osalMemClassFlush
+ *
+ * @brief       Give every block kept on the size class free lists back to the heap.
+ *              Ints must be disabled.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      TRUE if any block was given back.
+ */
+static uint8 osalMemClassFlush(void)
+{
+  osalMemHdr_t *hdr;
+  uint8 flushed = FALSE;
+  uint8 idx;
+
+  for (idx = 0; idx < OSALMEM_SEG_CNT; idx++)
+  {
+    while ((hdr = osalMemClassFree[idx]) != NULL)
+    {
+      osalMemClassFree[idx] = *(osalMemHdr_t **)(hdr + 1);
+      hdr->hdr.inUse = FALSE;
+      if (ff1 > hdr)
+      {
+        ff1 = hdr;
+      }
+      flushed = TRUE;
+    }
+  }
+
+  return flushed;
+}
+#endif
+
 /**************************************************************************************************
 */
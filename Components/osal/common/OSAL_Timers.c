@@ -37,6 +37,7 @@
   contact Texas Instruments Incorporated at www.TI.com.
 **************************************************************************************************/
 
+
 /*********************************************************************
  * INCLUDES
  */
@@ -51,35 +52,70 @@
  * MACROS
  */
 
+// Index of the wheel slot and of the hash bucket
+#define OSAL_TIMER_SHIFT( level )       ( (level) * OSAL_TIMER_SLOT_BITS )
+#define OSAL_TIMER_SPAN( level )        ( (uint32)1 << OSAL_TIMER_SHIFT( level ) )
+#define OSAL_TIMER_INDEX( time, level ) \
+  ( (uint8)((time) >> OSAL_TIMER_SHIFT( level )) & OSAL_TIMER_SLOT_MASK )
+#define OSAL_TIMER_HASH( task_id, event_flag ) \
+  ( ((uint16)((event_flag) * 0x9E37u) >> 12 ^ (task_id)) & (OSAL_TIMER_HASH_SIZE - 1) )
+
 /*********************************************************************
  * CONSTANTS
  */
 
+// The timers live in a hierarchical timing wheel.  Level 0 has one slot
+// per millisecond, every level above covers a whole turn of the level
+// below with each slot.  A timer is kept in the lowest level whose span
+// holds its remaining time and moves down a level whenever the slot it
+// sits in comes due, so a tick only touches the slots that are due.
+// Timers further out than the top level wait in an overflow list that
+// is looked at once per turn of the top level.
+#define OSAL_TIMER_SLOT_BITS      5
+#define OSAL_TIMER_SLOTS          ( 1 << OSAL_TIMER_SLOT_BITS )
+#define OSAL_TIMER_SLOT_MASK      ( OSAL_TIMER_SLOTS - 1 )
+
+// 4 levels of 32 slots reach 2^20 ms (17.5 minutes)
+#if !defined ( OSAL_TIMER_LEVELS )
+  #define OSAL_TIMER_LEVELS       4
+#endif
+
+// Buckets of the (task_id, event_flag) lookup, at most 16
+#define OSAL_TIMER_HASH_SIZE      16
+
+// Slot number of a timer in the overflow list
+#define OSAL_TIMER_OVERFLOW       0xFF
+
+// Timer records are taken from a fixed pool rather than the heap, size
+// it for the timers that can run at the same time
+#if !defined ( OSAL_TIMERS_POOL_SIZE )
+  #define OSAL_TIMERS_POOL_SIZE   16
+#endif
+
+#if ( OSAL_TIMERS_POOL_SIZE > 255 )
+  #error "OSAL_TIMERS_POOL_SIZE must fit osal_timer_num_active()"
+#endif
+
 /*********************************************************************
  * TYPEDEFS
  */
 
-typedef union {
-  uint32 time32;
-  uint16 time16[2];
-  uint8 time8[4];
-} osalTime_t;
-
-typedef struct
+typedef struct osalTimerRec
 {
-  void   *next;
-  osalTime_t timeout;
+  struct osalTimerRec *next;      // Slot list
+  struct osalTimerRec *prev;
+  struct osalTimerRec *hashNext;  // Lookup bucket
+  uint32 expires;                 // System clock at expiry
+  uint32 reloadTimeout;
   uint16 event_flag;
   uint8  task_id;
-  uint32 reloadTimeout;
+  uint8  slot;                    // (level << OSAL_TIMER_SLOT_BITS) | index
 } osalTimerRec_t;
 
 /*********************************************************************
  * GLOBAL VARIABLES
  */
 
-osalTimerRec_t *timerHead;
-
 /*********************************************************************
  * EXTERNAL VARIABLES
  */
@@ -94,6 +130,24 @@ osalTimerRec_t *timerHead;
 // Milliseconds since last reboot
 static uint32 osal_systemClock;
 
+// Time the wheel has been advanced to, only behind osal_systemClock
+// while osalTimerUpdate() runs
+static uint32 osalTimerNow;
+
+static osalTimerRec_t *osalTimerWheel[OSAL_TIMER_LEVELS][OSAL_TIMER_SLOTS];
+static uint32 osalTimerOccupied[OSAL_TIMER_LEVELS];
+static osalTimerRec_t *osalTimerOverflow;
+static osalTimerRec_t *osalTimerHash[OSAL_TIMER_HASH_SIZE];
+static uint8 osalTimerCount;
+
+// Record pool, the free records are chained through 'next'
+static osalTimerRec_t osalTimerPool[OSAL_TIMERS_POOL_SIZE];
+static osalTimerRec_t *osalTimerFree;
+
+// Exhaustion counters
+static uint8 osalTimerHighWater;
+static uint16 osalTimerFailed;
+
 /*********************************************************************
  * LOCAL FUNCTION PROTOTYPES
  */
@@ -101,6 +155,13 @@ osalTimerRec_t  *osalAddTimer( uint8 task_id, uint16 event_flag, uint32 timeout
 osalTimerRec_t *osalFindTimer( uint8 task_id, uint16 event_flag );
 void osalDeleteTimer( osalTimerRec_t *rmTimer );
 
+static void osalTimerRemove( osalTimerRec_t *rmTimer );
+static void osalTimerLink( osalTimerRec_t *timer );
+static void osalTimerUnlink( osalTimerRec_t *timer );
+static void osalTimerCascade( uint8 level );
+static uint32 osalTimerNextTick( void );
+static uint8 osalTimerFirstSlot( uint32 occupied, uint8 index );
+
 /*********************************************************************
  * FUNCTIONS
  *********************************************************************/
@@ -116,13 +177,24 @@ void osalDeleteTimer( osalTimerRec_t *rmTimer );
  */
 void osalTimerInit( void )
 {
+  uint8 idx;
+
   osal_systemClock = 0;
+  osalTimerNow = 0;
+
+  // Chain the whole pool on the free list
+  osalTimerFree = NULL;
+  for ( idx = 0; idx < OSAL_TIMERS_POOL_SIZE; idx++ )
+  {
+    osalTimerPool[idx].next = osalTimerFree;
+    osalTimerFree = &osalTimerPool[idx];
+  }
 }
 
 /*********************************************************************
  * @fn      osalAddTimer
  *
- * @brief   Add a timer to the timer list.
+ * @brief   Add a timer to the timer wheel.
  *          Ints must be disabled.
  *
  * @param   task_id
@@ -134,54 +206,57 @@ void osalTimerInit( void )
 osalTimerRec_t * osalAddTimer( uint8 task_id, uint16 event_flag, uint32 timeout )
 {
   osalTimerRec_t *newTimer;
-  osalTimerRec_t *srchTimer;
+  uint8 bucket;
+
+  // A zero timeout expires with the next update, as any other
+  if ( timeout == 0 )
+  {
+    timeout = 1;
+  }
 
   // Look for an existing timer first
   newTimer = osalFindTimer( task_id, event_flag );
   if ( newTimer )
   {
-    // Timer is found - update it.
-    newTimer->timeout.time32 = timeout;
+    // Timer is found - move it to its new slot.
+    osalTimerUnlink( newTimer );
+    newTimer->expires = osal_systemClock + timeout;
+    osalTimerLink( newTimer );
 
     return ( newTimer );
   }
   else
   {
     // New Timer
-    newTimer = osal_mem_alloc( sizeof( osalTimerRec_t ) );
+    newTimer = osalTimerFree;
 
     if ( newTimer )
     {
+      osalTimerFree = newTimer->next;
+
       // Fill in new timer
       newTimer->task_id = task_id;
       newTimer->event_flag = event_flag;
-      newTimer->timeout.time32 = timeout;
-      newTimer->next = (void *)NULL;
+      newTimer->expires = osal_systemClock + timeout;
       newTimer->reloadTimeout = 0;
 
-      // Does the timer list already exist
-      if ( timerHead == NULL )
+      // Add it to its lookup bucket and to the wheel
+      bucket = OSAL_TIMER_HASH( task_id, event_flag );
+      newTimer->hashNext = osalTimerHash[bucket];
+      osalTimerHash[bucket] = newTimer;
+      osalTimerLink( newTimer );
+      osalTimerCount++;
+      if ( osalTimerCount > osalTimerHighWater )
       {
-        // Start task list
-        timerHead = newTimer;
-      }
-      else
-      {
-        // Add it to the end of the timer list
-        srchTimer = timerHead;
-
-        // Stop at the last record
-        while ( srchTimer->next )
-          srchTimer = srchTimer->next;
-
-        // Add to the list
-        srchTimer->next = newTimer;
+        osalTimerHighWater = osalTimerCount;
       }
 
       return ( newTimer );
     }
     else
     {
+      // Pool exhausted
+      osalTimerFailed++;
       return ( (osalTimerRec_t *)NULL );
     }
   }
@@ -190,7 +265,7 @@ osalTimerRec_t * osalAddTimer( uint8 task_id, uint16 event_flag, uint32 timeout
 /*********************************************************************
  * @fn      osalFindTimer
  *
- * @brief   Find a timer in a timer list.
+ * @brief   Find a timer in the timer wheel.
  *          Ints must be disabled.
  *
  * @param   task_id
@@ -202,8 +277,8 @@ osalTimerRec_t *osalFindTimer( uint8 task_id, uint16 event_flag )
 {
   osalTimerRec_t *srchTimer;
 
-  // Head of the timer list
-  srchTimer = timerHead;
+  // Head of the lookup bucket
+  srchTimer = osalTimerHash[OSAL_TIMER_HASH( task_id, event_flag )];
 
   // Stop when found or at the end
   while ( srchTimer )
@@ -215,7 +290,7 @@ osalTimerRec_t *osalFindTimer( uint8 task_id, uint16 event_flag )
     }
 
     // Not this one, check another
-    srchTimer = srchTimer->next;
+    srchTimer = srchTimer->hashNext;
   }
 
   return ( srchTimer );
@@ -224,22 +299,272 @@ osalTimerRec_t *osalFindTimer( uint8 task_id, uint16 event_flag )
 /*********************************************************************
  * @fn      osalDeleteTimer
  *
- * @brief   Delete a timer from a timer list.
+ * @brief   Delete a timer from the timer wheel.
+ *          Ints must be disabled.
  *
- * @param   table
  * @param   rmTimer
  *
  * @return  none
  */
 void osalDeleteTimer( osalTimerRec_t *rmTimer )
 {
-  // Does the timer list really exist
+  // Does the timer really exist
   if ( rmTimer )
   {
-    // Clear the event flag and osalTimerUpdate() will delete
-    // the timer from the list.
-    rmTimer->event_flag = 0;
+    osalTimerRemove( rmTimer );
+
+    // Back to the pool
+    rmTimer->next = osalTimerFree;
+    osalTimerFree = rmTimer;
+  }
+}
+
+/*********************************************************************
+ * @fn      osalTimerRemove
+ *
+ * @brief   Take a timer out of the wheel and of its lookup bucket.
+ *          Ints must be disabled.
+ *
+ * @param   rmTimer
+ *
+ * @return  none
+ */
+static void osalTimerRemove( osalTimerRec_t *rmTimer )
+{
+  osalTimerRec_t **srchTimer;
+
+  osalTimerUnlink( rmTimer );
+
+  srchTimer = &osalTimerHash[OSAL_TIMER_HASH( rmTimer->task_id, rmTimer->event_flag )];
+  while ( *srchTimer != rmTimer )
+  {
+    srchTimer = &(*srchTimer)->hashNext;
+  }
+  *srchTimer = rmTimer->hashNext;
+
+  osalTimerCount--;
+}
+
+/*********************************************************************
+ * @fn      osalTimerLink
+ *
+ * @brief   Put a timer in the slot of the lowest level whose span
+ *          holds its remaining time, or in the overflow list.
+ *          Ints must be disabled.
+ *
+ * @param   timer
+ *
+ * @return  none
+ */
+static void osalTimerLink( osalTimerRec_t *timer )
+{
+  osalTimerRec_t **head;
+  uint32 delta = timer->expires - osalTimerNow;
+  uint8 level = 0;
+  uint8 index;
+
+  while ( (level < OSAL_TIMER_LEVELS) && (delta >= OSAL_TIMER_SPAN( level + 1 )) )
+  {
+    level++;
+  }
+
+  if ( level < OSAL_TIMER_LEVELS )
+  {
+    index = OSAL_TIMER_INDEX( timer->expires, level );
+    head = &osalTimerWheel[level][index];
+    osalTimerOccupied[level] |= (uint32)1 << index;
+    timer->slot = (level << OSAL_TIMER_SLOT_BITS) | index;
+  }
+  else
+  {
+    head = &osalTimerOverflow;
+    timer->slot = OSAL_TIMER_OVERFLOW;
+  }
+
+  timer->prev = NULL;
+  timer->next = *head;
+  if ( *head )
+  {
+    (*head)->prev = timer;
+  }
+  *head = timer;
+}
+
+/*********************************************************************
+ * @fn      osalTimerUnlink
+ *
+ * @brief   Take a timer out of its slot.
+ *          Ints must be disabled.
+ *
+ * @param   timer
+ *
+ * @return  none
+ */
+static void osalTimerUnlink( osalTimerRec_t *timer )
+{
+  osalTimerRec_t **head;
+  uint8 level = timer->slot >> OSAL_TIMER_SLOT_BITS;
+  uint8 index = timer->slot & OSAL_TIMER_SLOT_MASK;
+
+  if ( timer->slot == OSAL_TIMER_OVERFLOW )
+  {
+    head = &osalTimerOverflow;
+  }
+  else
+  {
+    head = &osalTimerWheel[level][index];
+  }
+
+  if ( timer->prev )
+  {
+    timer->prev->next = timer->next;
+  }
+  else
+  {
+    *head = timer->next;
+  }
+  if ( timer->next )
+  {
+    timer->next->prev = timer->prev;
+  }
+
+  if ( (*head == NULL) && (timer->slot != OSAL_TIMER_OVERFLOW) )
+  {
+    osalTimerOccupied[level] &= ~((uint32)1 << index);
+  }
+}
+
+/*********************************************************************
+ * @fn      osalTimerCascade
+ *
+ * @brief   Move the timers of the slot of a level that is due now
+ *          to the levels below.  One timer is moved per critical
+ *          section.  The overflow list is sorted out in one, it only
+ *          holds timers more than a turn of the top level away.
+ *
+ * @param   level - 1 to OSAL_TIMER_LEVELS, the latter for overflow
+ *
+ * @return  none
+ */
+static void osalTimerCascade( uint8 level )
+{
+  halIntState_t intState;
+  osalTimerRec_t *srchTimer;
+  osalTimerRec_t *nextTimer;
+  osalTimerRec_t **head;
+
+  if ( level == OSAL_TIMER_LEVELS )
+  {
+    HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+    for ( srchTimer = osalTimerOverflow; srchTimer; srchTimer = nextTimer )
+    {
+      nextTimer = srchTimer->next;
+      if ( (srchTimer->expires - osalTimerNow) < OSAL_TIMER_SPAN( OSAL_TIMER_LEVELS ) )
+      {
+        osalTimerUnlink( srchTimer );
+        osalTimerLink( srchTimer );
+      }
+    }
+
+    HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+    return;
+  }
+
+  head = &osalTimerWheel[level][OSAL_TIMER_INDEX( osalTimerNow, level )];
+  do
+  {
+    HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+    srchTimer = *head;
+    if ( srchTimer )
+    {
+      // Due within this slot's span, so it lands on a lower level
+      osalTimerUnlink( srchTimer );
+      osalTimerLink( srchTimer );
+    }
+
+    HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+  } while ( srchTimer );
+}
+
+/*********************************************************************
+ * @fn      osalTimerFirstSlot
+ *
+ * @brief   Distance from a slot to the first occupied slot at or
+ *          after it, wrapping around the level.
+ *
+ * @param   occupied - slot bitmap of the level, not zero
+ * @param   index - slot to start from
+ *
+ * @return  0 to OSAL_TIMER_SLOTS - 1
+ */
+static uint8 osalTimerFirstSlot( uint32 occupied, uint8 index )
+{
+  uint8 dist = 0;
+
+  // Rotate the slot to start from down to bit 0
+  if ( index )
+  {
+    occupied = (occupied >> index) | (occupied << (OSAL_TIMER_SLOTS - index));
+  }
+
+  if ( (occupied & 0xFFFF) == 0 ) { occupied >>= 16; dist += 16; }
+  if ( (occupied & 0x00FF) == 0 ) { occupied >>= 8;  dist += 8;  }
+  if ( (occupied & 0x000F) == 0 ) { occupied >>= 4;  dist += 4;  }
+  if ( (occupied & 0x0003) == 0 ) { occupied >>= 2;  dist += 2;  }
+  if ( (occupied & 0x0001) == 0 ) {                  dist += 1;  }
+
+  return ( dist );
+}
+
+/*********************************************************************
+ * @fn      osalTimerNextTick
+ *
+ * @brief   Find the next time the wheel has work to do: a level 0
+ *          slot to expire or a higher level slot to cascade.
+ *          Ints must be disabled.
+ *
+ * @param   none
+ *
+ * @return  milliseconds from osalTimerNow, 0 if there are no timers
+ */
+static uint32 osalTimerNextTick( void )
+{
+  uint32 from = osalTimerNow + 1;
+  uint32 next = 0;
+  uint32 slotTime;
+  uint32 delta;
+  uint8 level;
+
+  for ( level = 0; level <= OSAL_TIMER_LEVELS; level++ )
+  {
+    // First slot boundary of this level at or after 'from'
+    slotTime = (from >> OSAL_TIMER_SHIFT( level )) +
+               ((from & (OSAL_TIMER_SPAN( level ) - 1)) != 0);
+
+    if ( level < OSAL_TIMER_LEVELS )
+    {
+      if ( osalTimerOccupied[level] == 0 )
+      {
+        continue;
+      }
+      slotTime += osalTimerFirstSlot( osalTimerOccupied[level],
+                                      (uint8)slotTime & OSAL_TIMER_SLOT_MASK );
+    }
+    else if ( osalTimerOverflow == NULL )
+    {
+      continue;
+    }
+
+    delta = (slotTime << OSAL_TIMER_SHIFT( level )) - osalTimerNow;
+    if ( (next == 0) || (delta < next) )
+    {
+      next = delta;
+    }
   }
+
+  return ( next );
 }
 
 /*********************************************************************
@@ -361,7 +686,7 @@ uint32 osal_get_timeoutEx( uint8 task_id, uint16 event_id )
 
   if ( tmr )
   {
-    rtrn = tmr->timeout.time32;
+    rtrn = tmr->expires - osal_systemClock;
   }
 
   HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
@@ -380,25 +705,37 @@ uint32 osal_get_timeoutEx( uint8 task_id, uint16 event_id )
  */
 uint8 osal_timer_num_active( void )
 {
-  halIntState_t intState;
-  uint8 num_timers = 0;
-  osalTimerRec_t *srchTimer;
-
-  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
-
-  // Head of the timer list
-  srchTimer = timerHead;
-
-  // Count timers in the list
-  while ( srchTimer != NULL )
-  {
-    num_timers++;
-    srchTimer = srchTimer->next;
-  }
+  return osalTimerCount;
+}
 
-  HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+/*********************************************************************
+ * @fn      osal_timer_high_water
+ *
+ * @brief
+ *
+ *   This function returns the most timers that have been active at
+ *   the same time, to size OSAL_TIMERS_POOL_SIZE.
+ *
+ * @return  uint8 - number of timers
+ */
+uint8 osal_timer_high_water( void )
+{
+  return osalTimerHighWater;
+}
 
-  return num_timers;
+/*********************************************************************
+ * @fn      osal_timer_num_failed
+ *
+ * @brief
+ *
+ *   This function counts the timers that could not be started
+ *   because the timer pool was exhausted.
+ *
+ * @return  uint16 - number of NO_TIMER_AVAIL returns
+ */
+uint16 osal_timer_num_failed( void )
+{
+  return osalTimerFailed;
 }
 
 /*********************************************************************
@@ -406,7 +743,12 @@ uint8 osal_timer_num_active( void )
  *
  * @brief   Update the timer structures for a timer tick.
  *
- * @param   none
+ *          The wheel is stepped straight to each time it has work
+ *          to do up to the new system clock, so the cost depends on
+ *          the timers due and not on the timers running.  Interrupts
+ *          are held off for one timer at a time.
+ *
+ * @param   updateTime - milliseconds elapsed
  *
  * @return  none
  *********************************************************************/
@@ -414,114 +756,75 @@ void osalTimerUpdate( uint32 updateTime )
 {
   halIntState_t intState;
   osalTimerRec_t *srchTimer;
-  osalTimerRec_t *prevTimer;
-
-  osalTime_t timeUnion;
-  timeUnion.time32 = updateTime;
+  osalTimerRec_t **head;
+  uint32 target;
+  uint32 step;
+  uint16 event_flag;
+  uint8 task_id;
+  uint8 level;
 
   HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
   // Update the system time
   osal_systemClock += updateTime;
+  target = osal_systemClock;
   HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
 
-  // Look for open timer slot
-  if ( timerHead != NULL )
+  for ( ;; )
   {
-    // Add it to the end of the timer list
-    srchTimer = timerHead;
-    prevTimer = (void *)NULL;
+    HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
 
-    // Look for open timer slot
-    while ( srchTimer )
+    step = osalTimerNextTick();
+    if ( (step == 0) || (step > target - osalTimerNow) )
     {
-      osalTimerRec_t *freeTimer = NULL;
-
-      HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+      // Nothing more is due
+      osalTimerNow = target;
+      HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+      break;
+    }
+    osalTimerNow += step;
 
-      // To minimize time in this critical section, avoid 32-bit math
-      if ((timeUnion.time16[1] == 0) && (timeUnion.time8[1] == 0))
-      {
-        // If upper 24 bits are zero, check lower 8 bits for roll over
-        if (srchTimer->timeout.time8[0] >= timeUnion.time8[0])
-        {
-          // 8-bit math
-          srchTimer->timeout.time8[0] -= timeUnion.time8[0];
-        }
-        else
-        {
-          // 32-bit math
-          if (srchTimer->timeout.time32 > timeUnion.time32)
-          {
-            srchTimer->timeout.time32 -= timeUnion.time32;
-          }
-          else
-          {
-            srchTimer->timeout.time32 = 0;
-          }
-        }
-      }
-      else
-      {
-          // 32-bit math
-        if (srchTimer->timeout.time32 > timeUnion.time32)
-        {
-          srchTimer->timeout.time32 -= timeUnion.time32;
-        }
-        else
-        {
-          srchTimer->timeout.time32 = 0;
-        }
-      }
+    HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
 
-      // Check for reloading
-      if ( (srchTimer->timeout.time16[0] == 0) && (srchTimer->timeout.time16[1] == 0) &&
-           (srchTimer->reloadTimeout) && (srchTimer->event_flag) )
-      {
-        // Notify the task of a timeout
-        osal_set_event( srchTimer->task_id, srchTimer->event_flag );
+    // Bring down the timers of every level that has turned a slot
+    for ( level = 1; (level <= OSAL_TIMER_LEVELS) &&
+                     ((osalTimerNow & (OSAL_TIMER_SPAN( level ) - 1)) == 0); level++ )
+    {
+      osalTimerCascade( level );
+    }
 
-        // Reload the timer timeout value
-        srchTimer->timeout.time32 = srchTimer->reloadTimeout;
-      }
+    // Expire the level 0 slot
+    head = &osalTimerWheel[0][OSAL_TIMER_INDEX( osalTimerNow, 0 )];
+    do
+    {
+      HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
 
-      // When timeout or delete (event_flag == 0)
-      if ( ((srchTimer->timeout.time16[0] == 0) && (srchTimer->timeout.time16[1] == 0)) ||
-            (srchTimer->event_flag == 0) )
+      srchTimer = *head;
+      if ( srchTimer )
       {
-        // Take out of list
-        if ( prevTimer == NULL )
+        task_id = srchTimer->task_id;
+        event_flag = srchTimer->event_flag;
+
+        if ( srchTimer->reloadTimeout )
         {
-          timerHead = srchTimer->next;
+          // Reload the timer timeout value
+          osalTimerUnlink( srchTimer );
+          srchTimer->expires = target + srchTimer->reloadTimeout;
+          osalTimerLink( srchTimer );
         }
         else
         {
-          prevTimer->next = srchTimer->next;
+          osalDeleteTimer( srchTimer );
         }
-
-        // Setup to free memory
-        freeTimer = srchTimer;
-
-        // Next
-        srchTimer = srchTimer->next;
-      }
-      else
-      {
-        // Get next
-        prevTimer = srchTimer;
-        srchTimer = srchTimer->next;
       }
 
       HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
 
-      if ( freeTimer )
+      if ( srchTimer )
       {
-        if ( (freeTimer->timeout.time16[0] == 0) && (freeTimer->timeout.time16[1] == 0) )
-        {
-          osal_set_event( freeTimer->task_id, freeTimer->event_flag );
-        }
-        osal_mem_free( freeTimer );
+        // Notify the task of a timeout
+        osal_set_event( task_id, event_flag );
       }
-    }
+    } while ( srchTimer );
   }
 }
 
@@ -539,7 +842,7 @@ void osal_adjust_timers( void )
 {
   uint32 eTime;
 
-  if ( timerHead != NULL )
+  if ( osalTimerCount != 0 )
   {
     // Compute elapsed time (msec)
     eTime = TimerElapsed() / TICK_COUNT;
@@ -556,8 +859,12 @@ void osal_adjust_timers( void )
  *
  * @brief
  *
- *   Search timer table to return the lowest timeout value. If the
- *   timer list is empty, then the returned timeout will be zero.
+ *   Search the timer wheel to return the lowest timeout value. If
+ *   there are no timers, then the returned timeout will be zero.
+ *
+ *   The first occupied level 0 slot is exact; on the levels above
+ *   only the slots that start before the best time found so far
+ *   are looked into.
  *
  * @param   none
  *
@@ -566,29 +873,65 @@ void osal_adjust_timers( void )
 uint32 osal_next_timeout( void )
 {
   uint32 nextTimeout;
+  uint32 from = osalTimerNow + 1;
+  uint32 occupied;
+  uint32 slotTime;
+  uint32 delta;
   osalTimerRec_t *srchTimer;
+  uint8 level;
+  uint8 index;
+
+  if ( osalTimerCount == 0 )
+  {
+    // No timers
+    return ( 0 );
+  }
 
-  if ( timerHead != NULL )
+  nextTimeout = OSAL_TIMERS_MAX_TIMEOUT;
+
+  for ( level = 0; level < OSAL_TIMER_LEVELS; level++ )
   {
-    // Head of the timer list
-    srchTimer = timerHead;
-    nextTimeout = OSAL_TIMERS_MAX_TIMEOUT;
+    occupied = osalTimerOccupied[level];
+    slotTime = (from >> OSAL_TIMER_SHIFT( level )) +
+               ((from & (OSAL_TIMER_SPAN( level ) - 1)) != 0);
 
-    // Look for the next timeout timer
-    while ( srchTimer != NULL )
+    while ( occupied )
     {
-      if (srchTimer->timeout.time32 < nextTimeout)
+      slotTime += osalTimerFirstSlot( occupied, (uint8)slotTime & OSAL_TIMER_SLOT_MASK );
+      delta = (slotTime << OSAL_TIMER_SHIFT( level )) - osalTimerNow;
+      if ( delta >= nextTimeout )
+      {
+        // Nothing on this level expires earlier
+        break;
+      }
+
+      index = (uint8)slotTime & OSAL_TIMER_SLOT_MASK;
+      if ( level == 0 )
       {
-        nextTimeout = srchTimer->timeout.time32;
+        nextTimeout = delta;
+        break;
       }
-      // Check next timer
-      srchTimer = srchTimer->next;
+
+      for ( srchTimer = osalTimerWheel[level][index]; srchTimer; srchTimer = srchTimer->next )
+      {
+        if ( (srchTimer->expires - osalTimerNow) < nextTimeout )
+        {
+          nextTimeout = srchTimer->expires - osalTimerNow;
+        }
+      }
+
+      occupied &= ~((uint32)1 << index);
+      slotTime++;
     }
   }
-  else
+
+  // Look for the next timeout timer beyond the top level
+  for ( srchTimer = osalTimerOverflow; srchTimer; srchTimer = srchTimer->next )
   {
-    // No timers
-    nextTimeout = 0;
+    if ( (srchTimer->expires - osalTimerNow) < nextTimeout )
+    {
+      nextTimeout = srchTimer->expires - osalTimerNow;
+    }
   }
 
   return ( nextTimeout );
@@ -86,6 +86,15 @@ extern "C"
 /*** Interrupts ***/
 #define INTS_ALL    0xFF
 
+/*** Tasks ***/
+// Most tasks the ready bitmap of osal_run_system() can hold
+#define OSAL_MAX_TASKS    16
+
+// Count the dispatches of every task and the longest run of its event handler
+#if !defined ( OSAL_TASK_STATS )
+  #define OSAL_TASK_STATS  FALSE
+#endif
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -104,6 +113,13 @@ typedef struct
 
 typedef void * osal_msg_q_t;
 
+// Task statistics; durations are in OSAL_TASK_STATS_CLOCK() units, MAC backoffs on the MSP430
+typedef struct
+{
+  uint32 dispatches;  // Calls of the event handler
+  uint16 worst;       // Longest handler run
+} osalTaskStats_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -228,6 +244,19 @@ typedef void * osal_msg_q_t;
    */
   extern uint8 osal_self( void );
 
+  /*
+   * Check if any task has an event pending
+   */
+  extern uint8 osal_events_pending( void );
+
+#if ( OSAL_TASK_STATS )
+  /*
+   * Get and reset the statistics of a task
+   */
+  extern uint8 osal_task_stats( uint8 task_id, osalTaskStats_t *pStats );
+  extern void osal_task_stats_reset( void );
+#endif
+
 
 /*** Helper Functions ***/
 
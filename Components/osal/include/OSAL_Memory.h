@@ -58,6 +58,30 @@ extern "C"
   #define OSALMEM_METRICS  FALSE
 #endif
 
+// Record every allocation and free in a ring to be read out with osal_mem_trace_read()
+#if !defined ( OSALMEM_TRACE )
+  #define OSALMEM_TRACE  FALSE
+#endif
+#if !defined ( OSALMEM_TRACE_LEN )
+  #define OSALMEM_TRACE_LEN  32
+#endif
+
+// osalMemTrace_t size field
+#define OSALMEM_TRACE_ALLOC    0x0000  // Size asked for
+#define OSALMEM_TRACE_FREE     0x8000  // Length of the block freed, header included
+#define OSALMEM_TRACE_MARK     0x4000  // No block, see below
+#define OSALMEM_TRACE_OP_MASK  0xC000
+#define OSALMEM_TRACE_INIT     (OSALMEM_TRACE_MARK | 0)  // osal_mem_init()
+#define OSALMEM_TRACE_KICK     (OSALMEM_TRACE_MARK | 1)  // osal_mem_kick()
+
+// osalMemTrace_t block field of a failed allocation
+#define OSALMEM_TRACE_FAILED   0xFFFF
+
+// The callers' source lines are passed down for the trace or the heap trace printout
+#if defined ( DPRINTF_OSALHEAPTRACE ) || OSALMEM_TRACE
+  #define OSALMEM_CALLER_INFO
+#endif
+
 /*********************************************************************
  * MACROS
  */
@@ -68,6 +92,15 @@ extern "C"
  * TYPEDEFS
  */
 
+// Allocation trace record
+typedef struct
+{
+  uint16 tick;   // osal_GetSystemClock(), low 16 bits
+  uint16 size;   // OSALMEM_TRACE_ALLOC/FREE | size, or OSALMEM_TRACE_INIT/KICK
+  uint16 tag;    // Source line of the caller
+  uint16 block;  // Offset of the block header in the heap
+} osalMemTrace_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -89,22 +122,22 @@ extern "C"
  /*
   * Allocate a block of memory.
   */
-#ifdef DPRINTF_OSALHEAPTRACE
+#ifdef OSALMEM_CALLER_INFO
   void *osal_mem_alloc_dbg( uint16 size, const char *fname, unsigned lnum );
 #define osal_mem_alloc(_size ) osal_mem_alloc_dbg(_size, __FILE__, __LINE__)
-#else /* DPRINTF_OSALHEAPTRACE */
+#else /* OSALMEM_CALLER_INFO */
   void *osal_mem_alloc( uint16 size );
-#endif /* DPRINTF_OSALHEAPTRACE */
+#endif /* OSALMEM_CALLER_INFO */
 
  /*
   * Free a block of memory.
   */
-#ifdef DPRINTF_OSALHEAPTRACE
+#ifdef OSALMEM_CALLER_INFO
   void osal_mem_free_dbg( void *ptr, const char *fname, unsigned lnum );
 #define osal_mem_free(_ptr ) osal_mem_free_dbg(_ptr, __FILE__, __LINE__)
-#else /* DPRINTF_OSALHEAPTRACE */
+#else /* OSALMEM_CALLER_INFO */
   void osal_mem_free( void *ptr );
-#endif /* DPRINTF_OSALHEAPTRACE */
+#endif /* OSALMEM_CALLER_INFO */
 
 #if ( OSALMEM_METRICS )
  /*
@@ -126,6 +159,24 @@ extern "C"
   * Return the current number of bytes allocated.
   */
   uint16 osal_heap_mem_used( void );
+
+ /*
+  * Return the bytes in free blocks and the largest block that could be allocated.
+  */
+  uint16 osal_heap_mem_free( void );
+  uint16 osal_heap_mem_largest( void );
+#endif
+
+#if ( OSALMEM_TRACE )
+ /*
+  * Move the oldest allocation trace records out of the ring.
+  */
+  uint8 osal_mem_trace_read( osalMemTrace_t *pBuf, uint8 max );
+
+ /*
+  * Return the number of trace records overwritten before they were read.
+  */
+  uint16 osal_mem_trace_lost( void );
 #endif
 
 #if defined (ZTOOL_P1) || defined (ZTOOL_P2)
@@ -118,6 +118,12 @@ extern "C"
    */
   extern uint8 osal_timer_num_active( void );
 
+  /*
+   * Timer pool exhaustion counters
+   */
+  extern uint8 osal_timer_high_water( void );
+  extern uint16 osal_timer_num_failed( void );
+
   /*
    * Set the hardware timer interrupts for sleep mode.
    * These functions should only be called in OSAL_PwrMgr.c
@@ -21,39 +21,47 @@
 #include "gateway.h"
 #include "fram.h"
 #include "packet.h"
+#include "wire.h"
+#include "batch.h"
+#include "frame.h"
+#include "crc.h"
+#include "devtab.h"
+#include "chsel.h"
+#include "mac_callback.h"
 #include "sensing.h"
 #include "sim900.h"
 
 /**** DEFINE   ****/
 #define UART0_RX_BUF_SIZE        128
 #define UART0_TX_BUF_SIZE        1028
+#if (HAL_UART_DMA == TRUE)
+#define UART0_BAUD_RATE          HAL_UART_BR_230400   /* DMA sends the frames without a TX interrupt per byte */
+#else
+#define UART0_BAUD_RATE          HAL_UART_BR_38400
+#endif
 
 #define GW_HEADER_LENGTH         4             /* Header includes DataLength + DeviceShortAddr + Sequence */
 #define GW_ECHO_LENGTH           8             /* Echo packet */
-#define GW_MAX_DEVICE_NUM        32            /* Maximun number of devices can associate with the coordinator */
+#define GW_ASSOC_PAN_FULL        0x01          /* association status: PAN at capacity */
+#define GW_DEV_AGE_ALIVES        16            /* alive periods a device may be silent before it is taken out */
+#define GW_STATS_PER_FRAME       ((FRAME_MAX_PAYLOAD - FRAME_STATS_HDR_LEN) / LSTAT_REC_LEN)
+#define GW_STATS_RETRY           20            /* ms to wait for room on the UART during a snapshot */
+#define GW_CMDS_LEN              48            /* bytes of a command frame, room for every command */
+#define GW_CALIB_PENDING         4             /* calibrations from the PC waiting for their node */
+
+#if !defined(MAC_CFG_APP_PENDING_QUEUE) || (MAC_CFG_APP_PENDING_QUEUE != TRUE)
+#error "ERROR! The gateway answers the polls itself, build the MAC with MAC_CFG_APP_PENDING_QUEUE=TRUE"
+#endif
+
+#if (GW_ASSESS_SLOTS > 32)
+#error "ERROR! The quiet slots of the channel assessment are the bits of a uint32"
+#endif
+
+#if (DEVTAB_SHORT_BASE + DEVTAB_SIZE > NWK_GW_SHORT_ADDR)
+#error "ERROR! The short addresses of the devices reach the one of the gateway"
+#endif
 
 
-/* Size table for MAC structures */
-const CODE uint8 gw_cbackSizeTable [] =
-{
-  0,                                   /* unused */
-  sizeof(macMlmeAssociateInd_t),       /* MAC_MLME_ASSOCIATE_IND */
-  sizeof(macMlmeAssociateCnf_t),       /* MAC_MLME_ASSOCIATE_CNF */
-  sizeof(macMlmeDisassociateInd_t),    /* MAC_MLME_DISASSOCIATE_IND */
-  sizeof(macMlmeDisassociateCnf_t),    /* MAC_MLME_DISASSOCIATE_CNF */
-  sizeof(macMlmeBeaconNotifyInd_t),    /* MAC_MLME_BEACON_NOTIFY_IND */
-  sizeof(macMlmeOrphanInd_t),          /* MAC_MLME_ORPHAN_IND */
-  sizeof(macMlmeScanCnf_t),            /* MAC_MLME_SCAN_CNF */
-  sizeof(macMlmeStartCnf_t),           /* MAC_MLME_START_CNF */
-  sizeof(macMlmeSyncLossInd_t),        /* MAC_MLME_SYNC_LOSS_IND */
-  sizeof(macMlmePollCnf_t),            /* MAC_MLME_POLL_CNF */
-  sizeof(macMlmeCommStatusInd_t),      /* MAC_MLME_COMM_STATUS_IND */
-  sizeof(macMcpsDataCnf_t),            /* MAC_MCPS_DATA_CNF */
-  sizeof(macMcpsDataInd_t),            /* MAC_MCPS_DATA_IND */
-  sizeof(macMcpsPurgeCnf_t),           /* MAC_MCPS_PURGE_CNF */
-  sizeof(macEventHdr_t),               /* MAC_PWR_ON_CNF */
-  sizeof(macMlmePollInd_t)             /* MAC_MLME_POLL_IND */
-};
 
 
 /*****  LOCAL VARIABLEs  ********************************/
@@ -69,15 +77,7 @@ sAddrExt_t    gw_ExtAddr         = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x
 uint16        gw_PanId           = NWK_PAN_ID;
 uint16        gw_CoordShortAddr  = NWK_GW_SHORT_ADDR;
 int8          gw_txPower = 19;
-/* List of short addresses that the coordinator will use*/
-uint16        gw_DevShortAddrList[] = { 0x0001, 0x0002, 0x0003, 0x0004, 0x0005,
-                                        0x0006, 0x0007, 0x0008, 0x0009, 0x000A,
-                                        0x000B, 0x000C, 0x000D, 0x000E, 0x000F,
-                                        0x0010, 0x0011, 0x0012, 0x0013, 0x0014,
-                                        0x0015, 0x0016, 0x0017, 0x0018, 0x0019,
-                                        0x001A, 0x001B, 0x001C, 0x001D, 0x001E,
-                                        0x001F, 0x0020};
-uint8         gw_NumOfDevices = 0; /* Current number of devices associated to the coordinator */
+/* The devices and their short addresses are in the device table, devtab.h */
 
 /* TRUE and FALSE value */
 bool          gw_MACTrue  = TRUE;
@@ -85,6 +85,19 @@ bool          gw_MACFalse = FALSE;
 
 /* flags used in the application */
 bool          gw_IsStarted      = FALSE;
+bool          gw_IsScanning     = FALSE;
+/* Channel of the PAN, and the one it is moving to, 0 if none */
+uint8         gw_Channel;
+uint8         gw_MoveChannel;
+/* Energy detect rounds done before the start, assessments in a row the channel scored worse */
+uint8         gw_ScanRounds;
+uint8         gw_MoveRounds;
+/* Channel assessment: frames heard in each slot of the stick since the last one, the slots it
+ * scans in, the system clock at the stick, and the channel it scans next, 0 if none */
+uint8         gw_SlotFrames[GW_ASSESS_SLOTS];
+uint32        gw_QuietSlots;
+uint32        gw_StickClock;
+uint8         gw_AssessChannel;
 /* Structure that used for association response */
 macMlmeAssociateRsp_t    gw_AssocRsp;
 
@@ -94,19 +107,50 @@ uint16  nodeShortAddrs[2];
 uint16  stickDuration  = GW_DEFAULT_STICK_DURATION;
 uint32  curStickTime   = 0;
 
-pkt_t alivePacket;
+pkt_t schedPacket;      /* periods of the nodes */
+/* Command frame in the MAC: its node, 0 if none, the commands in it and its handle */
+uint16  cmdsShort;
+uint8   cmdsSent;
+uint8   cmdsHandle;
+/* Snapshot of the link statistics being sent: next short address, 0 if none, and its number */
+uint16  statsNext;
+uint8   statsSnapshot;
+/* Calibrations waiting for the poll of their node; a slot is free once its node has none
+ * pending, sent or gone from the device table */
+typedef struct{
+  uint16  shortAddr;
+  calib_t calib;
+} gwCalib_t;
+gwCalib_t gw_Calib[GW_CALIB_PENDING];
+/* Command of the PC with parameters (frame.h) being received: its bytes, and how many */
+uint8   pcCmd[1 + FRAME_CMD_MAX_LEN + FRAME_CMD_CRC_LEN];
+uint8   pcCmdLen;
+uint8   pcCmdWant;
 /**** LOCAL FUNCTIONs DECLARATION ****/
 void UART0Start(void);
 void GW_UARTCallBack (uint8 port, uint8 event);
 /* Setup routines */
 void GW_CoordinatorStartup(uint8 usedChannel);
+void GW_CoordinatorMove(uint8 newChannel);
 /* MAC related routines */
 void ProcessInitPeriEvent(void);
 void ProcessStickTimerEvent(void);
 void ProcessingScanConfirm(macCbackEvent_t * pData);
+void ProcessAssessEvent(void);
+void ProcessAssessConfirm(macCbackEvent_t * pData);
+void ProcessChannelAssess(void);
+void GW_Heard(void);
+void GW_AssessStart(void);
+void GW_AssessNext(void);
 void ProcessAssocIndEvent(macCbackEvent_t* pMsg);
+void ProcessOrphanInd(macCbackEvent_t* pMsg);
 void ProcessReceivingPacket(macMcpsDataInd_t* pData);
-void GW_SendDataRequest(pktType_t pktType, uint8* pktPara, uint8 paraLen, uint16 dstShortAddr);
+void ProcessAliveTime(devEntry_t *pDev, const uint8 *pBuf, uint8 len);
+void ProcessStatsEvent(void);
+void ProcessPollInd(macCbackEvent_t* pMsg);
+void ProcessCmdsCnf(macCbackEvent_t* pMsg);
+void ProcessPcCommand(void);
+gwCalib_t *GW_CalibSlot(uint16 shortAddr, bool take);
 
 
 
@@ -114,11 +158,17 @@ void GW_SendDataRequest(pktType_t pktType, uint8* pktPara, uint8 paraLen, uint16
 /******************************************************/
 void GW_Init(uint8 taskId){
   GW_TaskId = taskId;
+  MACCB_Init(GW_TaskId);
   MAC_InitCoord();
   MAC_MlmeResetReq(TRUE);
   gw_BeaconOrder     = NWK_MAC_BEACON_ORDER;
   gw_SuperFrameOrder = NWK_MAC_SUPERFRAME_ORDER;
 
+  schedPacket.pktType = PKT_SCHED_TYPE;
+  schedPacket.pktPara.schedPara.sensingTime    = GW_DEFAULT_SENSING_TIME;
+  schedPacket.pktPara.schedPara.sendAliveTime  = GW_DEFAULT_SEND_ALIVE_TIME;
+  schedPacket.pktPara.schedPara.preparingDelta = GW_DEFAULT_PREPARING_DELTA;
+
   HalLedSet(HAL_LED_2, HAL_LED_MODE_ON);
   UART0Start();   /* init UART0 for PC communication */
   osal_start_timerEx(GW_TaskId, GW_PREP_INIT_EVENT, 10000); /* delay 10s after power up */
@@ -161,6 +211,28 @@ void GW_CoordinatorStartup(uint8 usedChannel)
 
 
 
+/* Move the started PAN to another channel: only the devices listening are told, by a coordinator
+ * realignment; the sleeping ones find it with the scan after their failed polls (node.c) */
+void GW_CoordinatorMove(uint8 newChannel)
+{
+  macMlmeStartReq_t   startReq;
+
+  startReq.startTime                = 0;
+  startReq.panId                    = gw_PanId;
+  startReq.logicalChannel           = newChannel;
+  startReq.beaconOrder              = gw_BeaconOrder;
+  startReq.superframeOrder          = gw_SuperFrameOrder;
+  startReq.panCoordinator           = TRUE;
+  startReq.batteryLifeExt           = FALSE;
+  startReq.coordRealignment         = TRUE;
+  startReq.realignSec.securityLevel = FALSE;
+  startReq.beaconSec.securityLevel  = FALSE;
+  gw_MoveChannel = newChannel;
+  MAC_MlmeStartReq(&startReq);
+}
+
+
+
 /*************  EVENT PROCESSING  ****************/
 /************************************************************/
 uint16 GW_ProcessEvent(uint8 taskId, uint16 events)
@@ -177,7 +249,17 @@ uint16 GW_ProcessEvent(uint8 taskId, uint16 events)
 
         case MAC_MLME_START_CNF:  /* COORDINATOR STARTED COMPLETED */
           pData = (macCbackEvent_t *) pMsg;
-          if (pData->startCnf.hdr.status == MAC_SUCCESS){
+          if (gw_MoveChannel != 0){       /* realignment */
+            if (pData->startCnf.hdr.status == MAC_SUCCESS){
+              gw_Channel = gw_MoveChannel;
+              HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "CHAN: moved to ", gw_Channel, 10);
+            }
+            else{
+              HalUARTPrintStr(HAL_UART_PORT_0, "CHAN: move fail\n");
+            }
+            gw_MoveChannel = 0;
+          }
+          else if (pData->startCnf.hdr.status == MAC_SUCCESS){
             gw_IsStarted       = TRUE;
             HalUARTPrintStr(HAL_UART_PORT_0, "COOR Started\n");
           }
@@ -190,19 +272,26 @@ uint16 GW_ProcessEvent(uint8 taskId, uint16 events)
           ProcessAssocIndEvent((macCbackEvent_t*) pMsg);
         break;
 
+        case MAC_MLME_ORPHAN_IND: /* a device lost its coordinator */
+          ProcessOrphanInd((macCbackEvent_t*) pMsg);
+        break;
+
         case MAC_MCPS_DATA_IND: /* receiving packet */
           ProcessReceivingPacket((macMcpsDataInd_t*) pMsg);
         break;
 
+        case MAC_MLME_POLL_IND:  /* a node asks for its data */
+          ProcessPollInd((macCbackEvent_t *) pMsg);
+          break;
+
         case MAC_MCPS_DATA_CNF:  /* MAC send data confirm */
           pData = (macCbackEvent_t *) pMsg;
-          HalUARTPrintStr(HAL_UART_PORT_0, "Data response\n");
-
+          ProcessCmdsCnf(pData);
           mac_msg_deallocate((uint8**)&pData->dataCnf.pDataReq);
           break;
 
       } /* end switch */
-      mac_msg_deallocate((uint8 **)&pMsg);
+      MACCB_Free(pMsg);
     } /* END while */
     return events ^ SYS_EVENT_MSG;
   }
@@ -216,6 +305,16 @@ uint16 GW_ProcessEvent(uint8 taskId, uint16 events)
     ProcessStickTimerEvent();
     return events ^ GW_STICK_TIMER_EVENT;
   }
+
+  if (events & GW_STATS_EVENT){
+    ProcessStatsEvent();
+    return events ^ GW_STATS_EVENT;
+  }
+
+  if (events & GW_ASSESS_EVENT){
+    ProcessAssessEvent();
+    return events ^ GW_ASSESS_EVENT;
+  }
   return 0;
 }
 
@@ -227,13 +326,19 @@ void ProcessInitPeriEvent(){
 
   if (ERROR_INIT_FAIL == fram_init(FRAM_MODE0)){ /* init FRAM */
     HalUARTPrintStr(HAL_UART_PORT_0, "FRAM: fail\n");
+    DEVTAB_Init(FALSE);
   }
   else{
     HalUARTPrintStr(HAL_UART_PORT_0, "FRAM: ok\n");
+    HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "DEVTAB: ", DEVTAB_Init(TRUE), 10);
   }
 
-  /* Start scan */
+  /* Start scan, the first of GW_SCAN_ROUNDS */
   HalUARTPrintStr(HAL_UART_PORT_0, "SCAN: start\n");
+  CHSEL_Init();
+  gw_ScanRounds  = 0;
+  gw_MoveRounds  = 0;
+  gw_IsScanning  = TRUE;
   NWK_ScanReq(MAC_SCAN_ED, GW_SCAN_DURATION);
 
   stickDuration  = GW_DEFAULT_STICK_DURATION;
@@ -251,23 +356,103 @@ void ProcessInitPeriEvent(){
 
 /****  SYS STICK TIMER EVENT ***/
 void ProcessStickTimerEvent(){
+  uint16 aged;
+
   curStickTime++;
+  gw_StickClock = osal_GetSystemClock();
+  aged = DEVTAB_Age(curStickTime,
+                    (uint32)GW_DEV_AGE_ALIVES * schedPacket.pktPara.schedPara.sendAliveTime);
+  if (aged != 0){
+    HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "DEVTAB: aged ", aged, 10);
+  }
   if (gw_IsStarted){
     HalLedBlink(HAL_LED_2, GW_DEFAULT_STICK_DURATION / 1000, 50, 1000);
+    if ((curStickTime % GW_ASSESS_STICKS == 0) && (gw_AssessChannel == 0)){
+      GW_AssessStart();
+    }
   }
-  /* for test */
- /* alivePacket.pktType = PKT_ALIVE_TYPE;
-  alivePacket.pktPara.alivePara.curTime = curStickTime;
-  alivePacket.pktPara.alivePara.nodeId  = 0;
+}
+
 
-  GW_SendDataRequest(PKT_ALIVE_TYPE, (uint8*) &(alivePacket.pktPara.alivePara),
-                     sizeof(alivePara_t), gw_DevShortAddrList[gw_NumOfDevices-1]);
-  */
+/****  CHANNEL ASSESSMENT EVENT ***/
+/* The energy detect scan of one channel of the started PAN, in a quiet slot (gateway.h).  A scan
+   that does not start, while a command frame waits for its confirm, waits for the next quiet
+   slot; a move of the PAN ends the assessment */
+void ProcessAssessEvent(){
+  if (gw_AssessChannel == 0){
+    return;
+  }
+  if (gw_MoveChannel != 0){
+    gw_AssessChannel = 0;
+    return;
+  }
+  if (gw_IsScanning || (cmdsShort != 0)){
+    GW_AssessNext();
+    return;
+  }
+  gw_IsScanning = TRUE;
+  NWK_ScanChannelsReq(MAC_SCAN_ED, (uint32)1 << gw_AssessChannel, GW_ASSESS_DURATION);
+}
+
+
+/* A frame of a node was heard: counted in its slot of the stick */
+void GW_Heard(void){
+  uint32 slot = (osal_GetSystemClock() - gw_StickClock) * GW_ASSESS_SLOTS / stickDuration;
+
+  if (slot >= GW_ASSESS_SLOTS){
+    slot = GW_ASSESS_SLOTS - 1;         /* the stick timer is late */
+  }
+  if (gw_SlotFrames[slot] < 0xFF){
+    gw_SlotFrames[slot]++;
+  }
+}
+
+
+/* Start an assessment, at the stick: its slots are those with the fewest frames, there is at
+   least one, and the count starts again for the next */
+void GW_AssessStart(void){
+  uint8 fewest = 0xFF;
+  uint8 slot;
+
+  for (slot = 0; slot < GW_ASSESS_SLOTS; slot++){
+    if (gw_SlotFrames[slot] < fewest){
+      fewest = gw_SlotFrames[slot];
+    }
+  }
+  gw_QuietSlots = 0;
+  for (slot = 0; slot < GW_ASSESS_SLOTS; slot++){
+    if (gw_SlotFrames[slot] == fewest){
+      gw_QuietSlots |= (uint32)1 << slot;
+    }
+    gw_SlotFrames[slot] = 0;
+  }
+  gw_AssessChannel = CHSEL_FIRST;
+  GW_AssessNext();
+}
+
+
+/* The next channel is scanned at the start of the next quiet slot, of this stick or the next */
+void GW_AssessNext(void){
+  uint16 slotMs  = stickDuration / GW_ASSESS_SLOTS;
+  uint32 elapsed = osal_GetSystemClock() - gw_StickClock;
+  uint32 slot    = (elapsed + slotMs - 1) / slotMs;
+
+  while (!(gw_QuietSlots & ((uint32)1 << (slot % GW_ASSESS_SLOTS)))){
+    slot++;
+  }
+  osal_start_timerEx(GW_TaskId, GW_ASSESS_EVENT, (slot * slotMs > elapsed) ? slot * slotMs - elapsed : 1);
 }
 
 
 /*** SCAN CONFIRM EVENT  ***/
 void ProcessingScanConfirm(macCbackEvent_t * pData){
+  uint8 ch;
+
+  gw_IsScanning = FALSE;
+  if (gw_IsStarted && (gw_AssessChannel != 0)){
+    ProcessAssessConfirm(pData);
+    return;
+  }
   if (pData->scanCnf.hdr.status == MAC_NO_BEACON){
     HalUARTPrintStr(HAL_UART_PORT_0, "SCAN: no beacon\n");
   }
@@ -275,78 +460,253 @@ void ProcessingScanConfirm(macCbackEvent_t * pData){
     HalUARTPrintStr(HAL_UART_PORT_0, "SCAN: invalid\n");
   }
   else if (pData->scanCnf.hdr.status == MAC_SUCCESS){
-    uint8 minCh = 0;     /* find minimum */
-    uint8 minChEnergy = pData->scanCnf.result.pEnergyDetect[0];
-    uint8 i;
-    HalUARTPrintStrAndUInt(HAL_UART_PORT_0, "CH[", 11, 10);
-    HalUARTPrintStrAndUInt(HAL_UART_PORT_0, "]: ", minChEnergy, 10);
-    for (i=1; i<pData->scanCnf.resultListSize; i++){
-      HalUARTPrintStrAndUInt(HAL_UART_PORT_0, "  CH[", i+11, 10);
-      HalUARTPrintStrAndUInt(HAL_UART_PORT_0, "]: ", pData->scanCnf.result.pEnergyDetect[i], 10);
-      if (minChEnergy > pData->scanCnf.result.pEnergyDetect[i]){
-        minChEnergy = pData->scanCnf.result.pEnergyDetect[i];
-        minCh = i;
-      }
+    CHSEL_Round(NWK_SCAN_CHANNELS, pData->scanCnf.result.pEnergyDetect,
+                pData->scanCnf.resultListSize);
+    if (++gw_ScanRounds < GW_SCAN_ROUNDS){
+      gw_IsScanning = TRUE;
+      NWK_ScanReq(MAC_SCAN_ED, GW_SCAN_DURATION);
+      return;
     }
-    HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "\nCOOR start on: ", (minCh+11), 10);
-    GW_CoordinatorStartup(minCh+11);
+    /* Scores of the channels, chsel.h: the lowest one is the quietest */
+    for (ch = CHSEL_FIRST; ch < CHSEL_FIRST + CHSEL_NUM; ch++){
+      HalUARTPrintStrAndUInt(HAL_UART_PORT_0, (ch == CHSEL_FIRST) ? "CH[" : "  CH[", ch, 10);
+      HalUARTPrintStrAndUInt(HAL_UART_PORT_0, "]: ", CHSEL_Score(ch), 10);
+    }
+    gw_Channel = CHSEL_Best();
+    HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "\nCOOR start on: ", gw_Channel, 10);
+    GW_CoordinatorStartup(gw_Channel);
+  }
+}
+
+
+/*** SCAN CONFIRM of a channel of the assessment ***/
+/* Its reading is taken; after the last channel the channels are compared.  A failed scan ends
+   the assessment */
+void ProcessAssessConfirm(macCbackEvent_t * pData){
+  if (pData->scanCnf.hdr.status != MAC_SUCCESS){
+    gw_AssessChannel = 0;
+    return;
+  }
+  CHSEL_Round((uint32)1 << gw_AssessChannel, pData->scanCnf.result.pEnergyDetect,
+              pData->scanCnf.resultListSize);
+  if (++gw_AssessChannel < CHSEL_FIRST + CHSEL_NUM){
+    GW_AssessNext();
+    return;
+  }
+  gw_AssessChannel = 0;
+  ProcessChannelAssess();
+}
+
+
+/*** CHANNEL ASSESSMENT, after the last channel of the started PAN  ***/
+/* The PAN moves only when its channel stays worse than the best, so a burst that a round or two
+   of readings catch does not make it move; without GW_MOVE_ENABLED the channel is only told */
+void ProcessChannelAssess(void){
+  uint8 best = CHSEL_Best();
+
+  if ((best == gw_Channel) || (CHSEL_Score(gw_Channel) <= CHSEL_Score(best) + GW_MOVE_MARGIN)){
+    gw_MoveRounds = 0;
+    return;
+  }
+  HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "CHAN: score ", CHSEL_Score(gw_Channel), 10);
+  if (++gw_MoveRounds < GW_MOVE_ROUNDS){
+    return;
+  }
+  gw_MoveRounds = 0;
+  if (!GW_MOVE_ENABLED){
+    HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "CHAN: better ", best, 10);
+    return;
   }
+  HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "CHAN: move to ", best, 10);
+  GW_CoordinatorMove(best);
 }
 
 
 /**** ASSOC IND event   ********************************/
+/* A device that associates again keeps its short address; when the table is full the device is
+ * refused until DEVTAB_Age() takes out a silent one */
 void ProcessAssocIndEvent(macCbackEvent_t* pMsg){
-  uint16 assocShortAddress;
+  devEntry_t *pDev;
 
-  if (gw_NumOfDevices == GW_MAX_DEVICE_NUM){   /* RESET the association IF over numbers */
-    gw_NumOfDevices = 0;
-    /* Add code clear pending packet */
-    HalUARTPrintStr(HAL_UART_PORT_0, "ASSOS: reset\n");
-  }
-  /* Build the record for this device */
-  assocShortAddress = gw_DevShortAddrList[gw_NumOfDevices];
-  gw_NumOfDevices++;
+  pDev = DEVTAB_Assoc(pMsg->associateInd.deviceAddress, curStickTime);
   /* Fill in association respond message */
   sAddrExtCpy(gw_AssocRsp.deviceAddress, pMsg->associateInd.deviceAddress);
-  gw_AssocRsp.assocShortAddress  = assocShortAddress;
-  gw_AssocRsp.status             = MAC_SUCCESS;
   gw_AssocRsp.sec.securityLevel  = MAC_SEC_LEVEL_NONE;
+  if (pDev == NULL){
+    gw_AssocRsp.assocShortAddress = 0xFFFF;
+    gw_AssocRsp.status            = GW_ASSOC_PAN_FULL;
+    MAC_MlmeAssociateRsp(&gw_AssocRsp);
+    HalUARTPrintStr(HAL_UART_PORT_0, "ASSOS: full\n");
+    return;
+  }
+  gw_AssocRsp.assocShortAddress  = DEVTAB_Short(pDev);
+  gw_AssocRsp.status             = MAC_SUCCESS;
   /* Call Associate Response */
   MAC_MlmeAssociateRsp(&gw_AssocRsp);
-  HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "ASSOS: allow ", assocShortAddress, 10);
+  HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "ASSOS: allow ", gw_AssocRsp.assocShortAddress, 10);
+  DEVTAB_Pend(pDev, DEVTAB_CMD(PKT_SCHED_TYPE)); /* taken by the poll after the response */
+}
+
+
+/**** ORPHAN IND event   *******************************/
+/* A known device that lost the gateway, after a reset or missed polls, is given its short
+ * address back with the coordinator realignment, and does not associate again, and the periods
+ * as after an association; a device that is not known gets no answer, its orphan scan fails
+ * and it associates */
+void ProcessOrphanInd(macCbackEvent_t* pMsg){
+  macMlmeOrphanRsp_t orphanRsp;
+  devEntry_t *pDev;
+
+  pDev = DEVTAB_Find(pMsg->orphanInd.orphanAddress);
+  if (pDev == NULL){
+    return;
+  }
+  DEVTAB_Seen(pDev, curStickTime);
+  sAddrExtCpy(orphanRsp.orphanAddress, pMsg->orphanInd.orphanAddress);
+  orphanRsp.shortAddress      = DEVTAB_Short(pDev);
+  orphanRsp.associatedMember  = TRUE;
+  orphanRsp.sec.securityLevel = MAC_SEC_LEVEL_NONE;
+  MAC_MlmeOrphanRsp(&orphanRsp);
+  HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "ORPHAN: realign ", orphanRsp.shortAddress, 10);
+  DEVTAB_Pend(pDev, DEVTAB_CMD(PKT_SCHED_TYPE)); /* taken by the poll after the realignment */
 }
 
 
 /****   RECEIVING PACKET event   ***********************/
 void ProcessReceivingPacket(macMcpsDataInd_t* pData){
-  pkt_t*        recvPkt;
+  devEntry_t *pDev = DEVTAB_Get(pData->mac.srcAddr.addr.shortAddr);
 
+  GW_Heard();
+  if (pDev == NULL){
+    HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "RECV: unknown ", pData->mac.srcAddr.addr.shortAddr, 10);
+  }
+  else{
+    pDev->lastSeen = curStickTime;
+    if (!LSTAT_Frame(&(pDev->link), pData->mac.dsn, pData->mac.rssi, pData->mac.mpduLinkQuality)){
+      return;                           /* sent again, its ACK was lost */
+    }
+    ProcessAliveTime(pDev, pData->msdu.p, pData->msdu.len);
+  }
+#if (GW_UART_TEXT == TRUE)
   HalUARTPrintStrAndUInt(HAL_UART_PORT_0, "RECV: sAdd(", pData->mac.srcAddr.addr.shortAddr, 10);
   HalUARTPrintStrAndUInt(HAL_UART_PORT_0, ") time: ", curStickTime, 10);
   HalUARTPrintStrAndInt(HAL_UART_PORT_0, "  rssi: ", pData->mac.rssi, 10);
   HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "  linkQuality: ", pData->mac.mpduLinkQuality,10);
 
-  recvPkt = (pkt_t*) pData->msdu.p;
-  PKT_Print(recvPkt);
+  PKT_Print(pData->msdu.p, pData->msdu.len);
+#else
+  FRAME_Send(HAL_UART_PORT_0, FRAME_TYPE_RECV, pData->mac.srcAddr.addr.shortAddr, pData->mac.rssi,
+             pData->mac.mpduLinkQuality, curStickTime, pData->msdu.p, pData->msdu.len);
+#endif
+}
+
+/* The time of the node in an alive packet, plain or a batch that stands for one, gives the lost
+ * alive packets and the jitter of the link */
+void ProcessAliveTime(devEntry_t *pDev, const uint8 *pBuf, uint8 len){
+  pkt_t   pkt;
+  batch_t batch;
+  uint32  time;
+
+  if ((len != 0) && (pBuf[0] == PKT_BATCH_TYPE)){
+    if (!BATCH_DecodeStart(&batch, pBuf, len) || !BATCH_Alive(&batch, &time)){
+      return;
+    }
+  }
+  else if (WIRE_Decode(pBuf, len, &pkt) && (pkt.pktType == PKT_ALIVE_TYPE)){
+    time = pkt.pktPara.alivePara.curTime;
+  }
+  else{
+    return;
+  }
+  LSTAT_Alive(&(pDev->link), time, osal_GetSystemClock(),
+              schedPacket.pktPara.schedPara.sendAliveTime, stickDuration);
+}
+
+
+/****   LINK STATISTICS event   ************************/
+/* The frames of a snapshot go out while the UART has room for them, the rest GW_STATS_RETRY ms
+ * later, so the snapshot never pushes out the received packets */
+void ProcessStatsEvent(){
+  uint8 buf[FRAME_STATS_HDR_LEN + GW_STATS_PER_FRAME * LSTAT_REC_LEN];
+  uint8 len;
+  devEntry_t *pDev;
+
+  while (statsNext != 0){
+    if (UART0_TX_BUF_SIZE - Hal_UART_TxBufLen(HAL_UART_PORT_0) <= FRAME_OVERHEAD + sizeof(buf)){
+      osal_start_timerEx(GW_TaskId, GW_STATS_EVENT, GW_STATS_RETRY);
+      return;
+    }
+    len = FRAME_STATS_HDR_LEN;
+    while ((len + LSTAT_REC_LEN <= sizeof(buf)) && (statsNext < DEVTAB_SHORT_BASE + DEVTAB_SIZE)){
+      if ((pDev = DEVTAB_Get(statsNext)) != NULL){
+        LSTAT_Pack(&(pDev->link), statsNext, curStickTime - pDev->lastSeen, &buf[len]);
+        len += LSTAT_REC_LEN;
+      }
+      statsNext++;
+    }
+    buf[0] = statsSnapshot;
+    buf[1] = 0;
+    if (statsNext == DEVTAB_SHORT_BASE + DEVTAB_SIZE){
+      buf[1]    = FRAME_STATS_LAST;
+      statsNext = 0;
+      statsSnapshot++;
+    }
+    FRAME_Send(HAL_UART_PORT_0, FRAME_TYPE_STATS, gw_CoordShortAddr, 0, 0, curStickTime, buf, len);
+  }
 }
 
-void GW_SendDataRequest(pktType_t pktType, uint8* pktPara, uint8 paraLen, uint16 dstShortAddr){
-  macMcpsDataReq_t  *pData;
-  static uint8      handle = 0;
-  pkt_t *dstAppPkt;
 
-  if ((pData = MAC_McpsDataAlloc(sizeof(pktType)+paraLen, MAC_SEC_LEVEL_NONE, MAC_KEY_ID_MODE_IMPLICIT)) != NULL){
+/****   POLL IND event   *******************************/
+/* The commands for a node wait in the device table, not in the MAC, whose few indirect slots
+ * would be full with the first nodes.  When the node polls, the MAC has nothing for it and asks
+ * here: the ACK had the pending bit if any node has commands, and those of the polling node go
+ * to it at once in one frame, while it listens.  One command frame is in the MAC at a time; a
+ * node polling meanwhile gets its commands at its next poll */
+void ProcessPollInd(macCbackEvent_t* pMsg){
+  macMcpsDataReq_t *pData;
+  devEntry_t       *pDev;
+  gwCalib_t        *pCalib;
+  pkt_t            pkt;
+  uint8            buf[GW_CMDS_LEN];
+  uint8            len = 0;
+  uint8            cmds = 0;
+  uint8            n;
+
+  GW_Heard();
+  if (pMsg->pollInd.noRsp || (cmdsShort != 0) ||
+      ((pDev = DEVTAB_Get(pMsg->pollInd.srcAddr.addr.shortAddr)) == NULL) || (pDev->cmds == 0)){
+    return;
+  }
+  if (pDev->cmds & DEVTAB_CMD(PKT_SCHED_TYPE)){
+    len   = WIRE_CmdsAdd(&schedPacket, buf, len, sizeof(buf));
+    cmds |= DEVTAB_CMD(PKT_SCHED_TYPE);
+  }
+  if ((pDev->cmds & DEVTAB_CMD(PKT_CALIB_TYPE)) &&
+      ((pCalib = GW_CalibSlot(pMsg->pollInd.srcAddr.addr.shortAddr, FALSE)) != NULL)){
+    pkt.pktType = PKT_CALIB_TYPE;
+    osal_memcpy(&(pkt.pktPara.calibPara), &(pCalib->calib), sizeof(calib_t));
+    if ((n = WIRE_CmdsAdd(&pkt, buf, len, sizeof(buf))) != 0){
+      len   = n;
+      cmds |= DEVTAB_CMD(PKT_CALIB_TYPE);
+    }
+  }
+  if (len == 0){
+    DEVTAB_Sent(pDev, pDev->cmds);      /* none the gateway can build */
+    return;
+  }
+
+  if ((pData = MAC_McpsDataAlloc(len, MAC_SEC_LEVEL_NONE, MAC_KEY_ID_MODE_IMPLICIT)) != NULL){
     pData->mac.srcAddrMode            = SADDR_MODE_SHORT;
     pData->mac.dstAddr.addrMode       = SADDR_MODE_SHORT;
-    pData->mac.dstAddr.addr.shortAddr = dstShortAddr;
+    pData->mac.dstAddr.addr.shortAddr = pMsg->pollInd.srcAddr.addr.shortAddr;
     pData->mac.dstPanId               = gw_PanId;
-    pData->mac.msduHandle             = handle++;
-    pData->mac.txOptions              = MAC_TXOPTION_ACK | MAC_TXOPTION_INDIRECT;
+    pData->mac.msduHandle             = ++cmdsHandle;
+    pData->mac.txOptions              = MAC_TXOPTION_ACK;     /* the node listens now */
     pData->sec.securityLevel          = MAC_SEC_LEVEL_NONE;
-    dstAppPkt = (pkt_t*) pData->msdu.p;
-    dstAppPkt->pktType = pktType;
-    osal_memcpy(&(dstAppPkt->pktPara), pktPara, paraLen);
-    HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "PEND: to ", dstShortAddr, 10);
+    osal_memcpy(pData->msdu.p, buf, len);
+    cmdsShort = pMsg->pollInd.srcAddr.addr.shortAddr;
+    cmdsSent  = cmds;
+    HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "PEND: to ", cmdsShort, 10);
     MAC_McpsDataReq(pData);
   }
   else{
@@ -354,6 +714,94 @@ void GW_SendDataRequest(pktType_t pktType, uint8* pktPara, uint8 paraLen, uint16
   }
 }
 
+/* The commands the node acknowledged no longer wait; the others go with its next poll */
+void ProcessCmdsCnf(macCbackEvent_t* pMsg){
+  devEntry_t *pDev;
+
+  if ((cmdsShort == 0) || (pMsg->dataCnf.msduHandle != cmdsHandle)){
+    return;
+  }
+  if ((pMsg->dataCnf.hdr.status == MAC_SUCCESS) && ((pDev = DEVTAB_Get(cmdsShort)) != NULL)){
+    DEVTAB_Sent(pDev, cmdsSent);
+    HalUARTPrintStr(HAL_UART_PORT_0, "PEND: sent\n");
+  }
+  else{
+    HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "PEND: fail ", pMsg->dataCnf.hdr.status, 16);
+  }
+  cmdsShort = 0;
+}
+
+
+/**************************************************************************************************
+ * @brief   New periods for the nodes: kept for the ones that associate later, and sent to every
+ *          node associated now, which takes them with its next poll.  Periods on their way in
+ *          a command frame are old ones, they wait again.
+ * @param   pSched - periods
+ * @return  FALSE if they are not valid and nothing was sent
+ **************************************************************************************************/
+bool GW_SetSched(const sched_t *pSched){
+  devEntry_t *pDev;
+  uint16 shortAddr;
+
+  if (!SCHED_Valid(pSched)){
+    return FALSE;
+  }
+  osal_memcpy(&(schedPacket.pktPara.schedPara), pSched, sizeof(sched_t));
+  cmdsSent &= ~DEVTAB_CMD(PKT_SCHED_TYPE);
+  for (shortAddr = DEVTAB_SHORT_BASE; shortAddr < DEVTAB_SHORT_BASE + DEVTAB_SIZE; shortAddr++){
+    if ((pDev = DEVTAB_Get(shortAddr)) != NULL){
+      DEVTAB_Pend(pDev, DEVTAB_CMD(PKT_SCHED_TYPE));
+    }
+  }
+  HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "PEND: sched ", DEVTAB_Pending(), 10);
+  return TRUE;
+}
+
+
+/**************************************************************************************************
+ * @brief   New calibration for one node, which takes it with its next poll.  A calibration on
+ *          its way to the node in a command frame is the old one, the new one waits again.
+ * @param   shortAddr - the node
+ *          pCalib    - calibration, magic and CRC are set by the node
+ * @return  FALSE if it is not valid, the node is not associated or no slot is free
+ **************************************************************************************************/
+bool GW_SetCalib(uint16 shortAddr, const calib_t *pCalib){
+  devEntry_t *pDev;
+  gwCalib_t  *pSlot;
+
+  if (!CALIB_Valid(pCalib) || ((pDev = DEVTAB_Get(shortAddr)) == NULL) ||
+      ((pSlot = GW_CalibSlot(shortAddr, TRUE)) == NULL)){
+    return FALSE;
+  }
+  pSlot->shortAddr = shortAddr;
+  osal_memcpy(&(pSlot->calib), pCalib, sizeof(calib_t));
+  if (cmdsShort == shortAddr){
+    cmdsSent &= ~DEVTAB_CMD(PKT_CALIB_TYPE);
+  }
+  DEVTAB_Pend(pDev, DEVTAB_CMD(PKT_CALIB_TYPE));
+  HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "PEND: calib ", shortAddr, 10);
+  return TRUE;
+}
+
+/* Slot of the calibration waiting for a node, or with 'take' a free one if it has none; NULL if
+ * there is none */
+gwCalib_t *GW_CalibSlot(uint16 shortAddr, bool take){
+  devEntry_t *pDev;
+  gwCalib_t  *pFree = NULL;
+  uint8 i;
+
+  for (i=0; i<GW_CALIB_PENDING; i++){
+    if (gw_Calib[i].shortAddr == shortAddr){
+      return &gw_Calib[i];
+    }
+    if ((pFree == NULL) && (((pDev = DEVTAB_Get(gw_Calib[i].shortAddr)) == NULL) ||
+                            !(pDev->cmds & DEVTAB_CMD(PKT_CALIB_TYPE)))){
+      pFree = &gw_Calib[i];
+    }
+  }
+  return take ? pFree : NULL;
+}
+
 
 /**************************************************************************************************
  * @brief   Callback service for keys
@@ -383,7 +831,7 @@ void UART0Start(){
 
   /* UART Configuration */
   uartConfig.configured           = TRUE;
-  uartConfig.baudRate             = HAL_UART_BR_38400;
+  uartConfig.baudRate             = UART0_BAUD_RATE;
   uartConfig.flowControl          = HAL_UART_FLOW_OFF;
   uartConfig.flowControlThreshold = 16;
   uartConfig.rx.maxBufSize        = UART0_RX_BUF_SIZE;
@@ -397,8 +845,63 @@ void UART0Start(){
 
 
 ///////////////////////////////////////////////////////////
+/* Commands of the PC (frame.h): one byte, or a byte, its parameters and a CRC */
 void GW_UARTCallBack (uint8 port, uint8 event){
-    //do nothing now
+  uint8 cmd;
+
+  while (HalUARTRead(port, &cmd, 1) != 0){
+    if (pcCmdLen != 0){
+      pcCmd[pcCmdLen++] = cmd;
+      if (pcCmdLen == pcCmdWant){
+        ProcessPcCommand();
+        pcCmdLen = 0;
+      }
+    }
+    else if (cmd == FRAME_CMD_STATS){
+      if (statsNext == 0){
+        statsNext = DEVTAB_SHORT_BASE;
+        osal_set_event(GW_TaskId, GW_STATS_EVENT);
+      }
+    }
+    else if ((cmd == FRAME_CMD_CALIB) || (cmd == FRAME_CMD_SCHED)){
+      pcCmd[0]  = cmd;
+      pcCmdLen  = 1;
+      pcCmdWant = 1 + ((cmd == FRAME_CMD_CALIB) ? FRAME_CMD_CALIB_LEN : FRAME_CMD_SCHED_LEN) +
+                  FRAME_CMD_CRC_LEN;
+    }
+  }
+}
+
+/* A command of the PC with parameters, all of it received */
+void ProcessPcCommand(void){
+  calib_t calib;
+  sched_t sched;
+  uint8 *p = &pcCmd[1];
+
+  if (CRC_Ccitt(CRC_INIT, pcCmd, pcCmdLen - FRAME_CMD_CRC_LEN) !=
+      BUILD_UINT16(pcCmd[pcCmdLen - 2], pcCmd[pcCmdLen - 1])){
+    HalUARTPrintStr(HAL_UART_PORT_0, "PC: crc\n");
+    return;
+  }
+  if (pcCmd[0] == FRAME_CMD_CALIB){
+    osal_memset(&calib, 0, sizeof(calib_t));
+    calib.intTmpOffset = (int16) BUILD_UINT16(p[2], p[3]);
+    calib.extTmpOffset = (int16) BUILD_UINT16(p[4], p[5]);
+    calib.pHOffset     = (int16) BUILD_UINT16(p[6], p[7]);
+    calib.pHSlope      = BUILD_UINT16(p[8], p[9]);
+    if (!GW_SetCalib(BUILD_UINT16(p[0], p[1]), &calib)){
+      HalUARTPrintStr(HAL_UART_PORT_0, "PC: calib refused\n");
+    }
+  }
+  else if (pcCmd[0] == FRAME_CMD_SCHED){
+    osal_memset(&sched, 0, sizeof(sched_t));
+    sched.sensingTime    = BUILD_UINT16(p[0], p[1]);
+    sched.sendAliveTime  = BUILD_UINT16(p[2], p[3]);
+    sched.preparingDelta = BUILD_UINT16(p[4], p[5]);
+    if (!GW_SetSched(&sched)){
+      HalUARTPrintStr(HAL_UART_PORT_0, "PC: sched refused\n");
+    }
+  }
 }
 
 
@@ -407,42 +910,31 @@ void GW_UARTCallBack (uint8 port, uint8 event){
  *              The application must implement this function.  A typical
  *              implementation of this function would allocate an OSAL message,
  *              copy the event parameters to the message, and send the message
- *              to the application's OSAL event handler.  This function may be
+ *              to the application's OSAL event handler.  Here the events go
+ *              through the static slots of mac_callback.c instead of the heap,
+ *              so they have to be released with MACCB_Free().  This function may be
  *              executed from task or interrupt context and therefore must
  *              be reentrant.
  * @param       pData - Pointer to parameters structure.
  * @return      None.
  **************************************************************************************************/
 void MAC_CbackEvent(macCbackEvent_t *pData){
-  macCbackEvent_t *pMsg = NULL;
-
-  uint8 len = gw_cbackSizeTable[pData->hdr.event];
-  switch (pData->hdr.event){
-    case MAC_MCPS_DATA_IND:
-      pMsg = pData;
-      break;
-
-    default:
-      if ((pMsg = (macCbackEvent_t *) osal_msg_allocate(len)) != NULL){
-        osal_memcpy(pMsg, pData, len);
-      }
-      break;
-  }
-
-  if (pMsg != NULL){
-    osal_msg_send(GW_TaskId, (uint8 *) pMsg);
-  }
+  MACCB_Event(pData);
 }
 
 
 /**************************************************************************************************
- * @brief   Returns the number of indirect messages pending in the application
+ * @brief   Returns the number of indirect messages pending in the application: the nodes with
+ *          commands waiting.  It does not tell which node polls, so any node polling while one
+ *          has commands listens for a frame; ProcessPollInd() sends the frame if it is for it.
  * @param   None
  * @return  Number of indirect messages in the application
  **************************************************************************************************/
 uint8 MAC_CbackCheckPending(void)
 {
-  return (0);
+  uint16 pending = DEVTAB_Pending();
+
+  return (pending > 0xFF) ? 0xFF : (uint8) pending;
 }
 
 /**************************************************************************************************
@@ -10,21 +10,59 @@ extern "C"
  * INCLUDES
  **************************************************************************************************/
 #include "hal_types.h"
+#include "sched.h"
+#include "calib.h"
 
 #define GW_KEY_INT_ENABLED       TRUE         /* FALSE = Key Polling, TRUE  = Key interrupt */
 
+/* Received packets go to the PC as binary frames (frame.h); TRUE prints them as text for debugging */
+#ifndef GW_UART_TEXT
+  #define GW_UART_TEXT           FALSE
+#endif
+
+/* The channel is chosen after GW_SCAN_ROUNDS energy detect scans of GW_SCAN_DURATION, and
+ * assessed again every GW_ASSESS_STICKS (chsel.h).  The gateway does not hear the nodes during a
+ * scan, and they send at any point of its stick, each at the same one every time: the stick is
+ * cut in GW_ASSESS_SLOTS slots, the frames heard in each are counted, and the assessment scans one
+ * channel at a time, for GW_ASSESS_DURATION, at the start of the slots that were the quietest
+ * since the assessment before.  The receiver is on between them */
+#define GW_ASSESS_SLOTS                 32            /* 32 at most, a bit each */
 #ifdef __DEBUG
-  #define GW_SCAN_DURATION              6
+  #define GW_SCAN_DURATION              4
+  #define GW_SCAN_ROUNDS                4
+  #define GW_ASSESS_DURATION            2
+  #define GW_ASSESS_STICKS              10
   #define GW_DEFAULT_STICK_DURATION     6000
+  #define GW_DEFAULT_SENSING_TIME       10
+  #define GW_DEFAULT_SEND_ALIVE_TIME    2
+  #define GW_DEFAULT_PREPARING_DELTA    5
 #else
-  #define GW_SCAN_DURATION              8
+  #define GW_SCAN_DURATION              6             /* 4 rounds take as long as one of 8 */
+  #define GW_SCAN_ROUNDS                4
+  #define GW_ASSESS_DURATION            3             /* 138 ms a channel */
+  #define GW_ASSESS_STICKS              15
   #define GW_DEFAULT_STICK_DURATION     60000
+  #define GW_DEFAULT_SENSING_TIME       30
+  #define GW_DEFAULT_SEND_ALIVE_TIME    5
+  #define GW_DEFAULT_PREPARING_DELTA    2
 #endif
+/* The periods of the nodes, in their sticks (sched.h), sent to each node as it associates */
+
+/* The PAN moves, by a coordinator realignment, when its channel scores worse than the best by
+ * GW_MOVE_MARGIN (about 5 dB on the median and the 90th percentile) in GW_MOVE_ROUNDS
+ * assessments in a row.  The sleeping nodes miss the realignment: their polls fail on the old
+ * channel, and more than NODE_POLL_FAIL_MAX in a row make a node scan for the PAN again.  Without
+ * GW_MOVE_ENABLED the gateway only tells the better channel */
+#define GW_MOVE_ENABLED               TRUE
+#define GW_MOVE_MARGIN                60
+#define GW_MOVE_ROUNDS                2
 
 /* Event IDs */
 #define GW_SEND_EVENT         0x0001
 #define GW_PREP_INIT_EVENT    0x0002
 #define GW_STICK_TIMER_EVENT  0x0004
+#define GW_STATS_EVENT        0x0008
+#define GW_ASSESS_EVENT       0x0010
 
 
 
@@ -35,6 +73,11 @@ extern void GW_Init( uint8 task_id );
 extern uint16 GW_ProcessEvent( uint8 task_id, uint16 events );
 extern void GW_HandleKeys( uint8 keys, uint8 shift );
 extern void GW_PowerMgr (uint8 mode);
+/* New periods for every node, from its next poll on; FALSE if they are not valid */
+extern bool GW_SetSched(const sched_t *pSched);
+/* New calibration for a node, from its next poll on; FALSE if it is not valid, the node is not
+ * associated or GW_CALIB_PENDING calibrations already wait */
+extern bool GW_SetCalib(uint16 shortAddr, const calib_t *pCalib);
 
 
 
@@ -0,0 +1,327 @@
+/**************************************************************************************************
+  Filename:       bench_batch.c
+
+  Description:    Host benchmark of the sensing batches of batch.c: bytes and airtime per
+                  sensing result against a PKT_SENSING_TYPE packet in the wire format of
+                  wire.h, and a check that every batch, and every single packet, decodes to
+                  what was put in.
+
+                  bench_batch [-n results] [-r seed]
+
+                  A series of results is drawn the way a node measures them: readings that
+                  drift slowly, a few counts of noise on every ADC sample and now and then a
+                  spike.  The series is cut into batches for every choice of fields and for
+                  1, 4 and as many results as one frame takes.  The airtime counts the PHY
+                  header, a MAC header with short addresses and PAN ID compression and the FCS
+                  at 250 kbit/s, and the ACK of every frame.  A batch cut short must give the
+                  records before the cut and nothing else.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hal_types.h"
+#include "batch.h"
+#include "wire.h"
+#include "bench_util.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+#define BENCH_DEFAULT_RESULTS     10000
+#define BENCH_FRAME_LEN           116   /* MAC_MAX_FRAME_SIZE */
+#define BENCH_PHY_LEN             6     /* preamble, SFD, length */
+#define BENCH_MAC_LEN             11    /* frame control, sequence, PAN ID, 2 short addresses, FCS */
+#define BENCH_ACK_LEN             (BENCH_PHY_LEN + 5)
+#define BENCH_BYTE_US             32
+#define BENCH_SENSING_TIME        30    /* sticks between results */
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static const uint8 benchFields[] =
+{
+  BATCH_DERIVED,
+  BATCH_DERIVED | BATCH_MEAN,
+  BATCH_DERIVED | BATCH_MEAN | BATCH_MINMAX,
+  BATCH_DERIVED | BATCH_MEAN | BATCH_MINMAX | BATCH_RAW
+};
+static const uint8 benchPeriods[] = {1, 4, 0xFF};
+
+static sensingPara_t *benchData;
+static int    benchFailed;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static void   benchFill(uint32 count);
+static void   benchCheck(const uint8 *pBuf, uint8 len, uint8 fields, uint32 first, uint8 count);
+static int    benchSame(const batchRec_t *pRec, const sensingPara_t *pIn, uint8 fields);
+
+/**************************************************************************************************
+ * @fn          main
+ *
+ * @brief       Batch the series every way and compare.
+ **************************************************************************************************
+ */
+int main(int argc, char **argv)
+{
+  uint32 results = BENCH_DEFAULT_RESULTS;
+  uint8 buf[BENCH_FRAME_LEN];
+  uint32 i, frames, bytes, airUs, singleUs;
+  uint8 singleLen = 0;
+  pkt_t pkt, dec;
+  uint8 f, p, inBatch;
+  batch_t batch;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:r:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n': results = strtoul(optarg, NULL, 0);      break;
+      case 'r': benchRandSeed(strtoul(optarg, NULL, 0)); break;
+      default:
+        fprintf(stderr, "usage: %s [-n results] [-r seed]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (results == 0)
+  {
+    fprintf(stderr, "%s: at least one result\n", argv[0]);
+    return 1;
+  }
+  benchData = malloc(results * sizeof(sensingPara_t));
+  benchFill(results);
+
+  /* One packet a result */
+  pkt.pktType = PKT_SENSING_TYPE;
+  for (i = 0; i < results; i++)
+  {
+    pkt.pktPara.sensingPara = benchData[i];
+    singleLen = WIRE_Encode(&pkt, buf, sizeof(buf));
+    if ((singleLen != WIRE_SENSING_LEN) || !WIRE_Decode(buf, singleLen, &dec) ||
+        (memcmp(&dec.pktPara.sensingPara, &benchData[i], sizeof(sensingPara_t)) != 0) ||
+        (buf[3] != (uint8)benchData[i].time) || (buf[6] != (uint8)(benchData[i].time >> 24)))
+    {
+      printf("MISMATCH: PKT_SENSING_TYPE packet of result %u\n", i);
+      benchFailed = 1;
+      break;
+    }
+  }
+  singleUs = (BENCH_PHY_LEN + BENCH_MAC_LEN + singleLen + BENCH_ACK_LEN) * BENCH_BYTE_US;
+  printf("%u results, PKT_SENSING_TYPE %u B and %u us on air a result\n", results, singleLen,
+         singleUs);
+  printf("%-6s %-7s %7s %9s %9s %7s %9s\n", "fields", "periods", "frames", "B/result",
+         "us/result", "ratio", "air ratio");
+
+  for (f = 0; f < sizeof(benchFields); f++)
+  {
+    for (p = 0; p < sizeof(benchPeriods); p++)
+    {
+      frames = bytes = airUs = 0;
+      i = 0;
+      while (i < results)
+      {
+        uint32 first = i;
+
+        BATCH_Start(&batch, buf, sizeof(buf), 1, benchFields[f]);
+        for (inBatch = 0; (i < results) && (inBatch < benchPeriods[p]); inBatch++, i++)
+        {
+          if (!BATCH_Add(&batch, &benchData[i]))
+          {
+            break;
+          }
+        }
+        if (BATCH_Count(&batch) == 0)
+        {
+          printf("MISMATCH: a result does not fit an empty batch\n");
+          return 1;
+        }
+        benchCheck(buf, BATCH_Len(&batch), benchFields[f], first, BATCH_Count(&batch));
+        frames++;
+        bytes += BATCH_Len(&batch);
+        airUs += (BENCH_PHY_LEN + BENCH_MAC_LEN + BATCH_Len(&batch) + BENCH_ACK_LEN) *
+                 BENCH_BYTE_US;
+      }
+      printf("0x%02X   %-7s %7u %9.1f %9.0f %7.2f %9.2f\n", benchFields[f],
+             (benchPeriods[p] == 0xFF) ? "full" : (benchPeriods[p] == 1) ? "1" : "4", frames,
+             (double)bytes / results, (double)airUs / results,
+             (double)singleLen * results / bytes, (double)singleUs * results / airUs);
+    }
+  }
+
+  free(benchData);
+  return benchFailed;
+}
+
+/**************************************************************************************************
+ * @fn          benchFill
+ *
+ * @brief       Draw the series of results.
+ **************************************************************************************************
+ */
+static void benchFill(uint32 count)
+{
+  int32 ph = 2048, ext = 1306, vdd = 2457, itmp = 1206;
+  uint32 i;
+  uint8 j;
+
+  memset(benchData, 0, count * sizeof(sensingPara_t));
+  for (i = 0; i < count; i++)
+  {
+    sensingPara_t *pRec = &benchData[i];
+    sensing_t *s = &pRec->sensingData;
+    uint32 sum = 0;
+
+    /* slow drift */
+    ph += (int32)(benchRand() % 9) - 4;
+    ext += (int32)(benchRand() % 5) - 2;
+    itmp += (int32)(benchRand() % 3) - 1;
+    if ((benchRand() % 64) == 0)
+    {
+      vdd--;
+    }
+
+    pRec->nodeId = 1;
+    pRec->time = (i + 1) * BENCH_SENSING_TIME;
+    pRec->run = 1 + i / 1000;
+    pRec->storeBlock = (uint16)(i % 1000);
+    for (j = 0; j < 16; j++)
+    {
+      int32 v = ph + (int32)(benchRand() % 9) - 4;
+
+      if ((benchRand() & 0x1F) == 0)
+      {
+        v += 200;
+      }
+      s->pHAdc[j] = (uint16)((v < 0) ? 0 : (v > 4095) ? 4095 : v);
+      sum += s->pHAdc[j];
+    }
+    s->vddAdcAvg = (uint16)vdd;
+    s->intTmpAdcAvg = (uint16)itmp;
+    s->pHAdcAvg = (uint16)(sum / 16);
+    s->extTmpAdcAvg = (uint16)ext;
+    s->vddVal = (uint16)(vdd * 5000 / 4096);
+    s->intTmpVal = (uint16)((itmp * 2500 - 650 * 4096) / 9216);
+    s->pHVal = (uint16)(500 - (ph - 2048) / 8);
+    s->extTmpRes = (uint16)(ext * 47000 / (4096 - ext));
+    s->extTmpVal = (uint16)(29 + (ext - 1306) / 30);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          benchCheck
+ *
+ * @brief       A batch must decode to its records, and a batch cut short to the records before
+ *              the cut.
+ **************************************************************************************************
+ */
+static void benchCheck(const uint8 *pBuf, uint8 len, uint8 fields, uint32 first, uint8 count)
+{
+  batch_t dec;
+  batchRec_t rec;
+  uint8 n = 0;
+  uint8 cut = len - 1 - (uint8)(benchRand() % (len - BATCH_HDR_LEN));
+
+  if (!BATCH_DecodeStart(&dec, pBuf, len))
+  {
+    printf("MISMATCH: batch not recognized\n");
+    benchFailed = 1;
+    return;
+  }
+  while (BATCH_DecodeNext(&dec, &rec))
+  {
+    if ((n >= count) || !benchSame(&rec, &benchData[first + n], fields))
+    {
+      printf("MISMATCH: fields 0x%02X, record %u of a batch at result %u\n", fields, n, first);
+      benchFailed = 1;
+      return;
+    }
+    n++;
+  }
+  if (n != count)
+  {
+    printf("MISMATCH: fields 0x%02X, %u records of %u decoded\n", fields, n, count);
+    benchFailed = 1;
+  }
+
+  /* cut short */
+  n = 0;
+  BATCH_DecodeStart(&dec, pBuf, cut);
+  while (BATCH_DecodeNext(&dec, &rec))
+  {
+    if ((n >= count) || !benchSame(&rec, &benchData[first + n], fields))
+    {
+      printf("MISMATCH: fields 0x%02X, batch cut at %u of %u decoded to garbage\n", fields, cut,
+             len);
+      benchFailed = 1;
+      return;
+    }
+    n++;
+  }
+  if (n >= count)
+  {
+    printf("MISMATCH: fields 0x%02X, batch cut at %u of %u decoded in full\n", fields, cut, len);
+    benchFailed = 1;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          benchSame
+ *
+ * @brief       Does a decoded record carry the values of the result it came from?
+ **************************************************************************************************
+ */
+static int benchSame(const batchRec_t *pRec, const sensingPara_t *pIn, uint8 fields)
+{
+  const sensing_t *d = &pRec->para.sensingData;
+  const sensing_t *s = &pIn->sensingData;
+  uint16 lo = 0xFFFF, hi = 0;
+  uint8 j;
+
+  if ((pRec->para.nodeId != pIn->nodeId) || (pRec->para.time != pIn->time) ||
+      (pRec->para.run != pIn->run) || (pRec->para.storeBlock != pIn->storeBlock))
+  {
+    return 0;
+  }
+  if ((fields & BATCH_DERIVED) &&
+      ((d->vddVal != s->vddVal) || (d->intTmpVal != s->intTmpVal) || (d->pHVal != s->pHVal) ||
+       (d->extTmpRes != s->extTmpRes) || (d->extTmpVal != s->extTmpVal)))
+  {
+    return 0;
+  }
+  if ((fields & BATCH_MEAN) &&
+      ((d->vddAdcAvg != s->vddAdcAvg) || (d->intTmpAdcAvg != s->intTmpAdcAvg) ||
+       (d->pHAdcAvg != s->pHAdcAvg) || (d->extTmpAdcAvg != s->extTmpAdcAvg)))
+  {
+    return 0;
+  }
+  for (j = 0; j < 16; j++)
+  {
+    lo = (s->pHAdc[j] < lo) ? s->pHAdc[j] : lo;
+    hi = (s->pHAdc[j] > hi) ? s->pHAdc[j] : hi;
+  }
+  if ((fields & BATCH_MINMAX) && ((pRec->pHAdcMin != lo) || (pRec->pHAdcMax != hi)))
+  {
+    return 0;
+  }
+  if ((fields & BATCH_RAW) && (memcmp(d->pHAdc, s->pHAdc, sizeof(s->pHAdc)) != 0))
+  {
+    return 0;
+  }
+  return 1;
+}
+
+/**************************************************************************************************
+ */
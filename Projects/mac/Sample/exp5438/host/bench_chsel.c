@@ -0,0 +1,303 @@
+/**************************************************************************************************
+  Filename:       bench_chsel.c
+
+  Description:    Host check of the channel assessment of chsel.c against a model that keeps
+                  the same readings and sorts them with qsort().
+
+                  bench_chsel [-n rounds] [-r seed]
+
+                  Each round scans a random set of channels, all of them, one, or a few, with
+                  random energies, and once in a while a round gives fewer readings than its
+                  mask has channels:
+                    - readings   the readings kept per channel, CHSEL_ROUNDS at most
+                    - pctile     the percentiles 0, 10, 50, 90 and 100 by the nearest rank
+                    - score      the scores, CHSEL_NO_SCORE for a channel never scanned
+                    - best       the channel of the lowest score, the lowest of equal ones
+                    - window     a channel that was loud for CHSEL_ROUNDS rounds and quiet for
+                                 as many more scores quiet
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hal_types.h"
+#include "chsel.h"
+#include "bench_util.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+#define BENCH_DEFAULT_ROUNDS      20000
+#define BENCH_LOUD                200   /* energy of a Wi-Fi burst */
+#define BENCH_QUIET               10
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static const uint8 benchPct[] = {0, 10, 50, 90, 100};
+
+/* The readings as the bench keeps them, newest last */
+static struct
+{
+  uint8 energy[CHSEL_ROUNDS];
+  uint8 num;
+} benchModel[CHSEL_NUM];
+static uint32 benchChecks[5];         /* readings, pctile, score, best, window */
+static int    benchFailed;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static void   benchRound(uint32 channels, const uint8 *pEnergy, uint8 num);
+static uint8  benchPercentile(uint8 ch, uint8 pct);
+static uint16 benchScore(uint8 ch);
+static void   benchCheck(uint32 round);
+static int    benchCmp(const void *a, const void *b);
+static void   benchFail(const char *test, const char *what, uint32 n);
+
+/**************************************************************************************************
+ * @fn          main
+ *
+ * @brief       Random rounds, each checked against the model, then the window.
+ **************************************************************************************************
+ */
+int main(int argc, char **argv)
+{
+  static const char *names[] = {"readings", "pctile", "score", "best", "window"};
+  uint8 energy[CHSEL_NUM];
+  uint32 rounds = BENCH_DEFAULT_ROUNDS;
+  uint32 r, channels;
+  uint8 ch, num, i;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:r:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n': rounds = strtoul(optarg, NULL, 0);       break;
+      case 'r': benchRandSeed(strtoul(optarg, NULL, 0)); break;
+      default:
+        fprintf(stderr, "usage: %s [-n rounds] [-r seed]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  printf("%u channels from %u, %u readings kept, score %u * median + %u * p90\n", CHSEL_NUM,
+         CHSEL_FIRST, CHSEL_ROUNDS, CHSEL_W_MEDIAN, CHSEL_W_P90);
+
+  /* Nothing scanned yet */
+  CHSEL_Init();
+  benchCheck(0);
+
+  for (r = 1; r <= rounds; r++)
+  {
+    switch (benchRand() % 4)
+    {
+      case 0:  channels = ((1UL << CHSEL_NUM) - 1) << CHSEL_FIRST;                 break;
+      case 1:  channels = 1UL << (CHSEL_FIRST + benchRand() % CHSEL_NUM);          break;
+      default: channels = (benchRand() & ((1UL << CHSEL_NUM) - 1)) << CHSEL_FIRST; break;
+    }
+    num = 0;
+    for (ch = CHSEL_FIRST; ch < CHSEL_FIRST + CHSEL_NUM; ch++)
+    {
+      if (channels & (1UL << ch))
+      {
+        /* Few energies, so that equal scores come up */
+        energy[num++] = (benchRand() % 8 == 0) ? BENCH_LOUD : (uint8)(benchRand() % 4) * 20;
+      }
+    }
+    if ((num != 0) && (benchRand() % 16 == 0))
+    {
+      num = (uint8)(benchRand() % num);
+    }
+    CHSEL_Round(channels, energy, num);
+    benchRound(channels, energy, num);
+    benchCheck(r);
+  }
+
+  /* A channel loud for CHSEL_ROUNDS rounds, then quiet as long, all the others loud */
+  CHSEL_Init();
+  memset(benchModel, 0, sizeof(benchModel));
+  for (r = 0; r < 2 * CHSEL_ROUNDS; r++)
+  {
+    for (i = 0; i < CHSEL_NUM; i++)
+    {
+      energy[i] = BENCH_LOUD;
+    }
+    if (r >= CHSEL_ROUNDS)
+    {
+      energy[15 - CHSEL_FIRST] = BENCH_QUIET;
+    }
+    channels = ((1UL << CHSEL_NUM) - 1) << CHSEL_FIRST;
+    CHSEL_Round(channels, energy, CHSEL_NUM);
+    benchRound(channels, energy, CHSEL_NUM);
+  }
+  benchChecks[4]++;
+  if ((CHSEL_Best() != 15) ||
+      (CHSEL_Score(15) != (CHSEL_W_MEDIAN + CHSEL_W_P90) * BENCH_QUIET))
+  {
+    benchFail("window", "quiet channel does not score quiet", CHSEL_Score(15));
+  }
+  benchCheck(r);
+
+  printf("%-9s %9s\n", "test", "checks");
+  for (i = 0; i < 5; i++)
+  {
+    printf("%-9s %9u\n", names[i], benchChecks[i]);
+  }
+  if (benchFailed != 0)
+  {
+    printf("FAILED: %d checks\n", benchFailed);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
+
+/**************************************************************************************************
+ * @fn          benchRound
+ *
+ * @brief       A round in the model: the readings go to the channels of the mask in order,
+ *              the oldest of a channel goes once it has CHSEL_ROUNDS.
+ **************************************************************************************************
+ */
+static void benchRound(uint32 channels, const uint8 *pEnergy, uint8 num)
+{
+  uint8 ch, i;
+
+  for (ch = CHSEL_FIRST; (ch < CHSEL_FIRST + CHSEL_NUM) && (num != 0); ch++)
+  {
+    if (!(channels & (1UL << ch)))
+    {
+      continue;
+    }
+    i = ch - CHSEL_FIRST;
+    if (benchModel[i].num == CHSEL_ROUNDS)
+    {
+      memmove(&benchModel[i].energy[0], &benchModel[i].energy[1], CHSEL_ROUNDS - 1);
+      benchModel[i].num--;
+    }
+    benchModel[i].energy[benchModel[i].num++] = *pEnergy++;
+    num--;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          benchPercentile
+ *
+ * @brief       Percentile of the readings of a channel in the model, by the nearest rank.
+ **************************************************************************************************
+ */
+static uint8 benchPercentile(uint8 ch, uint8 pct)
+{
+  uint8 sorted[CHSEL_ROUNDS];
+  uint8 num = benchModel[ch - CHSEL_FIRST].num;
+
+  if (num == 0)
+  {
+    return 0;
+  }
+  memcpy(sorted, benchModel[ch - CHSEL_FIRST].energy, num);
+  qsort(sorted, num, 1, benchCmp);
+  return sorted[(pct * (num - 1) + 50) / 100];
+}
+
+/**************************************************************************************************
+ * @fn          benchScore
+ *
+ * @brief       Score of a channel in the model.
+ **************************************************************************************************
+ */
+static uint16 benchScore(uint8 ch)
+{
+  if (benchModel[ch - CHSEL_FIRST].num == 0)
+  {
+    return CHSEL_NO_SCORE;
+  }
+  return CHSEL_W_MEDIAN * benchPercentile(ch, 50) + CHSEL_W_P90 * benchPercentile(ch, 90);
+}
+
+/**************************************************************************************************
+ * @fn          benchCheck
+ *
+ * @brief       Every channel must have the readings, percentiles and score of the model, and
+ *              the best channel must be the first of the lowest score.
+ **************************************************************************************************
+ */
+static void benchCheck(uint32 round)
+{
+  uint16 score, bestScore = CHSEL_NO_SCORE;
+  uint8 best = CHSEL_FIRST;
+  uint8 ch, i;
+
+  for (ch = CHSEL_FIRST; ch < CHSEL_FIRST + CHSEL_NUM; ch++)
+  {
+    benchChecks[0]++;
+    if (CHSEL_Readings(ch) != benchModel[ch - CHSEL_FIRST].num)
+    {
+      benchFail("readings", "readings kept", round);
+    }
+    for (i = 0; i < sizeof(benchPct); i++)
+    {
+      benchChecks[1]++;
+      if (CHSEL_Percentile(ch, benchPct[i]) != benchPercentile(ch, benchPct[i]))
+      {
+        benchFail("pctile", "percentile", round);
+      }
+    }
+    score = benchScore(ch);
+    benchChecks[2]++;
+    if (CHSEL_Score(ch) != score)
+    {
+      benchFail("score", "score", round);
+    }
+    if (score < bestScore)
+    {
+      best      = ch;
+      bestScore = score;
+    }
+  }
+  benchChecks[3]++;
+  if (CHSEL_Best() != best)
+  {
+    benchFail("best", "best channel", round);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          benchCmp
+ *
+ * @brief       Order of two readings for qsort().
+ **************************************************************************************************
+ */
+static int benchCmp(const void *a, const void *b)
+{
+  return *(const uint8*)a - *(const uint8*)b;
+}
+
+/**************************************************************************************************
+ * @fn          benchFail
+ *
+ * @brief       Report a failed check; only the first few of a run are printed.
+ **************************************************************************************************
+ */
+static void benchFail(const char *test, const char *what, uint32 n)
+{
+  if (benchFailed++ < 10)
+  {
+    printf("MISMATCH: %s: %s (%u)\n", test, what, n);
+  }
+}
+
+/**************************************************************************************************
+ */
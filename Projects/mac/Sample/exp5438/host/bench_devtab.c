@@ -0,0 +1,463 @@
+/**************************************************************************************************
+  Filename:       bench_devtab.c
+
+  Description:    Host check of the device table of devtab.c, with its records in the FRAM
+                  model of hal_sim_fram.c through the driver of fram.c.
+
+                  bench_devtab [-n ops] [-r seed]
+
+                  The extended addresses are drawn at random, and those of a collision are
+                  drawn until their hash gives the same slot:
+                    - collide    devices of one home slot take the slots after it in turn, and
+                                 each is found by its extended and by its short address
+                    - delete     a device aged out in the middle of the run leaves its slot
+                                 gone: the devices after it are still found, it is not
+                    - reuse      a device that associates again keeps its slot, a new device
+                                 of the same home slot takes the gone one
+                    - full       a full table takes no new device and still finds the others
+                    - pending    the devices with commands waiting are counted once each,
+                                 through DEVTAB_Pend(), DEVTAB_Sent() and DEVTAB_Age()
+                    - churn      'ops' associations, new and known, and agings at random
+                                 against a model of the table kept by the bench
+                    - reload     DEVTAB_Init() on the FRAM as the churn left it gives back
+                                 every device with its short address; a damaged record loses
+                                 that device only, the devices past it are still found
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hal_types.h"
+#include "hal_board_cfg.h"
+#include "hal_sim.h"
+#include "fram.h"
+#include "crc.h"
+#include "devtab.h"
+#include "bench_util.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+#define BENCH_DEFAULT_OPS         100000
+#define BENCH_MAX_AGE             50    /* sticks, of the agings of the churn */
+#define BENCH_AGE_EVERY           64    /* associations between two agings */
+#define BENCH_REC_LEN             DEVTAB_REC_LEN
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Global Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+volatile uint8 halSimIntEnabled = TRUE;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+/* The table as the bench sees it, by short address */
+static struct
+{
+  sAddrExt_t extAddr;
+  uint32     lastSeen;
+  bool       used;
+} benchModel[DEVTAB_SIZE];
+static uint16 benchCount;
+static int    benchFailed;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static uint16 benchHome(const sAddrExt_t extAddr);
+static void   benchExt(sAddrExt_t extAddr, int home);
+static void   benchCheck(const char *test);
+static void   benchRow(const char *test, uint32 ops);
+static void   benchFail(const char *test, const char *what, uint32 n);
+
+/**************************************************************************************************
+ * @fn          main
+ *
+ * @brief       Run the tests one after the other on one table.
+ **************************************************************************************************
+ */
+int main(int argc, char **argv)
+{
+  sAddrExt_t ext[6];
+  sAddrExt_t extAddr;
+  devEntry_t *pDev;
+  uint32 ops = BENCH_DEFAULT_OPS;
+  uint32 now, n;
+  uint16 home, slot, aged, want;
+  uint8 rec[BENCH_REC_LEN];
+  int opt, i;
+
+  while ((opt = getopt(argc, argv, "n:r:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n': ops = strtoul(optarg, NULL, 0);          break;
+      case 'r': benchRandSeed(strtoul(optarg, NULL, 0)); break;
+      default:
+        fprintf(stderr, "usage: %s [-n ops] [-r seed]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (fram_init(FRAM_MODE0) != OK)
+  {
+    fprintf(stderr, "FRAM model does not answer\n");
+    return 1;
+  }
+
+  printf("%u slots of %u bytes in RAM, %u in the FRAM\n", DEVTAB_SIZE,
+         (unsigned)sizeof(devEntry_t), DEVTAB_REC_LEN);
+  printf("%-9s %9s %9s %9s\n", "test", "ops", "devices", "bus B/op");
+
+  /* A blank FRAM gets an empty table */
+  memset(benchFram, 0, sizeof(benchFram));
+  if (DEVTAB_Init(TRUE) != 0)
+  {
+    benchFail("init", "blank FRAM gave devices", DEVTAB_Count());
+  }
+
+  /* Four devices of one home slot, the last one past the end of the table */
+  memset(&benchStats, 0, sizeof(benchStats));
+  home = DEVTAB_SIZE - 2;
+  for (i = 0; i < 6; i++)
+  {
+    benchExt(ext[i], home);
+  }
+  for (i = 0; i < 4; i++)
+  {
+    pDev = DEVTAB_Assoc(ext[i], (i == 1) ? 0 : 100);
+    slot = (home + i) % DEVTAB_SIZE;
+    if ((pDev == NULL) || (DEVTAB_Short(pDev) != DEVTAB_SHORT_BASE + slot))
+    {
+      benchFail("collide", "device not in the next slot", i);
+      continue;
+    }
+    sAddrExtCpy(benchModel[slot].extAddr, ext[i]);
+    benchModel[slot].lastSeen = (i == 1) ? 0 : 100;
+    benchModel[slot].used     = TRUE;
+    benchCount++;
+  }
+  benchCheck("collide");
+  benchRow("collide", 4);
+
+  /* The second one is aged out: the third and the fourth are found past its gone slot */
+  memset(&benchStats, 0, sizeof(benchStats));
+  aged = DEVTAB_Age(120, BENCH_MAX_AGE);
+  slot = (home + 1) % DEVTAB_SIZE;
+  if ((aged != 1) || (DEVTAB_Find(ext[1]) != NULL) || (DEVTAB_Get(DEVTAB_SHORT_BASE + slot) != NULL))
+  {
+    benchFail("delete", "aged device still there", aged);
+  }
+  benchModel[slot].used = FALSE;
+  benchCount--;
+  benchCheck("delete");
+  benchRow("delete", 1);
+
+  /* The fourth associates again and keeps its slot, a new one takes the gone slot, the next
+   * new one the free slot after the fourth */
+  memset(&benchStats, 0, sizeof(benchStats));
+  pDev = DEVTAB_Assoc(ext[3], 120);
+  if ((pDev == NULL) || (DEVTAB_Short(pDev) != DEVTAB_SHORT_BASE + (home + 3) % DEVTAB_SIZE))
+  {
+    benchFail("reuse", "known device moved", 3);
+  }
+  benchModel[(home + 3) % DEVTAB_SIZE].lastSeen = 120;
+  for (i = 4; i < 6; i++)
+  {
+    pDev = DEVTAB_Assoc(ext[i], 120);
+    slot = (home + ((i == 4) ? 1 : 4)) % DEVTAB_SIZE;
+    if ((pDev == NULL) || (DEVTAB_Short(pDev) != DEVTAB_SHORT_BASE + slot))
+    {
+      benchFail("reuse", "new device not in the first gone or free slot", i);
+      continue;
+    }
+    sAddrExtCpy(benchModel[slot].extAddr, ext[i]);
+    benchModel[slot].lastSeen = 120;
+    benchModel[slot].used     = TRUE;
+    benchCount++;
+  }
+  benchCheck("reuse");
+  benchRow("reuse", 3);
+
+  /* Fill the table: one more device does not fit, the known ones still associate */
+  memset(&benchStats, 0, sizeof(benchStats));
+  n = 0;
+  while (benchCount < DEVTAB_SIZE)
+  {
+    benchExt(extAddr, -1);
+    pDev = DEVTAB_Assoc(extAddr, 120);
+    n++;
+    if (pDev == NULL)
+    {
+      benchFail("full", "device refused before the table is full", benchCount);
+      break;
+    }
+    slot = DEVTAB_Short(pDev) - DEVTAB_SHORT_BASE;
+    sAddrExtCpy(benchModel[slot].extAddr, extAddr);
+    benchModel[slot].lastSeen = 120;
+    benchModel[slot].used     = TRUE;
+    benchCount++;
+  }
+  benchExt(extAddr, -1);
+  if (DEVTAB_Assoc(extAddr, 120) != NULL)
+  {
+    benchFail("full", "full table took a device", DEVTAB_Count());
+  }
+  if (DEVTAB_Assoc(ext[0], 120) != DEVTAB_Get(DEVTAB_SHORT_BASE + home))
+  {
+    benchFail("full", "known device not found in a full table", 0);
+  }
+  benchModel[home].lastSeen = 120;
+  benchCheck("full");
+  benchRow("full", n + 2);
+
+  /* Commands waiting: a device is counted once whatever it has, until none is left */
+  memset(&benchStats, 0, sizeof(benchStats));
+  DEVTAB_Pend(DEVTAB_Get(DEVTAB_SHORT_BASE + home), DEVTAB_CMD(3));
+  DEVTAB_Pend(DEVTAB_Get(DEVTAB_SHORT_BASE + home), DEVTAB_CMD(5));
+  DEVTAB_Pend(DEVTAB_Get(DEVTAB_SHORT_BASE + 0), DEVTAB_CMD(5));
+  DEVTAB_Pend(DEVTAB_Get(DEVTAB_SHORT_BASE + 1), 0);
+  if (DEVTAB_Pending() != 2)
+  {
+    benchFail("pending", "devices with commands after DEVTAB_Pend()", DEVTAB_Pending());
+  }
+  DEVTAB_Sent(DEVTAB_Get(DEVTAB_SHORT_BASE + home), DEVTAB_CMD(3));
+  DEVTAB_Sent(DEVTAB_Get(DEVTAB_SHORT_BASE + 1), DEVTAB_CMD(3));
+  if (DEVTAB_Pending() != 2)
+  {
+    benchFail("pending", "device counted out with a command left", DEVTAB_Pending());
+  }
+  DEVTAB_Sent(DEVTAB_Get(DEVTAB_SHORT_BASE + home), DEVTAB_CMD(5));
+  if (DEVTAB_Pending() != 1)
+  {
+    benchFail("pending", "device without commands still counted", DEVTAB_Pending());
+  }
+  benchModel[0].lastSeen = 0;
+  DEVTAB_Get(DEVTAB_SHORT_BASE + 0)->lastSeen = 0;
+  if ((DEVTAB_Age(120, BENCH_MAX_AGE) != 1) || (DEVTAB_Pending() != 0))
+  {
+    benchFail("pending", "aged device still counted", DEVTAB_Pending());
+  }
+  benchModel[0].used = FALSE;
+  benchCount--;
+  benchCheck("pending");
+  benchRow("pending", 9);
+
+  /* Churn: new devices, known ones again, and agings */
+  memset(&benchStats, 0, sizeof(benchStats));
+  now = 120;
+  for (n = 0; n < ops; n++)
+  {
+    now += benchRand() % 2;
+    slot = benchRand() % DEVTAB_SIZE;
+    if (benchModel[slot].used && (benchRand() % 2 == 0))
+    {
+      pDev = DEVTAB_Assoc(benchModel[slot].extAddr, now);
+      if ((pDev == NULL) || (DEVTAB_Short(pDev) != DEVTAB_SHORT_BASE + slot))
+      {
+        benchFail("churn", "known device moved", n);
+      }
+      benchModel[slot].lastSeen = now;
+    }
+    else
+    {
+      benchExt(extAddr, (benchRand() % 4 == 0) ? (int)(benchRand() % 4) : -1);
+      pDev = DEVTAB_Assoc(extAddr, now);
+      if (benchCount == DEVTAB_SIZE)
+      {
+        if (pDev != NULL)
+        {
+          benchFail("churn", "full table took a device", n);
+        }
+      }
+      else if ((pDev == NULL) || benchModel[DEVTAB_Short(pDev) - DEVTAB_SHORT_BASE].used)
+      {
+        benchFail("churn", "new device refused or on a device", n);
+      }
+      else
+      {
+        slot = DEVTAB_Short(pDev) - DEVTAB_SHORT_BASE;
+        sAddrExtCpy(benchModel[slot].extAddr, extAddr);
+        benchModel[slot].lastSeen = now;
+        benchModel[slot].used     = TRUE;
+        benchCount++;
+      }
+    }
+    if (n % BENCH_AGE_EVERY == BENCH_AGE_EVERY - 1)
+    {
+      want = 0;
+      for (slot = 0; slot < DEVTAB_SIZE; slot++)
+      {
+        if (benchModel[slot].used && (now - benchModel[slot].lastSeen > BENCH_MAX_AGE))
+        {
+          benchModel[slot].used = FALSE;
+          benchCount--;
+          want++;
+        }
+      }
+      if (DEVTAB_Age(now, BENCH_MAX_AGE) != want)
+      {
+        benchFail("churn", "devices aged", n);
+      }
+      benchCheck("churn");
+    }
+  }
+  benchCheck("churn");
+  benchRow("churn", ops);
+
+  /* Reset: the table comes back from the FRAM; then one record is damaged */
+  memset(&benchStats, 0, sizeof(benchStats));
+  if (DEVTAB_Init(TRUE) != benchCount)
+  {
+    benchFail("reload", "devices read back", DEVTAB_Count());
+  }
+  benchCheck("reload");
+  for (slot = 0; (slot < DEVTAB_SIZE) && !benchModel[slot].used; slot++)
+  {
+  }
+  if (slot < DEVTAB_SIZE)
+  {
+    fram_readMemory(DEVTAB_ADDR + DEVTAB_HDR_LEN + (uint32)slot * DEVTAB_REC_LEN, rec, sizeof(rec));
+    rec[0] ^= 0x01;
+    fram_writeMemory(DEVTAB_ADDR + DEVTAB_HDR_LEN + (uint32)slot * DEVTAB_REC_LEN, rec, sizeof(rec));
+    benchModel[slot].used = FALSE;
+    benchCount--;
+    if (DEVTAB_Init(TRUE) != benchCount)
+    {
+      benchFail("reload", "damaged record read back", slot);
+    }
+    benchCheck("reload");
+  }
+  benchRow("reload", 2);
+
+  if (benchFailed != 0)
+  {
+    printf("FAILED: %d checks\n", benchFailed);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
+
+/**************************************************************************************************
+ * @fn          benchHome
+ *
+ * @brief       Home slot of an extended address, the hash of devtab.c.
+ **************************************************************************************************
+ */
+static uint16 benchHome(const sAddrExt_t extAddr)
+{
+  return CRC_Ccitt(CRC_INIT, extAddr, SADDR_EXT_LEN) & (DEVTAB_SIZE - 1);
+}
+
+/**************************************************************************************************
+ * @fn          benchExt
+ *
+ * @brief       A random extended address, of home slot 'home' if it is not -1.
+ **************************************************************************************************
+ */
+static void benchExt(sAddrExt_t extAddr, int home)
+{
+  uint8 i;
+
+  do
+  {
+    for (i = 0; i < SADDR_EXT_LEN; i++)
+    {
+      extAddr[i] = (uint8)benchRand();
+    }
+  } while ((home >= 0) && (benchHome(extAddr) != home));
+}
+
+/**************************************************************************************************
+ * @fn          benchCheck
+ *
+ * @brief       The table must hold the devices of the model, each at its short address and
+ *              found by its extended address, and nothing at the other short addresses.
+ **************************************************************************************************
+ */
+static void benchCheck(const char *test)
+{
+  devEntry_t *pDev;
+  uint16 slot;
+
+  if (DEVTAB_Count() != benchCount)
+  {
+    benchFail(test, "number of devices", DEVTAB_Count());
+  }
+  for (slot = 0; slot < DEVTAB_SIZE; slot++)
+  {
+    pDev = DEVTAB_Get(DEVTAB_SHORT_BASE + slot);
+    if (!benchModel[slot].used)
+    {
+      if (pDev != NULL)
+      {
+        benchFail(test, "device at a short address the model has not", slot);
+      }
+      continue;
+    }
+    if ((pDev == NULL) || !sAddrExtCmp(pDev->extAddr, benchModel[slot].extAddr))
+    {
+      benchFail(test, "device not at its short address", slot);
+    }
+    else if (DEVTAB_Find(benchModel[slot].extAddr) != pDev)
+    {
+      benchFail(test, "device not found by its extended address", slot);
+    }
+  }
+}
+
+/**************************************************************************************************
+ * @fn          benchRow
+ *
+ * @brief       Print the results of a test.
+ **************************************************************************************************
+ */
+static void benchRow(const char *test, uint32 ops)
+{
+  printf("%-9s %9u %9u %9.1f\n", test, ops, DEVTAB_Count(),
+         (double)benchStats.framBytes / (ops ? ops : 1));
+}
+
+/**************************************************************************************************
+ * @fn          benchFail
+ *
+ * @brief       Report a failed check; only the first few of a run are printed.
+ **************************************************************************************************
+ */
+static void benchFail(const char *test, const char *what, uint32 n)
+{
+  if (benchFailed++ < 10)
+  {
+    printf("MISMATCH: %s: %s (%u)\n", test, what, n);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          osal_memcpy, osal_memset
+ *
+ * @brief       OSAL services of devtab.c and saddr.c.
+ **************************************************************************************************
+ */
+void *osal_memcpy(void *dst, const void *src, unsigned int len)
+{
+  return memcpy(dst, src, len);
+}
+
+void *osal_memset(void *dest, uint8 value, int len)
+{
+  return memset(dest, value, len);
+}
+
+/**************************************************************************************************
+ */
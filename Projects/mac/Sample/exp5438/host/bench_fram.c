@@ -0,0 +1,263 @@
+/**************************************************************************************************
+  Filename:       bench_fram.c
+
+  Description:    Host benchmark of the FRAM driver: fram.c against the byte at a time driver it
+                  replaced (bench_fram_ref.c), both talking to the FRAM model of hal_sim_fram.c.
+
+                  bench_fram [-n records] [-r seed]
+
+                  Four access patterns are played on both: store records of a 12 byte header
+                  and 64 bytes of data written one after the other, the same records read back,
+                  single byte writes and 4 byte updates of adjacent fields.  For each the SPI
+                  bytes and FRAM commands on the bus are counted, and the bus time per byte of
+                  payload is given at the SPI clock fram_init() sets.  The pauses between bytes of
+                  the polled reference, which the pipelined transfers of fram.c avoid, are not
+                  on the bus and not counted.  The FRAM must end up with the same content, and
+                  reads must return it, on both drivers.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hal_types.h"
+#include "hal_board_cfg.h"
+#include "hal_sim.h"
+#include "fram.h"
+#include "bench_util.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+#define BENCH_DEFAULT_RECORDS     2000
+#define BENCH_HDR_LEN             12
+#define BENCH_DATA_LEN            64
+#define BENCH_REC_LEN             (BENCH_HDR_LEN + BENCH_DATA_LEN)
+#define BENCH_FIELD_LEN           4
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Global Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+volatile uint8 halSimIntEnabled = TRUE;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static uint8  *benchData;
+static int    benchFailed;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+extern error_t benchRefFramReadMemory(uint32_t startAddr, uint8_t *pData, uint16_t size);
+extern error_t benchRefFramWriteByte(uint32_t startAddr, uint8_t data);
+extern error_t benchRefFramWriteMemory(uint32_t startAddr, const uint8_t *pData, uint16_t size);
+
+static void   benchStart(void);
+static void   benchPrint(const char *pattern, const char *impl, uint32 payload);
+static void   benchCheck(const char *pattern, const char *impl, uint32 len);
+
+/**************************************************************************************************
+ * @fn          main
+ *
+ * @brief       Run every pattern on both drivers and compare.
+ **************************************************************************************************
+ */
+int main(int argc, char **argv)
+{
+  uint8 rec[BENCH_REC_LEN];
+  fram_seg_t segs[2];
+  uint32 records = BENCH_DEFAULT_RECORDS;
+  uint32 len, addr, i;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:r:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n': records = strtoul(optarg, NULL, 0);      break;
+      case 'r': benchRandSeed(strtoul(optarg, NULL, 0)); break;
+      default:
+        fprintf(stderr, "usage: %s [-n records] [-r seed]\n", argv[0]);
+        return 1;
+    }
+  }
+  if ((records == 0) || ((uint64_t)records * BENCH_REC_LEN > HAL_SIM_FRAM_SIZE))
+  {
+    fprintf(stderr, "%s: 1 to %u records\n", argv[0], (unsigned)(HAL_SIM_FRAM_SIZE / BENCH_REC_LEN));
+    return 1;
+  }
+
+  len = records * BENCH_REC_LEN;
+  benchData = malloc(len);
+  for (i = 0; i < len; i++)
+  {
+    benchData[i] = (uint8)benchRand();
+  }
+
+  if (fram_init(FRAM_MODE0) != OK)
+  {
+    fprintf(stderr, "FRAM model does not answer\n");
+    return 1;
+  }
+
+  printf("%u records of %u bytes, SPI clock %.0f kHz\n", records, BENCH_REC_LEN,
+         HAL_CPU_CLOCK_MHZ * 1000.0 / usci_spi_getClkDiv());
+  printf("%-13s %-9s %9s %9s %9s %8s %10s\n", "pattern", "driver", "payload B", "bus B",
+         "commands", "bus/B", "bus us/B");
+
+  /* Records: header and data */
+  benchStart();
+  for (i = 0; i < records; i++)
+  {
+    benchRefFramWriteMemory(i * BENCH_REC_LEN, &benchData[i * BENCH_REC_LEN], BENCH_REC_LEN);
+  }
+  benchPrint("record write", "ref", len);
+  benchCheck("record write", "ref", len);
+
+  benchStart();
+  for (i = 0; i < records; i++)
+  {
+    addr = i * BENCH_REC_LEN;
+    segs[0].addr  = addr;
+    segs[0].pData = &benchData[addr];
+    segs[0].size  = BENCH_HDR_LEN;
+    segs[1].addr  = addr + BENCH_HDR_LEN;
+    segs[1].pData = &benchData[addr + BENCH_HDR_LEN];
+    segs[1].size  = BENCH_DATA_LEN;
+    fram_writeSegs(segs, 2);
+  }
+  benchPrint("record write", "segs", len);
+  benchCheck("record write", "segs", len);
+
+  /* The FRAM holds the records now, read them back */
+  benchStats.framBytes = benchStats.framSelects = 0;
+  for (i = 0; i < records; i++)
+  {
+    benchRefFramReadMemory(i * BENCH_REC_LEN, rec, BENCH_REC_LEN);
+    benchFailed |= (memcmp(rec, &benchData[i * BENCH_REC_LEN], BENCH_REC_LEN) != 0);
+  }
+  benchPrint("record read", "ref", len);
+
+  benchStats.framBytes = benchStats.framSelects = 0;
+  for (i = 0; i < records; i++)
+  {
+    fram_readMemory(i * BENCH_REC_LEN, rec, BENCH_REC_LEN);
+    benchFailed |= (memcmp(rec, &benchData[i * BENCH_REC_LEN], BENCH_REC_LEN) != 0);
+  }
+  benchPrint("record read", "read", len);
+
+  benchStats.framBytes = benchStats.framSelects = 0;
+  for (i = 0; i < records; i++)
+  {
+    fram_fastReadMemory(i * BENCH_REC_LEN, rec, BENCH_REC_LEN);
+    benchFailed |= (memcmp(rec, &benchData[i * BENCH_REC_LEN], BENCH_REC_LEN) != 0);
+  }
+  benchPrint("record read", "fastread", len);
+  if (benchFailed)
+  {
+    printf("MISMATCH: record read did not return what was written\n");
+  }
+
+  /* Single bytes, one after the other */
+  len = records * BENCH_DATA_LEN;
+  benchStart();
+  for (i = 0; i < len; i++)
+  {
+    benchRefFramWriteByte(i, benchData[i]);
+  }
+  benchPrint("byte write", "ref", len);
+  benchCheck("byte write", "ref", len);
+
+  benchStart();
+  for (i = 0; i < len; i++)
+  {
+    fram_writeByte(i, benchData[i]);
+  }
+  benchPrint("byte write", "byte", len);
+  benchCheck("byte write", "byte", len);
+
+  benchStart();
+  for (i = 0; i < len; i++)
+  {
+    fram_writeByteCombined(i, benchData[i]);
+  }
+  fram_flush();
+  benchPrint("byte write", "combined", len);
+  benchCheck("byte write", "combined", len);
+
+  /* Adjacent fields */
+  benchStart();
+  for (i = 0; i < len; i += BENCH_FIELD_LEN)
+  {
+    benchRefFramWriteMemory(i, &benchData[i], BENCH_FIELD_LEN);
+  }
+  benchPrint("4 B update", "ref", len);
+  benchCheck("4 B update", "ref", len);
+
+  benchStart();
+  for (i = 0; i < len; i += BENCH_FIELD_LEN)
+  {
+    fram_writeCombined(i, &benchData[i], BENCH_FIELD_LEN);
+  }
+  fram_flush();
+  benchPrint("4 B update", "combined", len);
+  benchCheck("4 B update", "combined", len);
+
+  free(benchData);
+  return benchFailed;
+}
+
+/**************************************************************************************************
+ * @fn          benchStart
+ *
+ * @brief       Blank the FRAM and the counters before a write pattern.
+ **************************************************************************************************
+ */
+static void benchStart(void)
+{
+  memset(benchFram, 0, sizeof(benchFram));
+  memset(&benchStats, 0, sizeof(benchStats));
+}
+
+/**************************************************************************************************
+ * @fn          benchPrint
+ *
+ * @brief       One line of results; the bus time counts 8 SPI clocks per byte.
+ **************************************************************************************************
+ */
+static void benchPrint(const char *pattern, const char *impl, uint32 payload)
+{
+  double busUs = benchStats.framBytes * 8.0 * usci_spi_getClkDiv() / HAL_CPU_CLOCK_MHZ;
+
+  printf("%-13s %-9s %9u %9u %9u %8.2f %10.2f\n", pattern, impl, payload, benchStats.framBytes,
+         benchStats.framSelects, (double)benchStats.framBytes / payload, busUs / payload);
+}
+
+/**************************************************************************************************
+ * @fn          benchCheck
+ *
+ * @brief       The FRAM must hold the test data after a write pattern.
+ **************************************************************************************************
+ */
+static void benchCheck(const char *pattern, const char *impl, uint32 len)
+{
+  if (memcmp(benchFram, benchData, len) != 0)
+  {
+    printf("MISMATCH: %s with %s left different data in the FRAM\n", pattern, impl);
+    benchFailed = 1;
+  }
+}
+
+/**************************************************************************************************
+ */
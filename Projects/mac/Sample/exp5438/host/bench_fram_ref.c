@@ -0,0 +1,99 @@
+/**************************************************************************************************
+  Filename:       bench_fram_ref.c
+
+  Description:    The FRAM accesses of fram.c as they were before the burst driver, kept as the
+                  reference of bench_fram.c: one polled usci_spi_sendByte() per byte, and WREN
+                  and WRDI around every write.  Only the names carry a benchRef prefix so it
+                  links next to fram.c.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "hal_types.h"
+#include "hal_mcu.h"
+#include "usci_spi.h"
+#include "fram.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static void sendAddr(uint32_t addr){
+  usci_spi_sendByte((addr & 0xFF0000) >> 16);
+  usci_spi_sendByte((addr & 0xFF00) >> 8);
+  usci_spi_sendByte(addr & 0xFF);
+}
+
+static void fram_writeEnable(void)
+{
+  CS_ENABLE();
+  usci_spi_sendByte(CMD_WREN);
+  CS_DISABLE();
+}
+
+static void fram_writeDisable(void)
+{
+  CS_ENABLE();
+  usci_spi_sendByte(CMD_WRDI);
+  CS_DISABLE();
+}
+
+/**************************************************************************************************
+ * @fn          benchRefFramReadMemory / benchRefFramWriteByte / benchRefFramWriteMemory
+ **************************************************************************************************
+ */
+error_t benchRefFramReadMemory(uint32_t startAddr, uint8_t *pData, uint16_t size)
+{
+  uint16_t i;
+
+  CS_ENABLE();
+  usci_spi_sendByte(CMD_READ);
+  sendAddr(startAddr);
+  for(i = 0; i < size; i++)
+  {
+    pData[i] = usci_spi_getByte();
+  }
+  CS_DISABLE();
+
+  return OK;
+}
+
+error_t benchRefFramWriteByte(uint32_t startAddr, uint8_t data)
+{
+  fram_writeEnable();
+
+  CS_ENABLE();
+  usci_spi_sendByte(CMD_WRITE);
+  sendAddr(startAddr);
+  usci_spi_sendByte(data);
+  CS_DISABLE();
+
+  fram_writeDisable();
+
+  return OK;
+}
+
+error_t benchRefFramWriteMemory(uint32_t startAddr, const uint8_t *pData, uint16_t size)
+{
+  uint16_t i;
+
+  fram_writeEnable();
+
+  CS_ENABLE();
+  usci_spi_sendByte(CMD_WRITE);
+  sendAddr(startAddr);
+  for(i = 0; i < size; i++)
+  {
+    usci_spi_sendByte(pData[i]);
+  }
+  CS_DISABLE();
+
+  fram_writeDisable();
+
+  return OK;
+}
+
+/**************************************************************************************************
+ */
@@ -0,0 +1,523 @@
+/**************************************************************************************************
+  Filename:       bench_heap.c
+
+  Description:    Host replayer of OSAL heap traces: runs an allocation trace against the
+                  first-fit allocator and the segregated-fit one of OSAL_Memory.c.
+
+                  bench_heap [-k copies] [-r rounds] [trace]
+
+                  A trace is what an image built with OSALMEM_TRACE reads out of its ring with
+                  osal_mem_trace_read(), behind an 8 byte header: "OSMT", the version, the
+                  record size and two reserved bytes.  The records are little endian as on the
+                  MSP430, so a ring streamed over the UART or dumped to FRAM replays as is.
+                  Blocks are identified by their offset in the heap of the traced device.
+
+                  Everything before osal_mem_kick() is long-lived and is replayed once, the rest
+                  is merged from the given number of copies shifted in time to load the heap
+                  like a burst of traffic.  Only the first boot of the device is replayed.
+                  traces/gateway.osmt was written by "spwm_sim -n 200 -t 900 -s 7 -r 40 -m",
+                  so its sizes are those of a 64-bit host.
+
+                  Each operation is timed in every round and its fastest time is kept, which
+                  takes out most of the noise of the host; the mean and the worst of those are
+                  printed, in TSC cycles on x86 and in ns elsewhere, with the failed
+                  allocations, the peak use of the heap and its fragmentation.  Fragmentation
+                  is 1 - largest free run / free bytes, sampled after every allocation of the
+                  first round.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "hal_types.h"
+#include "OSAL_Memory.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+#define BENCH_DEFAULT_TRACE       "traces/gateway.osmt"
+#define BENCH_DEFAULT_COPIES      8
+#define BENCH_DEFAULT_ROUNDS      20
+#define BENCH_COPY_SHIFT_MS       37
+
+#define BENCH_TRACE_VER           1
+#define BENCH_TRACE_REC           8
+#define BENCH_NO_SLOT             0xFFFFFFFF
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BENCH_UNIT                "cyc"
+#else
+#define BENCH_UNIT                "ns"
+#endif
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Typedefs
+ * ------------------------------------------------------------------------------------------------
+ */
+typedef struct
+{
+  uint32 ms;
+  uint32 slot;
+  uint16 size;
+  uint8  alloc;
+  uint8  kick;
+} benchOp_t;
+
+typedef struct
+{
+  const char *name;
+  void   (*init)(void);
+  void   (*kick)(void);
+  void  *(*alloc)(uint16 size);
+  void   (*free)(void *ptr);
+  uint16 (*blockMax)(void);
+  uint16 (*highWater)(void);
+  uint16 (*memFree)(void);
+  uint16 (*memLargest)(void);
+} benchHeap_t;
+
+typedef struct
+{
+  uint32 allocs;
+  uint32 frees;
+  uint32 failed;
+  double allocCost;
+  double allocMax;
+  double freeCost;
+  double freeMax;
+  double frag;
+  double fragMax;
+} benchResult_t;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Heap Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+#define BENCH_HEAP_PROTOTYPES(prefix)                                                            \
+  extern void   prefix##_mem_init(void);                                                         \
+  extern void   prefix##_mem_kick(void);                                                         \
+  extern void  *prefix##_mem_alloc(uint16 size);                                                 \
+  extern void   prefix##_mem_free(void *ptr);                                                    \
+  extern uint16 prefix##_heap_block_max(void);                                                   \
+  extern uint16 prefix##_heap_high_water(void);                                                  \
+  extern uint16 prefix##_heap_mem_free(void);                                                    \
+  extern uint16 prefix##_heap_mem_largest(void);
+
+BENCH_HEAP_PROTOTYPES(ff)
+BENCH_HEAP_PROTOTYPES(seg)
+
+static const benchHeap_t benchHeaps[] =
+{
+  {"first-fit", ff_mem_init, ff_mem_kick, ff_mem_alloc, ff_mem_free, ff_heap_block_max,
+   ff_heap_high_water, ff_heap_mem_free, ff_heap_mem_largest},
+  {"segregated", seg_mem_init, seg_mem_kick, seg_mem_alloc, seg_mem_free, seg_heap_block_max,
+   seg_heap_high_water, seg_heap_mem_free, seg_heap_mem_largest}
+};
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static benchOp_t *benchOps;
+static double    *benchOpCost;
+static uint32     benchOpCnt;
+static uint32     benchSlotCnt;
+static double     benchFrag;
+static double     benchFragMax;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static int    benchLoad(const char *path, uint32 copies);
+static uint32 benchReplay(const benchHeap_t *heap, bool sample);
+static int    benchCompare(const void *a, const void *b);
+static double benchNow(void);
+
+/**************************************************************************************************
+ * @fn          main
+ *
+ * @brief       Load the trace and replay it on both allocators.
+ **************************************************************************************************
+ */
+int main(int argc, char **argv)
+{
+  const char *path = BENCH_DEFAULT_TRACE;
+  uint32 copies = BENCH_DEFAULT_COPIES;
+  uint32 rounds = BENCH_DEFAULT_ROUNDS;
+  uint32 round;
+  uint8 i;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "k:r:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'k': copies = strtoul(optarg, NULL, 0); break;
+      case 'r': rounds = strtoul(optarg, NULL, 0); break;
+      default:
+        fprintf(stderr, "usage: %s [-k copies] [-r rounds] [trace]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (optind < argc)
+  {
+    path = argv[optind];
+  }
+
+  if ((copies == 0) || (rounds == 0) || (benchLoad(path, copies) != 0))
+  {
+    return 1;
+  }
+
+  printf("%s: %u operations from %u copies, %u rounds\n", path, benchOpCnt, copies, rounds);
+  printf("%-10s %8s %7s %10s %10s %10s %10s %8s %8s %6s %6s\n", "heap", "allocs", "failed",
+         "alloc " BENCH_UNIT, "alloc max", "free " BENCH_UNIT, "free max", "blocks", "peak B",
+         "frag", "frag max");
+
+  for (i = 0; i < sizeof(benchHeaps) / sizeof(benchHeaps[0]); i++)
+  {
+    benchResult_t result;
+    uint16 blocks = 0, peak = 0;
+    uint32 op;
+
+    memset(&result, 0, sizeof(result));
+    for (op = 0; op < benchOpCnt; op++)
+    {
+      benchOpCost[op] = 1e12;
+    }
+
+    for (round = 0; round < rounds; round++)
+    {
+      result.failed = benchReplay(&benchHeaps[i], (round == 0));
+
+      // The heap metrics are not reset by osal_mem_init(), take them from the first round
+      if (round == 0)
+      {
+        blocks = benchHeaps[i].blockMax();
+        peak = benchHeaps[i].highWater();
+        result.frag = benchFrag;
+        result.fragMax = benchFragMax;
+      }
+    }
+
+    for (op = 0; op < benchOpCnt; op++)
+    {
+      if (benchOpCost[op] >= 1e12)
+      {
+        continue;  // The kick, or the free of a failed allocation
+      }
+      if (benchOps[op].alloc)
+      {
+        result.allocs++;
+        result.allocCost += benchOpCost[op];
+        if (benchOpCost[op] > result.allocMax)
+        {
+          result.allocMax = benchOpCost[op];
+        }
+      }
+      else
+      {
+        result.frees++;
+        result.freeCost += benchOpCost[op];
+        if (benchOpCost[op] > result.freeMax)
+        {
+          result.freeMax = benchOpCost[op];
+        }
+      }
+    }
+
+    printf("%-10s %8u %7u %10.1f %10.0f %10.1f %10.0f %8u %8u %6.3f %8.3f\n",
+           benchHeaps[i].name, result.allocs, result.failed, result.allocCost / result.allocs,
+           result.allocMax, result.freeCost / result.frees, result.freeMax, blocks, peak,
+           result.frag, result.fragMax);
+  }
+
+  return 0;
+}
+
+/**************************************************************************************************
+ * @fn          benchLoad
+ *
+ * @brief       Read a trace, turn heap offsets into slots, replicate what follows the kick and
+ *              sort it by time.
+ **************************************************************************************************
+ */
+static int benchLoad(const char *path, uint32 copies)
+{
+  FILE *fp = fopen(path, "rb");
+  benchOp_t *ops = NULL;
+  uint32 *slotOf = malloc(0x10000 * sizeof(uint32));
+  uint32 cnt = 0, max = 0, kicked = 0, slots = 0, ms = 0;
+  uint32 recs = 0, failed = 0, unknown = 0, boots = 0;
+  uint32 i, copy;
+  uint16 tick = 0;
+  uint8 raw[BENCH_TRACE_REC];
+
+  if (fp == NULL)
+  {
+    perror(path);
+    return -1;
+  }
+  memset(slotOf, 0xFF, 0x10000 * sizeof(uint32));
+
+  if ((fread(raw, 1, sizeof(raw), fp) != sizeof(raw)) || (memcmp(raw, "OSMT", 4) != 0) ||
+      (raw[4] != BENCH_TRACE_VER) || (raw[5] != BENCH_TRACE_REC))
+  {
+    fprintf(stderr, "%s: not a version %u heap trace\n", path, BENCH_TRACE_VER);
+    fclose(fp);
+    return -1;
+  }
+
+  while (fread(raw, 1, sizeof(raw), fp) == sizeof(raw))
+  {
+    osalMemTrace_t trc;
+    benchOp_t rec;
+
+    trc.tick  = raw[0] | (raw[1] << 8);
+    trc.size  = raw[2] | (raw[3] << 8);
+    trc.tag   = raw[4] | (raw[5] << 8);
+    trc.block = raw[6] | (raw[7] << 8);
+
+    if (recs++ != 0)
+    {
+      ms += (uint16)(trc.tick - tick);
+    }
+    tick = trc.tick;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.ms = ms;
+
+    if (trc.size == OSALMEM_TRACE_INIT)
+    {
+      if (boots++ != 0)
+      {
+        break;  // The device rebooted
+      }
+      continue;
+    }
+    else if (trc.size == OSALMEM_TRACE_KICK)
+    {
+      // Drop the allocation and free done by osal_mem_kick() itself, the replay kicks again
+      if ((cnt >= 2) && ops[cnt - 2].alloc && !ops[cnt - 1].alloc &&
+          (ops[cnt - 2].slot == ops[cnt - 1].slot))
+      {
+        cnt -= 2;
+      }
+      rec.kick = TRUE;
+      rec.slot = BENCH_NO_SLOT;
+    }
+    else if (trc.size & OSALMEM_TRACE_FREE)
+    {
+      rec.slot = slotOf[trc.block];
+      if (rec.slot == BENCH_NO_SLOT)
+      {
+        unknown++;  // Allocated before the trace started
+        continue;
+      }
+      slotOf[trc.block] = BENCH_NO_SLOT;
+    }
+    else
+    {
+      rec.alloc = TRUE;
+      rec.size = trc.size;
+      rec.slot = slots++;
+      if (trc.block == OSALMEM_TRACE_FAILED)
+      {
+        failed++;
+      }
+      else
+      {
+        slotOf[trc.block] = rec.slot;
+      }
+    }
+
+    if (cnt == max)
+    {
+      max = max ? max * 2 : 1024;
+      ops = realloc(ops, max * sizeof(benchOp_t));
+    }
+    ops[cnt++] = rec;
+    if (rec.kick)
+    {
+      kicked = cnt;
+    }
+  }
+  fclose(fp);
+  free(slotOf);
+
+  if (boots == 0)
+  {
+    fprintf(stderr, "%s: the trace does not start at osal_mem_init()\n", path);
+    free(ops);
+    return -1;
+  }
+  if ((failed != 0) || (unknown != 0))
+  {
+    printf("%s: %u allocations failed on the device, %u frees of untraced blocks\n", path,
+           failed, unknown);
+  }
+
+  // Long-lived part and kick once, the rest from every copy with its own slots
+  benchOpCnt = kicked + (cnt - kicked) * copies;
+  benchOps = malloc(benchOpCnt * sizeof(benchOp_t));
+  benchOpCost = malloc(benchOpCnt * sizeof(double));
+  benchSlotCnt = slots * copies;
+  memcpy(benchOps, ops, kicked * sizeof(benchOp_t));
+
+  for (copy = 0; copy < copies; copy++)
+  {
+    for (i = kicked; i < cnt; i++)
+    {
+      benchOp_t *rec = &benchOps[kicked + copy * (cnt - kicked) + (i - kicked)];
+
+      *rec = ops[i];
+      rec->ms += copy * BENCH_COPY_SHIFT_MS;
+      rec->slot += copy * slots;
+    }
+  }
+  free(ops);
+
+  // Stable merge of the copies by time
+  qsort(benchOps + kicked, benchOpCnt - kicked, sizeof(benchOp_t), benchCompare);
+
+  return 0;
+}
+
+/**************************************************************************************************
+ * @fn          benchCompare
+ **************************************************************************************************
+ */
+static int benchCompare(const void *a, const void *b)
+{
+  const benchOp_t *x = a, *y = b;
+
+  if (x->ms != y->ms)
+  {
+    return (x->ms < y->ms) ? -1 : 1;
+  }
+  return (x < y) ? -1 : (x > y);
+}
+
+/**************************************************************************************************
+ * @fn          benchReplay
+ *
+ * @brief       Run the trace once on a fresh heap, keeping the fastest time of each operation.
+ *              A failed allocation leaves its slot empty and the matching free is skipped.
+ *              With 'sample' the fragmentation is sampled after every allocation, untimed.
+ *              Returns the number of failed allocations.
+ **************************************************************************************************
+ */
+static uint32 benchReplay(const benchHeap_t *heap, bool sample)
+{
+  void **slots = calloc(benchSlotCnt, sizeof(void *));
+  uint32 i, failed = 0, samples = 0;
+  double t0, dt;
+
+  heap->init();
+  benchFrag = benchFragMax = 0.0;
+
+  for (i = 0; i < benchOpCnt; i++)
+  {
+    const benchOp_t *rec = &benchOps[i];
+
+    if (rec->kick)
+    {
+      heap->kick();
+      continue;
+    }
+
+    if (rec->alloc)
+    {
+      t0 = benchNow();
+      slots[rec->slot] = heap->alloc(rec->size);
+      dt = benchNow() - t0;
+
+      if (slots[rec->slot] == NULL)
+      {
+        failed++;
+      }
+
+      if (sample)
+      {
+        uint16 memFree = heap->memFree();
+        double frag = (memFree != 0) ? 1.0 - (double)heap->memLargest() / memFree : 0.0;
+
+        benchFrag += frag;
+        samples++;
+        if (frag > benchFragMax)
+        {
+          benchFragMax = frag;
+        }
+      }
+    }
+    else if (slots[rec->slot] != NULL)
+    {
+      t0 = benchNow();
+      heap->free(slots[rec->slot]);
+      dt = benchNow() - t0;
+
+      slots[rec->slot] = NULL;
+    }
+    else
+    {
+      continue;
+    }
+
+    if (dt < benchOpCost[i])
+    {
+      benchOpCost[i] = dt;
+    }
+  }
+
+  free(slots);
+  if (samples != 0)
+  {
+    benchFrag /= samples;
+  }
+  return failed;
+}
+
+/**************************************************************************************************
+ * @fn          benchNow
+ *
+ * @brief       Time stamp in BENCH_UNIT.
+ **************************************************************************************************
+ */
+static double benchNow(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return (double)__rdtsc();
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+#endif
+}
+
+/**************************************************************************************************
+ *                                      HAL services of the heap
+ **************************************************************************************************
+ */
+volatile uint8 halSimIntEnabled = TRUE;
+
+void halAssertHandler(void)
+{
+  fprintf(stderr, "heap assertion failed\n");
+  abort();
+}
+
+/**************************************************************************************************
+ */
@@ -0,0 +1,273 @@
+/**************************************************************************************************
+  Filename:       bench_lstat.c
+
+  Description:    Host check of the link statistics of lstat.c against what the bench sent.
+
+                  bench_lstat [-n packets] [-r seed]
+
+                  A node sends 'packets' frames, of which the bench drops some and repeats
+                  some, the way a lossy link and lost ACKs do:
+                    - frames     frames and duplicates counted, the RSSI and LQI averages
+                                 within a unit of an average of weight 1/8 taken in doubles
+                    - lost       the alive packets missed over a window of periods, also
+                                 across the wrap of the 16 bit node time; an alive packet sent
+                                 again and a node that started again count nothing
+                    - jitter     a constant transit gives none, a transit that changes by d
+                                 from one packet to the next gives d, and a packet held back
+                                 more than LSTAT_JITTER_MAX leaves it as it is
+                    - pack       the record of LSTAT_Pack(), byte by byte
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hal_types.h"
+#include "lstat.h"
+#include "bench_util.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+#define BENCH_DEFAULT_PACKETS     20000
+#define BENCH_PERIOD              5     /* sticks between alive packets */
+#define BENCH_STICK_MS            60000
+#define BENCH_JITTER_MS           40    /* transit change of the jitter test */
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static int benchFailed;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static void benchRow(const char *test, uint32 ops, uint32 got, uint32 want);
+static void benchFail(const char *test, const char *what, uint32 n);
+
+/**************************************************************************************************
+ * @fn          main
+ *
+ * @brief       Run the tests one after the other, each on new statistics.
+ **************************************************************************************************
+ */
+int main(int argc, char **argv)
+{
+  static const uint8 want[LSTAT_REC_LEN] =
+  {
+    0x34, 0x12, (uint8)-71, 180, 0xE8, 0x03, 7, 0, 0x10, 0x27, 0x2A, 0, 25, 0, 0xFF, 0xFF
+  };
+  uint8 buf[LSTAT_REC_LEN];
+  uint32 packets = BENCH_DEFAULT_PACKETS;
+  uint32 n, frames, dups, lost, missed, time, arrival;
+  double rssiAvg = 0, lqiAvg = 0;
+  lstat_t stat;
+  uint16 jitter, was;
+  uint8 dsn;
+  int8 rssi;
+  uint8 lqi;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:r:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n': packets = strtoul(optarg, NULL, 0);      break;
+      case 'r': benchRandSeed(strtoul(optarg, NULL, 0)); break;
+      default:
+        fprintf(stderr, "usage: %s [-n packets] [-r seed]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (packets < 100)
+  {
+    fprintf(stderr, "%s: 100 packets at least\n", argv[0]);
+    return 1;
+  }
+
+  printf("alive packets every %u sticks of %u ms\n", BENCH_PERIOD, BENCH_STICK_MS);
+  printf("%-9s %9s %9s %9s\n", "test", "ops", "got", "want");
+
+  /* Frames: one in ten is sent again, the RSSI and LQI walk about */
+  memset(&stat, 0, sizeof(stat));
+  frames = 0;
+  dups = 0;
+  dsn = (uint8)benchRand();
+  rssi = -60;
+  lqi = 200;
+  for (n = 0; n < packets; n++)
+  {
+    if ((n == 0) || (benchRand() % 10 != 0))
+    {
+      dsn++;
+      frames++;
+      if (!LSTAT_Frame(&stat, dsn, rssi, lqi))
+      {
+        benchFail("frames", "new frame taken as a duplicate", n);
+      }
+    }
+    else
+    {
+      dups++;
+      if (LSTAT_Frame(&stat, dsn, rssi, lqi))
+      {
+        benchFail("frames", "duplicate taken as a new frame", n);
+      }
+    }
+    if (n == 0)
+    {
+      rssiAvg = rssi;
+      lqiAvg  = lqi;
+    }
+    else
+    {
+      rssiAvg += (rssi - rssiAvg) / 8;
+      lqiAvg  += (lqi - lqiAvg) / 8;
+    }
+    if ((stat.rssiAvg / 8.0 - rssiAvg > 1.0) || (rssiAvg - stat.rssiAvg / 8.0 > 1.0) ||
+        (stat.lqiAvg / 8.0 - lqiAvg > 1.0) || (lqiAvg - stat.lqiAvg / 8.0 > 1.0))
+    {
+      benchFail("frames", "average more than a unit off", n);
+    }
+    rssi += (int8)(benchRand() % 5) - 2;
+    rssi  = (rssi < -95) ? -95 : (rssi > -20) ? -20 : rssi;
+    lqi  += (uint8)(benchRand() % 5) - 2;
+    lqi   = (lqi < 50) ? 50 : (lqi > 250) ? 250 : lqi;
+  }
+  if ((stat.frames != (uint16)frames) || (stat.dups != (uint16)dups))
+  {
+    benchFail("frames", "frames or duplicates counted", stat.frames);
+  }
+  benchRow("frames", packets, stat.frames, (uint16)frames);
+  benchRow("dups", packets, stat.dups, (uint16)dups);
+
+  /* Alive packets: dropped at random, one in twenty sent again, the node time wraps; then the
+   * node time goes back, as after a reset */
+  memset(&stat, 0, sizeof(stat));
+  lost = 0;
+  missed = 0;
+  time = 0x10000 - (packets / 2) * BENCH_PERIOD;
+  for (n = 0; n < packets; n++, time += BENCH_PERIOD)
+  {
+    if ((n != 0) && (benchRand() % 8 == 0))
+    {
+      missed++;
+      continue;
+    }
+    lost  += missed;                  /* known once the next one comes */
+    missed = 0;
+    arrival = time * BENCH_STICK_MS + 300;
+    LSTAT_Alive(&stat, time, arrival, BENCH_PERIOD, BENCH_STICK_MS);
+    if (benchRand() % 20 == 0)
+    {
+      LSTAT_Alive(&stat, time, arrival + 500, BENCH_PERIOD, BENCH_STICK_MS);
+    }
+  }
+  if (stat.lost != (uint16)lost)
+  {
+    benchFail("lost", "alive packets missed", stat.lost);
+  }
+  was = stat.lost;
+  LSTAT_Alive(&stat, stat.aliveTime - 2u * BENCH_PERIOD, time * BENCH_STICK_MS, BENCH_PERIOD,
+              BENCH_STICK_MS);
+  if (stat.lost != was)
+  {
+    benchFail("lost", "node that started again counted", stat.lost);
+  }
+  benchRow("lost", packets, stat.lost, (uint16)lost);
+
+  /* Jitter: none at a constant transit, BENCH_JITTER_MS when it changes by that every time,
+   * a packet held back does not change it */
+  memset(&stat, 0, sizeof(stat));
+  for (n = 0, time = 1000; n < packets; n++, time += BENCH_PERIOD)
+  {
+    LSTAT_Alive(&stat, time, time * BENCH_STICK_MS + 250, BENCH_PERIOD, BENCH_STICK_MS);
+  }
+  if (stat.jitter != 0)
+  {
+    benchFail("jitter", "jitter at a constant transit", stat.jitter);
+  }
+  for (n = 0; n < packets; n++, time += BENCH_PERIOD)
+  {
+    LSTAT_Alive(&stat, time, time * BENCH_STICK_MS + 250 + (n % 2) * BENCH_JITTER_MS,
+                BENCH_PERIOD, BENCH_STICK_MS);
+  }
+  LSTAT_Pack(&stat, 1, 0, buf);
+  jitter = buf[12] | (buf[13] << 8);
+  if ((jitter < BENCH_JITTER_MS - 1) || (jitter > BENCH_JITTER_MS + 1))
+  {
+    benchFail("jitter", "jitter of a transit changing by a constant", jitter);
+  }
+  was = stat.jitter;
+  LSTAT_Alive(&stat, time, time * BENCH_STICK_MS + 250 + 2 * LSTAT_JITTER_MAX,
+              BENCH_PERIOD, BENCH_STICK_MS);
+  if (stat.jitter != was)
+  {
+    benchFail("jitter", "packet held back taken as jitter", stat.jitter);
+  }
+  benchRow("jitter", 2 * packets + 1, jitter, BENCH_JITTER_MS);
+
+  /* Pack: every field at its place, the age held at 0xFFFF */
+  memset(&stat, 0, sizeof(stat));
+  stat.rssiAvg = -71 * 8 + 3;
+  stat.lqiAvg  = 180 * 8 - 3;
+  stat.frames  = 1000;
+  stat.dups    = 7;
+  stat.alives  = 10000;
+  stat.lost    = 42;
+  stat.jitter  = 25 * 16 + 7;
+  LSTAT_Pack(&stat, 0x1234, 0x12345, buf);
+  for (n = 0; n < LSTAT_REC_LEN; n++)
+  {
+    if (buf[n] != want[n])
+    {
+      benchFail("pack", "byte of the record", n);
+    }
+  }
+  benchRow("pack", 1, memcmp(buf, want, LSTAT_REC_LEN) == 0, 1);
+
+  if (benchFailed != 0)
+  {
+    printf("FAILED: %d checks\n", benchFailed);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
+
+/**************************************************************************************************
+ * @fn          benchRow
+ *
+ * @brief       Print the results of a test.
+ **************************************************************************************************
+ */
+static void benchRow(const char *test, uint32 ops, uint32 got, uint32 want)
+{
+  printf("%-9s %9u %9u %9u\n", test, ops, got, want);
+}
+
+/**************************************************************************************************
+ * @fn          benchFail
+ *
+ * @brief       Report a failed check; only the first few of a run are printed.
+ **************************************************************************************************
+ */
+static void benchFail(const char *test, const char *what, uint32 n)
+{
+  if (benchFailed++ < 10)
+  {
+    printf("MISMATCH: %s: %s (%u)\n", test, what, n);
+  }
+}
+
+/**************************************************************************************************
+ */
@@ -0,0 +1,162 @@
+/**************************************************************************************************
+  Filename:       bench_msg_list.c
+
+  Description:    The OSAL task messages as they were before the per-task queues, all tasks
+                  sharing one list, kept as the reference of bench_msgs.c.  The algorithm is
+                  unchanged, only the names carry a benchList prefix so it links next to OSAL.c.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "comdef.h"
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static osal_msg_q_t listQHead;
+
+/**************************************************************************************************
+ * @fn          listEnqueuePush
+ **************************************************************************************************
+ */
+static uint8 listEnqueuePush(uint8 destination_task, uint8 *msg_ptr, uint8 push)
+{
+  if (msg_ptr == NULL)
+  {
+    return INVALID_MSG_POINTER;
+  }
+
+  if (destination_task >= tasksCnt)
+  {
+    osal_msg_deallocate(msg_ptr);
+    return INVALID_TASK;
+  }
+
+  // Check the message header
+  if (OSAL_MSG_NEXT(msg_ptr) != NULL || OSAL_MSG_ID(msg_ptr) != TASK_NO_TASK)
+  {
+    osal_msg_deallocate(msg_ptr);
+    return INVALID_MSG_POINTER;
+  }
+
+  OSAL_MSG_ID(msg_ptr) = destination_task;
+
+  if (push == TRUE)
+  {
+    osal_msg_push(&listQHead, msg_ptr);
+  }
+  else
+  {
+    osal_msg_enqueue(&listQHead, msg_ptr);
+  }
+
+  osal_set_event(destination_task, SYS_EVENT_MSG);
+
+  return SUCCESS;
+}
+
+/**************************************************************************************************
+ * @fn          benchListMsgSend / benchListMsgPushFront
+ **************************************************************************************************
+ */
+uint8 benchListMsgSend(uint8 destination_task, uint8 *msg_ptr)
+{
+  return listEnqueuePush(destination_task, msg_ptr, FALSE);
+}
+
+uint8 benchListMsgPushFront(uint8 destination_task, uint8 *msg_ptr)
+{
+  return listEnqueuePush(destination_task, msg_ptr, TRUE);
+}
+
+/**************************************************************************************************
+ * @fn          benchListMsgReceive
+ **************************************************************************************************
+ */
+uint8 *benchListMsgReceive(uint8 task_id)
+{
+  osal_msg_hdr_t *listHdr;
+  osal_msg_hdr_t *prevHdr = NULL;
+  osal_msg_hdr_t *foundHdr = NULL;
+  halIntState_t   intState;
+
+  HAL_ENTER_CRITICAL_SECTION(intState);
+
+  listHdr = listQHead;
+
+  // Look through the queue for a message that belongs to the asking task
+  while (listHdr != NULL)
+  {
+    if ((listHdr - 1)->dest_id == task_id)
+    {
+      if (foundHdr == NULL)
+      {
+        foundHdr = listHdr;
+      }
+      else
+      {
+        break;
+      }
+    }
+    if (foundHdr == NULL)
+    {
+      prevHdr = listHdr;
+    }
+    listHdr = OSAL_MSG_NEXT(listHdr);
+  }
+
+  if (listHdr != NULL)
+  {
+    osal_set_event(task_id, SYS_EVENT_MSG);
+  }
+  else
+  {
+    osal_clear_event(task_id, SYS_EVENT_MSG);
+  }
+
+  if (foundHdr != NULL)
+  {
+    osal_msg_extract(&listQHead, foundHdr, prevHdr);
+  }
+
+  HAL_EXIT_CRITICAL_SECTION(intState);
+
+  return (uint8 *)foundHdr;
+}
+
+/**************************************************************************************************
+ * @fn          benchListMsgFind
+ **************************************************************************************************
+ */
+osal_event_hdr_t *benchListMsgFind(uint8 task_id, uint8 event)
+{
+  osal_msg_hdr_t *pHdr;
+  halIntState_t intState;
+
+  HAL_ENTER_CRITICAL_SECTION(intState);
+
+  pHdr = listQHead;
+
+  while (pHdr != NULL)
+  {
+    if (((pHdr-1)->dest_id == task_id) && (((osal_event_hdr_t *)pHdr)->event == event))
+    {
+      break;
+    }
+
+    pHdr = OSAL_MSG_NEXT(pHdr);
+  }
+
+  HAL_EXIT_CRITICAL_SECTION(intState);
+
+  return (osal_event_hdr_t *)pHdr;
+}
+
+/**************************************************************************************************
+ */
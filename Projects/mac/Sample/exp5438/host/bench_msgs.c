@@ -0,0 +1,351 @@
+/**************************************************************************************************
+  Filename:       bench_msgs.c
+
+  Description:    Host stress benchmark of the OSAL task messages: the per-task queues of OSAL.c
+                  against the single shared list they replaced (bench_msg_list.c).
+
+                  bench_msgs [-m messages] [-r seed]
+
+                  Bursts of 8 to 512 messages are sent to 16 tasks, three quarters of them to
+                  task 1 as the MAC sends data indications to the application, with one in
+                  eight pushed to the front and an osal_msg_find() for every eighth message.
+                  The tasks then drain their queues in priority order, one message per
+                  dispatch as osal_run_system() would call them.  The time per send, receive
+                  and find is printed, and the order the messages are received in must be the
+                  same for both.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "comdef.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+#include "bench_util.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+#define BENCH_DEFAULT_MESSAGES    1000000
+#define BENCH_TASKS               16
+#define BENCH_APP_TASK            1
+#define BENCH_EVENTS              8
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Typedefs
+ * ------------------------------------------------------------------------------------------------
+ */
+typedef struct
+{
+  const char *name;
+  uint8  (*send)(uint8 destination_task, uint8 *msg_ptr);
+  uint8  (*pushFront)(uint8 destination_task, uint8 *msg_ptr);
+  uint8 *(*receive)(uint8 task_id);
+  osal_event_hdr_t *(*find)(uint8 task_id, uint8 event);
+} benchImpl_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint32 id;
+} benchMsg_t;
+
+typedef struct
+{
+  double   sendNs;
+  double   receiveNs;
+  double   findNs;
+  uint32   messages;
+  uint32   finds;
+  uint64_t checksum;
+} benchResult_t;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Global Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+volatile uint8 halSimIntEnabled = TRUE;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+extern uint8  benchListMsgSend(uint8 destination_task, uint8 *msg_ptr);
+extern uint8  benchListMsgPushFront(uint8 destination_task, uint8 *msg_ptr);
+extern uint8 *benchListMsgReceive(uint8 task_id);
+extern osal_event_hdr_t *benchListMsgFind(uint8 task_id, uint8 event);
+
+static int    benchRun(const benchImpl_t *impl, uint16 burst, uint32 messages, uint32 seed,
+                       benchResult_t *result);
+static double benchNow(void);
+static uint16 benchTask(uint8 task_id, uint16 events);
+
+static const benchImpl_t benchQueues =
+{
+  "queues", osal_msg_send, osal_msg_push_front, osal_msg_receive, osal_msg_find
+};
+
+static const benchImpl_t benchList =
+{
+  "list", benchListMsgSend, benchListMsgPushFront, benchListMsgReceive, benchListMsgFind
+};
+
+/* ------------------------------------------------------------------------------------------------
+ *                                         Task Table
+ * ------------------------------------------------------------------------------------------------
+ */
+const pTaskEventHandlerFn tasksArr[BENCH_TASKS] =
+{
+  benchTask, benchTask, benchTask, benchTask, benchTask, benchTask, benchTask, benchTask,
+  benchTask, benchTask, benchTask, benchTask, benchTask, benchTask, benchTask, benchTask
+};
+const uint8 tasksCnt = BENCH_TASKS;
+uint16 *tasksEvents;
+
+/**************************************************************************************************
+ * @fn          main
+ *
+ * @brief       Run the bursts on both message implementations and compare.
+ **************************************************************************************************
+ */
+int main(int argc, char **argv)
+{
+  static const uint16 bursts[] = {8, 32, 128, 512};
+  uint32 messages = BENCH_DEFAULT_MESSAGES;
+  uint32 seed = 1;
+  int failed = 0;
+  uint8 i;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "m:r:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'm': messages = strtoul(optarg, NULL, 0); break;
+      case 'r': seed = strtoul(optarg, NULL, 0);     break;
+      default:
+        fprintf(stderr, "usage: %s [-m messages] [-r seed]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  osal_init_system();
+
+  printf("%6s  %-7s %10s %11s %10s %10s\n", "burst", "impl", "send ns", "receive ns", "find ns",
+         "messages");
+
+  for (i = 0; i < sizeof(bursts) / sizeof(bursts[0]); i++)
+  {
+    benchResult_t list, queues;
+
+    failed |= benchRun(&benchList, bursts[i], messages, seed, &list);
+    failed |= benchRun(&benchQueues, bursts[i], messages, seed, &queues);
+
+    printf("%6u  %-7s %10.1f %11.1f %10.1f %10u\n", bursts[i], "list", list.sendNs,
+           list.receiveNs, list.findNs, list.messages);
+    printf("%6u  %-7s %10.1f %11.1f %10.1f %10u\n", bursts[i], "queues", queues.sendNs,
+           queues.receiveNs, queues.findNs, queues.messages);
+
+    if ((list.messages != queues.messages) || (list.checksum != queues.checksum))
+    {
+      printf("MISMATCH: the queues and the list delivered in a different order\n");
+      failed = 1;
+    }
+  }
+
+  return failed;
+}
+
+/**************************************************************************************************
+ * @fn          benchRun
+ *
+ * @brief       Send and drain bursts of the seed on one implementation until 'messages' have
+ *              gone through.  Returns non-zero if a task is left with an event or a message.
+ **************************************************************************************************
+ */
+static int benchRun(const benchImpl_t *impl, uint16 burst, uint32 messages, uint32 seed,
+                    benchResult_t *result)
+{
+  benchMsg_t **msgs = malloc(burst * sizeof(benchMsg_t *));
+  uint8 *dests = malloc(burst);
+  uint32 id = 0;
+  uint16 i;
+  uint8 task;
+  double t0;
+
+  memset(result, 0, sizeof(*result));
+  benchRandSeed(seed);
+
+  while (result->messages < messages)
+  {
+    // Allocation is not timed
+    for (i = 0; i < burst; i++)
+    {
+      msgs[i] = (benchMsg_t *)osal_msg_allocate(sizeof(benchMsg_t));
+      msgs[i]->hdr.event = (uint8)(1 + benchRand() % BENCH_EVENTS);
+      msgs[i]->hdr.status = 0;
+      msgs[i]->id = id++;
+      dests[i] = ((benchRand() & 3) != 0) ? BENCH_APP_TASK : (uint8)(benchRand() % BENCH_TASKS);
+    }
+
+    for (i = 0; i < burst; i++)
+    {
+      bool front = ((benchRand() & 7) == 0);
+
+      t0 = benchNow();
+      if (front)
+      {
+        impl->pushFront(dests[i], (uint8 *)msgs[i]);
+      }
+      else
+      {
+        impl->send(dests[i], (uint8 *)msgs[i]);
+      }
+      result->sendNs += benchNow() - t0;
+
+      if ((i & 7) == 7)
+      {
+        osal_event_hdr_t *pFound;
+        uint8 findTask, findEvent;
+
+        findTask = ((benchRand() & 1) != 0) ? BENCH_APP_TASK : (uint8)(benchRand() % BENCH_TASKS);
+        findEvent = (uint8)(1 + benchRand() % BENCH_EVENTS);
+
+        t0 = benchNow();
+        pFound = impl->find(findTask, findEvent);
+        result->findNs += benchNow() - t0;
+        result->finds++;
+        result->checksum += ((pFound != NULL) ? ((benchMsg_t *)pFound)->id + 1 : 0) *
+                            0xC2B2AE3D27D4EB4Full;
+      }
+    }
+
+    // Drain in priority order, one message per dispatch of the highest priority ready task
+    for (;;)
+    {
+      benchMsg_t *pMsg;
+
+      for (task = 0; task < BENCH_TASKS; task++)
+      {
+        if (tasksEvents[task] & SYS_EVENT_MSG)
+        {
+          break;
+        }
+      }
+      if (task == BENCH_TASKS)
+      {
+        break;
+      }
+
+      t0 = benchNow();
+      pMsg = (benchMsg_t *)impl->receive(task);
+      result->receiveNs += benchNow() - t0;
+
+      if (pMsg == NULL)
+      {
+        printf("%s: task %u signalled with no message\n", impl->name, task);
+        break;
+      }
+      result->messages++;
+      result->checksum += ((uint64_t)pMsg->id << 8 | task) * 0x9E3779B97F4A7C15ull;
+      osal_msg_deallocate((uint8 *)pMsg);
+    }
+  }
+
+  free(msgs);
+  free(dests);
+
+  for (task = 0; task < BENCH_TASKS; task++)
+  {
+    if ((tasksEvents[task] != 0) || (impl->receive(task) != NULL))
+    {
+      printf("%s: task %u left with events or messages\n", impl->name, task);
+      return 1;
+    }
+  }
+
+  result->sendNs /= result->messages;
+  result->receiveNs /= result->messages;
+  result->findNs /= (result->finds != 0) ? result->finds : 1;
+  return 0;
+}
+
+/**************************************************************************************************
+ * @fn          benchNow
+ **************************************************************************************************
+ */
+static double benchNow(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**************************************************************************************************
+ * @fn          benchTask
+ *
+ * @brief       Event handler of every task; the benchmark receives the messages itself.
+ **************************************************************************************************
+ */
+static uint16 benchTask(uint8 task_id, uint16 events)
+{
+  (void)task_id;
+  return events;
+}
+
+/**************************************************************************************************
+ *                                    OSAL services of the tasks
+ **************************************************************************************************
+ */
+void osalInitTasks(void)
+{
+  tasksEvents = (uint16 *)osal_mem_alloc(sizeof(uint16) * tasksCnt);
+  osal_memset(tasksEvents, 0, sizeof(uint16) * tasksCnt);
+}
+
+void *osal_mem_alloc(uint16 size)
+{
+  return malloc(size);
+}
+
+void osal_mem_free(void *ptr)
+{
+  free(ptr);
+}
+
+void osal_mem_init(void) {}
+void osal_mem_kick(void) {}
+void osalTimerInit(void) {}
+void osalTimeUpdate(void) {}
+void osal_pwrmgr_init(void) {}
+void osal_pwrmgr_powerconserve(void) {}
+void Hal_ProcessPoll(void) {}
+
+uint16 Onboard_rand(void)
+{
+  return (uint16)benchRand();
+}
+
+void halAssertHandler(void)
+{
+  fprintf(stderr, "assertion failed\n");
+  abort();
+}
+
+/**************************************************************************************************
+ */
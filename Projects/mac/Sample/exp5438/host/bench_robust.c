@@ -0,0 +1,311 @@
+/**************************************************************************************************
+  Filename:       bench_robust.c
+
+  Description:    Host benchmark and equivalence check of the robust estimators of robust.c.
+
+                  bench_robust [-n measurements] [-r seed]
+
+                  Measurements of 16 samples are drawn from three sets: ADC readings with a
+                  few LSB of noise and the odd spike, as the sensors give them; readings from
+                  a range of 9 values, where many samples are at the same distance from the
+                  mean; and 12 bit values spread evenly.  On each, ROBUST_FilterAvg() must
+                  return what the AvgWithFilter() it replaced (bench_robust_ref.c) returned,
+                  and the median, the trimmed mean and their streaming forms what sorting a
+                  copy of the samples gives.  The median network is also run on all 65536
+                  patterns of 0 and 1, which proves it for any input.  The time per
+                  measurement is printed for each estimator.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hal_types.h"
+#include "robust.h"
+#include "bench_util.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+#define BENCH_DEFAULT_MEASUREMENTS  100000
+#define BENCH_N                     ROBUST_NUM_SAMPLES
+#define BENCH_TRIM                  4
+#define BENCH_SETS                  3
+#define BENCH_ESTIMATORS            5
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static const char *benchSetName[BENCH_SETS] = {"adc", "ties", "uniform"};
+static const char *benchEstName[BENCH_ESTIMATORS] =
+{
+  "AvgWithFilter", "FilterAvg", "Median16", "TrimmedMean", "Stream"
+};
+
+static uint16 *benchData;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+extern uint16_t benchRefAvgWithFilter(uint16_t inData[16]);
+
+static void   benchFill(uint8 set, uint32 count);
+static uint32 benchCheck(uint8 est, const uint16 *pSamples);
+static int    benchCmp(const void *a, const void *b);
+static double benchNow(void);
+
+/**************************************************************************************************
+ * @fn          main
+ *
+ * @brief       Check and time every estimator on every set.
+ **************************************************************************************************
+ */
+int main(int argc, char **argv)
+{
+  uint32 count = BENCH_DEFAULT_MEASUREMENTS;
+  uint32 bad[BENCH_ESTIMATORS];
+  uint32 i, failed = 0, sink = 0;
+  uint16 v[BENCH_N];
+  robustStream_t stream;
+  double t0, ns[BENCH_ESTIMATORS];
+  uint8 set, est, j;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:r:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n': count = strtoul(optarg, NULL, 0);        break;
+      case 'r': benchRandSeed(strtoul(optarg, NULL, 0)); break;
+      default:
+        fprintf(stderr, "usage: %s [-n measurements] [-r seed]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (count == 0)
+  {
+    fprintf(stderr, "%s: at least one measurement\n", argv[0]);
+    return 1;
+  }
+  benchData = malloc(count * BENCH_N * sizeof(uint16));
+
+  /* 0-1 principle: a network that sorts every pattern of 0 and 1 sorts everything */
+  for (i = 0; i < 0x10000; i++)
+  {
+    uint16 ones = 0;
+
+    for (j = 0; j < BENCH_N; j++)
+    {
+      v[j] = (i >> j) & 1;
+      ones += v[j];
+    }
+    /* the middle two are 1 with more than 8 ones, 0 with less than 8, 0 and 1 at 8 */
+    if (ROBUST_Median16(v) != ((ones > 8) ? 1 : 0))
+    {
+      failed++;
+    }
+  }
+  printf("median network on 65536 patterns of 0 and 1: %s\n", failed ? "MISMATCH" : "ok");
+
+  printf("%u measurements of %u samples\n", count, BENCH_N);
+  printf("%-8s %-14s %10s %10s\n", "set", "estimator", "ns/meas", "mismatch");
+
+  for (set = 0; set < BENCH_SETS; set++)
+  {
+    benchFill(set, count);
+
+    for (est = 0; est < BENCH_ESTIMATORS; est++)
+    {
+      bad[est] = 0;
+      for (i = 0; i < count; i++)
+      {
+        bad[est] += benchCheck(est, &benchData[i * BENCH_N]);
+      }
+    }
+
+    /* Timing, separate from the checks */
+    t0 = benchNow();
+    for (i = 0; i < count; i++)
+    {
+      sink += benchRefAvgWithFilter(&benchData[i * BENCH_N]);
+    }
+    ns[0] = benchNow() - t0;
+
+    t0 = benchNow();
+    for (i = 0; i < count; i++)
+    {
+      sink += ROBUST_FilterAvg(&benchData[i * BENCH_N]);
+    }
+    ns[1] = benchNow() - t0;
+
+    t0 = benchNow();
+    for (i = 0; i < count; i++)
+    {
+      sink += ROBUST_Median16(&benchData[i * BENCH_N]);
+    }
+    ns[2] = benchNow() - t0;
+
+    t0 = benchNow();
+    for (i = 0; i < count; i++)
+    {
+      memcpy(v, &benchData[i * BENCH_N], sizeof(v));
+      sink += ROBUST_TrimmedMean(v, BENCH_N, BENCH_TRIM);
+    }
+    ns[3] = benchNow() - t0;
+
+    t0 = benchNow();
+    for (i = 0; i < count; i++)
+    {
+      ROBUST_StreamInit(&stream);
+      for (j = 0; j < BENCH_N; j++)
+      {
+        ROBUST_StreamAdd(&stream, benchData[i * BENCH_N + j]);
+      }
+      sink += ROBUST_StreamTrimmedMean(&stream, BENCH_TRIM);
+    }
+    ns[4] = benchNow() - t0;
+
+    for (est = 0; est < BENCH_ESTIMATORS; est++)
+    {
+      printf("%-8s %-14s %10.1f %10u\n", benchSetName[set], benchEstName[est], ns[est] / count,
+             bad[est]);
+      failed += bad[est];
+    }
+  }
+
+  if (failed)
+  {
+    printf("MISMATCH: an estimator differs from its reference\n");
+  }
+  free(benchData);
+  return (failed != 0) || (sink == 0xFFFFFFFF);
+}
+
+/**************************************************************************************************
+ * @fn          benchFill
+ *
+ * @brief       Draw the measurements of a set.
+ **************************************************************************************************
+ */
+static void benchFill(uint8 set, uint32 count)
+{
+  uint32 i;
+  int32 value, level = 0;
+
+  for (i = 0; i < count * BENCH_N; i++)
+  {
+    if ((i % BENCH_N) == 0)
+    {
+      level = 200 + benchRand() % 3600;
+    }
+    switch (set)
+    {
+      case 0:
+        /* a few LSB of noise, one sample in 32 a spike of 100 to 400 LSB */
+        value = level + (int32)(benchRand() % 9) - 4;
+        if ((benchRand() & 0x1F) == 0)
+        {
+          value += ((benchRand() & 1) ? 1 : -1) * (int32)(100 + benchRand() % 301);
+        }
+        break;
+      case 1:
+        value = level + (int32)(benchRand() % 9);
+        break;
+      default:
+        value = benchRand() & 0x0FFF;
+        break;
+    }
+    benchData[i] = (uint16)((value < 0) ? 0 : (value > 4095) ? 4095 : value);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          benchCheck
+ *
+ * @brief       Compare one estimator on one measurement with its reference.
+ *
+ * @return      1 on a mismatch, else 0
+ **************************************************************************************************
+ */
+static uint32 benchCheck(uint8 est, const uint16 *pSamples)
+{
+  uint16 sorted[BENCH_N], v[BENCH_N];
+  uint32 sum = 0;
+  uint16 median, trimmed;
+  robustStream_t stream;
+  uint8 j;
+
+  memcpy(sorted, pSamples, sizeof(sorted));
+  qsort(sorted, BENCH_N, sizeof(uint16), benchCmp);
+  median = (uint16)(((uint32)sorted[BENCH_N / 2 - 1] + sorted[BENCH_N / 2]) / 2);
+  for (j = BENCH_TRIM; j < BENCH_N - BENCH_TRIM; j++)
+  {
+    sum += sorted[j];
+  }
+  trimmed = (uint16)(sum / (BENCH_N - 2 * BENCH_TRIM));
+
+  switch (est)
+  {
+    case 0:
+      return 0;
+
+    case 1:
+      memcpy(v, pSamples, sizeof(v));
+      return ROBUST_FilterAvg(pSamples) != benchRefAvgWithFilter(v);
+
+    case 2:
+      return ROBUST_Median16(pSamples) != median;
+
+    case 3:
+      memcpy(v, pSamples, sizeof(v));
+      return ROBUST_TrimmedMean(v, BENCH_N, BENCH_TRIM) != trimmed;
+
+    default:
+      ROBUST_StreamInit(&stream);
+      for (j = 0; j < BENCH_N; j++)
+      {
+        ROBUST_StreamAdd(&stream, pSamples[j]);
+      }
+      return (ROBUST_StreamMedian(&stream) != median) ||
+             (ROBUST_StreamTrimmedMean(&stream, BENCH_TRIM) != trimmed) ||
+             (memcmp(stream.sorted, sorted, sizeof(sorted)) != 0);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          benchCmp
+ *
+ * @brief       qsort() order of samples.
+ **************************************************************************************************
+ */
+static int benchCmp(const void *a, const void *b)
+{
+  return (int)*(const uint16 *)a - (int)*(const uint16 *)b;
+}
+
+/**************************************************************************************************
+ * @fn          benchNow
+ *
+ * @brief       Monotonic time in nanoseconds.
+ **************************************************************************************************
+ */
+static double benchNow(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**************************************************************************************************
+ */
@@ -0,0 +1,64 @@
+/**************************************************************************************************
+  Filename:       bench_robust_ref.c
+
+  Description:    AvgWithFilter() of sensing.c as it was before the robust estimators, kept as
+                  the reference of bench_robust.c: a full exchange sort of the distances to the
+                  mean, swapping the distances and their indexes.  Only the name carries a
+                  benchRef prefix.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+
+/**************************************************************************************************
+ * @fn          benchRefAvgWithFilter
+ **************************************************************************************************
+ */
+uint16_t benchRefAvgWithFilter(uint16_t inData[16]){
+  uint16_t sum, avg;
+  uint16_t delta[16], order[16];
+  uint16_t index, pos, swap;
+
+  sum = 0;
+  for (index=0; index<16; index++){
+    sum = sum + inData[index];
+    order[index] = index;
+  }
+  avg = sum >> 4;
+  /* calculate delta */
+  for (index=0; index<16; index++){
+    if (inData[index] > avg){
+      delta[index] = inData[index] - avg;
+    }
+    else{
+      delta[index] = avg - inData[index];
+    }
+  }
+
+  /* find 8 smallest delta */
+  for (index=0; index<16; index++){
+    for (pos=index+1; pos<16; pos++){
+      if (delta[pos] < delta[index]){
+        swap = delta[index];
+        delta[index] = delta[pos];
+        delta[pos]=swap;
+        swap = order[index];
+        order[index] = order[pos];
+        order[pos]=swap;
+      }
+    }
+  }
+
+  /*recalculate sum*/
+  sum = 0;
+  for (index=0;index<8; index++){
+    sum = sum + inData[(order[index])];
+  }
+  return (sum >> 3);
+}
+
+/**************************************************************************************************
+ */
@@ -0,0 +1,277 @@
+/**************************************************************************************************
+  Filename:       bench_sched.c
+
+  Description:    Host check of the periods of sched.c, and of the settings kept in the FRAM
+                  by sched.c, calib.c and coord.c, on the FRAM model of hal_sim_fram.c through
+                  the driver of fram.c.
+
+                  bench_sched [-n tries] [-r seed]
+
+                    - next       SCHED_Next() of random periods and sticks against the first
+                                 stick after them where SCHED_Due() is not 0, searched stick
+                                 by stick
+                    - valid      periods of 0, and a preparing delta of a period or more, are
+                                 refused
+                    - settings   the periods, the calibration and the network written one
+                                 after the other read back each as it was written; a copy with
+                                 a byte changed is refused and leaves what the caller had, the
+                                 defaults for the calibration
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hal_types.h"
+#include "hal_board_cfg.h"
+#include "hal_sim.h"
+#include "fram.h"
+#include "sched.h"
+#include "calib.h"
+#include "coord.h"
+#include "bench_util.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+#define BENCH_DEFAULT_TRIES       20000
+#define BENCH_MAX_PERIOD          200   /* sticks */
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Global Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+volatile uint8 halSimIntEnabled = TRUE;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static int benchFailed;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static void benchSettings(uint32 n);
+static void benchDamage(uint32 addr, uint8 len);
+static void benchRow(const char *test, uint32 ops, uint32 sticks);
+static void benchFail(const char *test, const char *what, uint32 n);
+
+/**************************************************************************************************
+ * @fn          main
+ *
+ * @brief       Run the tests one after the other.
+ **************************************************************************************************
+ */
+int main(int argc, char **argv)
+{
+  static const uint16 invalid[][3] =
+  {
+    {0, 5, 0}, {30, 0, 2}, {30, 5, 30}, {30, 5, 31}, {1, 1, 1}
+  };
+  uint32 tries = BENCH_DEFAULT_TRIES;
+  uint32 n, time, next, t, sticks;
+  sched_t sched;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:r:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n': tries = strtoul(optarg, NULL, 0);        break;
+      case 'r': benchRandSeed(strtoul(optarg, NULL, 0)); break;
+      default:
+        fprintf(stderr, "usage: %s [-n tries] [-r seed]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (fram_init(FRAM_MODE0) != OK)
+  {
+    fprintf(stderr, "FRAM model does not answer\n");
+    return 1;
+  }
+
+  printf("periods of 1 to %u sticks\n", BENCH_MAX_PERIOD);
+  printf("%-9s %9s %9s\n", "test", "ops", "sticks");
+
+  /* Next due stick, against a search */
+  sticks = 0;
+  for (n = 0; n < tries; n++)
+  {
+    sched.sensingTime    = 1 + benchRand() % BENCH_MAX_PERIOD;
+    sched.sendAliveTime  = 1 + benchRand() % BENCH_MAX_PERIOD;
+    sched.preparingDelta = benchRand() % sched.sensingTime;
+    time = (n % 4 == 0) ? benchRand() % BENCH_MAX_PERIOD : benchRand() >> 1;
+    if (!SCHED_Valid(&sched))
+    {
+      benchFail("next", "periods refused", n);
+      continue;
+    }
+    for (t = time + 1; SCHED_Due(&sched, t) == 0; t++)
+    {
+    }
+    sticks += t - time;
+    next = SCHED_Next(&sched, time);
+    if (next != t)
+    {
+      benchFail("next", "next due stick", n);
+    }
+  }
+  benchRow("next", tries, sticks);
+
+  /* Periods that cannot be used */
+  for (n = 0; n < sizeof(invalid) / sizeof(invalid[0]); n++)
+  {
+    sched.sensingTime    = invalid[n][0];
+    sched.sendAliveTime  = invalid[n][1];
+    sched.preparingDelta = invalid[n][2];
+    if (SCHED_Valid(&sched))
+    {
+      benchFail("valid", "periods taken", n);
+    }
+  }
+  benchRow("valid", n, 0);
+
+  /* Settings in the FRAM */
+  memset(benchFram, 0, sizeof(benchFram));
+  for (n = 0; n < tries / 100 + 1; n++)
+  {
+    benchSettings(n);
+  }
+  benchRow("settings", n, 0);
+
+  if (benchFailed != 0)
+  {
+    printf("FAILED: %d checks\n", benchFailed);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
+
+/**************************************************************************************************
+ * @fn          benchSettings
+ *
+ * @brief       Write random periods, calibration and network, read them back, then damage
+ *              each copy in turn.
+ **************************************************************************************************
+ */
+static void benchSettings(uint32 n)
+{
+  sched_t sched, schedIn;
+  calib_t calib, calibIn, calibDef;
+  coord_t coord, coordIn;
+  uint8 i;
+
+  memset(&sched, 0, sizeof(sched));
+  sched.sensingTime    = 1 + benchRand() % BENCH_MAX_PERIOD;
+  sched.sendAliveTime  = 1 + benchRand() % BENCH_MAX_PERIOD;
+  sched.preparingDelta = benchRand() % sched.sensingTime;
+  memset(&calib, 0, sizeof(calib));
+  calib.intTmpOffset = (int16)(benchRand() % 201) - 100;
+  calib.extTmpOffset = (int16)(benchRand() % 201) - 100;
+  calib.pHOffset     = (int16)(benchRand() % (2 * CALIB_PH_OFFSET_MAX + 1)) - CALIB_PH_OFFSET_MAX;
+  calib.pHSlope      = CALIB_PH_SLOPE_MIN +
+                       benchRand() % (CALIB_PH_SLOPE_MAX - CALIB_PH_SLOPE_MIN + 1);
+  memset(&coord, 0, sizeof(coord));
+  for (i = 0; i < SADDR_EXT_LEN; i++)
+  {
+    coord.extAddr[i] = (uint8)benchRand();
+  }
+  coord.shortAddr      = (uint16)benchRand();
+  coord.panId          = (uint16)benchRand();
+  coord.coordShortAddr = (uint16)benchRand();
+  coord.channel        = 11 + benchRand() % 16;
+
+  SCHED_Save(&sched);
+  CALIB_Save(&calib);
+  COORD_Save(&coord);
+  if (!SCHED_Load(&schedIn) || (memcmp(&schedIn, &sched, sizeof(sched_t)) != 0))
+  {
+    benchFail("settings", "periods do not read back", n);
+  }
+  if (!CALIB_Load(&calibIn) || (memcmp(&calibIn, &calib, sizeof(calib_t)) != 0))
+  {
+    benchFail("settings", "calibration does not read back", n);
+  }
+  if (!COORD_Load(&coordIn) || (memcmp(&coordIn, &coord, sizeof(coord_t)) != 0))
+  {
+    benchFail("settings", "network does not read back", n);
+  }
+
+  /* A byte changed in each copy, the others are still read */
+  benchDamage(SCHED_ADDR, SCHED_LEN);
+  memset(&schedIn, 0x55, sizeof(schedIn));
+  if (SCHED_Load(&schedIn) || (schedIn.sensingTime != 0x5555))
+  {
+    benchFail("settings", "damaged periods taken", n);
+  }
+  benchDamage(CALIB_ADDR, CALIB_LEN);
+  CALIB_Default(&calibDef);
+  if (CALIB_Load(&calibIn) || (memcmp(&calibIn, &calibDef, sizeof(calib_t)) != 0))
+  {
+    benchFail("settings", "damaged calibration taken", n);
+  }
+  if (!COORD_Load(&coordIn))
+  {
+    benchFail("settings", "network damaged with the others", n);
+  }
+  benchDamage(COORD_ADDR, COORD_LEN);
+  memset(&coordIn, 0x55, sizeof(coordIn));
+  if (COORD_Load(&coordIn) || (coordIn.channel != 0x55))
+  {
+    benchFail("settings", "damaged network taken", n);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          benchDamage
+ *
+ * @brief       Flip a bit of a random byte of a copy in the FRAM.
+ **************************************************************************************************
+ */
+static void benchDamage(uint32 addr, uint8 len)
+{
+  uint8 b;
+
+  addr += benchRand() % len;
+  fram_readMemory(addr, &b, 1);
+  b ^= (uint8)(1 << (benchRand() % 8));
+  fram_writeMemory(addr, &b, 1);
+}
+
+/**************************************************************************************************
+ * @fn          benchRow
+ *
+ * @brief       Print the results of a test.
+ **************************************************************************************************
+ */
+static void benchRow(const char *test, uint32 ops, uint32 sticks)
+{
+  printf("%-9s %9u %9u\n", test, ops, sticks);
+}
+
+/**************************************************************************************************
+ * @fn          benchFail
+ *
+ * @brief       Report a failed check; only the first few of a run are printed.
+ **************************************************************************************************
+ */
+static void benchFail(const char *test, const char *what, uint32 n)
+{
+  if (benchFailed++ < 10)
+  {
+    printf("MISMATCH: %s: %s (%u)\n", test, what, n);
+  }
+}
+
+/**************************************************************************************************
+ */
@@ -0,0 +1,61 @@
+/**************************************************************************************************
+  Filename:       bench_sim_fram.c
+
+  Description:    The simulation kernel as the FRAM model of hal_sim_fram.c and the driver of
+                  fram.c see it, for the host benchmarks that run them without a network: one
+                  device, a FRAM in benchFram[] and its bus counters in benchStats.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "hal_types.h"
+#include "hal_sim.h"
+#include "bench_util.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Global Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+volatile uint8 P1SEL, P1DIR, P3SEL, P3DIR, P3OUT, P5SEL, P5DIR, P5OUT, P7SEL, P7DIR, P7OUT;
+
+uint8 benchFram[HAL_SIM_FRAM_SIZE];
+halSimDevStats_t benchStats;
+
+/**************************************************************************************************
+ * @fn          osal_set_event
+ *
+ * @brief       End of the async transfers of fram.c, which are polled on the host.
+ **************************************************************************************************
+ */
+uint8 osal_set_event(uint8 task_id, uint16 event_flag)
+{
+  (void)task_id;
+  (void)event_flag;
+  return 0;
+}
+
+/**************************************************************************************************
+ * @fn          Simulation kernel services used by the FRAM model
+ **************************************************************************************************
+ */
+uint8 *halSimFramPage(uint32 addr, bool write)
+{
+  (void)write;
+  return &benchFram[(addr % HAL_SIM_FRAM_SIZE) / HAL_SIM_FRAM_PAGE_LEN * HAL_SIM_FRAM_PAGE_LEN];
+}
+
+halSimDevStats_t *halSimStats(uint16 dev)
+{
+  (void)dev;
+  return &benchStats;
+}
+
+uint16 halSimSelf(void)
+{
+  return 0;
+}
+
+/**************************************************************************************************
+ */
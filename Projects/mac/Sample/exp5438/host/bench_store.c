@@ -0,0 +1,387 @@
+/**************************************************************************************************
+  Filename:       bench_store.c
+
+  Description:    Host benchmark and check of the FRAM store of store.c, on the FRAM model of
+                  hal_sim_fram.c through the driver of fram.c.
+
+                  bench_store [-n laps] [-r seed]
+
+                  Records of random length and data are appended with times that go up by 1 to
+                  3, through 'laps' turns of the ring, and the log is checked as it goes:
+                    - append     every record reads back, the oldest ones are gone once the
+                                 ring wrapped, and the FRAM bus bytes per append are counted
+                    - reboot     STORE_Init() on the FRAM as it is, after a number of appends
+                                 that is not a checkpoint interval, and several times within
+                                 one interval: the head rolls forward over the records appended
+                                 after the checkpoint, and the store_info of the checkpoint
+                                 comes back
+                    - cut        the newest checkpoint is damaged, as by a reset during its
+                                 write: the log starts from the one before and finds the same
+                                 head
+                    - range      STORE_FindTime() and STORE_FindBlock() against the records
+                                 the bench appended, and their bus bytes
+                    - new log    the checkpoints are erased with the records left in the ring:
+                                 the new log starts past every old sequence number, no old
+                                 record reads back as a new one
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hal_types.h"
+#include "hal_board_cfg.h"
+#include "hal_sim.h"
+#include "fram.h"
+#include "store.h"
+#include "bench_util.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+#define BENCH_DEFAULT_LAPS        3
+#define BENCH_REBOOT_EVERY        1001  /* appends between reboots, not a STORE_CP_INTERVAL */
+#define BENCH_FIND_TRIES          2000
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Global Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+volatile uint8 halSimIntEnabled = TRUE;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static uint32 *benchTime;             /* time of every record appended, by sequence number */
+static uint32 benchFirst;             /* sequence number of the first record of the log */
+static uint32 benchTimeNow;
+static uint32 benchCpHead;            /* head at the newest checkpoint, as the bench counts */
+static int    benchFailed;
+static struct
+{
+  uint32 appends;                     /* head of the log, saved with the checkpoints */
+} benchInfo;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static void   benchAppend(const char *test);
+static void   benchReboot(const char *test);
+static void   benchFill(uint32 seq, uint8 *pData, uint8 *pLen);
+static void   benchCheckRec(const char *test, uint32 seq);
+static void   benchFail(const char *test, const char *what, uint32 seq);
+
+/**************************************************************************************************
+ * @fn          main
+ *
+ * @brief       Run the tests one after the other on one log.
+ **************************************************************************************************
+ */
+int main(int argc, char **argv)
+{
+  uint8 data[STORE_DATA_LEN];
+  uint32 laps = BENCH_DEFAULT_LAPS;
+  uint32 total, seq, head, oldest, t, i;
+  uint32 cpSeq, newest, slot;
+  uint32 bytes;
+  uint16 block;
+  uint8 len;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:r:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n': laps = strtoul(optarg, NULL, 0);         break;
+      case 'r': benchRandSeed(strtoul(optarg, NULL, 0)); break;
+      default:
+        fprintf(stderr, "usage: %s [-n laps] [-r seed]\n", argv[0]);
+        return 1;
+    }
+  }
+  if ((laps == 0) || (laps > 100))
+  {
+    fprintf(stderr, "%s: 1 to 100 laps\n", argv[0]);
+    return 1;
+  }
+  if (fram_init(FRAM_MODE0) != OK)
+  {
+    fprintf(stderr, "FRAM model does not answer\n");
+    return 1;
+  }
+
+  total = laps * STORE_BLOCKS + STORE_BLOCKS / 2;
+  benchTime = malloc((total + STORE_BLOCKS) * sizeof(uint32));
+  printf("%u blocks of %u bytes, checkpoint every %u appends, %u appends\n", STORE_BLOCKS,
+         STORE_REC_LEN, STORE_CP_INTERVAL, total);
+  printf("%-9s %9s %9s %9s\n", "test", "ops", "bus B/op", "cmds/op");
+
+  /* Append, with a reboot now and then */
+  memset(benchFram, 0, sizeof(benchFram));
+  if (STORE_Init(&benchInfo, sizeof(benchInfo)) || (STORE_Head() != 0))
+  {
+    benchFail("append", "blank FRAM did not start a log at 0", STORE_Head());
+  }
+  benchFirst = 0;
+  benchCpHead = 0;
+  bytes = 0;
+  memset(&benchStats, 0, sizeof(benchStats));
+  for (seq = 0; seq < total; seq++)
+  {
+    benchAppend("append");
+    if ((seq >= STORE_BLOCKS) && (STORE_Read(seq - STORE_BLOCKS, &t, data, &len) != STORE_GONE))
+    {
+      benchFail("append", "overwritten record still reads", seq - STORE_BLOCKS);
+    }
+    if ((seq + 1) % BENCH_REBOOT_EVERY == 0)
+    {
+      bytes += benchStats.framBytes;
+      benchReboot("reboot");
+      memset(&benchStats, 0, sizeof(benchStats));
+    }
+  }
+  bytes += benchStats.framBytes;
+  printf("%-9s %9u %9.1f\n", "append", total, (double)bytes / total);
+
+  /* Resets closer together than the checkpoints */
+  for (i = 0; i < 3; i++)
+  {
+    for (t = 0; t < STORE_CP_INTERVAL * 2 / 3; t++)
+    {
+      benchAppend("reboot");
+    }
+    memset(&benchStats, 0, sizeof(benchStats));
+    benchReboot("reboot");
+  }
+  printf("%-9s %9u %9u %9u\n", "reboot", 1, benchStats.framBytes, benchStats.framSelects);
+
+  /* Checkpoint cut by a reset: it is the last write of the append that made it */
+  do
+  {
+    benchAppend("cut");
+  } while (benchCpHead != STORE_Head());
+  head = STORE_Head();
+  newest = 0;
+  slot = 0;
+  for (i = 0; i < STORE_CP_SLOTS; i++)
+  {
+    fram_readMemory(STORE_CP_BASE + i * STORE_CP_LEN, (uint8 *)&cpSeq, sizeof(cpSeq));
+    if (cpSeq >= newest)
+    {
+      newest = cpSeq;
+      slot = i;
+    }
+  }
+  fram_readMemory(STORE_CP_BASE + slot * STORE_CP_LEN, data, STORE_CP_LEN);
+  data[4] ^= 0xFF;                      /* the head no longer matches the CRC */
+  fram_writeMemory(STORE_CP_BASE + slot * STORE_CP_LEN, data, STORE_CP_LEN);
+  if (!STORE_Init(&benchInfo, sizeof(benchInfo)) || (STORE_Head() != head))
+  {
+    benchFail("cut", "head not found from the checkpoint before", STORE_Head());
+  }
+  for (seq = STORE_Oldest(); seq < STORE_Head(); seq++)
+  {
+    benchCheckRec("cut", seq);
+  }
+
+  /* Range reads */
+  oldest = STORE_Oldest();
+  if (oldest != head - STORE_BLOCKS)
+  {
+    benchFail("range", "oldest record", oldest);
+  }
+  memset(&benchStats, 0, sizeof(benchStats));
+  for (i = 0; i < BENCH_FIND_TRIES; i++)
+  {
+    t = benchTime[oldest] - 2 + benchRand() % (benchTime[head - 1] - benchTime[oldest] + 4);
+    seq = STORE_FindTime(t);
+    if ((seq < oldest) || (seq > head) || ((seq < head) && (benchTime[seq] < t)) ||
+        ((seq > oldest) && (benchTime[seq - 1] >= t)))
+    {
+      benchFail("range", "STORE_FindTime", t);
+    }
+  }
+  printf("%-9s %9u %9.1f %9.1f\n", "findtime", BENCH_FIND_TRIES,
+         (double)benchStats.framBytes / BENCH_FIND_TRIES, (double)benchStats.framSelects / BENCH_FIND_TRIES);
+  for (block = 0; block < STORE_BLOCKS; block++)
+  {
+    seq = STORE_FindBlock(block);
+    if ((seq < oldest) || (seq >= head) || (STORE_Block(seq) != block))
+    {
+      benchFail("range", "STORE_FindBlock", block);
+    }
+  }
+  if (STORE_FindBlock(STORE_BLOCKS) != head)
+  {
+    benchFail("range", "STORE_FindBlock past the ring", STORE_BLOCKS);
+  }
+
+  /* New log over the records of an old one */
+  memset(&benchFram[STORE_CP_BASE], 0, STORE_CP_SLOTS * STORE_CP_LEN);
+  if (STORE_Init(&benchInfo, sizeof(benchInfo)))
+  {
+    benchFail("new log", "erased checkpoints found", 0);
+  }
+  benchFirst = STORE_Head();
+  if ((benchFirst < head) || (benchFirst % STORE_BLOCKS != 0) || (STORE_Oldest() != benchFirst))
+  {
+    benchFail("new log", "does not start past the old one", benchFirst);
+  }
+  if (STORE_Read(head - 1, &t, data, &len) != STORE_GONE)
+  {
+    benchFail("new log", "old record reads", head - 1);
+  }
+  for (block = 0; block < STORE_BLOCKS; block++)
+  {
+    if (STORE_FindBlock(block) != benchFirst)
+    {
+      benchFail("new log", "old record in a block of the new log", block);
+    }
+  }
+  benchCpHead = benchFirst;
+  benchInfo.appends = benchFirst;
+  benchTimeNow = 0;
+  for (seq = benchFirst; seq < benchFirst + STORE_BLOCKS / 2; seq++)
+  {
+    benchAppend("new log");
+  }
+  if (STORE_FindTime(0) != benchFirst)
+  {
+    benchFail("new log", "STORE_FindTime found an old record", STORE_FindTime(0));
+  }
+
+  free(benchTime);
+  printf("%s\n", benchFailed ? "FAILED" : "all checks passed");
+  return benchFailed;
+}
+
+/**************************************************************************************************
+ * @fn          benchAppend
+ *
+ * @brief       Append the next record, check it reads back, and follow the checkpoints the
+ *              way store.c takes them: one every STORE_CP_INTERVAL appends of the log.
+ **************************************************************************************************
+ */
+static void benchAppend(const char *test)
+{
+  uint8 data[STORE_DATA_LEN];
+  uint32 seq = STORE_Head();
+  uint8 len;
+
+  benchTimeNow += 1 + benchRand() % 3;
+  benchTime[seq - benchFirst] = benchTimeNow;
+  benchFill(seq, data, &len);
+  benchInfo.appends = seq + 1;
+  if (STORE_Append(benchTimeNow, data, len) != seq)
+  {
+    benchFail(test, "sequence number", seq);
+  }
+  if (seq + 1 - benchCpHead == STORE_CP_INTERVAL)
+  {
+    benchCpHead = seq + 1;
+  }
+  benchCheckRec(test, seq);
+}
+
+/**************************************************************************************************
+ * @fn          benchReboot
+ *
+ * @brief       Reset: the store_info in RAM is lost, STORE_Init() must find the head that was
+ *              reached and give back the store_info of the newest checkpoint.
+ **************************************************************************************************
+ */
+static void benchReboot(const char *test)
+{
+  uint32 head = STORE_Head();
+
+  benchInfo.appends = 0;
+  if (!STORE_Init(&benchInfo, sizeof(benchInfo)) || (STORE_Head() != head))
+  {
+    benchFail(test, "head not rolled forward", STORE_Head());
+  }
+  if (benchInfo.appends != benchCpHead)
+  {
+    benchFail(test, "store_info not the one of the newest checkpoint", benchInfo.appends);
+  }
+  benchInfo.appends = head;
+}
+
+/**************************************************************************************************
+ * @fn          benchFill
+ *
+ * @brief       Data of a record: its length and bytes follow from its sequence number, so any
+ *              record can be checked without keeping it.
+ **************************************************************************************************
+ */
+static void benchFill(uint32 seq, uint8 *pData, uint8 *pLen)
+{
+  uint32 x = seq * 2654435761u + 1;
+  uint8 i;
+
+  *pLen = (uint8)(1 + seq % STORE_DATA_LEN);
+  for (i = 0; i < *pLen; i++)
+  {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    pData[i] = (uint8)x;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          benchCheckRec
+ *
+ * @brief       A record of the ring must read back with its time and data.
+ **************************************************************************************************
+ */
+static void benchCheckRec(const char *test, uint32 seq)
+{
+  uint8 want[STORE_DATA_LEN];
+  uint8 data[STORE_DATA_LEN];
+  uint8 wantLen, len;
+  uint32 time;
+
+  benchFill(seq, want, &wantLen);
+  if ((STORE_Read(seq, &time, data, &len) != STORE_OK) || (time != benchTime[seq - benchFirst]) ||
+      (len != wantLen) || (memcmp(data, want, len) != 0))
+  {
+    benchFail(test, "record does not read back", seq);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          benchFail
+ *
+ * @brief       Report a failed check; only the first few of a run are printed.
+ **************************************************************************************************
+ */
+static void benchFail(const char *test, const char *what, uint32 seq)
+{
+  if (benchFailed++ < 10)
+  {
+    printf("MISMATCH: %s: %s (%u)\n", test, what, seq);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          osal_memcpy
+ *
+ * @brief       OSAL services of store.c.
+ **************************************************************************************************
+ */
+void *osal_memcpy(void *dst, const void *src, unsigned int len)
+{
+  return memcpy(dst, src, len);
+}
+
+/**************************************************************************************************
+ */
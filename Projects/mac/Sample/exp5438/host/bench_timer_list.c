@@ -0,0 +1,293 @@
+/**************************************************************************************************
+  Filename:       bench_timer_list.c
+
+  Description:    The linear list OSAL timers as they were before the timing wheel, kept as the
+                  reference of bench_timers.c.  The algorithm is unchanged, only the names carry
+                  a benchList prefix so it links next to OSAL_Timers.c.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "comdef.h"
+#include "hal_mcu.h"
+#include "OSAL.h"
+#include "OSAL_Timers.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Typedefs
+ * ------------------------------------------------------------------------------------------------
+ */
+typedef union {
+  uint32 time32;
+  uint16 time16[2];
+  uint8 time8[4];
+} listTime_t;
+
+typedef struct
+{
+  void   *next;
+  listTime_t timeout;
+  uint16 event_flag;
+  uint8  task_id;
+  uint32 reloadTimeout;
+} listTimerRec_t;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static listTimerRec_t *listHead;
+
+/**************************************************************************************************
+ * @fn          listFindTimer
+ **************************************************************************************************
+ */
+static listTimerRec_t *listFindTimer(uint8 task_id, uint16 event_flag)
+{
+  listTimerRec_t *srchTimer = listHead;
+
+  while (srchTimer)
+  {
+    if (srchTimer->event_flag == event_flag && srchTimer->task_id == task_id)
+    {
+      break;
+    }
+    srchTimer = srchTimer->next;
+  }
+
+  return srchTimer;
+}
+
+/**************************************************************************************************
+ * @fn          listAddTimer
+ **************************************************************************************************
+ */
+static listTimerRec_t *listAddTimer(uint8 task_id, uint16 event_flag, uint32 timeout)
+{
+  listTimerRec_t *newTimer;
+  listTimerRec_t *srchTimer;
+
+  newTimer = listFindTimer(task_id, event_flag);
+  if (newTimer)
+  {
+    newTimer->timeout.time32 = timeout;
+    return newTimer;
+  }
+
+  newTimer = osal_mem_alloc(sizeof(listTimerRec_t));
+  if (newTimer)
+  {
+    newTimer->task_id = task_id;
+    newTimer->event_flag = event_flag;
+    newTimer->timeout.time32 = timeout;
+    newTimer->next = NULL;
+    newTimer->reloadTimeout = 0;
+
+    if (listHead == NULL)
+    {
+      listHead = newTimer;
+    }
+    else
+    {
+      srchTimer = listHead;
+      while (srchTimer->next)
+      {
+        srchTimer = srchTimer->next;
+      }
+      srchTimer->next = newTimer;
+    }
+  }
+
+  return newTimer;
+}
+
+/**************************************************************************************************
+ * @fn          benchListStartTimer
+ **************************************************************************************************
+ */
+uint8 benchListStartTimer(uint8 taskID, uint16 event_id, uint32 timeout_value)
+{
+  halIntState_t intState;
+  listTimerRec_t *newTimer;
+
+  HAL_ENTER_CRITICAL_SECTION(intState);
+  newTimer = listAddTimer(taskID, event_id, timeout_value);
+  HAL_EXIT_CRITICAL_SECTION(intState);
+
+  return (newTimer != NULL) ? SUCCESS : NO_TIMER_AVAIL;
+}
+
+/**************************************************************************************************
+ * @fn          benchListStartReloadTimer
+ **************************************************************************************************
+ */
+uint8 benchListStartReloadTimer(uint8 taskID, uint16 event_id, uint32 timeout_value)
+{
+  halIntState_t intState;
+  listTimerRec_t *newTimer;
+
+  HAL_ENTER_CRITICAL_SECTION(intState);
+  newTimer = listAddTimer(taskID, event_id, timeout_value);
+  if (newTimer)
+  {
+    newTimer->reloadTimeout = timeout_value;
+  }
+  HAL_EXIT_CRITICAL_SECTION(intState);
+
+  return (newTimer != NULL) ? SUCCESS : NO_TIMER_AVAIL;
+}
+
+/**************************************************************************************************
+ * @fn          benchListStopTimer
+ **************************************************************************************************
+ */
+uint8 benchListStopTimer(uint8 task_id, uint16 event_id)
+{
+  halIntState_t intState;
+  listTimerRec_t *foundTimer;
+
+  HAL_ENTER_CRITICAL_SECTION(intState);
+  foundTimer = listFindTimer(task_id, event_id);
+  if (foundTimer)
+  {
+    foundTimer->event_flag = 0;
+  }
+  HAL_EXIT_CRITICAL_SECTION(intState);
+
+  return (foundTimer != NULL) ? SUCCESS : INVALID_EVENT_ID;
+}
+
+/**************************************************************************************************
+ * @fn          benchListNumActive
+ **************************************************************************************************
+ */
+uint8 benchListNumActive(void)
+{
+  halIntState_t intState;
+  uint8 num_timers = 0;
+  listTimerRec_t *srchTimer;
+
+  HAL_ENTER_CRITICAL_SECTION(intState);
+  for (srchTimer = listHead; srchTimer != NULL; srchTimer = srchTimer->next)
+  {
+    num_timers++;
+  }
+  HAL_EXIT_CRITICAL_SECTION(intState);
+
+  return num_timers;
+}
+
+/**************************************************************************************************
+ * @fn          benchListUpdate
+ **************************************************************************************************
+ */
+void benchListUpdate(uint32 updateTime)
+{
+  halIntState_t intState;
+  listTimerRec_t *srchTimer;
+  listTimerRec_t *prevTimer;
+  listTime_t timeUnion;
+
+  timeUnion.time32 = updateTime;
+
+  srchTimer = listHead;
+  prevTimer = NULL;
+
+  while (srchTimer)
+  {
+    listTimerRec_t *freeTimer = NULL;
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+
+    if ((timeUnion.time16[1] == 0) && (timeUnion.time8[1] == 0))
+    {
+      if (srchTimer->timeout.time8[0] >= timeUnion.time8[0])
+      {
+        srchTimer->timeout.time8[0] -= timeUnion.time8[0];
+      }
+      else if (srchTimer->timeout.time32 > timeUnion.time32)
+      {
+        srchTimer->timeout.time32 -= timeUnion.time32;
+      }
+      else
+      {
+        srchTimer->timeout.time32 = 0;
+      }
+    }
+    else if (srchTimer->timeout.time32 > timeUnion.time32)
+    {
+      srchTimer->timeout.time32 -= timeUnion.time32;
+    }
+    else
+    {
+      srchTimer->timeout.time32 = 0;
+    }
+
+    if ((srchTimer->timeout.time32 == 0) && srchTimer->reloadTimeout && srchTimer->event_flag)
+    {
+      osal_set_event(srchTimer->task_id, srchTimer->event_flag);
+      srchTimer->timeout.time32 = srchTimer->reloadTimeout;
+    }
+
+    if ((srchTimer->timeout.time32 == 0) || (srchTimer->event_flag == 0))
+    {
+      if (prevTimer == NULL)
+      {
+        listHead = srchTimer->next;
+      }
+      else
+      {
+        prevTimer->next = srchTimer->next;
+      }
+      freeTimer = srchTimer;
+      srchTimer = srchTimer->next;
+    }
+    else
+    {
+      prevTimer = srchTimer;
+      srchTimer = srchTimer->next;
+    }
+
+    HAL_EXIT_CRITICAL_SECTION(intState);
+
+    if (freeTimer)
+    {
+      if (freeTimer->timeout.time32 == 0)
+      {
+        osal_set_event(freeTimer->task_id, freeTimer->event_flag);
+      }
+      osal_mem_free(freeTimer);
+    }
+  }
+}
+
+/**************************************************************************************************
+ * @fn          benchListNextTimeout
+ **************************************************************************************************
+ */
+uint32 benchListNextTimeout(void)
+{
+  uint32 nextTimeout;
+  listTimerRec_t *srchTimer;
+
+  if (listHead == NULL)
+  {
+    return 0;
+  }
+
+  nextTimeout = OSAL_TIMERS_MAX_TIMEOUT;
+  for (srchTimer = listHead; srchTimer != NULL; srchTimer = srchTimer->next)
+  {
+    if (srchTimer->timeout.time32 < nextTimeout)
+    {
+      nextTimeout = srchTimer->timeout.time32;
+    }
+  }
+
+  return nextTimeout;
+}
+
+/**************************************************************************************************
+ */
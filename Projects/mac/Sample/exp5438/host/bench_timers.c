@@ -0,0 +1,331 @@
+/**************************************************************************************************
+  Filename:       bench_timers.c
+
+  Description:    Host benchmark of the OSAL timers: the timing wheel of OSAL_Timers.c against
+                  the linear list it replaced (bench_timer_list.c).
+
+                  bench_timers [-s steps] [-r seed]
+
+                  For 10, 100 and 250 running timers the same scripted load is played on both:
+                  mostly 1 ms updates with random jumps as after a sleep, one-shot timers started
+                  again by their task when they fire, reload timers, and random restarts and
+                  stops.  A tenth of the timers run for minutes to hours.  The time spent per
+                  update, per start or stop and per next timeout query is printed, and the
+                  events fired by both must match.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "comdef.h"
+#include "OSAL.h"
+#include "OSAL_Timers.h"
+#include "bench_util.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+#define BENCH_DEFAULT_STEPS       300000
+#define BENCH_MAX_TIMERS          250
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Typedefs
+ * ------------------------------------------------------------------------------------------------
+ */
+typedef struct
+{
+  const char *name;
+  uint8  (*start)(uint8 task_id, uint16 event_id, uint32 timeout);
+  uint8  (*reload)(uint8 task_id, uint16 event_id, uint32 timeout);
+  uint8  (*stop)(uint8 task_id, uint16 event_id);
+  void   (*update)(uint32 updateTime);
+  uint32 (*next)(void);
+  uint8  (*active)(void);
+} benchImpl_t;
+
+typedef struct
+{
+  double   updateNs;
+  double   startStopNs;
+  double   nextNs;
+  uint32   starts;
+  uint32   fires;
+  uint64_t checksum;
+} benchResult_t;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Global Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+volatile uint8 halSimIntEnabled = TRUE;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static bool   benchFired[BENCH_MAX_TIMERS];
+static uint16 benchFireCount;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+extern uint8  benchListStartTimer(uint8 taskID, uint16 event_id, uint32 timeout_value);
+extern uint8  benchListStartReloadTimer(uint8 taskID, uint16 event_id, uint32 timeout_value);
+extern uint8  benchListStopTimer(uint8 task_id, uint16 event_id);
+extern void   benchListUpdate(uint32 updateTime);
+extern uint32 benchListNextTimeout(void);
+extern uint8  benchListNumActive(void);
+
+static void   benchRun(const benchImpl_t *impl, uint16 timers, uint32 steps, uint32 seed,
+                       benchResult_t *result);
+static uint32 benchPeriod(void);
+static double benchNow(void);
+
+static const benchImpl_t benchWheel =
+{
+  "wheel", osal_start_timerEx, osal_start_reload_timer, osal_stop_timerEx, osalTimerUpdate,
+  osal_next_timeout, osal_timer_num_active
+};
+
+static const benchImpl_t benchList =
+{
+  "list", benchListStartTimer, benchListStartReloadTimer, benchListStopTimer, benchListUpdate,
+  benchListNextTimeout, benchListNumActive
+};
+
+/**************************************************************************************************
+ * @fn          main
+ *
+ * @brief       Run the load on both timer implementations and compare.
+ **************************************************************************************************
+ */
+int main(int argc, char **argv)
+{
+  static const uint16 sizes[] = {10, 100, BENCH_MAX_TIMERS};
+  uint32 steps = BENCH_DEFAULT_STEPS;
+  uint32 seed = 1;
+  int failed = 0;
+  uint8 i;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "s:r:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 's': steps = strtoul(optarg, NULL, 0); break;
+      case 'r': seed = strtoul(optarg, NULL, 0);  break;
+      default:
+        fprintf(stderr, "usage: %s [-s steps] [-r seed]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  printf("%6s  %-6s %12s %12s %12s %10s %10s\n", "timers", "impl", "update ns", "start/stop ns",
+         "next ns", "starts", "fires");
+
+  for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+  {
+    benchResult_t list, wheel;
+
+    benchRun(&benchList, sizes[i], steps, seed, &list);
+    benchRun(&benchWheel, sizes[i], steps, seed, &wheel);
+
+    printf("%6u  %-6s %12.1f %12.1f %12.1f %10u %10u\n", sizes[i], "list", list.updateNs,
+           list.startStopNs, list.nextNs, list.starts, list.fires);
+    printf("%6u  %-6s %12.1f %12.1f %12.1f %10u %10u\n", sizes[i], "wheel", wheel.updateNs,
+           wheel.startStopNs, wheel.nextNs, wheel.starts, wheel.fires);
+
+    if ((list.fires != wheel.fires) || (list.checksum != wheel.checksum))
+    {
+      printf("MISMATCH: the wheel and the list fired different events\n");
+      failed = 1;
+    }
+  }
+
+  printf("wheel pool: %u timers at most, %u failed starts\n", osal_timer_high_water(),
+         osal_timer_num_failed());
+
+  return failed;
+}
+
+/**************************************************************************************************
+ * @fn          benchRun
+ *
+ * @brief       Play the load of the seed on one implementation.  Timer i belongs to task i / 16
+ *              with event bit i % 16; every fourth timer reloads.
+ **************************************************************************************************
+ */
+static void benchRun(const benchImpl_t *impl, uint16 timers, uint32 steps, uint32 seed,
+                     benchResult_t *result)
+{
+  uint32 clock = 0;
+  uint32 step, dt;
+  uint16 i;
+  double t0;
+
+  memset(result, 0, sizeof(*result));
+  benchRandSeed(seed);
+  osalTimerInit();
+
+  for (i = 0; i < timers; i++)
+  {
+    if ((i & 3) == 0)
+    {
+      impl->reload((uint8)(i >> 4), (uint16)(1 << (i & 15)), benchPeriod());
+    }
+    else
+    {
+      impl->start((uint8)(i >> 4), (uint16)(1 << (i & 15)), benchPeriod());
+    }
+  }
+
+  for (step = 0; step < steps; step++)
+  {
+    // Mostly a 1 ms tick, now and then the time slept
+    dt = ((benchRand() & 15) == 0) ? 2 + benchRand() % 2000 : 1;
+    clock += dt;
+
+    benchFireCount = 0;
+    t0 = benchNow();
+    impl->update(dt);
+    result->updateNs += benchNow() - t0;
+
+    // Tasks start their one-shot timers again, in timer order so both use the same periods
+    for (i = 0; benchFireCount != 0; i++)
+    {
+      if (!benchFired[i])
+      {
+        continue;
+      }
+      benchFired[i] = FALSE;
+      benchFireCount--;
+
+      result->fires++;
+      result->checksum += ((uint64_t)clock << 16 | i) * 0x9E3779B97F4A7C15ull;
+
+      if ((i & 3) != 0)
+      {
+        t0 = benchNow();
+        impl->start((uint8)(i >> 4), (uint16)(1 << (i & 15)), benchPeriod());
+        result->startStopNs += benchNow() - t0;
+        result->starts++;
+      }
+    }
+
+    // Now and then a timer is rescheduled or stopped for a while
+    if ((benchRand() & 7) == 0)
+    {
+      i = (uint16)(benchRand() % timers);
+      t0 = benchNow();
+      if ((benchRand() & 3) == 0)
+      {
+        impl->stop((uint8)(i >> 4), (uint16)(1 << (i & 15)));
+      }
+      else if ((i & 3) == 0)
+      {
+        impl->reload((uint8)(i >> 4), (uint16)(1 << (i & 15)), benchPeriod());
+      }
+      else
+      {
+        impl->start((uint8)(i >> 4), (uint16)(1 << (i & 15)), benchPeriod());
+      }
+      result->startStopNs += benchNow() - t0;
+      result->starts++;
+    }
+
+    t0 = benchNow();
+    (void)impl->next();
+    result->nextNs += benchNow() - t0;
+  }
+
+  // Leave no timer behind for the next run
+  for (i = 0; i < timers; i++)
+  {
+    impl->stop((uint8)(i >> 4), (uint16)(1 << (i & 15)));
+  }
+  impl->update(1);
+
+  result->updateNs /= steps;
+  result->nextNs /= steps;
+  result->startStopNs /= (result->starts != 0) ? result->starts : 1;
+}
+
+/**************************************************************************************************
+ * @fn          benchPeriod
+ *
+ * @brief       Timeout of a timer: up to 5 s, or one in ten up to an hour.
+ **************************************************************************************************
+ */
+static uint32 benchPeriod(void)
+{
+  if (benchRand() % 10 == 0)
+  {
+    return 60000 + benchRand() % 3540000;
+  }
+  return 1 + benchRand() % 5000;
+}
+
+/**************************************************************************************************
+ * @fn          benchNow
+ **************************************************************************************************
+ */
+static double benchNow(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**************************************************************************************************
+ *                                    OSAL services of the timers
+ **************************************************************************************************
+ */
+uint8 osal_set_event(uint8 task_id, uint16 event_flag)
+{
+  uint16 timer = (uint16)(task_id << 4);
+
+  // The list sets no event for a stopped timer that comes due
+  if (event_flag == 0)
+  {
+    return SUCCESS;
+  }
+  while ((event_flag >>= 1) != 0)
+  {
+    timer++;
+  }
+  if (!benchFired[timer])
+  {
+    benchFired[timer] = TRUE;
+    benchFireCount++;
+  }
+  return SUCCESS;
+}
+
+void *osal_mem_alloc(uint16 size)
+{
+  return malloc(size);
+}
+
+void osal_mem_free(void *ptr)
+{
+  free(ptr);
+}
+
+uint32 TimerElapsed(void)
+{
+  return 0;
+}
+
+/**************************************************************************************************
+ */
@@ -0,0 +1,47 @@
+/**************************************************************************************************
+  Filename:       bench_util.c
+
+  Description:    Pseudo random numbers of the host benchmarks.  They are deterministic, so a run
+                  is repeated with its seed, and both implementations a benchmark compares see
+                  the same workload.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "bench_util.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static uint32 benchSeed = 1;
+
+/**************************************************************************************************
+ * @fn          benchRandSeed
+ *
+ * @brief       Restart the sequence; xorshift32 would stay at 0, so 0 is taken as 1.
+ **************************************************************************************************
+ */
+void benchRandSeed(uint32 seed)
+{
+  benchSeed = (seed != 0) ? seed : 1;
+}
+
+/**************************************************************************************************
+ * @fn          benchRand
+ *
+ * @brief       Deterministic pseudo random numbers (xorshift32).
+ **************************************************************************************************
+ */
+uint32 benchRand(void)
+{
+  benchSeed ^= benchSeed << 13;
+  benchSeed ^= benchSeed >> 17;
+  benchSeed ^= benchSeed << 5;
+  return benchSeed;
+}
+
+/**************************************************************************************************
+ */
@@ -0,0 +1,47 @@
+/**************************************************************************************************
+  Filename:       bench_util.h
+
+  Description:    Services shared by the host benchmarks: the pseudo random numbers of
+                  bench_util.c, and the simulation kernel services behind the FRAM model of
+                  hal_sim_fram.c, in bench_sim_fram.c, for the benchmarks of the FRAM driver
+                  and of what is stored through it.
+**************************************************************************************************/
+
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "hal_types.h"
+#include "hal_sim.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Global Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+/* bench_sim_fram.c: content of the FRAM model, and its bus counters */
+extern uint8 benchFram[HAL_SIM_FRAM_SIZE];
+extern halSimDevStats_t benchStats;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+/* Restart the pseudo random numbers at 'seed'; a zero seed is taken as 1 */
+extern void   benchRandSeed(uint32 seed);
+
+/* Next pseudo random number (xorshift32), the same sequence on every host */
+extern uint32 benchRand(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BENCH_UTIL_H */
@@ -0,0 +1,340 @@
+/**************************************************************************************************
+  Filename:       bench_wire.c
+
+  Description:    Host check of the wire format of wire.c: every packet type with pkt_t
+                  parameters goes through WIRE_Encode() and WIRE_Decode() and comes back as it
+                  was.
+
+                  bench_wire [-n packets] [-r seed]
+
+                  The fields of the packets are filled at random from the field lists of
+                  wire.h, the rest of the pkt_t is left 0:
+                    - roundtrip  each packet encodes to WIRE_Len() bytes and decodes to itself
+                    - bytes      an alive packet of known fields gives known bytes, low byte
+                                 first
+                    - refuse     an unknown type, a buffer too small, a packet cut short and
+                                 another version are refused; a longer header and more bytes
+                                 of parameters are skipped
+                    - cmds       the periods and a calibration in one PKT_CMDS_TYPE packet, as
+                                 the gateway answers a poll, then random packets added to one
+                                 until the frame is full: WIRE_CmdsNext() gives back each one
+                                 and nothing after; a packet that does not fit leaves the ones
+                                 before as they were, and a PKT_CMDS_TYPE packet cut short
+                                 gives the packets before the cut
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "hal_types.h"
+#include "wire.h"
+#include "bench_util.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+#define BENCH_DEFAULT_PACKETS     10000
+#define BENCH_BUF_LEN             116   /* MAC_MAX_FRAME_SIZE */
+
+/* Fill a field of the parameters of *pPkt at random */
+#define BENCH_FIELD(type, member, n) \
+  benchFill((uint8*) &((type*) &pPkt->pktPara)->member, sizeof(((type*) 0)->member));
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static const struct
+{
+  pktType_t   pktType;
+  const char *name;
+  uint8       len;
+} benchTypes[] =
+{
+  {PKT_ALIVE_TYPE,   "alive",   WIRE_ALIVE_LEN},
+  {PKT_SENSING_TYPE, "sensing", WIRE_SENSING_LEN},
+  {PKT_CALIB_TYPE,   "calib",   WIRE_CALIB_LEN},
+  {PKT_SCHED_TYPE,   "sched",   WIRE_SCHED_LEN},
+};
+
+static int benchFailed;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static void benchPacket(pkt_t *pPkt, pktType_t pktType);
+static void benchCmds(uint32 packets);
+static uint8 benchWalk(const uint8 *pBuf, uint8 len, const pkt_t *pPkts, uint8 num);
+static void benchFill(uint8 *p, uint8 len);
+static void benchFail(const char *test, const char *what, uint32 n);
+
+/**************************************************************************************************
+ * @fn          main
+ *
+ * @brief       Every type in turn, then the bytes and the packets to refuse.
+ **************************************************************************************************
+ */
+int main(int argc, char **argv)
+{
+  static const uint8 aliveBytes[] = {PKT_ALIVE_TYPE, WIRE_VER_HDR, 0x5A, 0x44, 0x33, 0x22, 0x11};
+  uint32 packets = BENCH_DEFAULT_PACKETS;
+  uint8 buf[BENCH_BUF_LEN];
+  uint8 t, len;
+  uint32 n;
+  pkt_t pkt, dec;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:r:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n': packets = strtoul(optarg, NULL, 0);      break;
+      case 'r': benchRandSeed(strtoul(optarg, NULL, 0)); break;
+      default:
+        fprintf(stderr, "usage: %s [-n packets] [-r seed]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  printf("wire version %u, header %u bytes\n", WIRE_VERSION, WIRE_HDR_LEN);
+  printf("%-9s %-9s %9s %9s\n", "test", "type", "packets", "bytes");
+
+  /* Round trip of every type */
+  for (t = 0; t < sizeof(benchTypes) / sizeof(benchTypes[0]); t++)
+  {
+    if (WIRE_Len(benchTypes[t].pktType) != benchTypes[t].len)
+    {
+      benchFail("roundtrip", "WIRE_Len()", benchTypes[t].pktType);
+    }
+    for (n = 0; n < packets; n++)
+    {
+      benchPacket(&pkt, benchTypes[t].pktType);
+      len = WIRE_Encode(&pkt, buf, sizeof(buf));
+      memset(&dec, 0xA5, sizeof(dec));
+      if ((len != benchTypes[t].len) || (buf[0] != pkt.pktType) || (buf[1] != WIRE_VER_HDR) ||
+          !WIRE_Decode(buf, len, &dec) || (memcmp(&dec, &pkt, sizeof(pkt_t)) != 0))
+      {
+        benchFail("roundtrip", "packet does not come back", n);
+      }
+    }
+    printf("%-9s %-9s %9u %9u\n", "roundtrip", benchTypes[t].name, packets, benchTypes[t].len);
+  }
+
+  /* Known bytes */
+  memset(&pkt, 0, sizeof(pkt));
+  pkt.pktType                   = PKT_ALIVE_TYPE;
+  pkt.pktPara.alivePara.nodeId  = 0x5A;
+  pkt.pktPara.alivePara.curTime = 0x11223344;
+  len = WIRE_Encode(&pkt, buf, sizeof(buf));
+  if ((len != sizeof(aliveBytes)) || (memcmp(buf, aliveBytes, len) != 0))
+  {
+    benchFail("bytes", "alive packet", len);
+  }
+  printf("%-9s %-9s %9u %9u\n", "bytes", "alive", 1, len);
+
+  /* Packets to refuse, and to take */
+  n = 0;
+  pkt.pktType = PKT_BATCH_TYPE;
+  if (WIRE_Encode(&pkt, buf, sizeof(buf)) != 0)
+  {
+    benchFail("refuse", "type without pkt_t parameters encoded", pkt.pktType);
+  }
+  benchPacket(&pkt, PKT_SENSING_TYPE);
+  if (WIRE_Encode(&pkt, buf, WIRE_SENSING_LEN - 1) != 0)
+  {
+    benchFail("refuse", "encoded in a buffer too small", WIRE_SENSING_LEN - 1);
+  }
+  len = WIRE_Encode(&pkt, buf, sizeof(buf));
+  if (WIRE_Decode(buf, len - 1, &dec))
+  {
+    benchFail("refuse", "packet cut short decoded", len - 1);
+  }
+  buf[1] = ((WIRE_VERSION + 1) << 4) | WIRE_HDR_LEN;
+  if (WIRE_Decode(buf, len, &dec) || (WIRE_HdrLen(buf, len) != 0))
+  {
+    benchFail("refuse", "other version decoded", buf[1]);
+  }
+  n += 4;
+  memmove(&buf[WIRE_HDR_LEN + 1], &buf[WIRE_HDR_LEN], len - WIRE_HDR_LEN);
+  buf[1] = (WIRE_VERSION << 4) | (WIRE_HDR_LEN + 1);
+  buf[WIRE_HDR_LEN] = 0xEE;
+  buf[len + 1] = 0xEE;
+  if (!WIRE_Decode(buf, len + 2, &dec) || (memcmp(&dec, &pkt, sizeof(pkt_t)) != 0))
+  {
+    benchFail("refuse", "longer header or parameters not skipped", len + 2);
+  }
+  n++;
+  printf("%-9s %-9s %9u %9s\n", "refuse", "sensing", n, "-");
+
+  benchCmds(packets);
+
+  if (benchFailed != 0)
+  {
+    printf("FAILED: %d checks\n", benchFailed);
+    return 1;
+  }
+  printf("all checks passed\n");
+  return 0;
+}
+
+/**************************************************************************************************
+ * @fn          benchPacket
+ *
+ * @brief       A packet of a type with the fields it sends drawn at random, the rest 0.
+ **************************************************************************************************
+ */
+static void benchPacket(pkt_t *pPkt, pktType_t pktType)
+{
+  memset(pPkt, 0, sizeof(pkt_t));
+  pPkt->pktType = pktType;
+  switch (pktType)
+  {
+    case PKT_ALIVE_TYPE:   WIRE_ALIVE_FIELDS(BENCH_FIELD)   break;
+    case PKT_SENSING_TYPE: WIRE_SENSING_FIELDS(BENCH_FIELD) break;
+    case PKT_CALIB_TYPE:   WIRE_CALIB_FIELDS(BENCH_FIELD)   break;
+    case PKT_SCHED_TYPE:   WIRE_SCHED_FIELDS(BENCH_FIELD)   break;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          benchCmds
+ *
+ * @brief       PKT_CMDS_TYPE packets: the answer of the gateway to a poll with both commands
+ *              waiting, the same in a frame too small for the second, and random ones filled
+ *              up to a frame.
+ **************************************************************************************************
+ */
+static void benchCmds(uint32 packets)
+{
+  pkt_t pkts[BENCH_BUF_LEN / WIRE_HDR_LEN];
+  uint8 buf[BENCH_BUF_LEN];
+  uint32 n, cmds = 0;
+  uint8 types = sizeof(benchTypes) / sizeof(benchTypes[0]);
+  uint8 len, next, num, cut;
+
+  /* Periods then calibration, in a frame with room for both and in one with room for one */
+  benchPacket(&pkts[0], PKT_SCHED_TYPE);
+  benchPacket(&pkts[1], PKT_CALIB_TYPE);
+  len = WIRE_CmdsAdd(&pkts[0], buf, 0, sizeof(buf));
+  len = WIRE_CmdsAdd(&pkts[1], buf, len, sizeof(buf));
+  if ((len != WIRE_HDR_LEN + 1 + WIRE_SCHED_LEN + 1 + WIRE_CALIB_LEN) ||
+      (benchWalk(buf, len, pkts, 2) != 2))
+  {
+    benchFail("cmds", "periods and calibration", len);
+  }
+  len = WIRE_CmdsAdd(&pkts[0], buf, 0, WIRE_HDR_LEN + 1 + WIRE_SCHED_LEN + WIRE_CALIB_LEN);
+  if ((WIRE_CmdsAdd(&pkts[1], buf, len, WIRE_HDR_LEN + 1 + WIRE_SCHED_LEN + WIRE_CALIB_LEN) != 0) ||
+      (benchWalk(buf, len, pkts, 1) != 1))
+  {
+    benchFail("cmds", "calibration added to a frame too small", len);
+  }
+  if ((WIRE_CmdsAdd(&pkts[0], buf, 0, WIRE_HDR_LEN - 1) != 0) ||
+      (WIRE_CmdsAdd(&pkts[0], buf, 0, WIRE_HDR_LEN + WIRE_SCHED_LEN) != 0))
+  {
+    benchFail("cmds", "periods added to a frame too small", 0);
+  }
+  cmds += 7;
+
+  /* Random packets up to a full frame, walked whole and cut short */
+  for (n = 0; n < packets; n++)
+  {
+    len = 0;
+    for (num = 0; ; num++)
+    {
+      benchPacket(&pkts[num], benchTypes[benchRand() % types].pktType);
+      next = WIRE_CmdsAdd(&pkts[num], buf, len, sizeof(buf));
+      if (next == 0)
+      {
+        break;
+      }
+      len = next;
+    }
+    cmds += num;
+    if (benchWalk(buf, len, pkts, num) != num)
+    {
+      benchFail("cmds", "packets walked", n);
+    }
+    if (num > 1)
+    {
+      /* Cut in the last packet: the ones before come back */
+      cut = len - 1 - benchRand() % WIRE_Len(pkts[num - 1].pktType);
+      if (benchWalk(buf, cut, pkts, num - 1) != num - 1)
+      {
+        benchFail("cmds", "packets before a cut", n);
+      }
+    }
+  }
+  buf[0] = PKT_SCHED_TYPE;
+  if (benchWalk(buf, len, pkts, 0) != 0)
+  {
+    benchFail("cmds", "packet of another type walked", 0);
+  }
+  printf("%-9s %-9s %9u %9u\n", "cmds", "mixed", cmds, BENCH_BUF_LEN);
+}
+
+/**************************************************************************************************
+ * @fn          benchWalk
+ *
+ * @brief       Walk a PKT_CMDS_TYPE packet; each packet must decode to the next of pPkts, and
+ *              there must be no more than num.
+ * @return      number of packets walked through
+ **************************************************************************************************
+ */
+static uint8 benchWalk(const uint8 *pBuf, uint8 len, const pkt_t *pPkts, uint8 num)
+{
+  const uint8 *pCmd;
+  uint8 off = 0, cmdLen;
+  uint8 i = 0;
+  pkt_t dec;
+
+  while ((pCmd = WIRE_CmdsNext(pBuf, len, &off, &cmdLen)) != NULL)
+  {
+    if ((i == num) || !WIRE_Decode(pCmd, cmdLen, &dec) ||
+        (memcmp(&dec, &pPkts[i], sizeof(pkt_t)) != 0))
+    {
+      return 0xFF;
+    }
+    i++;
+  }
+  return i;
+}
+
+/**************************************************************************************************
+ * @fn          benchFill
+ *
+ * @brief       Random bytes.
+ **************************************************************************************************
+ */
+static void benchFill(uint8 *p, uint8 len)
+{
+  while (len-- != 0)
+  {
+    *p++ = (uint8)benchRand();
+  }
+}
+
+/**************************************************************************************************
+ * @fn          benchFail
+ *
+ * @brief       Report a failed check; only the first few of a run are printed.
+ **************************************************************************************************
+ */
+static void benchFail(const char *test, const char *what, uint32 n)
+{
+  if (benchFailed++ < 10)
+  {
+    printf("MISMATCH: %s: %s (%u)\n", test, what, n);
+  }
+}
+
+/**************************************************************************************************
+ */
@@ -0,0 +1,604 @@
+/**************************************************************************************************
+  Filename:       frame_dec.c
+
+  Description:    Host decoder of the gateway UART stream: binary frames (libs/inc/frame.h)
+                  mixed with text lines.
+
+                  Bytes are pushed in as they come off the serial line, in pieces of any size.
+                  A frame starts with the two sync bytes and is only delivered when its CRC
+                  matches; after a bad CRC the search for the next frame starts again right
+                  after the first sync byte, so a corrupted length cannot swallow the frames
+                  behind it.  Everything outside a frame is text and is delivered line by
+                  line, the way the gateway prints it in GW_UART_TEXT mode.
+
+                  The payload is a packet in the wire format of wire.h, the same bytes
+                  whatever built the node, which wire.c decodes.  Nodes with older firmware
+                  sent the pkt_t as their compiler laid it out: 2 byte alignment on the MSP430
+                  and natural alignment in the 64-bit host simulation.  frameDecPkt() still
+                  takes those by their lengths, which differ for every packet type and from
+                  the wire format.  A PKT_BATCH_TYPE packet holds several sensing results;
+                  batch.c decodes it, frameDecPkts() gives all of them.  FRAME_TYPE_STATS
+                  frames, the link statistics the gateway sends when asked, are read by
+                  frameDecStats() instead.
+
+                  The other way, frameDecCommand() builds the commands of the PC that carry
+                  parameters.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "frame.h"
+#include "lstat.h"
+#include "packet.h"
+#include "batch.h"
+#include "wire.h"
+#include "frame_dec.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Typedefs
+ * ------------------------------------------------------------------------------------------------
+ */
+/* Where the fields of a pkt_t are for one ABI, -1 when the packet type does not have them */
+typedef struct
+{
+  uint8_t pktType;
+  uint8_t abi;
+  uint8_t len;
+  int8_t  nodeId;
+  int8_t  time;
+  int8_t  run;
+  int8_t  storeBlock;
+  int8_t  sensing;
+} frameDecLayout_t;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static const frameDecLayout_t frameDecLayouts[] =
+{
+  {PKT_ALIVE_TYPE,   FRAME_DEC_ABI_MSP430,  8, 2, 4, -1, -1, -1},
+  {PKT_SENSING_TYPE, FRAME_DEC_ABI_MSP430, 62, 2, 4,  8, 10, 12},
+  {PKT_ALIVE_TYPE,   FRAME_DEC_ABI_LP64,   12, 4, 8, -1, -1, -1},
+  {PKT_SENSING_TYPE, FRAME_DEC_ABI_LP64,   68, 4, 8, 12, 14, 16},
+};
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static void     frameDecByte(frameDec_t *pDec, uint8_t b);
+static void     frameDecText(frameDec_t *pDec, uint8_t b);
+static void     frameDecResync(frameDec_t *pDec);
+static void     frameDecDeliver(frameDec_t *pDec);
+static int      frameDecWire(const frameDecFrame_t *pFrame, frameDecPkt_t *pPkt);
+static int      frameDecBatch(const frameDecFrame_t *pFrame, frameDecPkt_t *pPkts, int max);
+static void     frameDecSensing(frameDecPkt_t *pPkt, const sensingPara_t *pPara);
+static uint16_t frameDecGet16(const uint8_t *p);
+static uint32_t frameDecGet32(const uint8_t *p);
+
+/**************************************************************************************************
+ * @fn          frameDecInit
+ *
+ * @brief       Start a decoder.  Either callback may be NULL.
+ **************************************************************************************************
+ */
+void frameDecInit(frameDec_t *pDec, frameDecFrameFn_t onFrame, frameDecTextFn_t onText, void *ctx)
+{
+  memset(pDec, 0, sizeof(*pDec));
+  pDec->onFrame = onFrame;
+  pDec->onText = onText;
+  pDec->ctx = ctx;
+}
+
+/**************************************************************************************************
+ * @fn          frameDecPush
+ *
+ * @brief       Bytes received from the gateway.
+ **************************************************************************************************
+ */
+void frameDecPush(frameDec_t *pDec, const uint8_t *pBuf, size_t len)
+{
+  while (len--)
+  {
+    frameDecByte(pDec, *pBuf++);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          frameDecFlush
+ *
+ * @brief       End of the stream: a partial frame is text and the last line is delivered.
+ **************************************************************************************************
+ */
+void frameDecFlush(frameDec_t *pDec)
+{
+  uint16_t i;
+
+  for (i = 0; i < pDec->bufLen; i++)
+  {
+    frameDecText(pDec, pDec->buf[i]);
+  }
+  pDec->bufLen = 0;
+  frameDecText(pDec, '\n');
+}
+
+/**************************************************************************************************
+ * @fn          frameDecPkt
+ *
+ * @brief       Unpack the pkt_t of a FRAME_TYPE_RECV frame, the first packet of a batch.
+ *              Returns 0 if the payload is not a packet type and length this decoder knows.
+ **************************************************************************************************
+ */
+int frameDecPkt(const frameDecFrame_t *pFrame, frameDecPkt_t *pPkt)
+{
+  const frameDecLayout_t *pLay = NULL;
+  const uint8_t *p = pFrame->payload;
+  uint8_t i;
+
+  memset(pPkt, 0, sizeof(*pPkt));
+  if ((pFrame->type != FRAME_TYPE_RECV) || (pFrame->len == 0))
+  {
+    return 0;
+  }
+  if (p[0] == PKT_BATCH_TYPE)
+  {
+    return frameDecBatch(pFrame, pPkt, 1);
+  }
+
+  for (i = 0; i < sizeof(frameDecLayouts) / sizeof(frameDecLayouts[0]); i++)
+  {
+    if ((frameDecLayouts[i].pktType == p[0]) && (frameDecLayouts[i].len == pFrame->len))
+    {
+      pLay = &frameDecLayouts[i];
+      break;
+    }
+  }
+  if (pLay == NULL)
+  {
+    return frameDecWire(pFrame, pPkt);
+  }
+
+  pPkt->pktType = pLay->pktType;
+  pPkt->abi = pLay->abi;
+  pPkt->nodeId = p[pLay->nodeId];
+  pPkt->time = frameDecGet32(&p[pLay->time]);
+
+  if (pLay->sensing >= 0)
+  {
+    const uint8_t *s = &p[pLay->sensing];
+
+    pPkt->run = frameDecGet16(&p[pLay->run]);
+    pPkt->storeBlock = frameDecGet16(&p[pLay->storeBlock]);
+    for (i = 0; i < 16; i++)
+    {
+      pPkt->pHAdc[i] = frameDecGet16(&s[2 * i]);
+    }
+    pPkt->vddAdcAvg = frameDecGet16(&s[32]);
+    pPkt->intTmpAdcAvg = frameDecGet16(&s[34]);
+    pPkt->pHAdcAvg = frameDecGet16(&s[36]);
+    pPkt->extTmpAdcAvg = frameDecGet16(&s[38]);
+    pPkt->vddVal = frameDecGet16(&s[40]);
+    pPkt->intTmpVal = frameDecGet16(&s[42]);
+    pPkt->pHVal = frameDecGet16(&s[44]);
+    pPkt->extTmpRes = frameDecGet16(&s[46]);
+    pPkt->extTmpVal = frameDecGet16(&s[48]);
+  }
+
+  return 1;
+}
+
+/**************************************************************************************************
+ * @fn          frameDecPkts
+ *
+ * @brief       Unpack every packet of a FRAME_TYPE_RECV frame: the alive packet and the records
+ *              of a batch, else the one pkt_t.  Returns how many, 0 if the payload is not known; pPkts[0] has the
+ *              packet type then.
+ **************************************************************************************************
+ */
+int frameDecPkts(const frameDecFrame_t *pFrame, frameDecPkt_t *pPkts, int max)
+{
+  if (max <= 0)
+  {
+    return 0;
+  }
+  if ((pFrame->type == FRAME_TYPE_RECV) && (pFrame->len != 0) &&
+      (pFrame->payload[0] == PKT_BATCH_TYPE))
+  {
+    memset(pPkts, 0, sizeof(*pPkts));
+    return frameDecBatch(pFrame, pPkts, max);
+  }
+  return frameDecPkt(pFrame, pPkts);
+}
+
+/**************************************************************************************************
+ * @fn          frameDecFormat
+ *
+ * @brief       One line of text for a packet of a frame, with the fields the gateway used to
+ *              print.  pPkt is what frameDecPkts() gave, NULL if it gave nothing.
+ **************************************************************************************************
+ */
+void frameDecFormat(const frameDecFrame_t *pFrame, const frameDecPkt_t *pPkt, char *pBuf,
+                    size_t size)
+{
+  int n;
+
+  n = snprintf(pBuf, size, "RECV: sAdd(%u) time: %u  rssi: %d  linkQuality: %u  seq: %u",
+               pFrame->srcAddr, pFrame->time, pFrame->rssi, pFrame->lqi, pFrame->seq);
+  if ((n < 0) || ((size_t)n >= size))
+  {
+    return;
+  }
+  pBuf += n;
+  size -= n;
+
+  if ((pPkt == NULL) || (pPkt->abi == FRAME_DEC_ABI_UNKNOWN))
+  {
+    snprintf(pBuf, size, "  type %u, %u bytes", (pFrame->len != 0) ? pFrame->payload[0] : 0,
+             pFrame->len);
+  }
+  else if (pPkt->pktType == PKT_ALIVE_TYPE)
+  {
+    snprintf(pBuf, size, "  ALIVE: node(%u) time: %u", pPkt->nodeId, pPkt->time);
+  }
+  else
+  {
+    snprintf(pBuf, size, "  SENSING: node(%u) time: %u  run: %u  store: %u  VDD: %u  iTMP: %u"
+             "  pH: %u  eTmpRES: %u  eTMP: %u", pPkt->nodeId, pPkt->time, pPkt->run,
+             pPkt->storeBlock, pPkt->vddVal, pPkt->intTmpVal, pPkt->pHVal, pPkt->extTmpRes,
+             pPkt->extTmpVal);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          frameDecStats
+ *
+ * @brief       Unpack the node records of a FRAME_TYPE_STATS frame, up to max.  Returns how many,
+ *              0 if the frame is not one.
+ **************************************************************************************************
+ */
+int frameDecStats(const frameDecFrame_t *pFrame, frameDecStat_t *pStats, int max)
+{
+  const uint8_t *p = &pFrame->payload[FRAME_STATS_HDR_LEN];
+  int n = 0;
+
+  if ((pFrame->type != FRAME_TYPE_STATS) || (pFrame->len < FRAME_STATS_HDR_LEN))
+  {
+    return 0;
+  }
+  while ((n < max) && (p + LSTAT_REC_LEN <= &pFrame->payload[pFrame->len]))
+  {
+    frameDecStat_t *pStat = &pStats[n++];
+
+    pStat->snapshot = pFrame->payload[0];
+    pStat->last = (pFrame->payload[1] & FRAME_STATS_LAST) != 0;
+    pStat->shortAddr = frameDecGet16(&p[0]);
+    pStat->rssi = (int8_t)p[2];
+    pStat->lqi = p[3];
+    pStat->frames = frameDecGet16(&p[4]);
+    pStat->dups = frameDecGet16(&p[6]);
+    pStat->alives = frameDecGet16(&p[8]);
+    pStat->lost = frameDecGet16(&p[10]);
+    pStat->jitter = frameDecGet16(&p[12]);
+    pStat->age = frameDecGet16(&p[14]);
+    p += LSTAT_REC_LEN;
+  }
+  return n;
+}
+
+/**************************************************************************************************
+ * @fn          frameDecFormatStat
+ *
+ * @brief       One line of text for the link statistics of a node.
+ **************************************************************************************************
+ */
+void frameDecFormatStat(const frameDecStat_t *pStat, char *pBuf, size_t size)
+{
+  snprintf(pBuf, size, "STATS: snapshot %u sAdd(%u) rssi: %d  linkQuality: %u  frames: %u"
+           "  dups: %u  alives: %u  lost: %u  jitter: %u ms  age: %u", pStat->snapshot,
+           pStat->shortAddr, pStat->rssi, pStat->lqi, pStat->frames, pStat->dups,
+           pStat->alives, pStat->lost, pStat->jitter, pStat->age);
+}
+
+/**************************************************************************************************
+ * @fn          frameDecCrc
+ *
+ * @brief       CRC-16/CCITT as CRC_Ccitt() computes it, bit by bit.
+ **************************************************************************************************
+ */
+uint16_t frameDecCrc(uint16_t crc, const uint8_t *pBuf, size_t len)
+{
+  uint8_t bit;
+
+  while (len--)
+  {
+    crc ^= (uint16_t)(*pBuf++) << 8;
+    for (bit = 0; bit < 8; bit++)
+    {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+/**************************************************************************************************
+ * @fn          frameDecCommand
+ *
+ * @brief       A command of the PC with parameters, as the gateway takes it: the command byte,
+ *              the parameters and their CRC.  pBuf has room for len + 3 bytes.
+ *
+ * @return      bytes written
+ **************************************************************************************************
+ */
+size_t frameDecCommand(uint8_t *pBuf, uint8_t cmd, const uint8_t *pParams, uint8_t len)
+{
+  uint16_t crc;
+
+  pBuf[0] = cmd;
+  memcpy(&pBuf[1], pParams, len);
+  crc = frameDecCrc(0xFFFF, pBuf, 1 + len);
+  pBuf[1 + len] = (uint8_t)crc;
+  pBuf[2 + len] = (uint8_t)(crc >> 8);
+  return 3 + len;
+}
+
+/**************************************************************************************************
+ * @fn          frameDecByte
+ **************************************************************************************************
+ */
+static void frameDecByte(frameDec_t *pDec, uint8_t b)
+{
+  switch (pDec->bufLen)
+  {
+    case 0:
+      if (b == FRAME_SYNC0)
+      {
+        pDec->buf[pDec->bufLen++] = b;
+      }
+      else
+      {
+        frameDecText(pDec, b);
+      }
+      return;
+
+    case 1:
+      if (b != FRAME_SYNC1)
+      {
+        pDec->bufLen = 0;
+        frameDecText(pDec, FRAME_SYNC0);
+        frameDecByte(pDec, b);
+        return;
+      }
+      break;
+
+    case 2:
+      if (b < FRAME_HDR_LEN)
+      {
+        pDec->buf[pDec->bufLen++] = b;
+        frameDecResync(pDec);
+        return;
+      }
+      break;
+  }
+
+  pDec->buf[pDec->bufLen++] = b;
+
+  if ((pDec->bufLen > 2) && (pDec->bufLen == 3 + pDec->buf[2] + 2))
+  {
+    uint16_t crc = frameDecCrc(0xFFFF, &pDec->buf[2], 1 + pDec->buf[2]);
+
+    if (crc == frameDecGet16(&pDec->buf[pDec->bufLen - 2]))
+    {
+      frameDecDeliver(pDec);
+      pDec->bufLen = 0;
+    }
+    else
+    {
+      pDec->crcErrors++;
+      frameDecResync(pDec);
+    }
+  }
+}
+
+/**************************************************************************************************
+ * @fn          frameDecResync
+ *
+ * @brief       The bytes held are not a frame: give up the first sync byte and look again in the
+ *              rest.
+ **************************************************************************************************
+ */
+static void frameDecResync(frameDec_t *pDec)
+{
+  uint8_t  rest[sizeof(pDec->buf)];
+  uint16_t len = pDec->bufLen - 1;
+
+  memcpy(rest, &pDec->buf[1], len);
+  pDec->bufLen = 0;
+  frameDecText(pDec, FRAME_SYNC0);
+  frameDecPush(pDec, rest, len);
+}
+
+/**************************************************************************************************
+ * @fn          frameDecDeliver
+ **************************************************************************************************
+ */
+static void frameDecDeliver(frameDec_t *pDec)
+{
+  frameDecFrame_t frame;
+  const uint8_t *p = &pDec->buf[3];
+
+  frame.type = p[0];
+  frame.seq = p[1];
+  frame.srcAddr = frameDecGet16(&p[2]);
+  frame.rssi = (int8_t)p[4];
+  frame.lqi = p[5];
+  frame.time = frameDecGet32(&p[6]);
+  frame.len = pDec->buf[2] - FRAME_HDR_LEN;
+  memcpy(frame.payload, &p[FRAME_HDR_LEN], frame.len);
+
+  if (pDec->seqValid)
+  {
+    pDec->lost += (uint8_t)(frame.seq - pDec->seqNext);
+  }
+  pDec->seqValid = 1;
+  pDec->seqNext = frame.seq + 1;
+  pDec->frames++;
+
+  if (pDec->onFrame != NULL)
+  {
+    pDec->onFrame(pDec->ctx, &frame);
+  }
+}
+
+/**************************************************************************************************
+ * @fn          frameDecBatch
+ *
+ * @brief       The records of a PKT_BATCH_TYPE payload, up to max, after the alive packet the
+ *              batch stands for if it carries one.  Records after a damaged one are lost.
+ **************************************************************************************************
+ */
+static int frameDecBatch(const frameDecFrame_t *pFrame, frameDecPkt_t *pPkts, int max)
+{
+  batch_t batch;
+  batchRec_t rec;
+  int n = 0;
+
+  pPkts[0].pktType = PKT_BATCH_TYPE;
+  if (!BATCH_DecodeStart(&batch, pFrame->payload, pFrame->len))
+  {
+    return 0;
+  }
+  if (BATCH_Alive(&batch, &pPkts[0].time))
+  {
+    pPkts[0].pktType = PKT_ALIVE_TYPE;
+    pPkts[0].abi = FRAME_DEC_ABI_PACKED;
+    pPkts[0].nodeId = batch.nodeId;
+    n++;
+  }
+  while ((n < max) && BATCH_DecodeNext(&batch, &rec))
+  {
+    frameDecPkt_t *pPkt = &pPkts[n++];
+
+    frameDecSensing(pPkt, &rec.para);
+    pPkt->fields = batch.fields;
+    pPkt->pHAdcMin = rec.pHAdcMin;
+    pPkt->pHAdcMax = rec.pHAdcMax;
+  }
+  return n;
+}
+
+/**************************************************************************************************
+ * @fn          frameDecWire
+ *
+ * @brief       A payload in the wire format of wire.h.
+ **************************************************************************************************
+ */
+static int frameDecWire(const frameDecFrame_t *pFrame, frameDecPkt_t *pPkt)
+{
+  pkt_t pkt;
+
+  pPkt->pktType = pFrame->payload[0];
+  if (!WIRE_Decode(pFrame->payload, pFrame->len, &pkt))
+  {
+    return 0;
+  }
+  if (pkt.pktType == PKT_SENSING_TYPE)
+  {
+    frameDecSensing(pPkt, &pkt.pktPara.sensingPara);
+  }
+  else if (pkt.pktType == PKT_ALIVE_TYPE)
+  {
+    pPkt->abi = FRAME_DEC_ABI_PACKED;
+    pPkt->nodeId = pkt.pktPara.alivePara.nodeId;
+    pPkt->time = pkt.pktPara.alivePara.curTime;
+  }
+  else
+  {
+    return 0;
+  }
+  return 1;
+}
+
+/**************************************************************************************************
+ * @fn          frameDecSensing
+ *
+ * @brief       A sensing result decoded by wire.c or batch.c.
+ **************************************************************************************************
+ */
+static void frameDecSensing(frameDecPkt_t *pPkt, const sensingPara_t *pPara)
+{
+  const sensing_t *s = &pPara->sensingData;
+  uint8_t i;
+
+  memset(pPkt, 0, sizeof(*pPkt));
+  pPkt->pktType = PKT_SENSING_TYPE;
+  pPkt->abi = FRAME_DEC_ABI_PACKED;
+  pPkt->nodeId = pPara->nodeId;
+  pPkt->time = pPara->time;
+  pPkt->run = pPara->run;
+  pPkt->storeBlock = pPara->storeBlock;
+  for (i = 0; i < 16; i++)
+  {
+    pPkt->pHAdc[i] = s->pHAdc[i];
+  }
+  pPkt->vddAdcAvg = s->vddAdcAvg;
+  pPkt->intTmpAdcAvg = s->intTmpAdcAvg;
+  pPkt->pHAdcAvg = s->pHAdcAvg;
+  pPkt->extTmpAdcAvg = s->extTmpAdcAvg;
+  pPkt->vddVal = s->vddVal;
+  pPkt->intTmpVal = s->intTmpVal;
+  pPkt->pHVal = s->pHVal;
+  pPkt->extTmpRes = s->extTmpRes;
+  pPkt->extTmpVal = s->extTmpVal;
+}
+
+/**************************************************************************************************
+ * @fn          frameDecText
+ *
+ * @brief       A byte outside any frame.  Lines are split at a newline or when they get too long,
+ *              and bytes that cannot be printed show as '.'.
+ **************************************************************************************************
+ */
+static void frameDecText(frameDec_t *pDec, uint8_t b)
+{
+  if ((b == '\n') || (pDec->lineLen == FRAME_DEC_LINE_LEN - 1))
+  {
+    if (pDec->lineLen != 0)
+    {
+      pDec->line[pDec->lineLen] = '\0';
+      pDec->lines++;
+      if (pDec->onText != NULL)
+      {
+        pDec->onText(pDec->ctx, pDec->line);
+      }
+    }
+    pDec->lineLen = 0;
+  }
+
+  if (b != '\n')
+  {
+    pDec->line[pDec->lineLen++] = ((b >= 0x20) && (b < 0x7F)) || (b == '\t') ? (char)b : '.';
+  }
+}
+
+/**************************************************************************************************
+ * @fn          frameDecGet16 / frameDecGet32
+ **************************************************************************************************
+ */
+static uint16_t frameDecGet16(const uint8_t *p)
+{
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t frameDecGet32(const uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**************************************************************************************************
+ */
@@ -0,0 +1,138 @@
+/**************************************************************************************************
+  Filename:       frame_dec.h
+
+  Description:    Host decoder of the gateway UART stream: binary frames (libs/inc/frame.h)
+                  mixed with text lines.
+**************************************************************************************************/
+
+#ifndef FRAME_DEC_H
+#define FRAME_DEC_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+#define FRAME_DEC_LINE_LEN        256   /* longer text lines are split */
+#define FRAME_DEC_TEXT_LEN        512   /* room for frameDecFormat() */
+#define FRAME_DEC_MAX_PKTS        64    /* records of a batch frameDecPkts() decodes at most */
+#define FRAME_DEC_MAX_STATS       16    /* node records of a FRAME_TYPE_STATS frame, at most */
+
+/* pkt_t layouts the payload can be in, told apart by the payload length */
+#define FRAME_DEC_ABI_UNKNOWN     0
+#define FRAME_DEC_ABI_MSP430      1     /* 2 byte alignment, the real nodes */
+#define FRAME_DEC_ABI_LP64        2     /* natural alignment, the host simulation */
+#define FRAME_DEC_ABI_PACKED      3     /* wire format of wire.h or a batch record, the same on
+                                           every node */
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Typedefs
+ * ------------------------------------------------------------------------------------------------
+ */
+typedef struct
+{
+  uint8_t  type;
+  uint8_t  seq;
+  uint16_t srcAddr;
+  int8_t   rssi;
+  uint8_t  lqi;
+  uint32_t time;
+  uint8_t  len;
+  uint8_t  payload[255];
+} frameDecFrame_t;
+
+/* pkt_t of packet.h in host order */
+typedef struct
+{
+  uint8_t  pktType;
+  uint8_t  abi;
+  uint8_t  nodeId;
+  uint32_t time;
+  uint16_t run;             /* sensing packets only from here on */
+  uint16_t storeBlock;
+  uint16_t pHAdc[16];
+  uint16_t vddAdcAvg;
+  uint16_t intTmpAdcAvg;
+  uint16_t pHAdcAvg;
+  uint16_t extTmpAdcAvg;
+  uint16_t vddVal;
+  uint16_t intTmpVal;
+  uint16_t pHVal;
+  uint16_t extTmpRes;
+  uint16_t extTmpVal;
+  uint8_t  fields;          /* batch records only: BATCH_xxx carried, and the pHAdc range */
+  uint16_t pHAdcMin;
+  uint16_t pHAdcMax;
+} frameDecPkt_t;
+
+/* Link statistics of a node, a record of a FRAME_TYPE_STATS frame (lstat.h) */
+typedef struct
+{
+  uint8_t  snapshot;
+  uint8_t  last;            /* the frame is the last of its snapshot */
+  uint16_t shortAddr;
+  int8_t   rssi;
+  uint8_t  lqi;
+  uint16_t frames;
+  uint16_t dups;
+  uint16_t alives;
+  uint16_t lost;
+  uint16_t jitter;          /* ms */
+  uint16_t age;             /* sticks */
+} frameDecStat_t;
+
+typedef void (*frameDecFrameFn_t)(void *ctx, const frameDecFrame_t *pFrame);
+typedef void (*frameDecTextFn_t)(void *ctx, const char *line);
+
+typedef struct
+{
+  frameDecFrameFn_t onFrame;
+  frameDecTextFn_t  onText;
+  void              *ctx;
+
+  uint8_t   buf[3 + 255 + 2];
+  uint16_t  bufLen;
+  char      line[FRAME_DEC_LINE_LEN];
+  uint16_t  lineLen;
+  int       seqValid;
+  uint8_t   seqNext;
+
+  uint32_t  frames;
+  uint32_t  crcErrors;
+  uint32_t  lost;           /* frames missing from the sequence numbers */
+  uint32_t  lines;
+} frameDec_t;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+extern void frameDecInit(frameDec_t *pDec, frameDecFrameFn_t onFrame, frameDecTextFn_t onText,
+                         void *ctx);
+extern void frameDecPush(frameDec_t *pDec, const uint8_t *pBuf, size_t len);
+extern void frameDecFlush(frameDec_t *pDec);
+extern int  frameDecPkt(const frameDecFrame_t *pFrame, frameDecPkt_t *pPkt);
+extern int  frameDecPkts(const frameDecFrame_t *pFrame, frameDecPkt_t *pPkts, int max);
+extern void frameDecFormat(const frameDecFrame_t *pFrame, const frameDecPkt_t *pPkt, char *pBuf,
+                           size_t size);
+extern int  frameDecStats(const frameDecFrame_t *pFrame, frameDecStat_t *pStats, int max);
+extern void frameDecFormatStat(const frameDecStat_t *pStat, char *pBuf, size_t size);
+extern uint16_t frameDecCrc(uint16_t crc, const uint8_t *pBuf, size_t len);
+extern size_t frameDecCommand(uint8_t *pBuf, uint8_t cmd, const uint8_t *pParams, uint8_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,620 @@
+/**************************************************************************************************
+  Filename:       sim_main.c
+
+  Description:    POSIX host simulation of an exp5438 network: one gateway and any number of
+                  sensor nodes running the unmodified applications on a virtual clock.
+
+                  spwm_sim [-n nodes] [-t seconds] [-s seed] [-r radius] [-v] [-m file]
+                           [-u file] [-q seconds] [-w channel,dBm,duty[,seconds]]
+                           [-c node,intTmp,extTmp,pH,slope[,seconds]]
+                           [-p sensing,alive,prepare[,seconds]]
+
+                  The gateway sits at the origin and its UART output is echoed with timestamps,
+                  its binary frames decoded by frame_dec.c into a line each; nodes are placed
+                  uniformly in a disc of the given radius and power up at random times during
+                  the first ten seconds.  With -v the nodes' UART output is echoed as well.
+                  With -m the gateway's OSAL heap trace is written to a file for bench_heap to
+                  replay, with -u its raw UART output for spwm_frames.  With -q the PC asks the
+                  gateway for its link statistics that often; the last snapshot is summed up
+                  at the end.  With -w an interferer comes up on a channel, the one the gateway
+                  is on then for channel 0, at that level and duty cycle, from the given time.
+                  With -c the PC sends the gateway a calibration for one node, by the short
+                  address the node has then, and the node takes it with its next poll.  With
+                  -p it sends new periods for all the nodes, in sticks.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hal_types.h"
+#include "hal_sim.h"
+#include "mac_sim.h"
+#include "packet.h"
+#include "frame.h"
+#include "frame_dec.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+#define SIM_DEFAULT_NODES         100
+#define SIM_DEFAULT_SECONDS       3600
+#define SIM_DEFAULT_RADIUS        30.0
+#define SIM_BOOT_SPREAD_US        (10 * HAL_SIM_USEC_PER_SEC)
+#define SIM_MAX_NODES             60000
+#define SIM_DEFAULT_CMD_AT        300       /* s, commands of the PC once the nodes are in */
+
+/* Current drawn by a node, MSP430F5438A at 8 MHz and CC2520, for the average printed at the end.
+ * The CPU is taken to run SIM_WAKE_US per wake-up and to sleep in LPM3 otherwise; the UART
+ * output of the nodes is for debugging and left out */
+#define SIM_SLEEP_UA              2.6       /* LPM3, CC2520 in LPM2 */
+#define SIM_ACTIVE_UA             2500.0
+#define SIM_WAKE_US               500.0
+#define SIM_ADC_UA                250.0     /* ADC12 on, 2.5 V reference and its output buffer */
+#define SIM_RX_UA                 18500.0
+#define SIM_TX_UA                 33600.0   /* +5 dBm */
+
+/* Sum of a link statistics snapshot of the gateway */
+typedef struct
+{
+  uint8   snapshot;
+  uint32  nodes;
+  uint32  frames;
+  uint32  dups;
+  uint32  alives;
+  uint32  lost;
+  double  rssi;           /* sums, for the means */
+  double  jitter;
+  uint16  worstAddr;      /* node with the most alive packets lost, by share */
+  double  worstLoss;
+} simLink_t;
+
+/* Interferer of -w */
+typedef struct
+{
+  uint8   channel;        /* 0 for the channel of the gateway */
+  int8    levelDbm;
+  uint8   dutyPct;
+} simInterf_t;
+
+/* Calibration of -c, the parameters of FRAME_CMD_CALIB but the node */
+typedef struct
+{
+  uint16  node;           /* 1 for node1 */
+  int16   intTmpOffset;
+  int16   extTmpOffset;
+  int16   pHOffset;
+  uint16  pHSlope;
+} simCalib_t;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Image Descriptors
+ * ------------------------------------------------------------------------------------------------
+ */
+extern const halSimImage_t halSimGatewayImage;
+extern const halSimImage_t halSimNodeImage;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static frameDec_t simGatewayDec;
+static FILE       *simGatewayCapture;
+static uint32     simSensingFrames;     /* frames with sensing results, and their payload */
+static uint32     simSensingBytes;
+static uint32     simSensingResults;
+static halSimTime_t simStatsPeriod;     /* -q, 0 if the statistics are not asked for */
+static simLink_t  simLinkNext;          /* snapshot being received */
+static simLink_t  simLinkLast;          /* last complete one */
+static simInterf_t simInterf;           /* -w */
+static simCalib_t simCalib;             /* -c */
+static uint16     simSched[3];          /* -p, the parameters of FRAME_CMD_SCHED */
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static void   simUsage(const char *prog);
+static double simUniform(void);
+static double simWallClock(void);
+static void   simPrintStats(double wallSeconds);
+static void   simGatewayUart(uint16 dev, const uint8 *pBuf, uint16 len);
+static void   simGatewayFrame(void *ctx, const frameDecFrame_t *pFrame);
+static void   simGatewayText(void *ctx, const char *line);
+static void   simGatewayStats(const frameDecFrame_t *pFrame);
+static void   simStatsAsk(uint16 dev, void *arg);
+static void   simInterfOn(uint16 dev, void *arg);
+static void   simCalibSend(uint16 dev, void *arg);
+static void   simSchedSend(uint16 dev, void *arg);
+static void   simCommand(uint16 dev, uint8 cmd, const uint16 *pParams, uint8 num);
+
+/**************************************************************************************************
+ * @fn          main
+ *
+ * @brief       Parse the command line, build the network and run it.
+ **************************************************************************************************
+ */
+int main(int argc, char **argv)
+{
+  unsigned long nodes = SIM_DEFAULT_NODES;
+  unsigned long seconds = SIM_DEFAULT_SECONDS;
+  unsigned long seed = (unsigned long)time(NULL);
+  double radius = SIM_DEFAULT_RADIUS;
+  bool verbose = FALSE;
+  const char *heapTrace = NULL;
+  const char *uartCapture = NULL;
+  unsigned long interfAt = 0;
+  int ch = -1, level = 0, duty = 0;
+  unsigned long calibAt = SIM_DEFAULT_CMD_AT;
+  int calib[5], calibArgs = 0;
+  unsigned long schedAt = SIM_DEFAULT_CMD_AT;
+  int sched[3], schedArgs = 0;
+  uint16 gateway, dev;
+  unsigned long i;
+  double start;
+  char name[16];
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:t:s:r:vm:u:q:w:c:p:h")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n': nodes = strtoul(optarg, NULL, 0);   break;
+      case 't': seconds = strtoul(optarg, NULL, 0); break;
+      case 's': seed = strtoul(optarg, NULL, 0);    break;
+      case 'r': radius = atof(optarg);              break;
+      case 'v': verbose = TRUE;                     break;
+      case 'm': heapTrace = optarg;                 break;
+      case 'u': uartCapture = optarg;               break;
+      case 'q': simStatsPeriod = strtoul(optarg, NULL, 0) * HAL_SIM_USEC_PER_SEC; break;
+      case 'w':
+        if (sscanf(optarg, "%d,%d,%d,%lu", &ch, &level, &duty, &interfAt) < 3)
+        {
+          ch = MAC_SIM_CHAN_FIRST + MAC_SIM_CHAN_NUM;
+        }
+        break;
+      case 'c':
+        calibArgs = sscanf(optarg, "%d,%d,%d,%d,%d,%lu", &calib[0], &calib[1], &calib[2],
+                           &calib[3], &calib[4], &calibAt);
+        break;
+      case 'p':
+        schedArgs = sscanf(optarg, "%d,%d,%d,%lu", &sched[0], &sched[1], &sched[2], &schedAt);
+        break;
+      default:  simUsage(argv[0]);                  return 1;
+    }
+  }
+
+  if ((nodes > SIM_MAX_NODES) || (radius <= 0.0) ||
+      (ch < -1) || ((ch > 0) && ((ch < MAC_SIM_CHAN_FIRST) || (ch >= MAC_SIM_CHAN_FIRST + MAC_SIM_CHAN_NUM))) ||
+      (level < -128) || (level > 0) || (duty < 0) || (duty > 100) ||
+      ((calibArgs != 0) && ((calibArgs < 5) || (calib[0] <= 0) || ((unsigned long)calib[0] > nodes) ||
+                            (calib[4] <= 0) || (calib[4] > 0xFFFF))) ||
+      ((schedArgs != 0) && ((schedArgs < 3) || (sched[0] <= 0) || (sched[0] > 0xFFFF) ||
+                            (sched[1] <= 0) || (sched[1] > 0xFFFF) || (sched[2] < 0) ||
+                            (sched[2] >= sched[0]))))
+  {
+    simUsage(argv[0]);
+    return 1;
+  }
+
+  printf("sim: %lu nodes within %.1f m, %lu s, seed %lu\n", nodes, radius, seconds, seed);
+
+  halSimInit((uint16)(nodes + 1), (uint32)seed);
+  macSimChanInit((uint16)(nodes + 1));
+
+  gateway = halSimAddDevice(&halSimGatewayImage, "gateway");
+  macSimChanPlace(gateway, 0.0, 0.0);
+  halSimUartTap(gateway, simGatewayUart);
+  frameDecInit(&simGatewayDec, simGatewayFrame, simGatewayText, NULL);
+  if ((uartCapture != NULL) && ((simGatewayCapture = fopen(uartCapture, "wb")) == NULL))
+  {
+    perror(uartCapture);
+    return 1;
+  }
+  if ((heapTrace != NULL) && !halSimHeapTraceOpen(gateway, heapTrace))
+  {
+    perror(heapTrace);
+    return 1;
+  }
+  halSimBoot(gateway, 0);
+  if (simStatsPeriod != 0)
+  {
+    halSimSchedule(simStatsPeriod, gateway, simStatsAsk, NULL);
+  }
+  if (ch != -1)
+  {
+    simInterf.channel = (uint8)ch;
+    simInterf.levelDbm = (int8)level;
+    simInterf.dutyPct = (uint8)duty;
+    halSimSchedule((halSimTime_t)interfAt * HAL_SIM_USEC_PER_SEC, gateway, simInterfOn, NULL);
+  }
+  if (calibArgs != 0)
+  {
+    simCalib.node = (uint16)calib[0];
+    simCalib.intTmpOffset = (int16)calib[1];
+    simCalib.extTmpOffset = (int16)calib[2];
+    simCalib.pHOffset = (int16)calib[3];
+    simCalib.pHSlope = (uint16)calib[4];
+    halSimSchedule((halSimTime_t)calibAt * HAL_SIM_USEC_PER_SEC, gateway, simCalibSend, NULL);
+  }
+  if (schedArgs != 0)
+  {
+    for (i = 0; i < 3; i++)
+    {
+      simSched[i] = (uint16)sched[i];
+    }
+    halSimSchedule((halSimTime_t)schedAt * HAL_SIM_USEC_PER_SEC, gateway, simSchedSend, NULL);
+  }
+
+  for (i = 0; i < nodes; i++)
+  {
+    double r = radius * sqrt(simUniform());
+    double a = 2.0 * M_PI * simUniform();
+
+    snprintf(name, sizeof(name), "node%lu", i + 1);
+    dev = halSimAddDevice(&halSimNodeImage, name);
+    macSimChanPlace(dev, r * cos(a), r * sin(a));
+    halSimUartEcho(dev, verbose);
+    halSimBoot(dev, (halSimTime_t)(simUniform() * SIM_BOOT_SPREAD_US));
+  }
+
+  start = simWallClock();
+  halSimRunUntil((halSimTime_t)seconds * HAL_SIM_USEC_PER_SEC);
+  simPrintStats(simWallClock() - start);
+  halSimHeapTraceClose();
+  if (simGatewayCapture != NULL)
+  {
+    fclose(simGatewayCapture);
+  }
+
+  return 0;
+}
+
+/**************************************************************************************************
+ * @fn          simUsage
+ **************************************************************************************************
+ */
+static void simUsage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [-n nodes] [-t seconds] [-s seed] [-r radius] [-v] [-m file]"
+                  " [-u file] [-q seconds]\n"
+                  "       [-w channel,dBm,duty[,seconds]] [-c node,intTmp,extTmp,pH,slope[,seconds]]\n"
+                  "       [-p sensing,alive,prepare[,seconds]]\n"
+                  "  -n  number of sensor nodes (default %d, at most %d)\n"
+                  "  -t  virtual time to simulate in seconds (default %d)\n"
+                  "  -s  random seed (default: time of day)\n"
+                  "  -r  radius of the disc the nodes are placed in, metres (default %.0f)\n"
+                  "  -v  echo the UART output of the nodes too\n"
+                  "  -m  write the OSAL heap trace of the gateway to a file\n"
+                  "  -u  write the raw UART output of the gateway to a file\n"
+                  "  -q  ask the gateway for its link statistics every so many seconds\n"
+                  "  -w  interferer on a channel, 0 for the gateway's, its level, its duty cycle\n"
+                  "      in percent and the time it comes up (default 0)\n"
+                  "  -c  calibration for a node, 1 for node1: offsets of the internal\n"
+                  "      and external temperature and of the pH probe in mV, pH slope in\n"
+                  "      0.2 mV/pH, and the time the PC sends it (default %d)\n"
+                  "  -p  periods of the nodes in sticks: between measurements, between alive\n"
+                  "      packets, of the sensors up before a measurement, and the time the PC\n"
+                  "      sends them (default %d)\n",
+          prog, SIM_DEFAULT_NODES, SIM_MAX_NODES, SIM_DEFAULT_SECONDS, SIM_DEFAULT_RADIUS,
+          SIM_DEFAULT_CMD_AT, SIM_DEFAULT_CMD_AT);
+}
+
+/**************************************************************************************************
+ * @fn          simUniform
+ *
+ * @brief       Uniform variate in [0, 1) from the simulation's generator, so a seed reproduces
+ *              the placement too.
+ **************************************************************************************************
+ */
+static double simUniform(void)
+{
+  return (double)halSimRand() / 65536.0;
+}
+
+/**************************************************************************************************
+ * @fn          simWallClock
+ **************************************************************************************************
+ */
+static double simWallClock(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**************************************************************************************************
+ * @fn          simPrintStats
+ *
+ * @brief       Totals per image, the radio channel totals and the speed of the run.
+ **************************************************************************************************
+ */
+static void simPrintStats(double wallSeconds)
+{
+  const halSimImage_t *images[2] = {&halSimGatewayImage, &halSimNodeImage};
+  double virtSeconds = (double)halSimNow() / HAL_SIM_USEC_PER_SEC;
+  uint16 dev;
+  uint8 i;
+
+  fflush(stdout);
+  printf("\n");
+
+  for (i = 0; i < 2; i++)
+  {
+    halSimDevStats_t total;
+    halSimTime_t rx, tx;
+    double rxUs = 0.0, txUs = 0.0, adcMs = 0.0;
+    uint32 count = 0;
+    uint32 stateSize = 0;
+
+    memset(&total, 0, sizeof(total));
+    for (dev = 0; dev < halSimNumDevices(); dev++)
+    {
+      const halSimDevStats_t *p = halSimStats(dev);
+
+      if (strncmp(halSimDevName(dev), images[i]->name, strlen(images[i]->name)) != 0)
+      {
+        continue;
+      }
+      count++;
+      stateSize = halSimStateSize(dev);
+      total.boots += p->boots;
+      total.wakeups += p->wakeups;
+      total.sleeps += p->sleeps;
+      total.uartBytes += p->uartBytes;
+      total.uartDrops += p->uartDrops;
+      total.framSelects += p->framSelects;
+      total.framBytes += p->framBytes;
+      adcMs += p->adcOnMs;
+      macSimChanRadioTime(dev, &rx, &tx);
+      rxUs += (double)rx;
+      txUs += (double)tx;
+    }
+
+    if (count != 0)
+    {
+      printf("%-8s x%-5u state %u B, boots %u, wakeups %u, sleeps %u, uart %u B, uart drops %u, "
+             "fram %u B in %u commands\n", images[i]->name, count, stateSize, total.boots,
+             total.wakeups, total.sleeps, total.uartBytes, total.uartDrops, total.framBytes,
+             total.framSelects);
+    }
+    if ((count != 0) && (images[i] == &halSimNodeImage) && (virtSeconds > 0.0))
+    {
+      double us = virtSeconds * HAL_SIM_USEC_PER_SEC * count;
+      double cpu = total.wakeups * SIM_WAKE_US * SIM_ACTIVE_UA / us;
+      double adc = adcMs * 1000.0 * SIM_ADC_UA / us;
+      double rxUa = rxUs * SIM_RX_UA / us;
+      double txUa = txUs * SIM_TX_UA / us;
+
+      printf("%-8s average current %.2f uA: sleep %.2f, CPU %.2f, ADC %.2f, radio rx %.2f, "
+             "tx %.2f\n", images[i]->name, SIM_SLEEP_UA + cpu + adc + rxUa + txUa, SIM_SLEEP_UA,
+             cpu, adc, rxUa, txUa);
+    }
+  }
+
+  printf("gateway  frames %u, CRC errors %u, lost %u\n", simGatewayDec.frames,
+         simGatewayDec.crcErrors, simGatewayDec.lost);
+  printf("gateway  sensing results %u in %u frames, %u B of payload, %.1f B per result\n",
+         simSensingResults, simSensingFrames, simSensingBytes,
+         (simSensingResults != 0) ? (double)simSensingBytes / simSensingResults : 0.0);
+  if (simLinkLast.nodes != 0)
+  {
+    uint32 sent = simLinkLast.alives + simLinkLast.lost;
+
+    printf("gateway  link snapshot %u: %u devices, %u frames, %u dups, alives %u of %u (%.2f%%), "
+           "rssi %.1f dBm, jitter %.1f ms, worst sAdd(%u) %.1f%% lost\n", simLinkLast.snapshot,
+           simLinkLast.nodes, simLinkLast.frames, simLinkLast.dups, simLinkLast.alives, sent,
+           (sent != 0) ? 100.0 * simLinkLast.alives / sent : 0.0,
+           simLinkLast.rssi / simLinkLast.nodes, simLinkLast.jitter / simLinkLast.nodes,
+           simLinkLast.worstAddr, 100.0 * simLinkLast.worstLoss);
+  }
+
+  macSimChanPrintStats();
+
+  printf("sim: %.0f s virtual in %.2f s wall (x%.0f), %u events\n", virtSeconds, wallSeconds,
+         (wallSeconds > 0.0) ? virtSeconds / wallSeconds : 0.0, halSimEventCount());
+}
+
+/**************************************************************************************************
+ * @fn          simGatewayUart
+ *
+ * @brief       UART tap of the gateway: capture the bytes and decode them for the echo.
+ **************************************************************************************************
+ */
+static void simGatewayUart(uint16 dev, const uint8 *pBuf, uint16 len)
+{
+  (void)dev;
+
+  if (simGatewayCapture != NULL)
+  {
+    fwrite(pBuf, 1, len, simGatewayCapture);
+  }
+  frameDecPush(&simGatewayDec, pBuf, len);
+}
+
+/**************************************************************************************************
+ * @fn          simGatewayFrame / simGatewayText
+ *
+ * @brief       Echo of the gateway, prefixed like the lines halSimUartOut() echoes.
+ **************************************************************************************************
+ */
+static void simGatewayFrame(void *ctx, const frameDecFrame_t *pFrame)
+{
+  static frameDecPkt_t pkts[FRAME_DEC_MAX_PKTS];
+  char line[FRAME_DEC_TEXT_LEN];
+  int n, i;
+
+  if (pFrame->type == FRAME_TYPE_STATS)
+  {
+    simGatewayStats(pFrame);
+    return;
+  }
+
+  n = frameDecPkts(pFrame, pkts, FRAME_DEC_MAX_PKTS);
+  if ((n != 0) && (pkts[n - 1].pktType == PKT_SENSING_TYPE))
+  {
+    simSensingFrames++;
+    simSensingBytes += pFrame->len;
+    simSensingResults += (pkts[0].pktType == PKT_SENSING_TYPE) ? n : n - 1;
+  }
+
+  i = 0;
+  do
+  {
+    frameDecFormat(pFrame, (n != 0) ? &pkts[i] : NULL, line, sizeof(line));
+    simGatewayText(ctx, line);
+  } while (++i < n);
+}
+
+static void simGatewayText(void *ctx, const char *line)
+{
+  (void)ctx;
+  printf("%10.3f %-8s %s\n", (double)halSimNow() / HAL_SIM_USEC_PER_SEC, "gateway", line);
+}
+
+/**************************************************************************************************
+ * @fn          simGatewayStats
+ *
+ * @brief       Echo the node records of a statistics frame and sum them up; the last frame of a
+ *              snapshot makes it the one printed at the end.
+ **************************************************************************************************
+ */
+static void simGatewayStats(const frameDecFrame_t *pFrame)
+{
+  frameDecStat_t stats[FRAME_DEC_MAX_STATS];
+  char line[FRAME_DEC_TEXT_LEN];
+  double loss;
+  int n, i;
+
+  n = frameDecStats(pFrame, stats, FRAME_DEC_MAX_STATS);
+  if ((pFrame->len >= FRAME_STATS_HDR_LEN) && (pFrame->payload[0] != simLinkNext.snapshot))
+  {
+    memset(&simLinkNext, 0, sizeof(simLinkNext));
+    simLinkNext.snapshot = pFrame->payload[0];
+  }
+
+  for (i = 0; i < n; i++)
+  {
+    frameDecFormatStat(&stats[i], line, sizeof(line));
+    simGatewayText(NULL, line);
+
+    simLinkNext.nodes++;
+    simLinkNext.frames += stats[i].frames;
+    simLinkNext.dups += stats[i].dups;
+    simLinkNext.alives += stats[i].alives;
+    simLinkNext.lost += stats[i].lost;
+    simLinkNext.rssi += stats[i].rssi;
+    simLinkNext.jitter += stats[i].jitter;
+    loss = (stats[i].alives + stats[i].lost != 0) ?
+           (double)stats[i].lost / (stats[i].alives + stats[i].lost) : 0.0;
+    if ((simLinkNext.nodes == 1) || (loss > simLinkNext.worstLoss))
+    {
+      simLinkNext.worstAddr = stats[i].shortAddr;
+      simLinkNext.worstLoss = loss;
+    }
+  }
+
+  if ((pFrame->len >= FRAME_STATS_HDR_LEN) && (pFrame->payload[1] & FRAME_STATS_LAST))
+  {
+    simLinkLast = simLinkNext;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          simStatsAsk
+ *
+ * @brief       The PC sends the gateway FRAME_CMD_STATS, and again after -q seconds.
+ **************************************************************************************************
+ */
+static void simStatsAsk(uint16 dev, void *arg)
+{
+  static const uint8 cmd = FRAME_CMD_STATS;
+
+  (void)arg;
+
+  halSimUartIn(dev, &cmd, 1);
+  halSimSchedule(halSimNow() + simStatsPeriod, dev, simStatsAsk, NULL);
+}
+
+/**************************************************************************************************
+ * @fn          simCalibSend
+ *
+ * @brief       The PC sends the gateway the FRAME_CMD_CALIB of -c.
+ **************************************************************************************************
+ */
+static void simCalibSend(uint16 dev, void *arg)
+{
+  const uint16 fields[5] = {macSimChanShortOf(simCalib.node), (uint16)simCalib.intTmpOffset,
+                            (uint16)simCalib.extTmpOffset, (uint16)simCalib.pHOffset,
+                            simCalib.pHSlope};
+
+  (void)arg;
+
+  printf("%10.3f %-8s calibration for node%u, short address %u\n",
+         (double)halSimNow() / HAL_SIM_USEC_PER_SEC, "sim", simCalib.node, fields[0]);
+  simCommand(dev, FRAME_CMD_CALIB, fields, 5);
+}
+
+/**************************************************************************************************
+ * @fn          simSchedSend
+ *
+ * @brief       The PC sends the gateway the FRAME_CMD_SCHED of -p.
+ **************************************************************************************************
+ */
+static void simSchedSend(uint16 dev, void *arg)
+{
+  (void)arg;
+
+  printf("%10.3f %-8s periods %u, %u, %u sticks\n", (double)halSimNow() / HAL_SIM_USEC_PER_SEC,
+         "sim", simSched[0], simSched[1], simSched[2]);
+  simCommand(dev, FRAME_CMD_SCHED, simSched, 3);
+}
+
+/**************************************************************************************************
+ * @fn          simCommand
+ *
+ * @brief       A command of the PC with 16 bit parameters onto the UART of the gateway.
+ **************************************************************************************************
+ */
+static void simCommand(uint16 dev, uint8 cmd, const uint16 *pParams, uint8 num)
+{
+  uint8 params[FRAME_CMD_MAX_LEN];
+  uint8 buf[FRAME_CMD_MAX_LEN + 3];
+  uint8 i;
+
+  for (i = 0; i < num; i++)
+  {
+    params[2 * i] = (uint8)pParams[i];
+    params[2 * i + 1] = (uint8)(pParams[i] >> 8);
+  }
+  halSimUartIn(dev, buf, (uint16)frameDecCommand(buf, cmd, params, 2 * num));
+}
+
+/**************************************************************************************************
+ * @fn          simInterfOn
+ *
+ * @brief       The interferer of -w comes up.
+ **************************************************************************************************
+ */
+static void simInterfOn(uint16 dev, void *arg)
+{
+  uint8 ch = (simInterf.channel != 0) ? simInterf.channel : macSimChanOf(dev);
+
+  (void)arg;
+
+  macSimChanInterf(ch, simInterf.levelDbm, simInterf.dutyPct);
+  printf("%10.3f %-8s interferer on channel %u, %d dBm, %u%%\n",
+         (double)halSimNow() / HAL_SIM_USEC_PER_SEC, "sim", ch, simInterf.levelDbm, simInterf.dutyPct);
+}
+
+/**************************************************************************************************
+ */
@@ -0,0 +1,156 @@
+/**************************************************************************************************
+  Filename:       spwm_frames.c
+
+  Description:    Decode what the gateway sends over its UART.
+
+                  spwm_frames [-c] [-t] [file]
+
+                  Reads a capture of the gateway's serial output from the file, or from stdin
+                  so a serial port can be piped in, and prints a line per frame in the words of
+                  the old text output, or one per result of a batch, and a STATS line per node
+                  of the link statistics the gateway sends when asked.  With -c the results are
+                  printed as CSV instead, one column per field, without the statistics.  Text
+                  lines the gateway prints between the frames are shown
+                  too unless -t is given.  The number of frames, CRC errors and frames missing
+                  from the sequence numbers go to stderr at the end; the exit status is 1 if
+                  there were any CRC errors.
+
+                  spwm_sim -u writes the capture of a simulated gateway.
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "frame.h"
+#include "frame_dec.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static int framesCsv;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static void framesOnFrame(void *ctx, const frameDecFrame_t *pFrame);
+static void framesOnText(void *ctx, const char *line);
+
+/**************************************************************************************************
+ * @fn          main
+ **************************************************************************************************
+ */
+int main(int argc, char **argv)
+{
+  frameDec_t dec;
+  uint8_t buf[4096];
+  int showText = 1;
+  FILE *in = stdin;
+  size_t n;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "cth")) != -1)
+  {
+    switch (opt)
+    {
+      case 'c': framesCsv = 1; break;
+      case 't': showText = 0;  break;
+      default:
+        fprintf(stderr, "usage: %s [-c] [-t] [file]\n"
+                        "  -c  print the frames as CSV\n"
+                        "  -t  do not print the text lines between the frames\n", argv[0]);
+        return 1;
+    }
+  }
+
+  if ((optind < argc) && ((in = fopen(argv[optind], "rb")) == NULL))
+  {
+    perror(argv[optind]);
+    return 1;
+  }
+
+  if (framesCsv)
+  {
+    printf("seq,src,rssi,lqi,gwtime,type,node,time,run,store,vdd,itmp,ph,etmpres,etmp\n");
+  }
+
+  frameDecInit(&dec, framesOnFrame, showText ? framesOnText : NULL, NULL);
+  while ((n = fread(buf, 1, sizeof(buf), in)) != 0)
+  {
+    frameDecPush(&dec, buf, n);
+  }
+  frameDecFlush(&dec);
+
+  fprintf(stderr, "%u frames, %u CRC errors, %u lost, %u text lines\n", dec.frames,
+          dec.crcErrors, dec.lost, dec.lines);
+
+  return (dec.crcErrors != 0) ? 1 : 0;
+}
+
+/**************************************************************************************************
+ * @fn          framesOnFrame
+ **************************************************************************************************
+ */
+static void framesOnFrame(void *ctx, const frameDecFrame_t *pFrame)
+{
+  static frameDecPkt_t pkts[FRAME_DEC_MAX_PKTS];
+  frameDecStat_t stats[FRAME_DEC_MAX_STATS];
+  char line[FRAME_DEC_TEXT_LEN];
+  const frameDecPkt_t *pPkt;
+  int n, i;
+
+  (void)ctx;
+
+  /* a line for each node of a statistics snapshot, none in the CSV */
+  if (pFrame->type == FRAME_TYPE_STATS)
+  {
+    n = frameDecStats(pFrame, stats, FRAME_DEC_MAX_STATS);
+    for (i = 0; (i < n) && !framesCsv; i++)
+    {
+      frameDecFormatStat(&stats[i], line, sizeof(line));
+      printf("%s\n", line);
+    }
+    return;
+  }
+
+  /* a line, or a row, for each result of a batch */
+  n = frameDecPkts(pFrame, pkts, FRAME_DEC_MAX_PKTS);
+  i = 0;
+  do
+  {
+    pPkt = &pkts[i];
+    if (!framesCsv)
+    {
+      frameDecFormat(pFrame, (n != 0) ? pPkt : NULL, line, sizeof(line));
+      printf("%s\n", line);
+      continue;
+    }
+    printf("%u,%u,%d,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n", pFrame->seq, pFrame->srcAddr,
+           pFrame->rssi, pFrame->lqi, pFrame->time, pPkt->pktType, pPkt->nodeId, pPkt->time,
+           pPkt->run, pPkt->storeBlock, pPkt->vddVal, pPkt->intTmpVal, pPkt->pHVal,
+           pPkt->extTmpRes, pPkt->extTmpVal);
+  } while (++i < n);
+}
+
+/**************************************************************************************************
+ * @fn          framesOnText
+ **************************************************************************************************
+ */
+static void framesOnText(void *ctx, const char *line)
+{
+  (void)ctx;
+
+  if (!framesCsv)
+  {
+    printf("%s\n", line);
+  }
+}
+
+/**************************************************************************************************
+ */
@@ -0,0 +1,86 @@
+#ifndef __BATCH_H
+#define __BATCH_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "hal_types.h"
+#include "packet.h"
+#include "wire.h"
+
+/***************************/
+/* PKT_BATCH_TYPE packet: the results of several sensing periods of one node in one frame, in
+ * the same bytes on every compiler.
+ *   0  pktType   PKT_BATCH_TYPE
+ *   1  WIRE_VER_HDR, the header of every packet (wire.h)
+ *   2  nodeId
+ *   3  fields    BATCH_xxx, what every record carries, and BATCH_ALIVE
+ *   4  count     number of records
+ *   5  with BATCH_ALIVE, the time of the node as a varint: the batch is its alive packet too
+ *      records, each a run of varints: time, run and storeBlock, then the values of the
+ *      fields in the order of their bits
+ * Every value is sent as its change from the same value in the record before, the first
+ * record against zeros; a raw sample after the first is against the sample before it.  A
+ * change is zigzag coded (0, -1, 1, -2 .. as 0, 1, 2, 3 ..) and written 7 bits to a byte, low
+ * bits first, bit 7 set on all but the last byte.  Results a few counts apart take one byte a
+ * value.
+ */
+#define BATCH_DERIVED             0x01  /* vddVal intTmpVal pHVal extTmpRes extTmpVal */
+#define BATCH_MEAN                0x02  /* vddAdcAvg intTmpAdcAvg pHAdcAvg extTmpAdcAvg */
+#define BATCH_MINMAX              0x04  /* smallest and largest of pHAdc */
+#define BATCH_RAW                 0x08  /* pHAdc[16] */
+#define BATCH_FIELDS              0x0F
+#define BATCH_ALIVE               0x80  /* the header carries what PKT_ALIVE_TYPE would */
+
+#define BATCH_HDR_LEN             (WIRE_HDR_LEN + 3)
+#define BATCH_MAX_VALS            (2 + 5 + 4 + 2 + 16)  /* 16 bit values of a record */
+
+/* A record as decoded; what the fields of the batch leave out is 0 */
+typedef struct{
+  sensingPara_t para;
+  uint16        pHAdcMin;
+  uint16        pHAdcMax;
+} batchRec_t;
+
+/* Encoder, and decoder, state: the values of the record before */
+typedef struct{
+  uint8         *pBuf;
+  const uint8   *pIn;
+  uint8         size;
+  uint8         len;
+  uint8         nodeId;
+  uint8         fields;
+  uint8         count;
+  uint8         left;                   /* records still to decode */
+  bool          alive;
+  uint32        aliveTime;
+  uint32        prevTime;
+  uint16        prev[BATCH_MAX_VALS];
+} batch_t;
+
+/****  FUNCTIONs  ****/
+/* Start a batch in pBuf, of 'size' bytes at most */
+void    BATCH_Start(batch_t *pBatch, uint8 *pBuf, uint8 size, uint8 nodeId, uint8 fields);
+/* Make the batch the alive packet of the node as well, before any record is added; FALSE if
+ * it does not fit */
+bool    BATCH_SetAlive(batch_t *pBatch, uint32 time);
+/* Add a record; FALSE if it does not fit, and the batch is left as it was */
+bool    BATCH_Add(batch_t *pBatch, const sensingPara_t *pRec);
+/* Records in the batch, and its length in bytes */
+uint8   BATCH_Count(const batch_t *pBatch);
+uint8   BATCH_Len(const batch_t *pBatch);
+
+/* Open a received batch of 'len' bytes; FALSE if it is not one */
+bool    BATCH_DecodeStart(batch_t *pBatch, const uint8 *pBuf, uint8 len);
+/* Next record; FALSE after the last or if the rest is damaged */
+bool    BATCH_DecodeNext(batch_t *pBatch, batchRec_t *pRec);
+/* Is the batch an alive packet too, and the time it gives */
+bool    BATCH_Alive(const batch_t *pBatch, uint32 *pTime);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BATCH_H */
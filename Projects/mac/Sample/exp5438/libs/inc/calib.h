@@ -0,0 +1,59 @@
+#ifndef __CALIB_H
+#define __CALIB_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "hal_types.h"
+
+/***************************/
+/* Calibration of the sensing conversions of one node.  It is kept in the settings area at the
+ * start of the FRAM (see store.h), so a node is recalibrated by writing it there, from a
+ * PKT_CALIB_TYPE packet, without new firmware.  A blank or damaged copy gives the defaults,
+ * which are the constants the conversions were written with.
+ */
+#define CALIB_ADDR                0x000000UL
+#define CALIB_LEN                 12
+#define CALIB_MAGIC               0xCA1B
+
+/* Defaults */
+#define CALIB_INT_TMP_OFFSET      (-30)         /* mV */
+#define CALIB_EXT_TMP_OFFSET      0             /* mV */
+#define CALIB_PH_OFFSET           0             /* mV */
+#define CALIB_PH_SLOPE            310           /* 0.2 mV/pH at 0 C, plus 0.2 mV/pH per C */
+
+/* Range of a calibration that is taken, by CALIB_Valid().  A probe outside has worn out; the
+ * bounds also keep the pH conversion of sensing.c within 32 bits: the reciprocal of the slope
+ * times the ADC counts from pH 7, offset included, stays below 2^31 for any NTC knot above
+ * -100 C */
+#define CALIB_PH_SLOPE_MIN        200           /* 65 % of the default */
+#define CALIB_PH_SLOPE_MAX        400           /* 130 % of the default */
+#define CALIB_PH_OFFSET_MAX       500           /* mV, either way */
+
+typedef struct{
+  uint16  magic;
+  int16   intTmpOffset;                 /* mV */
+  int16   extTmpOffset;                 /* mV, on the NTC divider */
+  int16   pHOffset;                     /* mV, of the probe at pH 7 */
+  uint16  pHSlope;                      /* 0.2 mV/pH at 0 C */
+  uint16  crc;                          /* of the fields before */
+} calib_t;
+
+/****  FUNCTIONs  ****/
+/* TRUE if the calibration can be used: the pH slope and offset are within their range */
+bool    CALIB_Valid(const calib_t *pCalib);
+/* The defaults */
+void    CALIB_Default(calib_t *pCalib);
+/* Read the calibration from the FRAM, FRAM must be up.  FALSE if there is none and the
+ * defaults were given */
+bool    CALIB_Load(calib_t *pCalib);
+/* Write the calibration to the FRAM; magic and CRC are set here */
+void    CALIB_Save(calib_t *pCalib);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CALIB_H */
@@ -0,0 +1,45 @@
+#ifndef __CHSEL_H
+#define __CHSEL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "hal_types.h"
+
+/***************************/
+/* Channel assessment of the gateway.  Each energy detect scan of the channels is a round; the
+ * readings of the last CHSEL_ROUNDS rounds are kept per channel, and a channel is scored by
+ * their median and their 90th percentile:
+ *     score = CHSEL_W_MEDIAN * median + CHSEL_W_P90 * p90
+ * The median is the level a channel has most of the time, the 90th percentile the bursts of a
+ * Wi-Fi network on it, which a single quiet reading hides.  The lowest score is the best.
+ */
+#define CHSEL_FIRST               11            /* channels 11 to 26 of the 2.4 GHz band */
+#define CHSEL_NUM                 16
+#define CHSEL_ROUNDS              8             /* readings kept per channel */
+#define CHSEL_W_MEDIAN            1
+#define CHSEL_W_P90               2
+#define CHSEL_NO_SCORE            0xFFFF        /* a channel without readings */
+
+/****  FUNCTIONs  ****/
+/* Forget all readings */
+void    CHSEL_Init(void);
+/* A round: the energy of each channel of the 'channels' mask (MAC_CHAN_xx_MASK), in channel
+ * order, as MAC_MLME_SCAN_CNF gives it */
+void    CHSEL_Round(uint32 channels, const uint8 *pEnergy, uint8 num);
+/* Readings kept of a channel */
+uint8   CHSEL_Readings(uint8 channel);
+/* pct percentile of the readings of a channel, 0 without any */
+uint8   CHSEL_Percentile(uint8 channel, uint8 pct);
+/* Score of a channel, CHSEL_NO_SCORE without readings */
+uint16  CHSEL_Score(uint8 channel);
+/* Channel with the lowest score, the lowest channel of those with the same */
+uint8   CHSEL_Best(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CHSEL_H */
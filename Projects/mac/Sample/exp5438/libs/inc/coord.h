@@ -0,0 +1,48 @@
+#ifndef __COORD_H
+#define __COORD_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "hal_types.h"
+#include "saddr.h"
+
+/***************************/
+/* What a node knows of its network, kept in the settings area of the FRAM after the periods
+ * (sched.h) so it survives a reset:
+ *   - its extended address, drawn once; the gateway keeps its devices by it (devtab.h), so the
+ *     node keeps its slot and its short address when it joins again
+ *   - the channel, PAN and short address of the coordinator, and its own short address, of the
+ *     last association
+ * With them a node that lost its coordinator, or was reset, tries an orphan scan and a scan of
+ * the one channel before it scans them all.  A channel of 0 is a node that never associated.
+ */
+#define COORD_ADDR                0x000020UL
+#define COORD_LEN                 20
+#define COORD_MAGIC               0xC02D
+
+typedef struct{
+  uint16      magic;
+  sAddrExt_t  extAddr;                  /* of this node */
+  uint16      shortAddr;                /* of this node */
+  uint16      panId;
+  uint16      coordShortAddr;
+  uint8       channel;                  /* 0 if not associated yet */
+  uint8       rsvd;
+  uint16      crc;                      /* of the fields before */
+} coord_t;
+
+/****  FUNCTIONs  ****/
+/* Read the network of this node from the FRAM, FRAM must be up.  FALSE if there is none, pCoord
+ * is left as it is then */
+bool    COORD_Load(coord_t *pCoord);
+/* Write the network to the FRAM; magic and CRC are set here */
+void    COORD_Save(coord_t *pCoord);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __COORD_H */
@@ -0,0 +1,22 @@
+#ifndef __CRC_H
+#define __CRC_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "hal_types.h"
+
+/***************************/
+#define CRC_INIT                  0xFFFF
+
+/****  FUNCTIONs  ****/
+/* CRC-16/CCITT (0x1021, not reflected) of a buffer, crc = CRC_INIT to start */
+uint16  CRC_Ccitt(uint16 crc, const uint8 *pBuf, uint16 len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CRC_H */
@@ -0,0 +1,95 @@
+#ifndef __DEVTAB_H
+#define __DEVTAB_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "hal_types.h"
+#include "saddr.h"
+#include "lstat.h"
+
+/***************************/
+/* Devices associated with the gateway, by extended address.  The table is open addressed: a
+ * device takes the first slot that is not in use from the hash of its extended address on, and
+ * its short address is DEVTAB_SHORT_BASE + slot.  The data indications, which carry the short
+ * address, find their device by an index, and an association finds it by a short probe, so a
+ * device that associates again keeps its slot and its address.  An orphan notification, which
+ * carries the extended address, finds it by the same probe with DEVTAB_Find().
+ *
+ * DEVTAB_Age() takes out the devices not heard for a while.  Their slots are marked gone, not
+ * free, so the probes still reach the devices after them, and a new device takes the first gone
+ * slot on its probe.
+ *
+ * An entry also holds the commands waiting for the device to poll, one bit per packet type;
+ * DEVTAB_Pending() counts the devices with any, for the frame pending bit of the ACKs.
+ *
+ * The extended addresses and states are kept in the FRAM, a record per slot, so the gateway
+ * knows its devices again after a reset; the nodes do not associate again for it.  The gateway
+ * keeps no store log (store.h), the table is where the nodes have their checkpoints.
+ *
+ * The table lives in RAM and must fit in DEVTAB_RAM_BUDGET, a quarter of the 16 KB of the
+ * MSP430F5438, which devtab.c checks.  A larger deployment defines both, e.g. -DDEVTAB_SIZE=256
+ * -DDEVTAB_RAM_BUDGET=10240, on a part with the RAM for it.
+ */
+#ifndef DEVTAB_SIZE
+#define DEVTAB_SIZE               64            /* power of 2 */
+#endif
+#ifndef DEVTAB_RAM_BUDGET
+#define DEVTAB_RAM_BUDGET         4096          /* bytes of RAM for the table */
+#endif
+#define DEVTAB_SHORT_BASE         0x0001
+#define DEVTAB_ADDR               0x000100UL
+#define DEVTAB_MAGIC              0xDE7A
+#define DEVTAB_HDR_LEN            4             /* magic, DEVTAB_SIZE */
+#define DEVTAB_REC_LEN            12            /* extended address, state, CRC */
+
+/* devEntry_t.cmds: a command of a packet type waits for the poll of the device */
+#define DEVTAB_CMD(pktType)       ((uint8) (1 << (pktType)))
+
+/* devEntry_t.state */
+#define DEVTAB_FREE               0
+#define DEVTAB_USED               1
+#define DEVTAB_GONE               2
+
+typedef struct{
+  sAddrExt_t  extAddr;
+  uint32      lastSeen;                 /* stick of the association or the last frame */
+  lstat_t     link;                     /* statistics of its frames, lstat.h */
+  uint8       cmds;                     /* DEVTAB_CMD() of the commands waiting for its poll */
+  uint8       state;
+} devEntry_t;
+
+/****  FUNCTIONs  ****/
+/* Empty the table, then, if useFram, read the devices back from the FRAM, which must be up.
+ * Returns the number of devices */
+uint16      DEVTAB_Init(bool useFram);
+/* Device associating at 'time': its entry, a new one if it is not known.  NULL if the table is
+ * full */
+devEntry_t *DEVTAB_Assoc(const sAddrExt_t extAddr, uint32 time);
+/* A known device joins again at 'time', by an association or an orphan scan: it is seen, and
+ * its clock may have started again */
+void        DEVTAB_Seen(devEntry_t *pDev, uint32 time);
+/* Device of an extended address, NULL if it is not known */
+devEntry_t *DEVTAB_Find(const sAddrExt_t extAddr);
+/* Device of a short address, NULL if there is none */
+devEntry_t *DEVTAB_Get(uint16 shortAddr);
+/* Short address of a device */
+uint16      DEVTAB_Short(const devEntry_t *pDev);
+/* Take out the devices not heard for more than maxAge sticks; returns how many */
+uint16      DEVTAB_Age(uint32 time, uint32 maxAge);
+/* Number of devices */
+uint16      DEVTAB_Count(void);
+/* Commands for a device, DEVTAB_CMD() or'ed, wait for its poll */
+void        DEVTAB_Pend(devEntry_t *pDev, uint8 cmds);
+/* Commands that reached a device no longer wait */
+void        DEVTAB_Sent(devEntry_t *pDev, uint8 cmds);
+/* Number of devices with commands waiting */
+uint16      DEVTAB_Pending(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DEVTAB_H */
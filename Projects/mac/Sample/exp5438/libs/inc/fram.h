@@ -16,6 +16,14 @@ extern "C" {
 #include "usci_spi.h"
 
 
+#define FRAM_SIZE   0x40000UL   /* MB85RS2MT, 2 Mbit */
+
+/* SPI clock division once the FRAM has answered, SMCLK / 1 = 12 MHz (the MB85RS2MT takes up
+ * to 25 MHz); the device ID is read at SPI_CLK_DIV */
+#ifndef FRAM_CLK_DIV
+#define FRAM_CLK_DIV  1
+#endif
+
 #define FRAM_MODE0  SPI_MODE0
 #define FRAM_MODE3  SPI_MODE3
 
@@ -63,13 +71,37 @@ typedef enum {
   ERROR_WRITE_FAIL = (2)
 } error_t;
 
+/* Write-combining buffer of fram_writeCombined() and fram_writeByteCombined() */
+#ifndef FRAM_WC_LEN
+#define FRAM_WC_LEN     32
+#endif
+
+/* One piece of a scatter/gather write */
+typedef struct {
+  uint32_t       addr;
+  const uint8_t *pData;
+  uint16_t       size;
+} fram_seg_t;
+
 /* FRAM Interface */
 error_t fram_init(uint8_t spi_mode);
 
 error_t fram_readMemory(uint32_t startAddr, uint8_t *pData, uint16_t size);
 error_t fram_fastReadMemory(uint32_t startAddr, uint8_t *pData, uint16_t size);
-error_t fram_writeMemory(uint32_t startAddr, const uint8_t *pData, uint16_t size);
 error_t fram_writeByte(uint32_t startAddr, uint8_t data);
+error_t fram_writeMemory(uint32_t startAddr, const uint8_t *pData, uint16_t size);
+error_t fram_writeSegs(const fram_seg_t *pSegs, uint8_t count);
+/* Buffered: adjacent writes are combined and reach the FRAM with the next read, the next
+ * write that does not continue them, or fram_flush() */
+error_t fram_writeCombined(uint32_t startAddr, const uint8_t *pData, uint16_t size);
+error_t fram_writeByteCombined(uint32_t startAddr, uint8_t data);
+error_t fram_flush(void);
+/* Started in the background, by DMA: the buffer must stay until 'event' is set for 'taskId'.
+ * Any other call waits for the end of the transfer */
+error_t fram_readMemoryAsync(uint32_t startAddr, uint8_t *pData, uint16_t size,
+                             uint8_t taskId, uint16_t event);
+error_t fram_writeMemoryAsync(uint32_t startAddr, const uint8_t *pData, uint16_t size,
+                              uint8_t taskId, uint16_t event);
 
 error_t fram_readDeviceID(uint8_t *pDeviceID);
 //error_t fram_sleepMode(void);
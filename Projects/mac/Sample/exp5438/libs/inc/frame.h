@@ -0,0 +1,74 @@
+#ifndef __FRAME_H
+#define __FRAME_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "hal_types.h"
+
+/***************************/
+/* Binary frame of the gateway UART, all fields little endian:
+ *
+ *   0  sync     FRAME_SYNC0, FRAME_SYNC1
+ *   2  len      bytes from type to the end of the payload
+ *   3  type     FRAME_TYPE_xxx
+ *   4  seq      incremented on every frame, a gap means frames were dropped
+ *   5  srcAddr  short address of the sender (2)
+ *   7  rssi     dBm, signed
+ *   8  lqi      link quality
+ *   9  time     stick time of the gateway (4)
+ *  13  payload  raw pkt_t as received
+ *   .  crc      CRC-16/CCITT (CRC_Ccitt) of len up to the end of the payload (2)
+ *
+ * Both sync bytes are outside ASCII, so text lines can share the UART with the frames.
+ *
+ * The PC asks for the link statistics of the nodes with the byte FRAME_CMD_STATS.  The gateway
+ * answers with a snapshot in FRAME_TYPE_STATS frames; their srcAddr is that of the gateway,
+ * rssi and lqi are 0, and the payload is
+ *   0  snapshot  number of the snapshot, the same in all its frames
+ *   1  flags     FRAME_STATS_LAST on the last frame of the snapshot
+ *   2  records   LSTAT_REC_LEN bytes for each node (lstat.h)
+ *
+ * The other commands of the PC carry parameters: the command byte, its FRAME_CMD_xxx_LEN bytes
+ * of parameters, little endian, then the CRC-16/CCITT of the command byte and the parameters (2).
+ * The gateway drops a command with a bad CRC.
+ *   FRAME_CMD_CALIB  the short address of a node (2), then the intTmpOffset, extTmpOffset,
+ *                    pHOffset and pHSlope of its calib_t (2 each, calib.h); the node takes them
+ *                    with its next poll
+ *   FRAME_CMD_SCHED  the sensingTime, sendAliveTime and preparingDelta of a sched_t (2 each,
+ *                    sched.h): new periods for every node, from its next poll on
+ */
+#define FRAME_SYNC0               0xA5
+#define FRAME_SYNC1               0x5A
+#define FRAME_HDR_LEN             10            /* type up to time */
+#define FRAME_OVERHEAD            (3 + FRAME_HDR_LEN + 2)
+#define FRAME_MAX_PAYLOAD         127           /* largest MSDU */
+
+#define FRAME_TYPE_RECV           1             /* packet received from a node */
+#define FRAME_TYPE_STATS          2             /* part of a snapshot of the link statistics */
+
+#define FRAME_CMD_STATS           'S'           /* from the PC: send the link statistics */
+#define FRAME_STATS_HDR_LEN       2
+#define FRAME_STATS_LAST          0x01
+
+#define FRAME_CMD_CALIB           'C'           /* from the PC: new calibration of a node */
+#define FRAME_CMD_CALIB_LEN       10
+#define FRAME_CMD_SCHED           'P'           /* from the PC: new periods of the nodes */
+#define FRAME_CMD_SCHED_LEN       6
+#define FRAME_CMD_MAX_LEN         FRAME_CMD_CALIB_LEN
+#define FRAME_CMD_CRC_LEN         2
+
+/****  FUNCTIONs  ****/
+/* Queue one frame on the UART, all of it or nothing.  Returns FALSE if it was dropped */
+bool    FRAME_Send(uint8 port, uint8 type, uint16 srcAddr, int8 rssi, uint8 lqi, uint32 time,
+                   const uint8 *pPayload, uint8 len);
+/* Frames refused by a full UART */
+uint16  FRAME_Dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FRAME_H */
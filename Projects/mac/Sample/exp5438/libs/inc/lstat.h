@@ -0,0 +1,69 @@
+#ifndef __LSTAT_H
+#define __LSTAT_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "hal_types.h"
+
+/***************************/
+/* Link statistics of one node, as the gateway sees it, updated in a few operations per frame.
+ *   - RSSI and LQI are averaged with a weight of 1/8 for the new frame
+ *   - a frame with the MAC sequence number of the frame before is a duplicate: the node sent it
+ *     again because the ACK was lost
+ *   - the alive packets, plain or in a batch, carry the stick of the node; sent every
+ *     sendAliveTime sticks, a gap of n periods between two of them means n - 1 were lost
+ *   - the jitter is that of RFC 3550: the change of the transit time, arrival less the time of
+ *     the node, from one alive packet to the next, averaged with a weight of 1/16
+ *
+ * LSTAT_Pack() writes the statistics in LSTAT_REC_LEN bytes, little endian:
+ *   0  shortAddr  (2)
+ *   2  rssi       average, dBm, signed
+ *   3  lqi        average
+ *   4  frames     received, duplicates left out (2)
+ *   6  dups       duplicates (2)
+ *   8  alives     alive packets received (2)
+ *  10  lost       alive packets missed (2)
+ *  12  jitter     ms (2)
+ *  14  age        sticks since the node was heard, 0xFFFF for more (2)
+ */
+#define LSTAT_REC_LEN             16
+
+#define LSTAT_AVG_SHIFT           3             /* averages are kept times 8 */
+#define LSTAT_JITTER_SHIFT        4             /* the jitter times 16 */
+#define LSTAT_JITTER_MAX          4095          /* ms, larger transit changes are left out */
+
+/* lstat_t.flags */
+#define LSTAT_HAVE_FRAME          0x01
+#define LSTAT_HAVE_ALIVE          0x02
+
+typedef struct{
+  int16   rssiAvg;                      /* dBm times 8 */
+  uint16  lqiAvg;                       /* times 8 */
+  uint16  frames;
+  uint16  dups;
+  uint16  alives;
+  uint16  lost;
+  uint16  jitter;                       /* ms times 16 */
+  uint16  aliveTime;                    /* stick of the node in the last alive packet, low bits */
+  uint32  transit;                      /* ms, of the last alive packet */
+  uint8   dsn;                          /* MAC sequence number of the last frame */
+  uint8   flags;
+} lstat_t;
+
+/****  FUNCTIONs  ****/
+/* A frame was received.  FALSE if it is a duplicate, to be dropped */
+bool    LSTAT_Frame(lstat_t *pStat, uint8 dsn, int8 rssi, uint8 lqi);
+/* The frame was an alive packet with the node time 'time', in sticks of stickMs, received at
+ * 'arrival' ms of the gateway; the node sends one every 'period' sticks */
+void    LSTAT_Alive(lstat_t *pStat, uint32 time, uint32 arrival, uint16 period, uint16 stickMs);
+/* Write the record of a node in pBuf, LSTAT_REC_LEN bytes */
+void    LSTAT_Pack(const lstat_t *pStat, uint16 shortAddr, uint32 age, uint8 *pBuf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LSTAT_H */
@@ -0,0 +1,39 @@
+#ifndef __MAC_CALLBACK_H
+#define __MAC_CALLBACK_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "hal_types.h"
+#include "mac_api.h"
+
+/***************************/
+/* MAC events that can wait for the application task at the same time, at most 8 */
+#ifndef MACCB_SLOTS
+#define MACCB_SLOTS               8
+#endif
+
+#if (MACCB_SLOTS < 1) || (MACCB_SLOTS > 8)
+#error "ERROR! MACCB_SLOTS has to be between 1 and 8"
+#endif
+
+/****  FUNCTIONs  ****/
+/* Task that receives the MAC events as OSAL messages */
+void    MACCB_Init(uint8 taskId);
+/* Call from MAC_CbackEvent() */
+void    MACCB_Event(macCbackEvent_t *pData);
+/* Release a MAC event received from osal_msg_receive() */
+void    MACCB_Free(uint8 *pMsg);
+/* Events lost for want of a slot, in total and of one type */
+uint16  MACCB_Dropped(void);
+uint16  MACCB_DroppedEvent(uint8 event);
+/* Most slots ever in use */
+uint8   MACCB_HighWater(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MAC_CALLBACK_H */
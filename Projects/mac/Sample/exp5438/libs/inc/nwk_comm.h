@@ -45,6 +45,7 @@ typedef union{ uint8         energy[NWK_MAC_MAX_RESULTS];
 extern  scan_result_t scanResult;
 /****  FUNCTIONs  ****/
 void NWK_ScanReq(uint8 scanType, uint8 scanDuration);
+void NWK_ScanChannelsReq(uint8 scanType, uint32 scanChannels, uint8 scanDuration);
 
 
 #ifdef __cplusplus
@@ -1,10 +1,17 @@
 #ifndef __PACKET_H
 #define __PACKET_H
 
+#include <stddef.h>
 #include "sensing.h"
+#include "calib.h"
+#include "sched.h"
 /* define packet type */
 #define PKT_SENSING_TYPE        1
 #define PKT_ALIVE_TYPE          2
+#define PKT_CALIB_TYPE          3       /* to a node: a calib_t to keep and use */
+#define PKT_BATCH_TYPE          4       /* sensing results of several periods, see batch.h */
+#define PKT_SCHED_TYPE          5       /* to a node: a sched_t of new periods to keep and use */
+#define PKT_CMDS_TYPE           6       /* to a node: several of the packets above, see wire.h */
 typedef uint8      pktType_t;
 
 typedef struct{
@@ -25,9 +32,12 @@ typedef struct{
   union{
     alivePara_t    alivePara;
     sensingPara_t  sensingPara;
+    calib_t        calibPara;
+    sched_t        schedPara;
   } pktPara;
 } pkt_t;
 
-void PKT_Print(pkt_t* pkt);
+/* A pkt_t is in the layout of the compiler, it goes on the air as wire.h writes it */
+void PKT_Print(const uint8* pBuf, uint8 len);
 
 #endif /* __PACKET_H */
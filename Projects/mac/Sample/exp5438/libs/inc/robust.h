@@ -0,0 +1,38 @@
+#ifndef __ROBUST_H
+#define __ROBUST_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "hal_types.h"
+
+/***************************/
+#define ROBUST_NUM_SAMPLES        16    /* samples of one measurement */
+#define ROBUST_STREAM_LEN         ROBUST_NUM_SAMPLES
+
+/* Samples kept sorted as they arrive */
+typedef struct{
+  uint16  sorted[ROBUST_STREAM_LEN];
+  uint8   n;
+} robustStream_t;
+
+/****  FUNCTIONs  ****/
+/* Mean of the 8 of 16 samples closest to their mean; 12 bit samples */
+uint16  ROBUST_FilterAvg(const uint16 *pData);
+/* Median of 16 samples, the mean of the middle two rounded down */
+uint16  ROBUST_Median16(const uint16 *pData);
+/* Mean of n samples without the 'trim' lowest and 'trim' highest; reorders pData */
+uint16  ROBUST_TrimmedMean(uint16 *pData, uint8 n, uint8 trim);
+
+void    ROBUST_StreamInit(robustStream_t *pStream);
+void    ROBUST_StreamAdd(robustStream_t *pStream, uint16 sample);
+uint16  ROBUST_StreamMedian(const robustStream_t *pStream);
+uint16  ROBUST_StreamTrimmedMean(const robustStream_t *pStream, uint8 trim);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ROBUST_H */
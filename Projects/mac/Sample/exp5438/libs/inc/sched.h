@@ -0,0 +1,57 @@
+#ifndef __SCHED_H
+#define __SCHED_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "hal_types.h"
+
+/***************************/
+/* Periods of the work of a node, in sticks.  The stick is the unit of the times a node
+ * records, so its duration stays a build constant; the periods can be changed by the gateway,
+ * with a PKT_SCHED_TYPE packet, and are kept in the settings area of the FRAM after the
+ * calibration (calib.h).  A blank or damaged copy leaves the periods the node was built with.
+ *
+ * At stick t the node
+ *   sends an alive packet and polls       if t % sendAliveTime == 0
+ *   measures                              if t % sensingTime == 0
+ *   powers the sensors up                 if (t + preparingDelta) % sensingTime == 0
+ * and it sleeps through the sticks where none of these is due.
+ */
+#define SCHED_ADDR                0x000010UL
+#define SCHED_LEN                 10
+#define SCHED_MAGIC               0x5C4E
+
+/* SCHED_Due() */
+#define SCHED_ALIVE               0x01
+#define SCHED_SENSE               0x02
+#define SCHED_PREPARE             0x04
+
+typedef struct{
+  uint16  magic;
+  uint16  sensingTime;                  /* sticks between measurements */
+  uint16  sendAliveTime;                /* sticks between alive packets and polls */
+  uint16  preparingDelta;               /* sticks the sensors are up before a measurement */
+  uint16  crc;                          /* of the fields before */
+} sched_t;
+
+/****  FUNCTIONs  ****/
+/* TRUE if the periods can be used: none is 0, and the sensors are prepared within a period */
+bool    SCHED_Valid(const sched_t *pSched);
+/* Read the periods from the FRAM, FRAM must be up.  FALSE if there are none, pSched is left
+ * as it is then */
+bool    SCHED_Load(sched_t *pSched);
+/* Write the periods to the FRAM; magic and CRC are set here */
+void    SCHED_Save(sched_t *pSched);
+/* What is due at stick 'time': SCHED_ALIVE, SCHED_SENSE, SCHED_PREPARE or'ed */
+uint8   SCHED_Due(const sched_t *pSched, uint32 time);
+/* First stick after 'time' where something is due */
+uint32  SCHED_Next(const sched_t *pSched, uint32 time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SCHED_H */
@@ -2,6 +2,19 @@
 #define __SENSING_H
 
 #include "arch_port.h"
+#include "calib.h"
+
+/* Channels, in the order of the ADC sequence */
+#define SS_CH_VDD             0
+#define SS_CH_INT_TMP         1
+#define SS_CH_PH              2
+#define SS_CH_EXT_TMP         3
+#define SS_NUM_CHANNELS       4
+
+/* Reduction of the 16 samples of a channel */
+#define SS_FILTER_LEGACY      0   /* mean of the 8 closest to the mean, as always */
+#define SS_FILTER_MEDIAN      1   /* median, sorting network */
+#define SS_FILTER_TRIMMED     2   /* mean of the middle 8, sorted in the ADC ISR */
 
 typedef struct {
   uint16_t pHAdc[16];
@@ -20,6 +33,9 @@ typedef struct {
 
 void SS_Init(void);
 void SS_Prepare(void);
+void SS_Start(uint8_t taskId, uint16_t event);
+void SS_SetFilter(uint8_t channel, uint8_t filter);
+void SS_SetCalib(const calib_t *pCalib);
 void SS_Measure(sensing_t* ssResult);
 void SS_Shutdown(void);
 void SS_Print(sensing_t* ssResult);
@@ -22,9 +22,13 @@
           2 = SMCLK
 **/
 
-/* SPI Clock division. Must be 4 or greater */
+/* SPI Clock division at init, changed at run time with usci_spi_setClkDiv() */
 #define SPI_CLK_DIV     25
 
+/* Blocks of at least this many bytes go by DMA when HAL_SPI_DMA is TRUE, shorter ones are
+ * polled: setting up the two channels takes longer than a few bytes on the bus */
+#define SPI_DMA_MIN     8
+
 /* Byte that is transmitted during read operations */
 #define DUMMY_CHAR     (0xFF)
 
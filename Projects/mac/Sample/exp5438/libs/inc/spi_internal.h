@@ -31,6 +31,8 @@
         #define SPI_UCIE     UCA0IE
         #define SPI_UCIFG    UCA0IFG
         #define SPI_UCIV     UCA0IV
+        #define SPI_DMA_RXTSEL  16     /* UCA0RXIFG */
+        #define SPI_DMA_TXTSEL  17     /* UCA0TXIFG */
     #else
         #error "Invalid SPI_USE_USCI in spi_config.h"
     #endif
@@ -46,6 +48,8 @@
         #define SPI_UCIE     UCA1IE
         #define SPI_UCIFG    UCA1IFG
         #define SPI_UCIV     UCA1IV
+        #define SPI_DMA_RXTSEL  20     /* UCA1RXIFG */
+        #define SPI_DMA_TXTSEL  21     /* UCA1TXIFG */
     #else
         #error "Invalid SPI_USE_USCI in spi_config.h"
     #endif
@@ -61,6 +65,8 @@
         #define SPI_UCIE     UCB0IE
         #define SPI_UCIFG    UCB0IFG
         #define SPI_UCIV     UCB0IV
+        #define SPI_DMA_RXTSEL  18     /* UCB0RXIFG */
+        #define SPI_DMA_TXTSEL  19     /* UCB0TXIFG */
     #else
         #error "Invalid SPI_USE_USCI in spi_config.h"
     #endif
@@ -75,6 +81,8 @@
         #define SPI_UCIE     UCB1IE
         #define SPI_UCIFG    UCB1IFG
         #define SPI_UCIV     UCB1IV
+        #define SPI_DMA_RXTSEL  22     /* UCB1RXIFG */
+        #define SPI_DMA_TXTSEL  23     /* UCB1TXIFG */
 #else
     #error "Invalid SPI_USE_USCI in spi_config.h"
 #endif
@@ -0,0 +1,75 @@
+#ifndef __STORE_H
+#define __STORE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "hal_types.h"
+#include "fram.h"
+
+/***************************/
+/* FRAM map:
+ *   0x000000  STORE_CP_BASE   reserved for settings, CALIB_ADDR (calib.h) at its start
+ *   STORE_CP_BASE             STORE_CP_SLOTS checkpoints of STORE_CP_LEN bytes, written in turn
+ *   STORE_LOG_BASE            ring of STORE_BLOCKS records of STORE_REC_LEN bytes, up to FRAM_SIZE
+ *
+ * A record is a header - sequence number, time, length, CRC - and STORE_DATA_LEN bytes of data.
+ * Record 'seq' is always in block seq % STORE_BLOCKS, so an append is one write at a computed
+ * address, and a block is found without a search.  The checkpoint keeps the head of the log and
+ * the application's store_info; it is written every STORE_CP_INTERVAL appends, each time into
+ * the next slot so no FRAM cell takes every write.  At power up the newest valid checkpoint is
+ * taken and the head rolled forward over the records appended after it.
+ */
+#define STORE_CP_BASE             0x000100UL
+#define STORE_CP_SLOTS            8
+#define STORE_CP_LEN              32
+#define STORE_LOG_BASE            (STORE_CP_BASE + STORE_CP_SLOTS * STORE_CP_LEN)
+
+#ifndef STORE_DATA_LEN
+#define STORE_DATA_LEN            64            /* a sensingPara_t */
+#endif
+#define STORE_HDR_LEN             12
+#define STORE_REC_LEN             (STORE_HDR_LEN + STORE_DATA_LEN)
+#define STORE_BLOCKS              ((uint16)((FRAM_SIZE - STORE_LOG_BASE) / STORE_REC_LEN))
+
+#ifndef STORE_CP_INTERVAL
+#define STORE_CP_INTERVAL         16            /* appends between checkpoints */
+#endif
+#define STORE_INFO_LEN            12            /* room for a store_info.h structure */
+
+#if (STORE_DATA_LEN > 255)
+#error "ERROR! STORE_DATA_LEN has to fit the uint8 length of a record"
+#endif
+
+/* STORE_Read() status */
+#define STORE_OK                  0
+#define STORE_GONE                1             /* overwritten, or not written yet */
+#define STORE_CORRUPT             2             /* CRC does not match */
+
+/****  FUNCTIONs  ****/
+/* Open the log, FRAM must be up.  The store_info of the newest checkpoint is copied to pInfo,
+ * which stays registered and is written with every checkpoint.  FALSE if a new log was started */
+bool    STORE_Init(void *pInfo, uint8 infoLen);
+/* Append a record, returns its sequence number */
+uint32  STORE_Append(uint32 time, const uint8 *pData, uint8 len);
+/* Read the record 'seq'; pData has room for STORE_DATA_LEN bytes */
+uint8   STORE_Read(uint32 seq, uint32 *pTime, uint8 *pData, uint8 *pLen);
+/* Sequence number of the next record, and of the oldest one still in the ring */
+uint32  STORE_Head(void);
+uint32  STORE_Oldest(void);
+/* First record with a time not before 'time', STORE_Head() if there is none.  Times must not go
+ * backwards from one append to the next */
+uint32  STORE_FindTime(uint32 time);
+/* Block of a record, and the record now in a block (STORE_Head() if the block is empty) */
+uint16  STORE_Block(uint32 seq);
+uint32  STORE_FindBlock(uint16 block);
+/* Write a checkpoint now, e.g. after the store_info changed */
+void    STORE_Checkpoint(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STORE_H */
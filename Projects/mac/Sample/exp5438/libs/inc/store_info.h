@@ -5,6 +5,7 @@ typedef struct{
   uint16_t curBlock; 
   uint16_t nodeId;
   uint16_t numReset;
+  uint32_t sentSeq;     /* first record of the store not yet acknowledged by the gateway */
 } node_store_info_t;
 
 typedef struct{
@@ -20,8 +20,23 @@ extern "C" {
 #define SPI_MODE2    (0)                 /**< brief CPOL = 1, CPHA = 0     */
 #define SPI_MODE3    (0+UCCKPL)          /**< brief CPOL = 1, CPHA = 1     */
 
+/* Called at the end of a usci_spi_transferAsync(), from the DMA interrupt */
+typedef void (*usci_spi_done_t)(void);
+
 void usci_spi_init(uint8_t spi_mode);
+void usci_spi_setClkDiv(uint16_t div);    /**< SPI clock = source clock / div, from now on */
+uint16_t usci_spi_getClkDiv(void);
 uint8_t usci_spi_sendByte(uint8_t data); /**< send & get byte concurrently */
+void usci_spi_write(const uint8_t *pData, uint16_t size); /**< send a block, received bytes dropped */
+void usci_spi_read(uint8_t *pData, uint16_t size);        /**< receive a block, DUMMY_CHAR sent  */
+/* pTx NULL sends DUMMY_CHAR, pRx NULL drops what is received.  Long blocks go by DMA and the
+ * CPU waits in LPM0, where interrupts are served; called with interrupts enabled */
+void usci_spi_transfer(const uint8_t *pTx, uint8_t *pRx, uint16_t size);
+/* Returns once the transfer is started; the buffers must stay until done() is called.  Without
+ * the DMA the transfer is polled and done() is called before this returns */
+void usci_spi_transferAsync(const uint8_t *pTx, uint8_t *pRx, uint16_t size, usci_spi_done_t done);
+uint8_t usci_spi_busy(void);             /**< an async transfer is running */
+void usci_spi_wait(void);                /**< wait for the end of an async transfer */
 
 #define usci_spi_getByte()    usci_spi_sendByte(DUMMY_CHAR)
 
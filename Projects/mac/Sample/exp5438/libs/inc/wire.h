@@ -0,0 +1,95 @@
+#ifndef __WIRE_H
+#define __WIRE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "hal_types.h"
+#include "packet.h"
+
+/***************************/
+/* A pkt_t on the air, in the same bytes on every compiler and CPU.
+ *   0  pktType
+ *   1  WIRE_VER_HDR  version in the high nibble, header length in the low one
+ *   2  the parameters, field after field in the order of their struct, no padding, every
+ *      field little endian
+ * A receiver takes a packet of its version with a longer header, or more bytes of parameters
+ * than it knows, and skips what it does not know: fields can be added at the end without a
+ * new version.  PKT_BATCH_TYPE packets have the same header, batch.h gives the rest.
+ *
+ * A PKT_CMDS_TYPE packet carries the commands the gateway holds for a node in one frame:
+ *   0  pktType   PKT_CMDS_TYPE
+ *   1  WIRE_VER_HDR
+ *   2  the packets, each its length in one byte, then the packet as WIRE_Encode() writes it
+ */
+#define WIRE_VERSION              1
+#define WIRE_HDR_LEN              2
+#define WIRE_VER_HDR              ((WIRE_VERSION << 4) | WIRE_HDR_LEN)
+
+/* The fields of each packet type in the order they are sent: X(struct, member, elements).  The
+ * encoder and decoder tables and the lengths below are made from these lists */
+#define WIRE_ALIVE_FIELDS(X)                          \
+  X(alivePara_t,   nodeId,                    1)      \
+  X(alivePara_t,   curTime,                   1)
+
+#define WIRE_SENSING_FIELDS(X)                        \
+  X(sensingPara_t, nodeId,                    1)      \
+  X(sensingPara_t, time,                      1)      \
+  X(sensingPara_t, run,                       1)      \
+  X(sensingPara_t, storeBlock,                1)      \
+  X(sensingPara_t, sensingData.pHAdc,        16)      \
+  X(sensingPara_t, sensingData.vddAdcAvg,     1)      \
+  X(sensingPara_t, sensingData.intTmpAdcAvg,  1)      \
+  X(sensingPara_t, sensingData.pHAdcAvg,      1)      \
+  X(sensingPara_t, sensingData.extTmpAdcAvg,  1)      \
+  X(sensingPara_t, sensingData.vddVal,        1)      \
+  X(sensingPara_t, sensingData.intTmpVal,     1)      \
+  X(sensingPara_t, sensingData.pHVal,         1)      \
+  X(sensingPara_t, sensingData.extTmpRes,     1)      \
+  X(sensingPara_t, sensingData.extTmpVal,     1)
+
+/* The magic and the CRC of calib_t and sched_t are those of their FRAM copy, set by the node
+ * when it saves them; only the values go on the air */
+#define WIRE_CALIB_FIELDS(X)                          \
+  X(calib_t,       intTmpOffset,              1)      \
+  X(calib_t,       extTmpOffset,              1)      \
+  X(calib_t,       pHOffset,                  1)      \
+  X(calib_t,       pHSlope,                   1)
+
+#define WIRE_SCHED_FIELDS(X)                          \
+  X(sched_t,       sensingTime,               1)      \
+  X(sched_t,       sendAliveTime,             1)      \
+  X(sched_t,       preparingDelta,            1)
+
+#define WIRE_FIELD_LEN(type, member, n)   + sizeof(((type*) 0)->member)
+
+/* Bytes of a packet, header included */
+#define WIRE_ALIVE_LEN            (WIRE_HDR_LEN WIRE_ALIVE_FIELDS(WIRE_FIELD_LEN))
+#define WIRE_SENSING_LEN          (WIRE_HDR_LEN WIRE_SENSING_FIELDS(WIRE_FIELD_LEN))
+#define WIRE_CALIB_LEN            (WIRE_HDR_LEN WIRE_CALIB_FIELDS(WIRE_FIELD_LEN))
+#define WIRE_SCHED_LEN            (WIRE_HDR_LEN WIRE_SCHED_FIELDS(WIRE_FIELD_LEN))
+
+/****  FUNCTIONs  ****/
+/* Bytes of a packet of this type, 0 if it has no pkt_t parameters */
+uint8   WIRE_Len(pktType_t pktType);
+/* Write a packet; its length, 0 if the type is not known or size is too small */
+uint8   WIRE_Encode(const pkt_t *pPkt, uint8 *pBuf, uint8 size);
+/* Header length of a received packet, 0 if it is not of this version */
+uint8   WIRE_HdrLen(const uint8 *pBuf, uint8 len);
+/* Read a received packet; FALSE if it is not of this version, of a type with pkt_t parameters,
+ * or is too short */
+bool    WIRE_Decode(const uint8 *pBuf, uint8 len, pkt_t *pPkt);
+/* Add a packet to the PKT_CMDS_TYPE packet of 'len' bytes in pBuf, begun if len is 0; the new
+ * length, 0 if it does not fit in size */
+uint8   WIRE_CmdsAdd(const pkt_t *pPkt, uint8 *pBuf, uint8 len, uint8 size);
+/* Next packet of a received PKT_CMDS_TYPE packet, from *pOff, 0 for the first; NULL after the
+ * last, or if it is not one.  *pLen is set to the length of the packet */
+const uint8 *WIRE_CmdsNext(const uint8 *pBuf, uint8 len, uint8 *pOff, uint8 *pLen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __WIRE_H */
@@ -0,0 +1,352 @@
+/* Hal Driver includes */
+#include "hal_types.h"
+
+#include "batch.h"
+
+/**** DEFINE ****/
+#define BATCH_VARINT_MAX          5     /* bytes of a 32 bit varint */
+
+/**** FUNCTIONs ****/
+static uint8  batchNum(uint8 fields);
+static uint8  batchValues(const sensingPara_t *pRec, uint8 fields, uint16 *pVals);
+static uint16 batchRef(const batch_t *pBatch, const uint16 *pVals, uint8 k);
+static bool   batchPut(batch_t *pBatch, int32 delta);
+static bool   batchGet(batch_t *pBatch, int32 *pDelta);
+
+
+/**************************************************************************************************
+ * @brief   Start a batch
+ * @param   pBuf   - room for the packet
+ *          size   - its size, BATCH_HDR_LEN at least
+ *          nodeId - sender
+ *          fields - BATCH_xxx carried by every record
+ **************************************************************************************************/
+void BATCH_Start(batch_t *pBatch, uint8 *pBuf, uint8 size, uint8 nodeId, uint8 fields)
+{
+  uint8 k;
+
+  pBatch->pBuf      = pBuf;
+  pBatch->pIn       = pBuf;
+  pBatch->size      = size;
+  pBatch->len       = BATCH_HDR_LEN;
+  pBatch->nodeId    = nodeId;
+  pBatch->fields    = fields & BATCH_FIELDS;
+  pBatch->count     = 0;
+  pBatch->left      = 0;
+  pBatch->alive     = FALSE;
+  pBatch->aliveTime = 0;
+  pBatch->prevTime  = 0;
+  for (k=0; k<BATCH_MAX_VALS; k++){
+    pBatch->prev[k] = 0;
+  }
+  pBuf[0] = PKT_BATCH_TYPE;
+  pBuf[1] = WIRE_VER_HDR;
+  pBuf[WIRE_HDR_LEN]   = nodeId;
+  pBuf[WIRE_HDR_LEN+1] = pBatch->fields;
+  pBuf[WIRE_HDR_LEN+2] = 0;
+}
+
+
+/**************************************************************************************************
+ * @brief   Put the time of the node in the header, so the batch stands for its alive packet
+ * @param   time - the time PKT_ALIVE_TYPE would carry
+ * @return  FALSE if records were added already or it does not fit
+ **************************************************************************************************/
+bool BATCH_SetAlive(batch_t *pBatch, uint32 time)
+{
+  if ((pBatch->count != 0) || pBatch->alive || !batchPut(pBatch, (int32) time)){
+    return FALSE;
+  }
+  pBatch->alive     = TRUE;
+  pBatch->aliveTime = time;
+  pBatch->pBuf[WIRE_HDR_LEN+1] |= BATCH_ALIVE;
+  return TRUE;
+}
+
+
+/**************************************************************************************************
+ * @brief   Add a record to a batch
+ * @param   pRec - sensing result
+ * @return  FALSE if it does not fit; nothing was added then
+ **************************************************************************************************/
+bool BATCH_Add(batch_t *pBatch, const sensingPara_t *pRec)
+{
+  uint16 vals[BATCH_MAX_VALS];
+  uint8  start = pBatch->len;
+  uint8  n, k;
+
+  if (pBatch->count == 0xFF){
+    return FALSE;
+  }
+  n = batchValues(pRec, pBatch->fields, vals);
+  if (!batchPut(pBatch, (int32) (pRec->time - pBatch->prevTime))){
+    pBatch->len = start;
+    return FALSE;
+  }
+  for (k=0; k<n; k++){
+    if (!batchPut(pBatch, (int16) (vals[k] - batchRef(pBatch, vals, k)))){
+      pBatch->len = start;
+      return FALSE;
+    }
+  }
+
+  pBatch->prevTime = pRec->time;
+  for (k=0; k<n; k++){
+    pBatch->prev[k] = vals[k];
+  }
+  pBatch->pBuf[WIRE_HDR_LEN+2] = ++pBatch->count;
+  return TRUE;
+}
+
+
+/**************************************************************************************************
+ * @brief   Number of records in a batch
+ **************************************************************************************************/
+uint8 BATCH_Count(const batch_t *pBatch)
+{
+  return pBatch->count;
+}
+
+
+/**************************************************************************************************
+ * @brief   Length of a batch in bytes, header included
+ **************************************************************************************************/
+uint8 BATCH_Len(const batch_t *pBatch)
+{
+  return pBatch->len;
+}
+
+
+/**************************************************************************************************
+ * @brief   Open a received batch for BATCH_DecodeNext()
+ * @param   pBuf - packet
+ *          len  - its length
+ * @return  FALSE if it is not a batch
+ **************************************************************************************************/
+bool BATCH_DecodeStart(batch_t *pBatch, const uint8 *pBuf, uint8 len)
+{
+  uint8 hdrLen = WIRE_HdrLen(pBuf, len);
+  int32 time;
+  uint8 k;
+
+  if ((hdrLen == 0) || (len < hdrLen + 3) || (pBuf[0] != PKT_BATCH_TYPE) ||
+      (pBuf[hdrLen+1] & ~(BATCH_FIELDS | BATCH_ALIVE))){
+    return FALSE;
+  }
+  pBatch->pBuf      = NULL;
+  pBatch->pIn       = pBuf;
+  pBatch->size      = len;
+  pBatch->len       = hdrLen + 3;
+  pBatch->nodeId    = pBuf[hdrLen];
+  pBatch->fields    = pBuf[hdrLen+1] & BATCH_FIELDS;
+  pBatch->count     = pBuf[hdrLen+2];
+  pBatch->left      = pBatch->count;
+  pBatch->alive     = FALSE;
+  pBatch->aliveTime = 0;
+  pBatch->prevTime  = 0;
+  for (k=0; k<BATCH_MAX_VALS; k++){
+    pBatch->prev[k] = 0;
+  }
+  if (pBuf[hdrLen+1] & BATCH_ALIVE){
+    if (!batchGet(pBatch, &time)){
+      return FALSE;
+    }
+    pBatch->alive     = TRUE;
+    pBatch->aliveTime = (uint32) time;
+  }
+  return TRUE;
+}
+
+
+/**************************************************************************************************
+ * @brief   Decode the next record of a batch
+ * @param   pRec - the record, with 0 in what the batch does not carry
+ * @return  FALSE after the last record, or if the packet ends inside one
+ **************************************************************************************************/
+bool BATCH_DecodeNext(batch_t *pBatch, batchRec_t *pRec)
+{
+  uint16 vals[BATCH_MAX_VALS];
+  uint8  *pDst = (uint8*) pRec;
+  sensing_t *pSs = &(pRec->para.sensingData);
+  int32  delta;
+  uint8  n, k, i;
+
+  if (pBatch->left == 0){
+    return FALSE;
+  }
+  for (i=0; i<sizeof(batchRec_t); i++){
+    pDst[i] = 0;
+  }
+
+  if (!batchGet(pBatch, &delta)){
+    pBatch->left = 0;
+    return FALSE;
+  }
+  pRec->para.time = pBatch->prevTime + (uint32) delta;
+  n = batchNum(pBatch->fields);
+  for (k=0; k<n; k++){
+    if (!batchGet(pBatch, &delta)){
+      pBatch->left = 0;
+      return FALSE;
+    }
+    vals[k] = batchRef(pBatch, vals, k) + (uint16) delta;
+  }
+  pBatch->prevTime = pRec->para.time;
+  for (k=0; k<n; k++){
+    pBatch->prev[k] = vals[k];
+  }
+  pBatch->left--;
+
+  k = 0;
+  pRec->para.nodeId     = pBatch->nodeId;
+  pRec->para.run        = vals[k++];
+  pRec->para.storeBlock = vals[k++];
+  if (pBatch->fields & BATCH_DERIVED){
+    pSs->vddVal    = vals[k++];
+    pSs->intTmpVal = vals[k++];
+    pSs->pHVal     = vals[k++];
+    pSs->extTmpRes = vals[k++];
+    pSs->extTmpVal = vals[k++];
+  }
+  if (pBatch->fields & BATCH_MEAN){
+    pSs->vddAdcAvg    = vals[k++];
+    pSs->intTmpAdcAvg = vals[k++];
+    pSs->pHAdcAvg     = vals[k++];
+    pSs->extTmpAdcAvg = vals[k++];
+  }
+  if (pBatch->fields & BATCH_MINMAX){
+    pRec->pHAdcMin = vals[k++];
+    pRec->pHAdcMax = vals[k++];
+  }
+  if (pBatch->fields & BATCH_RAW){
+    for (i=0; i<16; i++){
+      pSs->pHAdc[i] = vals[k++];
+    }
+  }
+  return TRUE;
+}
+
+
+/**************************************************************************************************
+ * @brief   Alive time of a batch
+ * @param   pTime - the time of the node, if the batch carries it
+ * @return  FALSE if the batch is not an alive packet
+ **************************************************************************************************/
+bool BATCH_Alive(const batch_t *pBatch, uint32 *pTime)
+{
+  *pTime = pBatch->aliveTime;
+  return pBatch->alive;
+}
+
+
+/**************************************************************************************************
+ * @brief   Number of 16 bit values of a record with these fields
+ **************************************************************************************************/
+static uint8 batchNum(uint8 fields)
+{
+  return 2 + ((fields & BATCH_DERIVED) ? 5 : 0) + ((fields & BATCH_MEAN) ? 4 : 0) +
+         ((fields & BATCH_MINMAX) ? 2 : 0) + ((fields & BATCH_RAW) ? 16 : 0);
+}
+
+
+/**************************************************************************************************
+ * @brief   The 16 bit values of a record that a batch carries, in the order they are sent
+ * @return  number of values
+ **************************************************************************************************/
+static uint8 batchValues(const sensingPara_t *pRec, uint8 fields, uint16 *pVals)
+{
+  const sensing_t *pSs = &(pRec->sensingData);
+  uint16 lo, hi;
+  uint8  k = 0;
+  uint8  i;
+
+  pVals[k++] = pRec->run;
+  pVals[k++] = pRec->storeBlock;
+  if (fields & BATCH_DERIVED){
+    pVals[k++] = pSs->vddVal;
+    pVals[k++] = pSs->intTmpVal;
+    pVals[k++] = pSs->pHVal;
+    pVals[k++] = pSs->extTmpRes;
+    pVals[k++] = pSs->extTmpVal;
+  }
+  if (fields & BATCH_MEAN){
+    pVals[k++] = pSs->vddAdcAvg;
+    pVals[k++] = pSs->intTmpAdcAvg;
+    pVals[k++] = pSs->pHAdcAvg;
+    pVals[k++] = pSs->extTmpAdcAvg;
+  }
+  if (fields & BATCH_MINMAX){
+    lo = hi = pSs->pHAdc[0];
+    for (i=1; i<16; i++){
+      if (pSs->pHAdc[i] < lo){
+        lo = pSs->pHAdc[i];
+      }
+      if (pSs->pHAdc[i] > hi){
+        hi = pSs->pHAdc[i];
+      }
+    }
+    pVals[k++] = lo;
+    pVals[k++] = hi;
+  }
+  if (fields & BATCH_RAW){
+    for (i=0; i<16; i++){
+      pVals[k++] = pSs->pHAdc[i];
+    }
+  }
+  return k;
+}
+
+
+/**************************************************************************************************
+ * @brief   What value k of a record is sent against: the same value of the record before, or
+ *          for a raw sample after the first, the sample before it
+ **************************************************************************************************/
+static uint16 batchRef(const batch_t *pBatch, const uint16 *pVals, uint8 k)
+{
+  if ((pBatch->fields & BATCH_RAW) && (k > batchNum(pBatch->fields & ~BATCH_RAW))){
+    return pVals[k-1];
+  }
+  return pBatch->prev[k];
+}
+
+
+/**************************************************************************************************
+ * @brief   Write a change as a zigzag varint
+ * @return  FALSE if the batch is full
+ **************************************************************************************************/
+static bool batchPut(batch_t *pBatch, int32 delta)
+{
+  uint32 z = (delta < 0) ? ((((uint32) -(delta + 1)) << 1) | 1) : (((uint32) delta) << 1);
+
+  do{
+    if (pBatch->len >= pBatch->size){
+      return FALSE;
+    }
+    pBatch->pBuf[pBatch->len++] = (uint8) ((z & 0x7F) | ((z > 0x7F) ? 0x80 : 0));
+    z >>= 7;
+  } while (z != 0);
+  return TRUE;
+}
+
+
+/**************************************************************************************************
+ * @brief   Read a zigzag varint
+ * @return  FALSE if the packet ends inside it
+ **************************************************************************************************/
+static bool batchGet(batch_t *pBatch, int32 *pDelta)
+{
+  uint32 z = 0;
+  uint8  shift = 0;
+  uint8  b;
+
+  do{
+    if ((pBatch->len >= pBatch->size) || (shift >= 7 * BATCH_VARINT_MAX)){
+      return FALSE;
+    }
+    b = pBatch->pIn[pBatch->len++];
+    z |= ((uint32) (b & 0x7F)) << shift;
+    shift += 7;
+  } while (b & 0x80);
+  *pDelta = (z & 1) ? -((int32) (z >> 1)) - 1 : (int32) (z >> 1);
+  return TRUE;
+}
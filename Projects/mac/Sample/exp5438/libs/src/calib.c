@@ -0,0 +1,70 @@
+#include <stddef.h>
+/* Hal Driver includes */
+#include "hal_types.h"
+#include "hal_assert.h"
+
+#include "fram.h"
+#include "crc.h"
+#include "calib.h"
+
+/**** DEFINE ****/
+/* The FRAM copy is the structure, padding included */
+HAL_ASSERT_SIZE(calib_t, CALIB_LEN);
+
+/**** FUNCTIONs ****/
+
+/**************************************************************************************************
+ * @brief   Check a calibration before it is used, from the FRAM or from the gateway
+ * @param   pCalib - calibration
+ * @return  TRUE if the pH slope is within CALIB_PH_SLOPE_MIN..MAX and the pH offset within
+ *          CALIB_PH_OFFSET_MAX
+ **************************************************************************************************/
+bool CALIB_Valid(const calib_t *pCalib)
+{
+  return ((pCalib->pHSlope >= CALIB_PH_SLOPE_MIN) && (pCalib->pHSlope <= CALIB_PH_SLOPE_MAX) &&
+          (pCalib->pHOffset >= -CALIB_PH_OFFSET_MAX) && (pCalib->pHOffset <= CALIB_PH_OFFSET_MAX));
+}
+
+
+/**************************************************************************************************
+ * @brief   The calibration the conversions of sensing.c were written with
+ * @param   pCalib - filled in
+ **************************************************************************************************/
+void CALIB_Default(calib_t *pCalib)
+{
+  pCalib->magic        = CALIB_MAGIC;
+  pCalib->intTmpOffset = CALIB_INT_TMP_OFFSET;
+  pCalib->extTmpOffset = CALIB_EXT_TMP_OFFSET;
+  pCalib->pHOffset     = CALIB_PH_OFFSET;
+  pCalib->pHSlope      = CALIB_PH_SLOPE;
+  pCalib->crc          = CRC_Ccitt(CRC_INIT, (uint8*) pCalib, offsetof(calib_t, crc));
+}
+
+
+/**************************************************************************************************
+ * @brief   Read the calibration of this node from the FRAM
+ * @param   pCalib - filled in, with the defaults if the FRAM has none
+ * @return  TRUE if it was found
+ **************************************************************************************************/
+bool CALIB_Load(calib_t *pCalib)
+{
+  fram_readMemory(CALIB_ADDR, (uint8*) pCalib, sizeof(calib_t));
+  if ((pCalib->magic == CALIB_MAGIC) && CALIB_Valid(pCalib) &&
+      (pCalib->crc == CRC_Ccitt(CRC_INIT, (uint8*) pCalib, offsetof(calib_t, crc)))){
+    return TRUE;
+  }
+  CALIB_Default(pCalib);
+  return FALSE;
+}
+
+
+/**************************************************************************************************
+ * @brief   Write the calibration of this node to the FRAM
+ * @param   pCalib - calibration; its magic and CRC are set
+ **************************************************************************************************/
+void CALIB_Save(calib_t *pCalib)
+{
+  pCalib->magic = CALIB_MAGIC;
+  pCalib->crc   = CRC_Ccitt(CRC_INIT, (uint8*) pCalib, offsetof(calib_t, crc));
+  fram_writeMemory(CALIB_ADDR, (uint8*) pCalib, sizeof(calib_t));
+}
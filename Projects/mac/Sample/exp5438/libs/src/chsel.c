@@ -0,0 +1,143 @@
+/* Hal Driver includes */
+#include "hal_types.h"
+
+#include "chsel.h"
+
+/**** DEFINE ****/
+typedef struct{
+  uint8   energy[CHSEL_ROUNDS];
+  uint8   next;                         /* reading written next */
+  uint8   num;                          /* readings kept */
+} chselChan_t;
+
+/**** VARIABLEs  ****/
+static chselChan_t chselChans[CHSEL_NUM];
+
+/**** FUNCTIONs ****/
+static chselChan_t *chselFind(uint8 channel);
+
+
+/**************************************************************************************************
+ * @brief   Forget all readings
+ **************************************************************************************************/
+void CHSEL_Init(void)
+{
+  uint8 i;
+
+  for (i = 0; i < CHSEL_NUM; i++){
+    chselChans[i].next = 0;
+    chselChans[i].num  = 0;
+  }
+}
+
+
+/**************************************************************************************************
+ * @brief   Take in a round of readings; each replaces the oldest of its channel once
+ *          CHSEL_ROUNDS are kept
+ * @param   channels - mask of the channels scanned, bit n for channel n
+ *          pEnergy  - energy of each of them, lowest channel first
+ *          num      - number of readings in pEnergy
+ **************************************************************************************************/
+void CHSEL_Round(uint32 channels, const uint8 *pEnergy, uint8 num)
+{
+  chselChan_t *pChan;
+  uint8 ch;
+
+  for (ch = CHSEL_FIRST; (ch < CHSEL_FIRST + CHSEL_NUM) && (num != 0); ch++){
+    if (!(channels & ((uint32)1 << ch))){
+      continue;
+    }
+    pChan = &chselChans[ch - CHSEL_FIRST];
+    pChan->energy[pChan->next] = *pEnergy++;
+    pChan->next = (pChan->next + 1) % CHSEL_ROUNDS;
+    if (pChan->num < CHSEL_ROUNDS){
+      pChan->num++;
+    }
+    num--;
+  }
+}
+
+
+/**************************************************************************************************
+ * @brief   Readings kept of a channel
+ **************************************************************************************************/
+uint8 CHSEL_Readings(uint8 channel)
+{
+  chselChan_t *pChan = chselFind(channel);
+
+  return (pChan != NULL) ? pChan->num : 0;
+}
+
+
+/**************************************************************************************************
+ * @brief   Percentile of the readings of a channel, by the nearest rank.  At most CHSEL_ROUNDS
+ *          readings are sorted, by insertion.
+ * @param   channel - 11 to 26
+ *          pct     - 0 to 100
+ * @return  the reading, 0 if the channel has none
+ **************************************************************************************************/
+uint8 CHSEL_Percentile(uint8 channel, uint8 pct)
+{
+  chselChan_t *pChan = chselFind(channel);
+  uint8 sorted[CHSEL_ROUNDS];
+  uint8 i, j, e;
+
+  if ((pChan == NULL) || (pChan->num == 0)){
+    return 0;
+  }
+  for (i = 0; i < pChan->num; i++){
+    e = pChan->energy[i];
+    for (j = i; (j > 0) && (sorted[j - 1] > e); j--){
+      sorted[j] = sorted[j - 1];
+    }
+    sorted[j] = e;
+  }
+  return sorted[((uint16)pct * (pChan->num - 1) + 50) / 100];
+}
+
+
+/**************************************************************************************************
+ * @brief   Score of a channel, see chsel.h
+ * @return  the score, CHSEL_NO_SCORE if the channel has no readings
+ **************************************************************************************************/
+uint16 CHSEL_Score(uint8 channel)
+{
+  if (CHSEL_Readings(channel) == 0){
+    return CHSEL_NO_SCORE;
+  }
+  return CHSEL_W_MEDIAN * CHSEL_Percentile(channel, 50) + CHSEL_W_P90 * CHSEL_Percentile(channel, 90);
+}
+
+
+/**************************************************************************************************
+ * @brief   Channel with the lowest score
+ * @return  the channel, CHSEL_FIRST if none has readings
+ **************************************************************************************************/
+uint8 CHSEL_Best(void)
+{
+  uint8  best = CHSEL_FIRST;
+  uint16 bestScore = CHSEL_NO_SCORE;
+  uint16 score;
+  uint8  ch;
+
+  for (ch = CHSEL_FIRST; ch < CHSEL_FIRST + CHSEL_NUM; ch++){
+    score = CHSEL_Score(ch);
+    if (score < bestScore){
+      best      = ch;
+      bestScore = score;
+    }
+  }
+  return best;
+}
+
+
+/**************************************************************************************************
+ * @brief   Readings of a channel, NULL if it is not one of the band
+ **************************************************************************************************/
+static chselChan_t *chselFind(uint8 channel)
+{
+  if ((channel < CHSEL_FIRST) || (channel >= CHSEL_FIRST + CHSEL_NUM)){
+    return NULL;
+  }
+  return &chselChans[channel - CHSEL_FIRST];
+}
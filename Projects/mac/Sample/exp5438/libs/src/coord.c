@@ -0,0 +1,55 @@
+#include <stddef.h>
+/* Hal Driver includes */
+#include "hal_types.h"
+#include "hal_assert.h"
+
+#include "fram.h"
+#include "crc.h"
+#include "sched.h"
+#include "store.h"
+#include "coord.h"
+
+/**** DEFINE ****/
+/* The FRAM copy is the structure, padding included */
+HAL_ASSERT_SIZE(coord_t, COORD_LEN);
+
+#if (COORD_ADDR < SCHED_ADDR + SCHED_LEN)
+#error "ERROR! COORD_ADDR overlaps the periods"
+#endif
+
+#if (COORD_ADDR + COORD_LEN > STORE_CP_BASE)
+#error "ERROR! COORD_ADDR is out of the settings area"
+#endif
+
+/**** FUNCTIONs ****/
+
+/**************************************************************************************************
+ * @brief   Read the network of this node from the FRAM
+ * @param   pCoord - filled in if the FRAM has a valid copy, left as is if not
+ * @return  TRUE if it was found
+ **************************************************************************************************/
+bool COORD_Load(coord_t *pCoord)
+{
+  coord_t coord;
+
+  fram_readMemory(COORD_ADDR, (uint8*) &coord, sizeof(coord_t));
+  if ((coord.magic == COORD_MAGIC) &&
+      (coord.crc == CRC_Ccitt(CRC_INIT, (uint8*) &coord, offsetof(coord_t, crc)))){
+    *pCoord = coord;
+    return TRUE;
+  }
+  return FALSE;
+}
+
+
+/**************************************************************************************************
+ * @brief   Write the network of this node to the FRAM
+ * @param   pCoord - network; its magic and CRC are set
+ **************************************************************************************************/
+void COORD_Save(coord_t *pCoord)
+{
+  pCoord->magic = COORD_MAGIC;
+  pCoord->rsvd  = 0;
+  pCoord->crc   = CRC_Ccitt(CRC_INIT, (uint8*) pCoord, offsetof(coord_t, crc));
+  fram_writeMemory(COORD_ADDR, (uint8*) pCoord, sizeof(coord_t));
+}
@@ -0,0 +1,29 @@
+#include "hal_types.h"
+
+#include "crc.h"
+
+/**** CONSTANTs  ****/
+/* CRC-16/CCITT, one nibble at a time */
+static const CODE uint16 crcTable[16] =
+{
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+  0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+
+/**************************************************************************************************
+ * @brief   CRC-16/CCITT (polynomial 0x1021, not reflected)
+ * @param   crc  - CRC_INIT, or the CRC of the bytes before
+ *          pBuf - bytes
+ *          len  - number of bytes
+ * @return  CRC
+ **************************************************************************************************/
+uint16 CRC_Ccitt(uint16 crc, const uint8 *pBuf, uint16 len)
+{
+  while (len--){
+    crc ^= (uint16)(*pBuf++) << 8;
+    crc = (crc << 4) ^ crcTable[crc >> 12];
+    crc = (crc << 4) ^ crcTable[crc >> 12];
+  }
+  return crc;
+}
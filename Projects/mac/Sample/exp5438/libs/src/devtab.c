@@ -0,0 +1,316 @@
+#include <stddef.h>
+/* Hal Driver includes */
+#include "hal_types.h"
+#include "hal_assert.h"
+/* OS includes */
+#include "OSAL.h"
+
+#include "fram.h"
+#include "crc.h"
+#include "devtab.h"
+
+/**** DEFINE ****/
+typedef struct{
+  sAddrExt_t  extAddr;
+  uint8       state;
+  uint8       rsvd;
+  uint16      crc;                      /* of the fields before */
+} devRec_t;
+
+typedef struct{
+  uint16  magic;
+  uint16  size;
+} devHdr_t;
+
+#if ((DEVTAB_SIZE & (DEVTAB_SIZE - 1)) != 0)
+#error "ERROR! DEVTAB_SIZE has to be a power of 2"
+#endif
+
+/* The FRAM records are the structures, padding included */
+HAL_ASSERT_SIZE(devRec_t, DEVTAB_REC_LEN);
+HAL_ASSERT_SIZE(devHdr_t, DEVTAB_HDR_LEN);
+
+/* The table fits in its RAM budget, the way of HAL_ASSERT_SIZE() */
+typedef char devTab_assert_ram_t[-1 + 10*(DEVTAB_SIZE * sizeof(devEntry_t) <= DEVTAB_RAM_BUDGET)];
+
+#define DEVTAB_MASK               (DEVTAB_SIZE - 1)
+#define DEVTAB_REC_ADDR(slot)     (DEVTAB_ADDR + DEVTAB_HDR_LEN + (uint32)(slot) * DEVTAB_REC_LEN)
+
+/**** VARIABLEs  ****/
+static devEntry_t devTab[DEVTAB_SIZE];
+static uint16     devCount;
+static uint16     devPending;                   /* devices with commands */
+static bool       devUseFram;
+
+/**** FUNCTIONs ****/
+static uint16 devProbe(const sAddrExt_t extAddr, uint16 *pGone);
+static void   devSave(uint16 slot);
+
+
+/**************************************************************************************************
+ * @brief   Empty the table and take back the devices kept in the FRAM.  A FRAM without the
+ *          table, or with a table of another size, whose slots would give other addresses, is
+ *          cleared for this one.  A damaged record is taken as gone: the device in it is lost,
+ *          the probes still go past it to the devices after.
+ * @param   useFram - FALSE if the FRAM is not up: the table is only in RAM then
+ * @return  number of devices
+ **************************************************************************************************/
+uint16 DEVTAB_Init(bool useFram)
+{
+  devHdr_t hdr;
+  devRec_t rec;
+  uint16 slot;
+
+  osal_memset(devTab, 0, sizeof(devTab));
+  devCount   = 0;
+  devPending = 0;
+  devUseFram = useFram;
+  if (!useFram){
+    return 0;
+  }
+
+  fram_readMemory(DEVTAB_ADDR, (uint8*) &hdr, sizeof(devHdr_t));
+  if ((hdr.magic != DEVTAB_MAGIC) || (hdr.size != DEVTAB_SIZE)){
+    for (slot = 0; slot < DEVTAB_SIZE; slot++){
+      devSave(slot);
+    }
+    hdr.magic = DEVTAB_MAGIC;
+    hdr.size  = DEVTAB_SIZE;
+    fram_writeMemory(DEVTAB_ADDR, (uint8*) &hdr, sizeof(devHdr_t));
+    return 0;
+  }
+
+  for (slot = 0; slot < DEVTAB_SIZE; slot++){
+    fram_readMemory(DEVTAB_REC_ADDR(slot), (uint8*) &rec, sizeof(devRec_t));
+    if (rec.crc != CRC_Ccitt(CRC_INIT, (uint8*) &rec, offsetof(devRec_t, crc))){
+      devTab[slot].state = DEVTAB_GONE;
+    }
+    else if ((rec.state == DEVTAB_USED) || (rec.state == DEVTAB_GONE)){
+      sAddrExtCpy(devTab[slot].extAddr, rec.extAddr);
+      devTab[slot].state = rec.state;
+      if (rec.state == DEVTAB_USED){
+        devCount++;
+      }
+    }
+  }
+  return devCount;
+}
+
+
+/**************************************************************************************************
+ * @brief   Entry of an associating device.  The probe from the hash of its extended address
+ *          ends at the device, or at a free slot; a new device then takes the first gone slot
+ *          on the way, or the free one.
+ * @param   extAddr - extended address of the device
+ *          time    - stick
+ * @return  its entry, NULL if the table is full
+ **************************************************************************************************/
+devEntry_t *DEVTAB_Assoc(const sAddrExt_t extAddr, uint32 time)
+{
+  uint16 gone;
+  uint16 slot = devProbe(extAddr, &gone);
+  devEntry_t *pDev;
+
+  if ((slot < DEVTAB_SIZE) && (devTab[slot].state == DEVTAB_USED)){
+    pDev = &devTab[slot];
+    DEVTAB_Seen(pDev, time);
+    return pDev;
+  }
+  if (gone != DEVTAB_SIZE){
+    slot = gone;
+  }
+  else if (slot == DEVTAB_SIZE){
+    return NULL;
+  }
+
+  pDev = &devTab[slot];
+  osal_memset(pDev, 0, sizeof(devEntry_t));
+  sAddrExtCpy(pDev->extAddr, extAddr);
+  pDev->state    = DEVTAB_USED;
+  pDev->lastSeen = time;
+  devCount++;
+  devSave(slot);
+  return pDev;
+}
+
+
+/**************************************************************************************************
+ * @brief   A known device joins again.  Its alive packets start over: the time in the next one
+ *          is not compared with the last, its clock may have started again with a reset.
+ * @param   pDev - entry of the device
+ *          time - stick
+ * @return  None
+ **************************************************************************************************/
+void DEVTAB_Seen(devEntry_t *pDev, uint32 time)
+{
+  pDev->lastSeen    = time;
+  pDev->link.flags &= ~LSTAT_HAVE_ALIVE;
+}
+
+
+/**************************************************************************************************
+ * @brief   Entry of a known device, by the same probe as DEVTAB_Assoc()
+ * @param   extAddr - extended address of the device
+ * @return  its entry, NULL if it is not in the table
+ **************************************************************************************************/
+devEntry_t *DEVTAB_Find(const sAddrExt_t extAddr)
+{
+  uint16 gone;
+  uint16 slot = devProbe(extAddr, &gone);
+
+  if ((slot == DEVTAB_SIZE) || (devTab[slot].state != DEVTAB_USED)){
+    return NULL;
+  }
+  return &devTab[slot];
+}
+
+
+/**************************************************************************************************
+ * @brief   Device of a short address
+ * @param   shortAddr - source of a frame
+ * @return  its entry, NULL if no device has it
+ **************************************************************************************************/
+devEntry_t *DEVTAB_Get(uint16 shortAddr)
+{
+  uint16 slot = shortAddr - DEVTAB_SHORT_BASE;
+
+  if ((slot >= DEVTAB_SIZE) || (devTab[slot].state != DEVTAB_USED)){
+    return NULL;
+  }
+  return &devTab[slot];
+}
+
+
+/**************************************************************************************************
+ * @brief   Short address of a device: its slot
+ **************************************************************************************************/
+uint16 DEVTAB_Short(const devEntry_t *pDev)
+{
+  return (uint16)(pDev - devTab) + DEVTAB_SHORT_BASE;
+}
+
+
+/**************************************************************************************************
+ * @brief   Take out the devices that were not heard for too long
+ * @param   time   - stick
+ *          maxAge - sticks
+ * @return  number of devices taken out
+ **************************************************************************************************/
+uint16 DEVTAB_Age(uint32 time, uint32 maxAge)
+{
+  uint16 slot;
+  uint16 aged = 0;
+
+  for (slot = 0; slot < DEVTAB_SIZE; slot++){
+    if ((devTab[slot].state == DEVTAB_USED) && (time - devTab[slot].lastSeen > maxAge)){
+      devTab[slot].state = DEVTAB_GONE;
+      devCount--;
+      if (devTab[slot].cmds != 0){
+        devTab[slot].cmds = 0;
+        devPending--;
+      }
+      aged++;
+      devSave(slot);
+    }
+  }
+  return aged;
+}
+
+
+/**************************************************************************************************
+ * @brief   Number of devices
+ **************************************************************************************************/
+uint16 DEVTAB_Count(void)
+{
+  return devCount;
+}
+
+
+/**************************************************************************************************
+ * @brief   Commands for a device wait for its poll.  A command that waits already is not added
+ *          again: the device takes it once, with what the gateway has then.
+ * @param   pDev - device
+ *          cmds - DEVTAB_CMD() of the packet types, or'ed
+ **************************************************************************************************/
+void DEVTAB_Pend(devEntry_t *pDev, uint8 cmds)
+{
+  if ((pDev->cmds == 0) && (cmds != 0)){
+    devPending++;
+  }
+  pDev->cmds |= cmds;
+}
+
+
+/**************************************************************************************************
+ * @brief   Commands that reached a device no longer wait
+ * @param   pDev - device
+ *          cmds - DEVTAB_CMD() of the packet types that were sent, or'ed
+ **************************************************************************************************/
+void DEVTAB_Sent(devEntry_t *pDev, uint8 cmds)
+{
+  if (pDev->cmds == 0){
+    return;
+  }
+  pDev->cmds &= ~cmds;
+  if (pDev->cmds == 0){
+    devPending--;
+  }
+}
+
+
+/**************************************************************************************************
+ * @brief   Number of devices with commands waiting
+ **************************************************************************************************/
+uint16 DEVTAB_Pending(void)
+{
+  return devPending;
+}
+
+
+/**************************************************************************************************
+ * @brief   Probe from the hash of an extended address, up to the device or a free slot
+ * @param   extAddr - extended address of the device
+ *          pGone   - first gone slot on the way, DEVTAB_SIZE if none
+ * @return  slot of the device, or the free slot the probe ended at; DEVTAB_SIZE if it went
+ *          through the whole table
+ **************************************************************************************************/
+static uint16 devProbe(const sAddrExt_t extAddr, uint16 *pGone)
+{
+  uint16 slot = CRC_Ccitt(CRC_INIT, extAddr, SADDR_EXT_LEN) & DEVTAB_MASK;
+  uint16 n;
+
+  *pGone = DEVTAB_SIZE;
+  for (n = 0; n < DEVTAB_SIZE; n++){
+    if (devTab[slot].state == DEVTAB_FREE){
+      return slot;
+    }
+    if (devTab[slot].state == DEVTAB_USED){
+      if (sAddrExtCmp(devTab[slot].extAddr, extAddr)){
+        return slot;
+      }
+    }
+    else if (*pGone == DEVTAB_SIZE){
+      *pGone = slot;
+    }
+    slot = (slot + 1) & DEVTAB_MASK;
+  }
+  return DEVTAB_SIZE;
+}
+
+
+/**************************************************************************************************
+ * @brief   Write the record of a slot to the FRAM
+ **************************************************************************************************/
+static void devSave(uint16 slot)
+{
+  devRec_t rec;
+
+  if (!devUseFram){
+    return;
+  }
+  sAddrExtCpy(rec.extAddr, devTab[slot].extAddr);
+  rec.state = devTab[slot].state;
+  rec.rsvd  = 0;
+  rec.crc   = CRC_Ccitt(CRC_INIT, (uint8*) &rec, offsetof(devRec_t, crc));
+  fram_writeMemory(DEVTAB_REC_ADDR(slot), (uint8*) &rec, sizeof(devRec_t));
+}
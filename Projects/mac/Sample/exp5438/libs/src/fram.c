@@ -8,10 +8,23 @@
 
 #include "hal_types.h"
 #include "hal_mcu.h"
+#include "OSAL.h"
 #include "usci_spi.h"
 #include "fram.h"
 
 volatile uint16_t loopDelay;
+
+/* Write-combining buffer: adjacent small writes collected for one WRITE command */
+static uint8_t  wcBuf[FRAM_WC_LEN];
+static uint32_t wcAddr;
+static uint16_t wcLen;
+
+/* Event set at the end of an async transfer */
+static uint8_t  asyncTask;
+static uint16_t asyncEvent;
+
+static void fram_asyncDone(void);
+
 /*---------------------------------------------------------------------------------------*/
 error_t fram_init(uint8_t spi_mode)
 {
@@ -28,6 +41,13 @@ error_t fram_init(uint8_t spi_mode)
   WP_DISABLE();
 
   usci_spi_init(spi_mode);
+  usci_spi_setClkDiv(SPI_CLK_DIV);
+  wcLen = 0;
+
+  /* Power up time once VDD is on, before the first command */
+  for (uint16_t j=0; j<5000; j++){
+    loopDelay++;
+  }
 
   /* Test SPI Operation */
   uint8_t pDeviceID[4];
@@ -36,6 +56,7 @@ error_t fram_init(uint8_t spi_mode)
   {
     return ERROR_INIT_FAIL;
   }
+  usci_spi_setClkDiv(FRAM_CLK_DIV);
 
   return OK;
 }
@@ -56,25 +77,26 @@ static void fram_writeEnable(void)
 }
 
 /*---------------------------------------------------------------------------------------*/
-static void fram_writeDisable(void)
+/* WREN and the WRITE command; the latch is reset by the chip when CS goes high again,
+ * so every WRITE needs its own WREN and no WRDI */
+static void fram_startWrite(uint32_t startAddr)
 {
+  fram_writeEnable();
+
   CS_ENABLE();
-  usci_spi_sendByte(CMD_WRDI);
-  CS_DISABLE();
+  usci_spi_sendByte(CMD_WRITE);
+  sendAddr(startAddr);
 }
 
 /*---------------------------------------------------------------------------------------*/
 error_t fram_readMemory(uint32_t startAddr, uint8_t *pData, uint16_t size)
 {
-  uint16_t i;
+  fram_flush();
 
   CS_ENABLE();
   usci_spi_sendByte(CMD_READ);
   sendAddr(startAddr);
-  for(i = 0; i < size; i++)
-  {
-    pData[i] = usci_spi_getByte();
-  }
+  usci_spi_read(pData, size);
   CS_DISABLE();
 
   return OK;
@@ -83,67 +105,166 @@ error_t fram_readMemory(uint32_t startAddr, uint8_t *pData, uint16_t size)
 /*---------------------------------------------------------------------------------------*/
 error_t fram_fastReadMemory(uint32_t startAddr, uint8_t *pData, uint16_t size)
 {
+  fram_flush();
+
   CS_ENABLE();
   usci_spi_sendByte(CMD_FSTRD);
-  CS_ENABLE();
+  sendAddr(startAddr);
+  usci_spi_getByte();       /* dummy byte */
+  usci_spi_read(pData, size);
+  CS_DISABLE();
 
   return OK;
 }
 
 /*---------------------------------------------------------------------------------------*/
+/* Written through: the byte is in the FRAM on return */
 error_t fram_writeByte(uint32_t startAddr, uint8_t data)
 {
-  fram_writeEnable();
+  return fram_writeMemory(startAddr, &data, 1);
+}
 
-  CS_ENABLE();
-  usci_spi_sendByte(CMD_WRITE);
-  sendAddr(startAddr);
-  usci_spi_sendByte(data);
+/*---------------------------------------------------------------------------------------*/
+error_t fram_writeByteCombined(uint32_t startAddr, uint8_t data)
+{
+  return fram_writeCombined(startAddr, &data, 1);
+}
+
+/*---------------------------------------------------------------------------------------*/
+error_t fram_writeMemory(uint32_t startAddr, const uint8_t *pData, uint16_t size)
+{
+  fram_flush();
+
+  fram_startWrite(startAddr);
+  usci_spi_write(pData, size);
   CS_DISABLE();
 
-  fram_writeDisable();
+  return OK;
+}
+
+/*---------------------------------------------------------------------------------------*/
+/* Segments that continue at the address where the previous one ended share its WRITE
+ * command, so a header and its data in two buffers go out as one transfer */
+error_t fram_writeSegs(const fram_seg_t *pSegs, uint8_t count)
+{
+  uint32_t nextAddr = 0;
+  uint8_t i;
+
+  fram_flush();
+
+  for (i = 0; i < count; i++)
+  {
+    if ((i == 0) || (pSegs[i].addr != nextAddr))
+    {
+      if (i != 0)
+      {
+        CS_DISABLE();
+      }
+      fram_startWrite(pSegs[i].addr);
+    }
+    usci_spi_write(pSegs[i].pData, pSegs[i].size);
+    nextAddr = pSegs[i].addr + pSegs[i].size;
+  }
+  if (count != 0)
+  {
+    CS_DISABLE();
+  }
 
   return OK;
 }
 
 /*---------------------------------------------------------------------------------------*/
-error_t fram_writeMemory(uint32_t startAddr, const uint8_t *pData, uint16_t size)
+/* Keep the bytes in the write-combining buffer while each write continues the one before;
+ * anything else writes the buffer out first.  Writes larger than the buffer go straight
+ * to the FRAM */
+error_t fram_writeCombined(uint32_t startAddr, const uint8_t *pData, uint16_t size)
 {
   uint16_t i;
 
-  fram_writeEnable();
+  if ((wcLen != 0) && ((startAddr != wcAddr + wcLen) || (wcLen + size > FRAM_WC_LEN)))
+  {
+    fram_flush();
+  }
+  if (size > FRAM_WC_LEN)
+  {
+    return fram_writeMemory(startAddr, pData, size);
+  }
+  if (wcLen == 0)
+  {
+    wcAddr = startAddr;
+  }
+  for (i = 0; i < size; i++)
+  {
+    wcBuf[wcLen++] = pData[i];
+  }
 
-  CS_ENABLE();
-  usci_spi_sendByte(CMD_WRITE);
-  sendAddr(startAddr);
-  for(i = 0; i < size; i++)
+  return OK;
+}
+
+/*---------------------------------------------------------------------------------------*/
+/* Ends an async transfer as well, every access goes through here first */
+error_t fram_flush(void)
+{
+  usci_spi_wait();
+  if (wcLen != 0)
   {
-    usci_spi_sendByte(pData[i]);
+    fram_startWrite(wcAddr);
+    usci_spi_write(wcBuf, wcLen);
+    CS_DISABLE();
+    wcLen = 0;
   }
-  CS_DISABLE();
 
-  fram_writeDisable();
+  return OK;
+}
+
+/*---------------------------------------------------------------------------------------*/
+/* The command and address are polled, only the data goes in the background */
+error_t fram_readMemoryAsync(uint32_t startAddr, uint8_t *pData, uint16_t size,
+                             uint8_t taskId, uint16_t event)
+{
+  fram_flush();
+
+  asyncTask  = taskId;
+  asyncEvent = event;
+  CS_ENABLE();
+  usci_spi_sendByte(CMD_READ);
+  sendAddr(startAddr);
+  usci_spi_transferAsync(NULL, pData, size, fram_asyncDone);
 
   return OK;
 }
 
 /*---------------------------------------------------------------------------------------*/
-error_t fram_readDeviceID(uint8_t* pDeviceID)
+error_t fram_writeMemoryAsync(uint32_t startAddr, const uint8_t *pData, uint16_t size,
+                              uint8_t taskId, uint16_t event)
+{
+  fram_flush();
+
+  asyncTask  = taskId;
+  asyncEvent = event;
+  fram_startWrite(startAddr);
+  usci_spi_transferAsync(pData, NULL, size, fram_asyncDone);
+
+  return OK;
+}
+
+/*---------------------------------------------------------------------------------------*/
+/* From the DMA interrupt: end the command and tell the task */
+static void fram_asyncDone(void)
 {
-  unsigned char i;
+  CS_DISABLE();
+  osal_set_event(asyncTask, asyncEvent);
+}
 
+/*---------------------------------------------------------------------------------------*/
+error_t fram_readDeviceID(uint8_t* pDeviceID)
+{
+  usci_spi_wait();
   usci_spi_getByte();
-  
+
   CS_ENABLE();
-  for (uint16_t j=0; j<5000; j++){
-    loopDelay++;
-  }
-  
   usci_spi_sendByte(CMD_RDID);
-  for(i = 0; i < 4; i++)
-  {
-    pDeviceID[i] = usci_spi_getByte();
-  }
+  usci_spi_read(pDeviceID, 4);
   CS_DISABLE();
 
   return OK;
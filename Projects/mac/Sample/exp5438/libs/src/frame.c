@@ -0,0 +1,77 @@
+/* Hal Driver includes */
+#include "hal_types.h"
+#include "hal_defs.h"
+#include "hal_uart.h"
+/* OS includes */
+#include "OSAL.h"
+
+#include "crc.h"
+#include "frame.h"
+
+/**** VARIABLEs  ****/
+static uint8  frameBuf[FRAME_OVERHEAD + FRAME_MAX_PAYLOAD];
+static uint8  frameSeq;
+static uint16 frameDropped;
+
+
+/**************************************************************************************************
+ * @brief   Build a frame and queue it on the UART in one HalUARTOutBuf() call, so a full TX
+ *          buffer drops the whole frame and never a part of it.  The sequence number moves on
+ *          either way, which lets the host see the loss.
+ * @param   port     - UART port
+ *          type     - FRAME_TYPE_xxx
+ *          srcAddr  - short address of the sender
+ *          rssi     - received power, dBm
+ *          lqi      - link quality
+ *          time     - stick time of the gateway
+ *          pPayload - raw packet
+ *          len      - packet length, at most FRAME_MAX_PAYLOAD
+ * @return  TRUE if the frame was queued
+ **************************************************************************************************/
+bool FRAME_Send(uint8 port, uint8 type, uint16 srcAddr, int8 rssi, uint8 lqi, uint32 time,
+                const uint8 *pPayload, uint8 len)
+{
+  uint8 *p = frameBuf;
+  uint16 crc;
+
+  if (len > FRAME_MAX_PAYLOAD){
+    len = FRAME_MAX_PAYLOAD;
+  }
+
+  *p++ = FRAME_SYNC0;
+  *p++ = FRAME_SYNC1;
+  *p++ = FRAME_HDR_LEN + len;
+  *p++ = type;
+  *p++ = frameSeq++;
+  *p++ = LO_UINT16(srcAddr);
+  *p++ = HI_UINT16(srcAddr);
+  *p++ = (uint8)rssi;
+  *p++ = lqi;
+  *p++ = BREAK_UINT32(time, 0);
+  *p++ = BREAK_UINT32(time, 1);
+  *p++ = BREAK_UINT32(time, 2);
+  *p++ = BREAK_UINT32(time, 3);
+  osal_memcpy(p, pPayload, len);
+  p += len;
+
+  crc = CRC_Ccitt(CRC_INIT, &frameBuf[2], (uint16)(p - &frameBuf[2]));
+  *p++ = LO_UINT16(crc);
+  *p++ = HI_UINT16(crc);
+
+  if (HalUARTOutBuf(port, frameBuf, (uint16)(p - frameBuf)) == 0){
+    frameDropped++;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+
+/**************************************************************************************************
+ * @brief   Number of frames refused by a full UART
+ * @param   None
+ * @return  Frames dropped
+ **************************************************************************************************/
+uint16 FRAME_Dropped(void)
+{
+  return frameDropped;
+}
@@ -0,0 +1,116 @@
+/* Hal Driver includes */
+#include "hal_types.h"
+#include "hal_defs.h"
+
+#include "lstat.h"
+
+/**** FUNCTIONs ****/
+
+/**************************************************************************************************
+ * @brief   A frame of the node was received: the averages take it in and, unless it is the last
+ *          frame again, it is counted
+ * @param   pStat - statistics of the node
+ *          dsn   - MAC sequence number of the frame
+ *          rssi  - dBm
+ *          lqi   - link quality
+ * @return  FALSE for a duplicate
+ **************************************************************************************************/
+bool LSTAT_Frame(lstat_t *pStat, uint8 dsn, int8 rssi, uint8 lqi)
+{
+  if (pStat->flags & LSTAT_HAVE_FRAME){
+    pStat->rssiAvg += ((int16)rssi * (1 << LSTAT_AVG_SHIFT) - pStat->rssiAvg) / 8;
+    pStat->lqiAvg  += ((int16)lqi * (1 << LSTAT_AVG_SHIFT) - (int16)pStat->lqiAvg) / 8;
+    if (pStat->dsn == dsn){
+      pStat->dups++;
+      return FALSE;
+    }
+  }
+  else{
+    pStat->rssiAvg = (int16)rssi * (1 << LSTAT_AVG_SHIFT);
+    pStat->lqiAvg  = (uint16)lqi << LSTAT_AVG_SHIFT;
+    pStat->flags  |= LSTAT_HAVE_FRAME;
+  }
+  pStat->dsn = dsn;
+  pStat->frames++;
+  return TRUE;
+}
+
+
+/**************************************************************************************************
+ * @brief   The frame was an alive packet.  The periods between it and the one before, rounded,
+ *          less one, were lost; an alive packet with the time of the one before is the same one
+ *          sent again and leaves everything as it is, a time that went back is the node started
+ *          again, its gap is not counted.  A transit that changed by more than LSTAT_JITTER_MAX
+ *          is a packet held back, the first one after the association, not jitter: it only
+ *          gives the transit to compare the next one with.
+ * @param   pStat   - statistics of the node
+ *          time    - stick of the node in the packet
+ *          arrival - ms of the gateway
+ *          period  - sticks between alive packets
+ *          stickMs - ms in a stick
+ **************************************************************************************************/
+void LSTAT_Alive(lstat_t *pStat, uint32 time, uint32 arrival, uint16 period, uint16 stickMs)
+{
+  uint32 transit = arrival - time * stickMs;
+  uint16 gap, missed;
+  int32  d;
+
+  if (pStat->flags & LSTAT_HAVE_ALIVE){
+    gap = (uint16)time - pStat->aliveTime;
+    if (gap == 0){
+      return;
+    }
+    if (gap < 0x8000){
+      missed = (gap + period / 2) / period;
+      if (missed > 1){
+        pStat->lost += missed - 1;
+      }
+      d = (int32)(transit - pStat->transit);
+      if (d < 0){
+        d = -d;
+      }
+      if (d <= LSTAT_JITTER_MAX){
+        pStat->jitter += (uint16)d - ((pStat->jitter + (1 << (LSTAT_JITTER_SHIFT - 1))) >> LSTAT_JITTER_SHIFT);
+      }
+    }
+  }
+  pStat->alives++;
+  pStat->aliveTime = (uint16)time;
+  pStat->transit   = transit;
+  pStat->flags    |= LSTAT_HAVE_ALIVE;
+}
+
+
+/**************************************************************************************************
+ * @brief   The record of a node in a snapshot, see lstat.h
+ * @param   pStat     - statistics of the node
+ *          shortAddr - its address
+ *          age       - sticks since it was heard
+ *          pBuf      - LSTAT_REC_LEN bytes
+ **************************************************************************************************/
+void LSTAT_Pack(const lstat_t *pStat, uint16 shortAddr, uint32 age, uint8 *pBuf)
+{
+  int16  rssi   = (pStat->rssiAvg + ((pStat->rssiAvg < 0) ? -4 : 4)) / (1 << LSTAT_AVG_SHIFT);
+  uint16 lqi    = (pStat->lqiAvg + 4) >> LSTAT_AVG_SHIFT;
+  uint16 jitter = (pStat->jitter + (1 << (LSTAT_JITTER_SHIFT - 1))) >> LSTAT_JITTER_SHIFT;
+
+  if (age > 0xFFFF){
+    age = 0xFFFF;
+  }
+  pBuf[0]  = LO_UINT16(shortAddr);
+  pBuf[1]  = HI_UINT16(shortAddr);
+  pBuf[2]  = (uint8)(int8)rssi;
+  pBuf[3]  = (uint8)lqi;
+  pBuf[4]  = LO_UINT16(pStat->frames);
+  pBuf[5]  = HI_UINT16(pStat->frames);
+  pBuf[6]  = LO_UINT16(pStat->dups);
+  pBuf[7]  = HI_UINT16(pStat->dups);
+  pBuf[8]  = LO_UINT16(pStat->alives);
+  pBuf[9]  = HI_UINT16(pStat->alives);
+  pBuf[10] = LO_UINT16(pStat->lost);
+  pBuf[11] = HI_UINT16(pStat->lost);
+  pBuf[12] = LO_UINT16(jitter);
+  pBuf[13] = HI_UINT16(jitter);
+  pBuf[14] = LO_UINT16((uint16)age);
+  pBuf[15] = HI_UINT16((uint16)age);
+}
@@ -0,0 +1,200 @@
+/* Hal Driver includes */
+#include "hal_mcu.h"
+/* OS includes */
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+/* MAC Application Interface */
+#include "mac_api.h"
+#include "mac_main.h"
+
+#include "mac_callback.h"
+
+/**** DEFINE   ****/
+#define MACCB_MAX_EVENT           MAC_MLME_POLL_IND
+#define MACCB_ALL_FREE            ((uint8)((1 << MACCB_SLOTS) - 1))
+
+/**** TYPEDEFs  ****/
+/* An OSAL message header and room for any MAC event, so a slot can go through osal_msg_send() */
+typedef struct{
+  osal_msg_hdr_t   hdr;
+  macCbackEvent_t  evt;
+} maccbSlot_t;
+
+/**** CONSTANTs  ****/
+/* Size table for MAC structures; an event is copied with its own size, never the whole union */
+static const CODE uint8 maccbSizeTable [] =
+{
+  0,                                   /* unused */
+  sizeof(macMlmeAssociateInd_t),       /* MAC_MLME_ASSOCIATE_IND */
+  sizeof(macMlmeAssociateCnf_t),       /* MAC_MLME_ASSOCIATE_CNF */
+  sizeof(macMlmeDisassociateInd_t),    /* MAC_MLME_DISASSOCIATE_IND */
+  sizeof(macMlmeDisassociateCnf_t),    /* MAC_MLME_DISASSOCIATE_CNF */
+  sizeof(macMlmeBeaconNotifyInd_t),    /* MAC_MLME_BEACON_NOTIFY_IND */
+  sizeof(macMlmeOrphanInd_t),          /* MAC_MLME_ORPHAN_IND */
+  sizeof(macMlmeScanCnf_t),            /* MAC_MLME_SCAN_CNF */
+  sizeof(macMlmeStartCnf_t),           /* MAC_MLME_START_CNF */
+  sizeof(macMlmeSyncLossInd_t),        /* MAC_MLME_SYNC_LOSS_IND */
+  sizeof(macMlmePollCnf_t),            /* MAC_MLME_POLL_CNF */
+  sizeof(macMlmeCommStatusInd_t),      /* MAC_MLME_COMM_STATUS_IND */
+  sizeof(macMcpsDataCnf_t),            /* MAC_MCPS_DATA_CNF */
+  sizeof(macMcpsDataInd_t),            /* MAC_MCPS_DATA_IND */
+  sizeof(macMcpsPurgeCnf_t),           /* MAC_MCPS_PURGE_CNF */
+  sizeof(macEventHdr_t),               /* MAC_PWR_ON_CNF */
+  sizeof(macMlmePollInd_t)             /* MAC_MLME_POLL_IND */
+};
+
+/**** VARIABLEs  ****/
+static maccbSlot_t maccbSlots[MACCB_SLOTS];
+static uint8       maccbFree = MACCB_ALL_FREE;   /* bit i set when slot i is free */
+static uint8       maccbUsed;
+static uint8       maccbHighWater;
+static uint8       maccbTaskId = TASK_NO_TASK;
+static uint16      maccbDropped[MACCB_MAX_EVENT + 1];  /* [0] is the total */
+
+/**** LOCAL FUNCTIONs  ****/
+static void MACCB_Drop(macCbackEvent_t *pData);
+
+
+/**************************************************************************************************
+ * @brief   Set the task that receives the MAC events and free all slots
+ * @param   taskId - OSAL task of the application
+ * @return  None
+ **************************************************************************************************/
+void MACCB_Init(uint8 taskId)
+{
+  maccbTaskId    = taskId;
+  maccbFree      = MACCB_ALL_FREE;
+  maccbUsed      = 0;
+  maccbHighWater = 0;
+  osal_memset(maccbDropped, 0, sizeof(maccbDropped));
+}
+
+
+/**************************************************************************************************
+ * @brief   Forward a MAC event to the application task without a heap allocation.
+ *          A data indication is already an OSAL message and is passed by reference.  Every
+ *          other event lives on the MAC's stack, so it is copied once into a free slot of a
+ *          static pool.  An event that finds no free slot is counted as dropped.  May be
+ *          called from interrupt context.
+ * @param   pData - event from MAC_CbackEvent()
+ * @return  None
+ **************************************************************************************************/
+void MACCB_Event(macCbackEvent_t *pData)
+{
+  halIntState_t intState;
+  maccbSlot_t  *pSlot = NULL;
+  uint8         idx;
+
+  if ((maccbTaskId >= tasksCnt) || (pData->hdr.event > MACCB_MAX_EVENT)){
+    MACCB_Drop(pData);     /* MACCB_Init() not called yet, or an unknown event */
+    return;
+  }
+
+  if (pData->hdr.event == MAC_MCPS_DATA_IND){
+    (void)osal_msg_send(maccbTaskId, (uint8 *)pData);
+    return;
+  }
+
+  HAL_ENTER_CRITICAL_SECTION(intState);
+  if (maccbFree != 0){
+    for (idx = 0; !(maccbFree & (1 << idx)); idx++);
+    maccbFree &= ~(1 << idx);
+    if (++maccbUsed > maccbHighWater){
+      maccbHighWater = maccbUsed;
+    }
+    pSlot = &maccbSlots[idx];
+  }
+  HAL_EXIT_CRITICAL_SECTION(intState);
+
+  if (pSlot == NULL){
+    MACCB_Drop(pData);
+    return;
+  }
+
+  pSlot->hdr.next    = NULL;
+  pSlot->hdr.len     = maccbSizeTable[pData->hdr.event];
+  pSlot->hdr.dest_id = TASK_NO_TASK;
+  osal_memcpy(&pSlot->evt, pData, maccbSizeTable[pData->hdr.event]);
+
+  (void)osal_msg_send(maccbTaskId, (uint8 *)(&pSlot->hdr + 1));
+}
+
+
+/**************************************************************************************************
+ * @brief   Release a MAC event the application has processed: a slot goes back to the pool,
+ *          a data indication back to the heap.
+ * @param   pMsg - message from osal_msg_receive()
+ * @return  None
+ **************************************************************************************************/
+void MACCB_Free(uint8 *pMsg)
+{
+  halIntState_t intState;
+  osal_msg_hdr_t *pHdr = (osal_msg_hdr_t *)pMsg - 1;
+  uint8 idx;
+
+  for (idx = 0; idx < MACCB_SLOTS; idx++){
+    if (pHdr == &maccbSlots[idx].hdr){
+      HAL_ENTER_CRITICAL_SECTION(intState);
+      maccbFree |= (1 << idx);
+      maccbUsed--;
+      HAL_EXIT_CRITICAL_SECTION(intState);
+      return;
+    }
+  }
+
+  mac_msg_deallocate(&pMsg);
+}
+
+
+/**************************************************************************************************
+ * @brief   Number of MAC events lost, in total or of one type
+ * @param   event - MAC event type
+ * @return  Events dropped
+ **************************************************************************************************/
+uint16 MACCB_Dropped(void)
+{
+  return maccbDropped[0];
+}
+
+uint16 MACCB_DroppedEvent(uint8 event)
+{
+  return ((event != 0) && (event <= MACCB_MAX_EVENT)) ? maccbDropped[event] : 0;
+}
+
+
+/**************************************************************************************************
+ * @brief   Most slots that were ever in use at the same time
+ * @param   None
+ * @return  High water mark of the pool
+ **************************************************************************************************/
+uint8 MACCB_HighWater(void)
+{
+  return maccbHighWater;
+}
+
+
+/**************************************************************************************************
+ * @brief   Count a lost event and free what the application would have freed: a data
+ *          indication, or the request buffer of a data confirm.
+ * @param   pData - event from MAC_CbackEvent()
+ * @return  None
+ **************************************************************************************************/
+static void MACCB_Drop(macCbackEvent_t *pData)
+{
+  halIntState_t intState;
+  uint8 event = pData->hdr.event;
+
+  if (event == MAC_MCPS_DATA_IND){
+    mac_msg_deallocate((uint8 **)&pData);
+  }
+  else if (event == MAC_MCPS_DATA_CNF){
+    mac_msg_deallocate((uint8 **)&pData->dataCnf.pDataReq);
+  }
+
+  HAL_ENTER_CRITICAL_SECTION(intState);
+  maccbDropped[0]++;
+  if (event <= MACCB_MAX_EVENT){
+    maccbDropped[event]++;
+  }
+  HAL_EXIT_CRITICAL_SECTION(intState);
+}
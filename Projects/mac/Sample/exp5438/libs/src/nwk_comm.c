@@ -11,16 +11,30 @@ scan_result_t scanResult;
 
 
 /**************************************************************************************************
- * @brief   Performs active scan on specified channel
- * @param   None
+ * @brief   Performs a scan on all the channels of the network
+ * @param   scanType     - MAC_SCAN_xxx
+ *          scanDuration - exponent of the time on a channel
  * @return  None
  **************************************************************************************************/
 void NWK_ScanReq(uint8 scanType, uint8 scanDuration)
+{
+  NWK_ScanChannelsReq(scanType, NWK_SCAN_CHANNELS, scanDuration);
+}
+
+
+/**************************************************************************************************
+ * @brief   Performs a scan on some channels only
+ * @param   scanType     - MAC_SCAN_xxx
+ *          scanChannels - MAC_CHAN_xx_MASK or'ed
+ *          scanDuration - exponent of the time on a channel
+ * @return  None
+ **************************************************************************************************/
+void NWK_ScanChannelsReq(uint8 scanType, uint32 scanChannels, uint8 scanDuration)
 {
   macMlmeScanReq_t scanReq;
 
   /* Fill in information for scan request structure */
-  scanReq.scanChannels  = NWK_SCAN_CHANNELS;
+  scanReq.scanChannels  = scanChannels;
   scanReq.scanType      = scanType;
   scanReq.scanDuration  = scanDuration;
   scanReq.maxResults    = NWK_MAC_MAX_RESULTS;
@@ -1,8 +1,11 @@
 #include "packet.h"
+#include "batch.h"
+#include "wire.h"
 #include "hal_uart.h"
 
 static void _PrintAlivePkt(alivePara_t* alivePara);
 static void _PrintSensingPkt(sensingPara_t* sensingPara);
+static void _PrintBatchPkt(const uint8* pBuf, uint8 len);
 
 
 /***************************************************/
@@ -22,15 +25,46 @@ static void _PrintSensingPkt(sensingPara_t* sensingPara){
 
 
 
-/******************************************************/
-void PKT_Print(pkt_t* pkt){
-  switch(pkt->pktType){
+/* Every record of a batch as a sensing packet, after the alive packet it stands for */
+static void _PrintBatchPkt(const uint8* pBuf, uint8 len){
+  batch_t     batch;
+  batchRec_t  rec;
+  alivePara_t alive;
+
+  if (!BATCH_DecodeStart(&batch, pBuf, len)){
+    return;
+  }
+  if (BATCH_Alive(&batch, &(alive.curTime))){
+    alive.nodeId = batch.nodeId;
+    _PrintAlivePkt(&alive);
+  }
+  HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "BATCH: records ", BATCH_Count(&batch), 10);
+  while (BATCH_DecodeNext(&batch, &rec)){
+    _PrintSensingPkt(&(rec.para));
+  }
+}
+
+
+
+/* A packet as received, in the wire format */
+void PKT_Print(const uint8* pBuf, uint8 len){
+  pkt_t pkt;
+
+  if ((len != 0) && (PKT_BATCH_TYPE == pBuf[0])){
+    _PrintBatchPkt(pBuf, len);
+    return;
+  }
+  if (!WIRE_Decode(pBuf, len, &pkt)){
+    HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "PKT: unknown, bytes ", len, 10);
+    return;
+  }
+  switch(pkt.pktType){
     case PKT_ALIVE_TYPE:
-      _PrintAlivePkt(&(pkt->pktPara.alivePara));
+      _PrintAlivePkt(&(pkt.pktPara.alivePara));
       break;
 
     case PKT_SENSING_TYPE:
-      _PrintSensingPkt(&(pkt->pktPara.sensingPara));
+      _PrintSensingPkt(&(pkt.pktPara.sensingPara));
     break;
   }
 }
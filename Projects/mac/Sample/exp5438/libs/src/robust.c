@@ -0,0 +1,207 @@
+#include "hal_types.h"
+
+#include "robust.h"
+
+/**** CONSTANTs  ****/
+/* Batcher's odd-even merge sort of 16, without the comparators that cannot move the middle
+ * two: 53 compare-exchanges put the 8th and 9th smallest at [7] and [8] */
+static const CODE uint8 robustMedianNet[53][2] =
+{
+  { 0, 1}, { 2, 3}, { 0, 2}, { 1, 3}, { 1, 2}, { 4, 5}, { 6, 7}, { 4, 6},
+  { 5, 7}, { 5, 6}, { 0, 4}, { 2, 6}, { 2, 4}, { 1, 5}, { 3, 7}, { 3, 5},
+  { 1, 2}, { 3, 4}, { 5, 6}, { 8, 9}, {10,11}, { 8,10}, { 9,11}, { 9,10},
+  {12,13}, {14,15}, {12,14}, {13,15}, {13,14}, { 8,12}, {10,14}, {10,12},
+  { 9,13}, {11,15}, {11,13}, { 9,10}, {11,12}, {13,14}, { 0, 8}, { 4,12},
+  { 4, 8}, { 2,10}, { 6,14}, { 6,10}, { 6, 8}, { 1, 9}, { 5,13}, { 5, 9},
+  { 3,11}, { 7,15}, { 7,11}, { 7, 9}, { 7, 8}
+};
+
+#define ROBUST_MEDIAN_CE          (sizeof(robustMedianNet) / sizeof(robustMedianNet[0]))
+
+/**** FUNCTIONs ****/
+static uint16 robustMid(uint16 a, uint16 b);
+
+
+/**************************************************************************************************
+ * @brief   Mean of the 8 samples closest to the mean of all 16, exactly as the exchange sort
+ *          it replaces picked them, ties included.  Only the first 8 passes of that sort decide
+ *          which samples are kept, and the distance and the index of a sample share one word,
+ *          distance << 4 | index, so a pass compares and swaps one array instead of two.
+ * @param   pData - 16 samples of 12 bits
+ * @return  filtered mean
+ **************************************************************************************************/
+uint16 ROBUST_FilterAvg(const uint16 *pData)
+{
+  uint16 key[ROBUST_NUM_SAMPLES];
+  uint16 sum, avg, swap, dist;
+  uint8 i, pos;
+
+  sum = 0;
+  for (i=0; i<ROBUST_NUM_SAMPLES; i++){
+    sum += pData[i];
+  }
+  avg = sum >> 4;
+  for (i=0; i<ROBUST_NUM_SAMPLES; i++){
+    dist   = (pData[i] > avg) ? (pData[i] - avg) : (avg - pData[i]);
+    key[i] = (dist << 4) | i;
+  }
+
+  for (i=0; i<8; i++){
+    for (pos=i+1; pos<ROBUST_NUM_SAMPLES; pos++){
+      if (key[pos] < (key[i] & 0xFFF0)){   /* distance strictly smaller */
+        swap     = key[i];
+        key[i]   = key[pos];
+        key[pos] = swap;
+      }
+    }
+  }
+
+  sum = 0;
+  for (i=0; i<8; i++){
+    sum += pData[key[i] & 0x0F];
+  }
+  return sum >> 3;
+}
+
+
+/**************************************************************************************************
+ * @brief   Median of 16 samples by a sorting network: no data dependent branches, a fixed 53
+ *          compare-exchanges
+ * @param   pData - 16 samples
+ * @return  mean of the 8th and 9th smallest, rounded down
+ **************************************************************************************************/
+uint16 ROBUST_Median16(const uint16 *pData)
+{
+  uint16 v[ROBUST_NUM_SAMPLES];
+  uint16 a, b;
+  uint8 i;
+
+  for (i=0; i<ROBUST_NUM_SAMPLES; i++){
+    v[i] = pData[i];
+  }
+  for (i=0; i<ROBUST_MEDIAN_CE; i++){
+    a = v[robustMedianNet[i][0]];
+    b = v[robustMedianNet[i][1]];
+    if (a > b){
+      v[robustMedianNet[i][0]] = b;
+      v[robustMedianNet[i][1]] = a;
+    }
+  }
+  return robustMid(v[7], v[8]);
+}
+
+
+/**************************************************************************************************
+ * @brief   Trimmed mean by partial selection: each pass moves the lowest and the highest sample
+ *          left to the two ends, 'trim' passes over a shrinking range, no full sort
+ * @param   pData - samples, left reordered
+ *          n     - number of samples
+ *          trim  - samples dropped at each end, 2 * trim < n
+ * @return  mean of the others, rounded down
+ **************************************************************************************************/
+uint16 ROBUST_TrimmedMean(uint16 *pData, uint8 n, uint8 trim)
+{
+  uint8 lo = 0, hi = n - 1;
+  uint8 i, iMin, iMax;
+  uint16 swap;
+  uint32 sum = 0;
+
+  if (2 * trim >= n){
+    return 0;
+  }
+  while (trim--){
+    iMin = iMax = lo;
+    for (i=lo+1; i<=hi; i++){
+      if (pData[i] < pData[iMin]){
+        iMin = i;
+      }
+      else if (pData[i] > pData[iMax]){
+        iMax = i;
+      }
+    }
+    swap = pData[lo]; pData[lo] = pData[iMin]; pData[iMin] = swap;
+    if (iMax == lo){
+      iMax = iMin;                        /* the highest was just moved */
+    }
+    swap = pData[hi]; pData[hi] = pData[iMax]; pData[iMax] = swap;
+    lo++;
+    hi--;
+  }
+  for (i=lo; i<=hi; i++){
+    sum += pData[i];
+  }
+  return (uint16)(sum / (uint8)(hi - lo + 1));
+}
+
+
+/**************************************************************************************************
+ * @brief   Start a stream
+ **************************************************************************************************/
+void ROBUST_StreamInit(robustStream_t *pStream)
+{
+  pStream->n = 0;
+}
+
+
+/**************************************************************************************************
+ * @brief   Insert a sample at its place, as it arrives; short enough for the ADC ISR.  Samples
+ *          after ROBUST_STREAM_LEN are dropped.
+ **************************************************************************************************/
+void ROBUST_StreamAdd(robustStream_t *pStream, uint16 sample)
+{
+  uint8 i = pStream->n;
+
+  if (i >= ROBUST_STREAM_LEN){
+    return;
+  }
+  while ((i > 0) && (pStream->sorted[i - 1] > sample)){
+    pStream->sorted[i] = pStream->sorted[i - 1];
+    i--;
+  }
+  pStream->sorted[i] = sample;
+  pStream->n++;
+}
+
+
+/**************************************************************************************************
+ * @brief   Median of the samples so far; for an even number, the middle two as ROBUST_Median16
+ **************************************************************************************************/
+uint16 ROBUST_StreamMedian(const robustStream_t *pStream)
+{
+  uint8 n = pStream->n;
+
+  if (n == 0){
+    return 0;
+  }
+  if (n & 1){
+    return pStream->sorted[n / 2];
+  }
+  return robustMid(pStream->sorted[n / 2 - 1], pStream->sorted[n / 2]);
+}
+
+
+/**************************************************************************************************
+ * @brief   Trimmed mean of the samples so far, the same as ROBUST_TrimmedMean() on them
+ **************************************************************************************************/
+uint16 ROBUST_StreamTrimmedMean(const robustStream_t *pStream, uint8 trim)
+{
+  uint32 sum = 0;
+  uint8 i;
+
+  if (2 * trim >= pStream->n){
+    return 0;
+  }
+  for (i=trim; i<pStream->n-trim; i++){
+    sum += pStream->sorted[i];
+  }
+  return (uint16)(sum / (uint8)(pStream->n - 2 * trim));
+}
+
+
+/**************************************************************************************************
+ * @brief   (a + b) / 2 rounded down, without overflow
+ **************************************************************************************************/
+static uint16 robustMid(uint16 a, uint16 b)
+{
+  return (a >> 1) + (b >> 1) + (a & b & 1);
+}
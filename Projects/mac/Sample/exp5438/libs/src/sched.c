@@ -0,0 +1,123 @@
+#include <stddef.h>
+/* Hal Driver includes */
+#include "hal_types.h"
+#include "hal_assert.h"
+
+#include "fram.h"
+#include "crc.h"
+#include "calib.h"
+#include "sched.h"
+
+/**** DEFINE ****/
+/* The FRAM copy is the structure, padding included */
+HAL_ASSERT_SIZE(sched_t, SCHED_LEN);
+
+#if (SCHED_ADDR < CALIB_ADDR + CALIB_LEN)
+#error "ERROR! SCHED_ADDR overlaps the calibration"
+#endif
+
+/**** FUNCTIONs ****/
+static uint32 schedAfter(uint32 time, uint16 period, uint16 phase);
+
+
+/**************************************************************************************************
+ * @brief   Check periods before they are used
+ * @param   pSched - periods
+ * @return  TRUE if none is 0 and preparingDelta is shorter than sensingTime
+ **************************************************************************************************/
+bool SCHED_Valid(const sched_t *pSched)
+{
+  return ((pSched->sensingTime != 0) && (pSched->sendAliveTime != 0) &&
+          (pSched->preparingDelta < pSched->sensingTime));
+}
+
+
+/**************************************************************************************************
+ * @brief   Read the periods of this node from the FRAM
+ * @param   pSched - filled in if the FRAM has valid ones, left as is if not
+ * @return  TRUE if they were found
+ **************************************************************************************************/
+bool SCHED_Load(sched_t *pSched)
+{
+  sched_t sched;
+
+  fram_readMemory(SCHED_ADDR, (uint8*) &sched, sizeof(sched_t));
+  if ((sched.magic == SCHED_MAGIC) && SCHED_Valid(&sched) &&
+      (sched.crc == CRC_Ccitt(CRC_INIT, (uint8*) &sched, offsetof(sched_t, crc)))){
+    *pSched = sched;
+    return TRUE;
+  }
+  return FALSE;
+}
+
+
+/**************************************************************************************************
+ * @brief   Write the periods of this node to the FRAM
+ * @param   pSched - periods; their magic and CRC are set
+ **************************************************************************************************/
+void SCHED_Save(sched_t *pSched)
+{
+  pSched->magic = SCHED_MAGIC;
+  pSched->crc   = CRC_Ccitt(CRC_INIT, (uint8*) pSched, offsetof(sched_t, crc));
+  fram_writeMemory(SCHED_ADDR, (uint8*) pSched, sizeof(sched_t));
+}
+
+
+/**************************************************************************************************
+ * @brief   What is due at a stick
+ * @param   pSched - periods
+ *          time   - stick
+ * @return  SCHED_ALIVE, SCHED_SENSE and SCHED_PREPARE or'ed, 0 for a stick to sleep through
+ **************************************************************************************************/
+uint8 SCHED_Due(const sched_t *pSched, uint32 time)
+{
+  uint8 due = 0;
+
+  if (0 == (time % pSched->sendAliveTime)){
+    due |= SCHED_ALIVE;
+  }
+  if (0 == (time % pSched->sensingTime)){
+    due |= SCHED_SENSE;
+  }
+  else if (0 == ((time + pSched->preparingDelta) % pSched->sensingTime)){
+    due |= SCHED_PREPARE;
+  }
+  return due;
+}
+
+
+/**************************************************************************************************
+ * @brief   Next stick with something to do, so the stick timer is set once for it.  Three
+ *          divisions, whatever the number of sticks slept through.
+ * @param   pSched - periods
+ *          time   - current stick
+ * @return  first stick after 'time' where SCHED_Due() is not 0
+ **************************************************************************************************/
+uint32 SCHED_Next(const sched_t *pSched, uint32 time)
+{
+  uint32 next = schedAfter(time, pSched->sendAliveTime, 0);
+  uint32 t;
+
+  t = schedAfter(time, pSched->sensingTime, 0);
+  if (t < next){
+    next = t;
+  }
+  if (pSched->preparingDelta != 0){
+    t = schedAfter(time, pSched->sensingTime, pSched->sensingTime - pSched->preparingDelta);
+    if (t < next){
+      next = t;
+    }
+  }
+  return next;
+}
+
+
+/**************************************************************************************************
+ * @brief   First stick after 'time' that is 'phase' sticks into a period
+ **************************************************************************************************/
+static uint32 schedAfter(uint32 time, uint16 period, uint16 phase)
+{
+  uint32 t = time + period - phase;
+
+  return t - (t % period) + phase;
+}
@@ -1,8 +1,11 @@
 #include "hal_types.h"
 #include "hal_adc.h"
 #include "hal_mcu.h"
+#include "hal_board_cfg.h"
 #include "hal_uart.h"
+#include "OSAL.h"
 
+#include "robust.h"
 #include "sensing.h"
 
 #define ADC_PORT_DIR     P6DIR
@@ -13,19 +16,68 @@
 #define ADC_EXT_TMP_CHANNEL   ADC12INCH_4
 #define ADC_INT_TMP_CHANNEL   ADC12INCH_10
 #define ADC_VDD_CHANNEL       ADC12INCH_11
-//////////////////////////////////////////////
-uint16_t AvgWithFilter(uint16_t inData[16]);
-uint16_t _SS_GetAdc(uint8_t channel);
 
-int32_t  intTmpOffsetCalib = -30; /* mV */
-int32_t  extTmpOffsetCalib = 0; /* mV */
-int32_t  pHOffsetCalib     = 0; /* mV */
+/* One sequence converts the four channels into ADC12MEM0..3; it is repeated SS_NUM_SAMPLES
+ * times by the ADC on its own, the ISR only copies the results out */
+#define SS_NUM_SAMPLES        ROBUST_NUM_SAMPLES
+
+/* Samples dropped at each end by SS_FILTER_TRIMMED */
+#define SS_TRIM               4
+
+/* NTC of the external probe against 47k: resistance where the reading goes from one degree
+ * to the next, ascending, in 0.01 C.  The knots are the steps of the probe's table; the two
+ * at the ends carry its first and last step on by one degree.  The reciprocal of the width of
+ * each segment is worked out by the compiler, so interpolating costs no divide */
+typedef struct{
+  uint16_t res;                       /* ohm */
+  int16_t  cdeg;                      /* 0.01 C */
+  uint16_t invW;                      /* 2^24 / (res of the next knot - res) */
+} ssNtc_t;
+
+#define SS_NTC_KNOT(res, cdeg, resNext)  {res, cdeg, (uint16_t) ((1UL << 24) / ((resNext) - (res)))}
+#define SS_NTC_LAST(res, cdeg)           {res, cdeg, 0}
+#define SS_NTC_KNOTS          12
+#define SS_NTC_RREF           47000UL
+
+static const CODE ssNtc_t ssNtc[SS_NTC_KNOTS] = {
+  SS_NTC_KNOT(17150, 3650, 17700),
+  SS_NTC_KNOT(17700, 3550, 18200),
+  SS_NTC_KNOT(18200, 3450, 18800),
+  SS_NTC_KNOT(18800, 3350, 19350),
+  SS_NTC_KNOT(19350, 3250, 19900),
+  SS_NTC_KNOT(19900, 3150, 20450),
+  SS_NTC_KNOT(20450, 3050, 21000),
+  SS_NTC_KNOT(21000, 2950, 22200),
+  SS_NTC_KNOT(22200, 2850, 23500),
+  SS_NTC_KNOT(23500, 2750, 25000),
+  SS_NTC_KNOT(25000, 2650, 26600),
+  SS_NTC_LAST(26600, 2550)
+};
+//////////////////////////////////////////////
+static uint16_t ssAdc[SS_NUM_CHANNELS][SS_NUM_SAMPLES];   /* in the order of SS_CH_xxx */
+static robustStream_t ssStream[SS_NUM_CHANNELS];
+static uint8_t  ssFilter[SS_NUM_CHANNELS] = {SS_FILTER_LEGACY, SS_FILTER_LEGACY,
+                                             SS_FILTER_LEGACY, SS_FILTER_LEGACY};
+static volatile uint8_t ssNumDone;
+static uint8_t  ssTaskId;
+static uint16_t ssEvent;
+
+/* Calibration, as SS_SetCalib() prepared it for the conversions */
+static int32_t  ssIntTmpOffset;       /* mV */
+static int16_t  ssExtTmpOffset;       /* ADC counts */
+static int16_t  ssPhOffset;           /* ADC counts */
+static uint32_t ssPhRecip[SS_NTC_KNOTS];  /* 2^16*625000/(4096*slope), slope at each knot */
+
+static uint16_t SS_Filter(uint8_t channel);
+static int16_t  SS_NtcTemp(uint16_t res, uint32_t *pPhRecip);
 
 //////////////////////////////////////////////
 /**
   * @brief Set pin mode
   */
 void SS_Init(void){
+  calib_t calib;
+
   ADC_PORT_DIR = 0; //input
   ADC_PORT_REN = 0; //no pull-up/pull-down resistor
   ADC_PORT_SEL = 0xFF; //peripheral I/O
@@ -35,6 +87,28 @@ void SS_Init(void){
   ADC12IE = 0;
 
   REFCTL0 &= ~REFMSTR; /*allo ADC reg config REF */
+
+  CALIB_Default(&calib);
+  SS_SetCalib(&calib);
+}
+
+
+
+/**
+  * @brief Take a calibration for the conversions.  The pH slope depends on the temperature;
+  *        its reciprocal is worked out here at every knot of the NTC table, and SS_Measure()
+  *        interpolates it along with the temperature instead of dividing.
+  */
+void SS_SetCalib(const calib_t *pCalib){
+  uint8_t i;
+
+  ssIntTmpOffset = pCalib->intTmpOffset;
+  ssExtTmpOffset = (int16_t) ((((int32_t) pCalib->extTmpOffset) * 4096) / 2500);
+  ssPhOffset     = (int16_t) ((((int32_t) pCalib->pHOffset) * 4096) / 2500);
+  for (i=0; i<SS_NTC_KNOTS; i++){
+    /* 2^16*625000/(4096*(slope + t)) = 10^9/(100*slope + t in 0.01 C) */
+    ssPhRecip[i] = 1000000000UL / (((uint32_t) pCalib->pHSlope) * 100 + ssNtc[i].cdeg);
+  }
 }
 
 
@@ -49,71 +123,97 @@ void SS_Prepare(void){
   ADC12CTL0 = ADC12SHT1_12 + ADC12SHT0_12 + ADC12REF2_5V + ADC12REFON + ADC12ON;
   /* preDivide 1, on Temp, Resolution 12, unsigned binary, 5max 200ksps, out ref continously */
   ADC12CTL2 = ADC12RES_2  + ADC12REFOUT;
-  /* StartMem0, SH trigger, SAMCON timer, clk div 8, Master clock, one channel */
-  ADC12CTL1 = ADC12CSTARTADD_0 + ADC12SHS_0 + ADC12SHP + ADC12DIV_7 + ADC12SSEL_2 + ADC12CONSEQ_0;
+  /* StartMem0, SH trigger, SAMCON timer, clk div 3, MODOSC, repeat sequence.  The sequence
+   * runs while the node sleeps in LPM3, which stops MCLK; MODOSC is started on request of the
+   * ADC12 in any mode.  At 4.8 MHz / 3 the samples take about as long as on MCLK / 8 */
+  ADC12CTL1 = ADC12CSTARTADD_0 + ADC12SHS_0 + ADC12SHP + ADC12DIV_2 + ADC12SSEL_0 + ADC12CONSEQ_3;
+  /* the sequence, in the order the samples were taken one by one before */
+  ADC12MCTL0 = ADC12SREF1 + ADC_VDD_CHANNEL;
+  ADC12MCTL1 = ADC12SREF1 + ADC_INT_TMP_CHANNEL;
+  ADC12MCTL2 = ADC12SREF1 + ADC_PH_CHANNEL;
+  ADC12MCTL3 = ADC12EOS + ADC12SREF1 + ADC_EXT_TMP_CHANNEL;
 }
 
 
 
 /**
-  * @brief Set pin mode, set ADC clock
+  * @brief Start sampling after SS_Prepare(), and return at once.  The ADC runs the sequence
+  *        SS_NUM_SAMPLES times, then 'event' is set for 'taskId' and SS_Measure() gives the
+  *        results.  About 40 ms with the 1024 clock sample time.
   */
-void SS_Measure(sensing_t *ssResult){
-  uint16_t index;
-  uint16_t vddAdc[16], intTmpAdc[16], extTmpAdc[16];
-  int32_t val, tmp;
-
-  for (index=0; index<16; index++){
-    vddAdc[index]              = _SS_GetAdc(ADC_VDD_CHANNEL);
-    intTmpAdc[index]           = _SS_GetAdc(ADC_INT_TMP_CHANNEL);
-    ssResult->pHAdc[index]     = _SS_GetAdc(ADC_PH_CHANNEL);
-    extTmpAdc[index]           = _SS_GetAdc(ADC_EXT_TMP_CHANNEL);
+void SS_Start(uint8_t taskId, uint16_t event){
+  uint8_t ch;
+
+  ssTaskId  = taskId;
+  ssEvent   = event;
+  ssNumDone = 0;
+  for (ch=0; ch<SS_NUM_CHANNELS; ch++){
+    ROBUST_StreamInit(&ssStream[ch]);
   }
 
+  ADC12CTL0 &= ~(ADC12ENC + ADC12SC);
+  ADC12IFG   = 0;
+  ADC12IE    = BV(3);                 /* end of the sequence */
+  ADC12CTL0 |= ADC12MSC;              /* the next sequence follows without a trigger */
+  ADC12CTL0 |= (ADC12ENC + ADC12SC);
+}
+
+
+
+/**
+  * @brief Results of the sampling started by SS_Start(), once its event came
+  */
+void SS_Measure(sensing_t *ssResult){
+  int32_t  val;
+  uint32_t phRecip;
+
+  osal_memcpy(ssResult->pHAdc, ssAdc[SS_CH_PH], sizeof(ssResult->pHAdc));
+
   /* calculate Average value */
-  ssResult->vddAdcAvg    = AvgWithFilter(vddAdc);
-  ssResult->intTmpAdcAvg = AvgWithFilter(intTmpAdc);
-  ssResult->pHAdcAvg     = AvgWithFilter(ssResult->pHAdc);
-  ssResult->extTmpAdcAvg = AvgWithFilter(extTmpAdc);
+  ssResult->vddAdcAvg    = SS_Filter(SS_CH_VDD);
+  ssResult->intTmpAdcAvg = SS_Filter(SS_CH_INT_TMP);
+  ssResult->pHAdcAvg     = SS_Filter(SS_CH_PH);
+  ssResult->extTmpAdcAvg = SS_Filter(SS_CH_EXT_TMP);
 
   /* calculate measured data */
   /* Vdd = (2.5/2^12)*N*2 (vol) = (5000*N)/4096 (miliVol) */
-  val = ((int32_t) ssResult->vddAdcAvg)* ((int32_t)5000);
-  ssResult->vddVal = (uint16_t) (val / ((int32_t)4096));
+  ssResult->vddVal = (uint16_t) ((((uint32_t) ssResult->vddAdcAvg) * 5000UL) >> 12);
 
   /*  V= -offset + 680+2.25*t (mV) <=> (2500/2^12)*N = -offset + 680+2.25*t
    => t = [(2500/4096)*N - 680 + offset]/2.25
    => t = [(2500*N - (680-offset)*4096)/4096)]/2.25 = (2500*N - 680*4096)/9216 (degree) */
   val = ((int32_t) ssResult->intTmpAdcAvg)* ((int32_t)2500);
-  val = val - ((int32_t) (((int32_t) 680) - intTmpOffsetCalib)*((int32_t) 4096));
+  val = val - ((int32_t) (((int32_t) 680) - ssIntTmpOffset)*((int32_t) 4096));
   ssResult->intTmpVal = (uint16_t) (val / ((int32_t)9216));
 
   /* V = Vref.R/(R+Rref)  <=> V.R + V.Rref = Vref.R
-  => R = V.Rref/(Vref-V) */
-  val = (((int32_t) ssResult->extTmpAdcAvg)* ((int32_t)2500)) / ((int32_t) 4096);
-  tmp = val * ((int32_t) 47000);
-  val = tmp / (((int32_t) 2500) - val);
-  ssResult->extTmpRes = val;
-  if (val < 17700)       {ssResult->extTmpVal = 36;}
-  else if (val < 18200)  {ssResult->extTmpVal = 35;}
-  else if (val < 18800)  {ssResult->extTmpVal = 34;}
-  else if (val < 19350)  {ssResult->extTmpVal = 33;}
-  else if (val < 19900)  {ssResult->extTmpVal = 32;}
-  else if (val < 20450)  {ssResult->extTmpVal = 31;}
-  else if (val < 21000)  {ssResult->extTmpVal = 30;}
-  else if (val < 22200)  {ssResult->extTmpVal = 29;}
-  else if (val < 23500)  {ssResult->extTmpVal = 28;}
-  else if (val < 25000)  {ssResult->extTmpVal = 27;}
-  else                   {ssResult->extTmpVal = 26;}
+  => R = V.Rref/(Vref-V) = N.Rref/(4096-N), straight from the counts */
+  val = ((int32_t) ssResult->extTmpAdcAvg) - ssExtTmpOffset;
+  if (val <= 0){
+    val = 0;
+  }
+  else if (val >= 4096){
+    val = 0xFFFF;                       /* open probe */
+  }
+  else{
+    val = (val * (int32_t) SS_NTC_RREF) / (4096 - val);
+    if (val > 0xFFFF){
+      val = 0xFFFF;
+    }
+  }
+  ssResult->extTmpRes = (uint16_t) val;
+  val = SS_NtcTemp(ssResult->extTmpRes, &phRecip);   /* 0.01 C */
+  ssResult->extTmpVal = (uint16_t) ((val + 50) / 100);
 
   /* V = Vref/2 + PH_OFFSET + (7-pH)*PH_SLOPE (mV)
        = Vref/2 + (PH_OFFSET_ZERO + t*PH_OFFSET_DRIFT) + (7-pH)*(59.2 + t*0.2)
  <=> 2500N/4096 - 2500/2 ~= 0 + (7-pH)*(59.2 + t*0.2)
   => pH = 7-(2500N-5120000)/[4096*(59.2 + t*0.2)]
-  => pH = 350-[(2500N-5120000)*250)/[4096*(296 + t)]  (0.02pH) */
-  val = ((int32_t) ssResult-> pHAdcAvg)* ((int32_t)2500);
-  val = (val - ((int32_t) 5120000)) * ((int32_t)250);
-  val = val / ( ((int32_t)4096)*(((int32_t)310) + ((int32_t)ssResult->extTmpVal)) );
+  => pH = 350-[(N-2048)*625000)/[4096*(slope + t)]  (0.02pH)
+  The reciprocal of 4096*(slope + t) comes with the temperature, scaled by 2^16; the range of
+  CALIB_Valid() keeps the product within int32 */
+  val = (((int32_t) ssResult->pHAdcAvg) - 2048 - ssPhOffset) * ((int32_t) phRecip);
+  val = (val >= 0) ? (val >> 16) : -((-val) >> 16);   /* towards 0, as the divide did */
   ssResult->pHVal = (uint16_t) (2*(250 - val));
 }
 
@@ -121,6 +221,8 @@ void SS_Measure(sensing_t *ssResult){
 
 void SS_Shutdown(void){
   //turn off REF, TEMP, GPIO, ADC
+  ADC12IE    = 0;
+  ADC12CTL1 &= ~ADC12CONSEQ_3; // Stop the sequence at once
   ADC12CTL0 &= ~ADC12ENC; // Disable ADC
   ADC12CTL0 = 0;          // Turn off reference (must be done AFTER clearing ENC).
   ADC12CTL2 = ADC12TCOFF; // Turn off RefOUT, temperature sensor
@@ -129,60 +231,86 @@ void SS_Shutdown(void){
 
 
 
-uint16_t AvgWithFilter(uint16_t inData[16]){
-  uint16_t sum, avg;
-  uint16_t delta[16], order[16];
-  uint16_t index, pos, swap;
+/**
+  * @brief Choose how the samples of a channel are reduced to one value, SS_FILTER_xxx
+  */
+void SS_SetFilter(uint8_t channel, uint8_t filter){
+  if (channel < SS_NUM_CHANNELS){
+    ssFilter[channel] = filter;
+  }
+}
+
 
-  sum = 0;
-  for (index=0; index<16; index++){
-    sum = sum + inData[index];
-    order[index] = index;
+
+/**
+  * @brief Temperature of the external probe by linear interpolation in the NTC table, held at
+  *        the ends of the table
+  * @param res      - NTC resistance, ohm
+  *        pPhRecip - reciprocal of the pH slope at that temperature, see ssPhRecip
+  * @return temperature in 0.01 C
+  */
+static int16_t SS_NtcTemp(uint16_t res, uint32_t *pPhRecip){
+  uint32_t f;
+  uint8_t  i;
+
+  if (res <= ssNtc[0].res){
+    *pPhRecip = ssPhRecip[0];
+    return ssNtc[0].cdeg;
   }
-  avg = sum >> 4;
-  /* calculate delta */
-  for (index=0; index<16; index++){
-    if (inData[index] > avg){
-      delta[index] = inData[index] - avg;
-    }
-    else{
-      delta[index] = avg - inData[index];
-    }
+  for (i=0; (i<SS_NTC_KNOTS-1) && (res >= ssNtc[i+1].res); i++){
   }
-
-  /* find 8 smallest delta */
-  for (index=0; index<16; index++){
-    for (pos=index+1; pos<16; pos++){
-      if (delta[pos] < delta[index]){
-        swap = delta[index];
-        delta[index] = delta[pos];
-        delta[pos]=swap;
-        swap = order[index];
-        order[index] = order[pos];
-        order[pos]=swap;
-      }
-    }
+  if (i == SS_NTC_KNOTS-1){
+    *pPhRecip = ssPhRecip[i];
+    return ssNtc[i].cdeg;
   }
+  f = (((uint32_t) (res - ssNtc[i].res)) * ssNtc[i].invW) >> 8;   /* 0..2^16 along the segment */
+  *pPhRecip = ssPhRecip[i] + (((ssPhRecip[i+1] - ssPhRecip[i]) * f) >> 16);
+  return ssNtc[i].cdeg - (int16_t) ((((int32_t) (ssNtc[i].cdeg - ssNtc[i+1].cdeg)) * (int32_t) f) >> 16);
+}
 
-  /*recalculate sum*/
-  sum = 0;
-  for (index=0;index<8; index++){
-    sum = sum + inData[(order[index])];
+
+
+/**
+  * @brief The value of a channel from its samples, by the filter set for it
+  */
+static uint16_t SS_Filter(uint8_t channel){
+  switch (ssFilter[channel]){
+    case SS_FILTER_MEDIAN:  return ROBUST_Median16(ssAdc[channel]);
+    case SS_FILTER_TRIMMED: return ROBUST_StreamTrimmedMean(&ssStream[channel], SS_TRIM);
+    default:                return ROBUST_FilterAvg(ssAdc[channel]);
   }
-  return (sum >> 3);
 }
 
 
 
-uint16_t _SS_GetAdc(uint8_t channel){
-  ADC12CTL0  &= ~ (ADC12ENC + ADC12SC); /*disable ADC to config */
-  ADC12MCTL0  = ADC12EOS + ADC12SREF1 + channel;
-  ADC12CTL0  |= (ADC12ENC + ADC12SC);
-  while (ADC12IFG == 0){
-    /*wait, do nothing*/
-  };
-  ADC12IFG = 0;
-  return ADC12MEM0;
+/**
+  * @brief End of a sequence: copy it out, and stop after the last one.  Reading the results
+  *        clears their flags.
+  */
+INTERRUPT_ADC12(){
+  uint8_t n = ssNumDone;
+  uint8_t ch;
+
+  if (n >= SS_NUM_SAMPLES){
+    return;
+  }
+  ssAdc[SS_CH_VDD][n]     = ADC12MEM0;
+  ssAdc[SS_CH_INT_TMP][n] = ADC12MEM1;
+  ssAdc[SS_CH_PH][n]      = ADC12MEM2;
+  ssAdc[SS_CH_EXT_TMP][n] = ADC12MEM3;
+  for (ch=0; ch<SS_NUM_CHANNELS; ch++){
+    if (ssFilter[ch] == SS_FILTER_TRIMMED){
+      ROBUST_StreamAdd(&ssStream[ch], ssAdc[ch][n]); /* sorted as they come */
+    }
+  }
+  ssNumDone = ++n;
+
+  if (n == SS_NUM_SAMPLES){
+    ADC12IE    = 0;
+    ADC12CTL1 &= ~ADC12CONSEQ_3;      /* no further sequence */
+    ADC12CTL0 &= ~ADC12ENC;
+    osal_set_event(ssTaskId, ssEvent);
+  }
 }
 
 
@@ -0,0 +1,285 @@
+#include <stddef.h>
+/* Hal Driver includes */
+#include "hal_types.h"
+#include "hal_defs.h"
+#include "hal_assert.h"
+/* OS includes */
+#include "OSAL.h"
+
+#include "fram.h"
+#include "crc.h"
+#include "store.h"
+
+/**** DEFINE ****/
+typedef struct{
+  uint32  seq;
+  uint32  time;
+  uint8   len;
+  uint8   rsvd;
+  uint16  crc;                          /* of the fields before and the data */
+} storeHdr_t;
+
+typedef struct{
+  uint32  cpSeq;                        /* written to slot cpSeq % STORE_CP_SLOTS */
+  uint32  headSeq;
+  uint32  firstSeq;                     /* first record of this log */
+  uint8   info[STORE_INFO_LEN];
+  uint16  rsvd;
+  uint16  crc;                          /* of the fields before */
+} storeCp_t;
+
+typedef struct{
+  storeHdr_t  hdr;
+  uint8       data[STORE_DATA_LEN];
+} storeRec_t;
+
+/* The FRAM layout follows the structures, padding included */
+HAL_ASSERT_SIZE(storeHdr_t, STORE_HDR_LEN);
+typedef char storeCp_assert_size_t[-1 + 10*(sizeof(storeCp_t) <= STORE_CP_LEN)];
+
+#define STORE_REC_ADDR(seq)       (STORE_LOG_BASE + (uint32)STORE_Block(seq) * STORE_REC_LEN)
+#define STORE_CP_ADDR(cpSeq)      (STORE_CP_BASE + (uint32)((cpSeq) % STORE_CP_SLOTS) * STORE_CP_LEN)
+
+/**** VARIABLEs  ****/
+static storeCp_t  storeCp;
+static storeRec_t storeRec;
+static uint8     *pStoreInfo;
+static uint8      storeInfoLen;
+static uint8      storeSinceCp;
+
+/**** FUNCTIONs ****/
+static uint16 storeRecCrc(storeRec_t *pRec);
+static uint8  storeLoad(uint32 seq);
+
+
+/**************************************************************************************************
+ * @brief   Open the log.  The newest checkpoint with a good CRC gives the head, which is then
+ *          moved over the records appended after that checkpoint.  They count towards the next
+ *          checkpoint, so however many resets come between two checkpoints the head never has
+ *          more than STORE_CP_INTERVAL records to move over.  Without any checkpoint a new log is
+ *          started, at a sequence number above every record an old log may have left in the
+ *          FRAM, so none of them can be taken for a new one.
+ * @param   pInfo   - store_info of the application, saved with every checkpoint
+ *          infoLen - its size, at most STORE_INFO_LEN
+ * @return  TRUE if the log was found, FALSE if a new one was started and pInfo was left as is
+ **************************************************************************************************/
+bool STORE_Init(void *pInfo, uint8 infoLen)
+{
+  storeCp_t cp;
+  bool found = FALSE;
+  uint8 i;
+
+  pStoreInfo   = (uint8*) pInfo;
+  storeInfoLen = (infoLen > STORE_INFO_LEN) ? STORE_INFO_LEN : infoLen;
+  storeSinceCp = 0;
+
+  for (i=0; i<STORE_CP_SLOTS; i++){
+    fram_readMemory(STORE_CP_BASE + (uint32)i * STORE_CP_LEN, (uint8*) &cp, sizeof(cp));
+    if ((cp.crc == CRC_Ccitt(CRC_INIT, (uint8*) &cp, offsetof(storeCp_t, crc))) &&
+        ((cp.cpSeq % STORE_CP_SLOTS) == i) && (!found || (cp.cpSeq > storeCp.cpSeq))){
+      storeCp = cp;
+      found   = TRUE;
+    }
+  }
+
+  if (found){
+    osal_memcpy(pStoreInfo, storeCp.info, storeInfoLen);
+    for (i=0; (i<STORE_CP_INTERVAL) && (STORE_OK == storeLoad(storeCp.headSeq)); i++){
+      storeCp.headSeq++;              /* appended after the checkpoint */
+    }
+    storeSinceCp = i;
+    return TRUE;
+  }
+
+  storeCp.cpSeq    = 0;
+  storeCp.firstSeq = 0;
+  fram_readMemory(STORE_LOG_BASE, (uint8*) &storeRec, sizeof(storeRec));
+  if ((storeRec.hdr.len <= STORE_DATA_LEN) && (storeRec.hdr.crc == storeRecCrc(&storeRec))){
+    storeCp.firstSeq = (storeRec.hdr.seq / STORE_BLOCKS + 1) * STORE_BLOCKS; /* past the old log */
+  }
+  storeCp.headSeq = storeCp.firstSeq;
+  STORE_Checkpoint();
+  return FALSE;
+}
+
+
+/**************************************************************************************************
+ * @brief   Append a record.  One FRAM write, at the block of its sequence number; a
+ *          checkpoint follows every STORE_CP_INTERVAL appends.
+ * @param   time  - time of the record, not before the one of the record before
+ *          pData - data
+ *          len   - data length, cut to STORE_DATA_LEN
+ * @return  sequence number of the record
+ **************************************************************************************************/
+uint32 STORE_Append(uint32 time, const uint8 *pData, uint8 len)
+{
+  uint32 seq = storeCp.headSeq;
+  storeHdr_t hdr;
+  fram_seg_t segs[2];
+
+  if (len > STORE_DATA_LEN){
+    len = STORE_DATA_LEN;
+  }
+  hdr.seq  = seq;
+  hdr.time = time;
+  hdr.len  = len;
+  hdr.rsvd = 0;
+  hdr.crc  = CRC_Ccitt(CRC_Ccitt(CRC_INIT, (uint8*) &hdr, offsetof(storeHdr_t, crc)), pData, len);
+  segs[0].addr  = STORE_REC_ADDR(seq);   /* header and data in one WRITE */
+  segs[0].pData = (uint8*) &hdr;
+  segs[0].size  = STORE_HDR_LEN;
+  segs[1].addr  = segs[0].addr + STORE_HDR_LEN;
+  segs[1].pData = pData;
+  segs[1].size  = len;
+  fram_writeSegs(segs, 2);
+
+  storeCp.headSeq++;
+  if (++storeSinceCp >= STORE_CP_INTERVAL){
+    STORE_Checkpoint();
+  }
+  return seq;
+}
+
+
+/**************************************************************************************************
+ * @brief   Read a record
+ * @param   seq   - sequence number
+ *          pTime - time of the record
+ *          pData - data, STORE_DATA_LEN bytes of room
+ *          pLen  - data length
+ * @return  STORE_OK, STORE_GONE or STORE_CORRUPT
+ **************************************************************************************************/
+uint8 STORE_Read(uint32 seq, uint32 *pTime, uint8 *pData, uint8 *pLen)
+{
+  uint8 status;
+
+  if ((seq >= storeCp.headSeq) || (seq < STORE_Oldest())){
+    return STORE_GONE;
+  }
+  if (STORE_OK != (status = storeLoad(seq))){
+    return status;
+  }
+  *pTime = storeRec.hdr.time;
+  *pLen  = storeRec.hdr.len;
+  osal_memcpy(pData, storeRec.data, storeRec.hdr.len);
+  return STORE_OK;
+}
+
+
+/**************************************************************************************************
+ * @brief   Sequence number of the next record
+ **************************************************************************************************/
+uint32 STORE_Head(void)
+{
+  return storeCp.headSeq;
+}
+
+
+/**************************************************************************************************
+ * @brief   Sequence number of the oldest record still in the ring
+ **************************************************************************************************/
+uint32 STORE_Oldest(void)
+{
+  if (storeCp.headSeq - storeCp.firstSeq > STORE_BLOCKS){
+    return storeCp.headSeq - STORE_BLOCKS;
+  }
+  return storeCp.firstSeq;
+}
+
+
+/**************************************************************************************************
+ * @brief   Binary search of the first record with a time not before 'time'.  A record that does
+ *          not read back counts as older, the search goes on after it.
+ * @param   time - time looked for
+ * @return  sequence number, STORE_Head() if every record is older
+ **************************************************************************************************/
+uint32 STORE_FindTime(uint32 time)
+{
+  uint32 lo = STORE_Oldest();
+  uint32 hi = storeCp.headSeq;
+  uint32 mid;
+
+  while (lo < hi){
+    mid = lo + (hi - lo) / 2;
+    if ((STORE_OK == storeLoad(mid)) && (storeRec.hdr.time >= time)){
+      hi = mid;
+    }
+    else{
+      lo = mid + 1;
+    }
+  }
+  return lo;
+}
+
+
+/**************************************************************************************************
+ * @brief   Block of the ring that holds a record
+ **************************************************************************************************/
+uint16 STORE_Block(uint32 seq)
+{
+  return (uint16)(seq % STORE_BLOCKS);
+}
+
+
+/**************************************************************************************************
+ * @brief   Record now in a block of the ring
+ * @param   block - block number
+ * @return  sequence number, STORE_Head() if the block has nothing of this log
+ **************************************************************************************************/
+uint32 STORE_FindBlock(uint16 block)
+{
+  uint32 last = storeCp.headSeq - 1;
+  uint16 back;
+
+  if ((block >= STORE_BLOCKS) || (storeCp.headSeq == storeCp.firstSeq)){
+    return storeCp.headSeq;
+  }
+  back = (STORE_Block(last) + STORE_BLOCKS - block) % STORE_BLOCKS;
+  if (last - STORE_Oldest() < back){
+    return storeCp.headSeq;
+  }
+  return last - back;
+}
+
+
+/**************************************************************************************************
+ * @brief   Write the head and the store_info to the next checkpoint slot.  The slot before
+ *          stays as it was, so a write cut by a reset leaves the previous checkpoint to start
+ *          from.
+ **************************************************************************************************/
+void STORE_Checkpoint(void)
+{
+  storeCp.cpSeq++;
+  osal_memcpy(storeCp.info, pStoreInfo, storeInfoLen);
+  storeCp.rsvd = 0;
+  storeCp.crc  = CRC_Ccitt(CRC_INIT, (uint8*) &storeCp, offsetof(storeCp_t, crc));
+  fram_writeMemory(STORE_CP_ADDR(storeCp.cpSeq), (uint8*) &storeCp, sizeof(storeCp));
+  storeSinceCp = 0;
+}
+
+
+/**************************************************************************************************
+ * @brief   CRC of a record: header up to the CRC, then the data
+ **************************************************************************************************/
+static uint16 storeRecCrc(storeRec_t *pRec)
+{
+  uint16 crc = CRC_Ccitt(CRC_INIT, (uint8*) &pRec->hdr, offsetof(storeHdr_t, crc));
+
+  return CRC_Ccitt(crc, pRec->data, pRec->hdr.len);
+}
+
+
+/**************************************************************************************************
+ * @brief   Read the block of a record into storeRec and check it
+ * @param   seq - sequence number
+ * @return  STORE_OK if the block holds that record, STORE_CORRUPT if not
+ **************************************************************************************************/
+static uint8 storeLoad(uint32 seq)
+{
+  fram_readMemory(STORE_REC_ADDR(seq), (uint8*) &storeRec, sizeof(storeRec));
+  if ((storeRec.hdr.len > STORE_DATA_LEN) || (storeRec.hdr.seq != seq) ||
+      (storeRec.hdr.crc != storeRecCrc(&storeRec))){
+    return STORE_CORRUPT;
+  }
+  return STORE_OK;
+}
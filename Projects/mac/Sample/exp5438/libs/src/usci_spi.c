@@ -8,9 +8,31 @@
 
 #include "hal_types.h"
 #include "hal_mcu.h"
+#include "hal_board_cfg.h"
 #include "usci_spi.h"
 #include "spi_internal.h"
 
+#if (HAL_SPI_DMA == TRUE)
+/* RX on channel 0, the highest priority, so RXBUF is read before the next byte lands in it;
+ * TX on channel 1.  Only RX interrupts: its last byte ends the transfer.  A transfer starts on
+ * a rising edge of the trigger, UCTXIFG is cleared and set again if TXBUF is already empty */
+#define SPI_DMA_TRIGGERS()    { DMACTL0 = SPI_DMA_RXTSEL | (SPI_DMA_TXTSEL << 8); }
+#define SPI_DMA_ADDR(reg, p)  { __data16_write_addr((unsigned short)&(reg), (unsigned long)(p)); }
+#define SPI_DMA_KICK()        { if (SPI_UCIFG & UCTXIFG) { SPI_UCIFG &= ~UCTXIFG; SPI_UCIFG |= UCTXIFG; } }
+
+static volatile usci_spi_done_t dmaDone;
+static volatile uint8_t dmaBusy;
+static uint8_t dmaSink;                   /* received bytes nobody wants */
+static const uint8_t dmaDummy = DUMMY_CHAR;
+
+static void usci_spi_dmaStart(const uint8_t *pTx, uint8_t *pRx, uint16_t size,
+                              usci_spi_done_t done);
+#endif
+
+static uint16_t clkDiv = SPI_CLK_DIV;
+
+static void usci_spi_poll(const uint8_t *pTx, uint8_t *pRx, uint16_t size);
+
 void usci_spi_init(uint8_t spi_mode)
 {
   /* Set UCSWRST - Hold peripheral (USCI) in reset state               */
@@ -19,7 +41,7 @@ void usci_spi_init(uint8_t spi_mode)
   /* MSB first, 8-bit data, Master mode, 3-pin SPI, Synchronous mode   */
   SPI_UCCTL0 = spi_mode + UCMSB + UCMST + UCSYNC;
   SPI_UCCTL1 = (SPI_CLK_SRC << 6) + UCSWRST;
-  SPI_UCBR = SPI_CLK_DIV;
+  SPI_UCBR = clkDiv;
 
   /* Configure port */
   #if (SPI_USE_USCI == 1)
@@ -51,6 +73,23 @@ void usci_spi_init(uint8_t spi_mode)
   SPI_UCCTL1 &= ~UCSWRST;
 }
 
+//--------------------------------------------------------------------------------------------------
+/* Also taken by usci_spi_init() from then on.  A running transfer is finished first */
+void usci_spi_setClkDiv(uint16_t div)
+{
+  usci_spi_wait();
+
+  SPI_UCCTL1 |= UCSWRST;
+  SPI_UCBR = clkDiv = div;
+  SPI_UCCTL1 &= ~UCSWRST;
+}
+
+//--------------------------------------------------------------------------------------------------
+uint16_t usci_spi_getClkDiv(void)
+{
+  return clkDiv;
+}
+
 //--------------------------------------------------------------------------------------------------
 uint8_t usci_spi_sendByte(uint8_t data)
 {
@@ -60,3 +99,168 @@ uint8_t usci_spi_sendByte(uint8_t data)
   x = SPI_UCRXBUF;                        /* dummy read to clear the RX flag */
   return x;
 }
+
+//--------------------------------------------------------------------------------------------------
+void usci_spi_write(const uint8_t *pData, uint16_t size)
+{
+  usci_spi_transfer(pData, NULL, size);
+}
+
+//--------------------------------------------------------------------------------------------------
+void usci_spi_read(uint8_t *pData, uint16_t size)
+{
+  usci_spi_transfer(NULL, pData, size);
+}
+
+//--------------------------------------------------------------------------------------------------
+void usci_spi_transfer(const uint8_t *pTx, uint8_t *pRx, uint16_t size)
+{
+#if (HAL_SPI_DMA == TRUE)
+  if ((size >= SPI_DMA_MIN) && HAL_INTERRUPTS_ARE_ENABLED())
+  {
+    usci_spi_wait();
+    usci_spi_dmaStart(pTx, pRx, size, NULL);
+    usci_spi_wait();
+    return;
+  }
+#endif
+  usci_spi_poll(pTx, pRx, size);
+}
+
+//--------------------------------------------------------------------------------------------------
+void usci_spi_transferAsync(const uint8_t *pTx, uint8_t *pRx, uint16_t size, usci_spi_done_t done)
+{
+#if (HAL_SPI_DMA == TRUE)
+  if ((size != 0) && HAL_INTERRUPTS_ARE_ENABLED())
+  {
+    usci_spi_wait();
+    usci_spi_dmaStart(pTx, pRx, size, done);
+    return;
+  }
+#endif
+  usci_spi_poll(pTx, pRx, size);
+  if (done != NULL)
+  {
+    done();
+  }
+}
+
+//--------------------------------------------------------------------------------------------------
+uint8_t usci_spi_busy(void)
+{
+#if (HAL_SPI_DMA == TRUE)
+  return dmaBusy;
+#else
+  return 0;
+#endif
+}
+
+//--------------------------------------------------------------------------------------------------
+/* Sleep in LPM0 until the DMA interrupt; SMCLK keeps the USCI going.  Interrupts are disabled
+ * while dmaBusy is looked at, and LPM0 is entered together with enabling them, so the end of
+ * the transfer cannot slip in between and leave the CPU asleep.  Interrupts must be enabled
+ * when a transfer is running, or its end never comes */
+void usci_spi_wait(void)
+{
+#if (HAL_SPI_DMA == TRUE)
+  if (!dmaBusy)
+  {
+    return;
+  }
+  HAL_DISABLE_INTERRUPTS();
+  while (dmaBusy)
+  {
+    __low_power_mode_0();
+    HAL_DISABLE_INTERRUPTS();
+  }
+  HAL_ENABLE_INTERRUPTS();
+#endif
+}
+
+#if (HAL_SPI_DMA == TRUE)
+//--------------------------------------------------------------------------------------------------
+static void usci_spi_dmaStart(const uint8_t *pTx, uint8_t *pRx, uint16_t size,
+                              usci_spi_done_t done)
+{
+  volatile uint8_t x;
+
+  dmaDone = done;
+  dmaBusy = 1;
+
+  x = SPI_UCRXBUF;                        /* RX triggers on a rising edge of UCRXIFG */
+  (void)x;
+  DMA0CTL = 0;
+  DMA1CTL = 0;
+  SPI_DMA_TRIGGERS();
+
+  SPI_DMA_ADDR(DMA0SA, &SPI_UCRXBUF);
+  SPI_DMA_ADDR(DMA0DA, (pRx != NULL) ? pRx : &dmaSink);
+  DMA0SZ = size;
+  DMA0CTL = DMADT_0 | DMASRCINCR_0 | ((pRx != NULL) ? DMADSTINCR_3 : DMADSTINCR_0) |
+            DMADSTBYTE | DMASRCBYTE | DMAIE | DMAEN;
+
+  SPI_DMA_ADDR(DMA1SA, (pTx != NULL) ? pTx : &dmaDummy);
+  SPI_DMA_ADDR(DMA1DA, &SPI_UCTXBUF);
+  DMA1SZ = size;
+  DMA1CTL = DMADT_0 | DMADSTINCR_0 | ((pTx != NULL) ? DMASRCINCR_3 : DMASRCINCR_0) |
+            DMADSTBYTE | DMASRCBYTE | DMAEN;
+
+  SPI_DMA_KICK();
+}
+
+//--------------------------------------------------------------------------------------------------
+/* From the DMA ISR of the board (hal_uart.c), which shares the vector with the UART */
+void usci_spi_dmaIsr(void)
+{
+  usci_spi_done_t done = dmaDone;
+
+  DMA0CTL &= ~(DMAIE | DMAIFG);
+  dmaDone = NULL;
+  dmaBusy = 0;
+  if (done != NULL)
+  {
+    done();
+  }
+}
+#endif
+
+//--------------------------------------------------------------------------------------------------
+/* Without received data the next byte goes into TXBUF as soon as it is free, while the one
+ * before is still being shifted, so the bus does not stop between bytes.  With received data
+ * the next byte is written one ahead, before the current one is read; an interrupt between
+ * the two could let it overwrite RXBUF, so the pair is not interrupted */
+static void usci_spi_poll(const uint8_t *pTx, uint8_t *pRx, uint16_t size)
+{
+  volatile uint8_t x;
+  halIntState_t s;
+
+  if (pRx == NULL)
+  {
+    while (size--)
+    {
+      while ((SPI_UCIFG & UCTXIFG) == 0); /* wait for TXBUF to be free       */
+      SPI_UCTXBUF = (pTx != NULL) ? *pTx++ : DUMMY_CHAR;
+    }
+    while (SPI_UCSTAT & UCBUSY);          /* wait for the last byte           */
+    x = SPI_UCRXBUF;                      /* dummy read to clear the RX flag */
+    (void)x;
+    return;
+  }
+
+  if (size == 0)
+  {
+    return;
+  }
+  SPI_UCTXBUF = (pTx != NULL) ? *pTx++ : DUMMY_CHAR;
+  while (--size)
+  {
+    HAL_ENTER_CRITICAL_SECTION(s);
+    while ((SPI_UCIFG & UCTXIFG) == 0);
+    SPI_UCTXBUF = (pTx != NULL) ? *pTx++ : DUMMY_CHAR;
+    while ((SPI_UCIFG & UCRXIFG) == 0);
+    *pRx++ = SPI_UCRXBUF;
+    HAL_EXIT_CRITICAL_SECTION(s);
+  }
+  while ((SPI_UCIFG & UCRXIFG) == 0);
+  *pRx = SPI_UCRXBUF;
+}
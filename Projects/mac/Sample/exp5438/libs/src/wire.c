@@ -0,0 +1,249 @@
+#include <stddef.h>
+/* Hal Driver includes */
+#include "hal_types.h"
+
+#include "wire.h"
+
+/**** DEFINE ****/
+typedef struct{
+  uint8   offset;                       /* in the parameters of pkt_t */
+  uint8   size;                         /* of one element: 1, 2 or 4 */
+  uint8   count;                        /* elements */
+} wireField_t;
+
+typedef struct{
+  pktType_t          pktType;
+  uint8              len;
+  uint8              num;
+  const wireField_t  *pFields;
+} wireType_t;
+
+#define WIRE_FIELD(type, member, n)   {offsetof(type, member), sizeof(((type*) 0)->member) / (n), (n)},
+
+/**** VARIABLEs  ****/
+static const CODE wireField_t wireAlive[]   = { WIRE_ALIVE_FIELDS(WIRE_FIELD) };
+static const CODE wireField_t wireSensing[] = { WIRE_SENSING_FIELDS(WIRE_FIELD) };
+static const CODE wireField_t wireCalib[]   = { WIRE_CALIB_FIELDS(WIRE_FIELD) };
+static const CODE wireField_t wireSched[]   = { WIRE_SCHED_FIELDS(WIRE_FIELD) };
+
+static const CODE wireType_t wireTypes[] = {
+  {PKT_ALIVE_TYPE,   WIRE_ALIVE_LEN,   sizeof(wireAlive)   / sizeof(wireField_t), wireAlive},
+  {PKT_SENSING_TYPE, WIRE_SENSING_LEN, sizeof(wireSensing) / sizeof(wireField_t), wireSensing},
+  {PKT_CALIB_TYPE,   WIRE_CALIB_LEN,   sizeof(wireCalib)   / sizeof(wireField_t), wireCalib},
+  {PKT_SCHED_TYPE,   WIRE_SCHED_LEN,   sizeof(wireSched)   / sizeof(wireField_t), wireSched},
+};
+
+/**** FUNCTIONs ****/
+static const wireType_t* wireFind(pktType_t pktType);
+
+
+/**************************************************************************************************
+ * @brief   Length of a packet on the air
+ * @param   pktType - packet type
+ * @return  bytes, header included; 0 if the type has no pkt_t parameters
+ **************************************************************************************************/
+uint8 WIRE_Len(pktType_t pktType)
+{
+  const wireType_t *pType = wireFind(pktType);
+
+  return (pType != NULL) ? pType->len : 0;
+}
+
+
+/**************************************************************************************************
+ * @brief   Write a packet in the wire format.  A field is read as the integer it is on this
+ *          CPU and written low byte first, so the bytes do not depend on the byte order or the
+ *          padding of the struct.
+ * @param   pPkt - packet, pktType and the parameters of that type
+ *          pBuf - room for it
+ *          size - bytes of room
+ * @return  length, 0 if the type is not known or it does not fit
+ **************************************************************************************************/
+uint8 WIRE_Encode(const pkt_t *pPkt, uint8 *pBuf, uint8 size)
+{
+  const wireType_t *pType = wireFind(pPkt->pktType);
+  const uint8 *pPara = (const uint8*) &(pPkt->pktPara);    /* fields stay aligned */
+  uint8 *pOut = pBuf + WIRE_HDR_LEN;
+  uint32 val;
+  uint8 f, i, b;
+
+  if ((pType == NULL) || (size < pType->len)){
+    return 0;
+  }
+  pBuf[0] = pPkt->pktType;
+  pBuf[1] = WIRE_VER_HDR;
+  for (f=0; f<pType->num; f++){
+    const wireField_t *pField = &(pType->pFields[f]);
+    const uint8 *pIn = pPara + pField->offset;
+
+    for (i=0; i<pField->count; i++, pIn += pField->size){
+      if (pField->size == 1){
+        val = *pIn;
+      }
+      else if (pField->size == 2){
+        val = *(const uint16*) pIn;
+      }
+      else{
+        val = *(const uint32*) pIn;
+      }
+      for (b=0; b<pField->size; b++){
+        *pOut++ = (uint8) val;
+        val >>= 8;
+      }
+    }
+  }
+  return pType->len;
+}
+
+
+/**************************************************************************************************
+ * @brief   Check the header of a received packet
+ * @param   pBuf - packet
+ *          len  - its length
+ * @return  header length, 0 if the packet is not of this version or shorter than its header
+ **************************************************************************************************/
+uint8 WIRE_HdrLen(const uint8 *pBuf, uint8 len)
+{
+  uint8 hdrLen;
+
+  if ((len < WIRE_HDR_LEN) || ((pBuf[1] >> 4) != WIRE_VERSION)){
+    return 0;
+  }
+  hdrLen = pBuf[1] & 0x0F;
+  if ((hdrLen < WIRE_HDR_LEN) || (hdrLen > len)){
+    return 0;
+  }
+  return hdrLen;
+}
+
+
+/**************************************************************************************************
+ * @brief   Read a packet in the wire format into a pkt_t
+ * @param   pBuf - packet
+ *          len  - its length
+ *          pPkt - the packet in the layout of this CPU
+ * @return  FALSE if it is not of this version, of a type with pkt_t parameters, or too short
+ **************************************************************************************************/
+bool WIRE_Decode(const uint8 *pBuf, uint8 len, pkt_t *pPkt)
+{
+  const wireType_t *pType;
+  uint8 *pPara = (uint8*) &(pPkt->pktPara);
+  uint8 hdrLen = WIRE_HdrLen(pBuf, len);
+  const uint8 *pIn = pBuf + hdrLen;
+  uint32 val;
+  uint8 f, i, b;
+
+  if (hdrLen == 0){
+    return FALSE;
+  }
+  pType = wireFind(pBuf[0]);
+  if ((pType == NULL) || (len - hdrLen < pType->len - WIRE_HDR_LEN)){
+    return FALSE;
+  }
+  for (i=0; i<sizeof(pkt_t); i++){
+    ((uint8*) pPkt)[i] = 0;
+  }
+  pPkt->pktType = pBuf[0];
+  for (f=0; f<pType->num; f++){
+    const wireField_t *pField = &(pType->pFields[f]);
+    uint8 *pOut = pPara + pField->offset;
+
+    for (i=0; i<pField->count; i++, pOut += pField->size){
+      val = 0;
+      for (b=pField->size; b>0; b--){
+        val = (val << 8) | pIn[b-1];
+      }
+      pIn += pField->size;
+      if (pField->size == 1){
+        *pOut = (uint8) val;
+      }
+      else if (pField->size == 2){
+        *(uint16*) pOut = (uint16) val;
+      }
+      else{
+        *(uint32*) pOut = val;
+      }
+    }
+  }
+  return TRUE;
+}
+
+
+/**************************************************************************************************
+ * @brief   Add a packet to a PKT_CMDS_TYPE packet
+ * @param   pPkt - packet to add
+ *          pBuf - the PKT_CMDS_TYPE packet
+ *          len  - its length, 0 to begin it
+ *          size - bytes of room in pBuf
+ * @return  its new length, 0 if the packet is not known or does not fit
+ **************************************************************************************************/
+uint8 WIRE_CmdsAdd(const pkt_t *pPkt, uint8 *pBuf, uint8 len, uint8 size)
+{
+  uint8 n;
+
+  if (len == 0){
+    if (size < WIRE_HDR_LEN){
+      return 0;
+    }
+    pBuf[0] = PKT_CMDS_TYPE;
+    pBuf[1] = WIRE_VER_HDR;
+    len = WIRE_HDR_LEN;
+  }
+  if (len >= size){
+    return 0;
+  }
+  n = WIRE_Encode(pPkt, &pBuf[len + 1], size - len - 1);
+  if (n == 0){
+    return 0;
+  }
+  pBuf[len] = n;
+  return len + 1 + n;
+}
+
+
+/**************************************************************************************************
+ * @brief   Walk through a received PKT_CMDS_TYPE packet
+ * @param   pBuf - the PKT_CMDS_TYPE packet
+ *          len  - its length
+ *          pOff - where the next packet is, 0 for the first
+ *          pLen - set to the length of the packet
+ * @return  the packet, NULL after the last one, at a length that goes past the end, or if pBuf
+ *          is not a PKT_CMDS_TYPE packet of this version
+ **************************************************************************************************/
+const uint8 *WIRE_CmdsNext(const uint8 *pBuf, uint8 len, uint8 *pOff, uint8 *pLen)
+{
+  uint8 off = *pOff;
+  uint8 n;
+
+  if (off == 0){
+    if ((len == 0) || (pBuf[0] != PKT_CMDS_TYPE) || ((off = WIRE_HdrLen(pBuf, len)) == 0)){
+      return NULL;
+    }
+  }
+  if (off >= len){
+    return NULL;
+  }
+  n = pBuf[off];
+  if ((n == 0) || (n > len - off - 1)){
+    return NULL;
+  }
+  *pOff = off + 1 + n;
+  *pLen = n;
+  return &pBuf[off + 1];
+}
+
+
+/**************************************************************************************************
+ * @brief   Table of a packet type, NULL if it has no pkt_t parameters
+ **************************************************************************************************/
+static const wireType_t* wireFind(pktType_t pktType)
+{
+  uint8 i;
+
+  for (i=0; i<sizeof(wireTypes)/sizeof(wireTypes[0]); i++){
+    if (wireTypes[i].pktType == pktType){
+      return &wireTypes[i];
+    }
+  }
+  return NULL;
+}
@@ -20,8 +20,16 @@
 #include "node.h"
 #include "nwk_comm.h"
 #include "fram.h"
+#include "store.h"
+#include "store_info.h"
+#include "calib.h"
+#include "sched.h"
+#include "coord.h"
 #include "sensing.h"
 #include "packet.h"
+#include "batch.h"
+#include "wire.h"
+#include "mac_callback.h"
 
 /**** DEFINE   ****/
 #define UART0_RX_BUF_SIZE         128
@@ -33,27 +41,10 @@
 #define NODE_HEADER_LENGTH         4             /* Header includes DataLength + DeviceShortAddr + Sequence */
 #define NODE_ECHO_LENGTH           8             /* Echo packet */
 
-/* Size table for MAC structures */
-const CODE uint8 node_cbackSizeTable [] =
-{
-  0,                                   /* unused */
-  sizeof(macMlmeAssociateInd_t),       /* MAC_MLME_ASSOCIATE_IND */
-  sizeof(macMlmeAssociateCnf_t),       /* MAC_MLME_ASSOCIATE_CNF */
-  sizeof(macMlmeDisassociateInd_t),    /* MAC_MLME_DISASSOCIATE_IND */
-  sizeof(macMlmeDisassociateCnf_t),    /* MAC_MLME_DISASSOCIATE_CNF */
-  sizeof(macMlmeBeaconNotifyInd_t),    /* MAC_MLME_BEACON_NOTIFY_IND */
-  sizeof(macMlmeOrphanInd_t),          /* MAC_MLME_ORPHAN_IND */
-  sizeof(macMlmeScanCnf_t),            /* MAC_MLME_SCAN_CNF */
-  sizeof(macMlmeStartCnf_t),           /* MAC_MLME_START_CNF */
-  sizeof(macMlmeSyncLossInd_t),        /* MAC_MLME_SYNC_LOSS_IND */
-  sizeof(macMlmePollCnf_t),            /* MAC_MLME_POLL_CNF */
-  sizeof(macMlmeCommStatusInd_t),      /* MAC_MLME_COMM_STATUS_IND */
-  sizeof(macMcpsDataCnf_t),            /* MAC_MCPS_DATA_CNF */
-  sizeof(macMcpsDataInd_t),            /* MAC_MCPS_DATA_IND */
-  sizeof(macMcpsPurgeCnf_t),           /* MAC_MCPS_PURGE_CNF */
-  sizeof(macEventHdr_t),               /* MAC_PWR_ON_CNF */
-  sizeof(macMlmePollInd_t)             /* MAC_MLME_POLL_IND */
-};
+/* Steps to find the coordinator, cheapest first; the first two need the last association */
+#define NODE_CONN_ORPHAN           0             /* orphan scan of its channel */
+#define NODE_CONN_CHANNEL          1             /* active scan of its channel */
+#define NODE_CONN_FULL             2             /* active scan of all channels */
 
 
 /**** VARIABLEs  ****/
@@ -84,44 +75,88 @@ bool    isAssociated   = FALSE;
 bool    isGWDetect     = FALSE;
 bool    isPendData     = FALSE;
 /* Retry rescan */
-uint8   curRescanNum       = 0;
+uint8   curRescanNum       = 0;   /* full scans failed since the last association */
 uint8   scanTimeOut        = NODE_DEFAULT_SCAN_TIME_OUT;
-uint8   numRescanTry       = NODE_DEFAULT_NUM_RESCAN_TRY;
 uint16  rescanWaitTime     = NODE_DEFAULT_RESCAN_WAIT_TIME;
-uint8   numPollFail        = 0;
-
-/* Sensing time management */
+uint32  rescanWaitMax      = NODE_DEFAULT_RESCAN_WAIT_MAX;
+uint8   numPollFail        = 0;   /* polls and frames failed in a row, NODE_LinkFail() */
+/* The extended address and the last association, kept over resets (coord.h): the node looks
+ * for its coordinator where it was first, and gets its short address back */
+coord_t nodeCoord;
+uint8   connStep           = NODE_CONN_FULL;
+
+/* Sensing time management: the stick timer is set for the next stick where something is due,
+ * the ones in between are slept through */
 uint16  stickDuration  = NODE_DEFAULT_STICK_DURATION;
-uint16  preparingDelta = NODE_DEFAULT_PREPARING_DELTA;
-uint16  sensingTime    = NODE_DEFAULT_SENSING_TIME;
-uint16  sendAliveTime  = NODE_DEFAULT_SEND_ALIVE_TIME;
+sched_t nodeSched;
 uint32  curStickTime   = 0;
+uint32  nextStickTime  = 0;       /* stick the timer is set for */
 /* Sensing result */
 pkt_t   alivePkt;
 pkt_t   sensingPkt;
+/* Sensing results are kept in the FRAM store and sent from there, oldest first, so the ones
+ * measured while the gateway could not be reached go out after the next association */
+bool    isStoreActive  = FALSE;
+uint32  replaySeq;                /* last stored result in the frame on the air */
+uint8   replayBudget   = 0;
+uint32  storeTimeBase  = 0;       /* times go on from the last record before the reset */
+uint8   storeBuf[STORE_DATA_LEN];
+node_store_info_t storeInfo;
+/* Calibration of the sensing, from the FRAM */
+calib_t nodeCalib;
+/* Results go out as PKT_BATCH_TYPE packets: every stored result not sent yet that fits one
+ * frame, once there are batchPeriods of them */
+uint8   batchPeriods   = NODE_DEFAULT_BATCH_PERIODS;
+uint8   batchFields    = NODE_DEFAULT_BATCH_FIELDS;
+uint8   batchBuf[MAC_MAX_FRAME_SIZE];
+/* Transmissions of a wake-up go out one after the other, each from the confirm of the one
+ * before, the poll last, so the radio is on once per wake-up.  A frame that fails holds the
+ * next ones back for txBackoff sticks */
+bool    isTxBusy       = FALSE;   /* a frame or the poll is on the air */
+bool    isRadioOn      = FALSE;
+bool    isSensing      = FALSE;   /* what is due waits for the result of the ADC */
+bool    txAliveDue     = FALSE;
+bool    txPollDue      = FALSE;
+bool    txHasResults   = FALSE;   /* the frame on the air carries results */
+uint8   txBackoff      = 0;
+uint8   txBackoffLen   = 1;
 
 /**** FUNCTIONs ****/
 void UART0Start(void);
 void NODE_UARTCallBack (uint8 port, uint8 event);
 
 void NODE_DeviceStartup(void);
+void NODE_CoordInit(void);
+void NODE_Connect(uint8 step);
+void NODE_Joined(uint8 channel);
 /* MAC related routines */
 void NODE_PollRequest(void);
 
 /* Support */
-void NODE_SendDirect(pktType_t pktType, uint8* pktPara, uint8 paraLen, uint16 dstShortAddr);
-void NODE_SendAlive(void);
-void NODE_SendSensingResult(void);
+macMcpsDataReq_t* NODE_DataAlloc(uint8 len, uint16 dstShortAddr);
+bool NODE_SendDirect(pkt_t* pPkt, uint16 dstShortAddr);
+bool NODE_SendBatch(batch_t *pBatch, uint16 dstShortAddr);
+void NODE_StoreInit(void);
+uint8 NODE_StickStart(void);
+void NODE_StickSet(uint32 stick);
+bool NODE_TxBuild(batch_t *pBatch);
+void NODE_TxRun(void);
+void NODE_TxDone(bool isSent);
+void NODE_LinkFail(void);
+void NODE_RadioOn(void);
+void NODE_RadioOff(void);
 void NODE_PollRequest(void);
 
 /* Process event / request */
 void ProcessInitPeriEvent(void);
 void ProcessScanConfirmEvent(macCbackEvent_t * pData);
 void ProcessStickTimerEvent(void);
+void ProcessSensedEvent(void);
 void ProcessScanFail(void);
 void ProcessStickTimerEvent(void);
 void ProcessAssocConfirmEvent(macCbackEvent_t *pData);
 void ProcessReceivingPacket(macMcpsDataInd_t* pData);
+void ProcessCommand(const uint8 *pBuf, uint8 len);
 
 /**************************************************************************************************
  * @brief       Initialize the application
@@ -130,6 +165,7 @@ void ProcessReceivingPacket(macMcpsDataInd_t* pData);
  **************************************************************************************************/
 void NODE_Init(uint8 taskId){
   NODE_TaskId = taskId;     /* store taskId */
+  MACCB_Init(NODE_TaskId);  /* MAC events through the static slots */
   MAC_InitDevice();         /* initialize MAC features */
   MAC_InitCoord();
   MAC_MlmeResetReq(TRUE);   /* Reset the MAC */
@@ -169,38 +205,57 @@ uint16 NODE_ProcessEvent(uint8 taskId, uint16 events)
               HalUARTPrintStr(HAL_UART_PORT_0,"POLL: ok\n");
               numPollFail = 0;
               break;
-            case MAC_CHANNEL_ACCESS_FAILURE: HalUARTPrintStr(HAL_UART_PORT_0,"POLL: access fail\n"); break;
+            case MAC_CHANNEL_ACCESS_FAILURE:
+              HalUARTPrintStr(HAL_UART_PORT_0,"POLL: access fail\n");
+              NODE_LinkFail();
+              break;
             case MAC_INVALID_PARAMETER: HalUARTPrintStr(HAL_UART_PORT_0,"POLL: invalid\n"); break;
             case MAC_NO_ACK:
               HalUARTPrintStr(HAL_UART_PORT_0,"POLL: no ACK\n");
-              if (5 == numPollFail++){
-                isAssociated = FALSE;
-                HalUARTPrintStr(HAL_UART_PORT_0,"CONNECT: reset request\n");
-              }
+              NODE_LinkFail();
               break;
-            case MAC_NO_DATA: HalUARTPrintStr(HAL_UART_PORT_0,"POLL: no DATA\n"); break;
+            case MAC_NO_DATA:
+              HalUARTPrintStr(HAL_UART_PORT_0,"POLL: no DATA\n");
+              numPollFail = 0;
+              break;
+          }
+          if (isTxBusy){
+            isTxBusy = FALSE;
+            NODE_TxRun();                /* the last of the wake-up, the radio goes off */
           }
           break;
         case MAC_MCPS_DATA_CNF:/* Send COMPLETED */
           pData = (macCbackEvent_t *) pMsg;
+          mac_msg_deallocate((uint8**) &(pData->dataCnf.pDataReq));
           switch (pData->hdr.status){
-            case MAC_SUCCESS: HalUARTPrintStr(HAL_UART_PORT_0, "SENT: success\n"); break;
-            case MAC_CHANNEL_ACCESS_FAILURE: HalUARTPrintStr(HAL_UART_PORT_0, "SENT: access fail\n"); break;
+            case MAC_SUCCESS:
+              HalUARTPrintStr(HAL_UART_PORT_0, "SENT: success\n");
+              numPollFail = 0;
+              break;
+            case MAC_CHANNEL_ACCESS_FAILURE:
+              HalUARTPrintStr(HAL_UART_PORT_0, "SENT: access fail\n");
+              NODE_LinkFail();
+              break;
             case MAC_FRAME_TOO_LONG: HalUARTPrintStr(HAL_UART_PORT_0, "SENT: too long\n"); break;
             case MAC_INVALID_PARAMETER: HalUARTPrintStr(HAL_UART_PORT_0, "SENT: invalid\n"); break;
-            case MAC_NO_ACK: HalUARTPrintStr(HAL_UART_PORT_0, "SENT: no ACK\n"); break;
+            case MAC_NO_ACK:
+              HalUARTPrintStr(HAL_UART_PORT_0, "SENT: no ACK\n");
+              NODE_LinkFail();
+              break;
             case MAC_TRANSACTION_EXPIRED: HalUARTPrintStr(HAL_UART_PORT_0, "SENT: expired\n"); break;
             case MAC_TRANSACTION_OVERFLOW: HalUARTPrintStr(HAL_UART_PORT_0, "SENT: overflow\n"); break;
             case MAC_COUNTER_ERROR: HalUARTPrintStr(HAL_UART_PORT_0, "SENT: error\n"); break;
           }
-          mac_msg_deallocate((uint8**) &(pData->dataCnf.pDataReq));
+          if (isTxBusy){
+            NODE_TxDone(MAC_SUCCESS == pData->hdr.status);
+          }
           break;
         case MAC_MCPS_DATA_IND: /* receiving packet */
           pData = (macCbackEvent_t *) pMsg;
           ProcessReceivingPacket((macMcpsDataInd_t*) pData);
         break;
       } /* end switch */
-      mac_msg_deallocate((uint8 **)&pMsg);       /* Deallocate */
+      MACCB_Free(pMsg);       /* Deallocate */
     } /* end while */
     return events ^ SYS_EVENT_MSG;
   } /* end sys event */
@@ -211,8 +266,8 @@ uint16 NODE_ProcessEvent(uint8 taskId, uint16 events)
   }
 
   if (events & NODE_RESCAN_EVENT){
-    NWK_ScanReq(MAC_SCAN_ACTIVE, scanTimeOut);
     HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "SCAN: rescan ", curRescanNum, 10);
+    NODE_Connect(NODE_CONN_FULL);
     return events ^ NODE_RESCAN_EVENT;
   }
 
@@ -221,6 +276,11 @@ uint16 NODE_ProcessEvent(uint8 taskId, uint16 events)
     return events ^ NODE_STICK_TIMER_EVENT;
   }
 
+  if (events & NODE_SENSED_EVENT){
+    ProcessSensedEvent();
+    return events ^ NODE_SENSED_EVENT;
+  }
+
   return 0;
 }
 
@@ -230,25 +290,36 @@ void ProcessInitPeriEvent(void){
   HalUARTPrintStr(HAL_UART_PORT_0, "\n\n*********************\n");
   HalUARTPrintStr(HAL_UART_PORT_0, "PROGRAM: start\n");
 
+  nodeSched.sensingTime    = NODE_DEFAULT_SENSING_TIME;
+  nodeSched.sendAliveTime  = NODE_DEFAULT_SEND_ALIVE_TIME;
+  nodeSched.preparingDelta = NODE_DEFAULT_PREPARING_DELTA;
   if (ERROR_INIT_FAIL == fram_init(FRAM_MODE0)){ /* init FRAM */
     HalUARTPrintStr(HAL_UART_PORT_0, "FRAM: fail\n");
+    CALIB_Default(&nodeCalib);
   }
   else{
     HalUARTPrintStr(HAL_UART_PORT_0, "FRAM: ok\n");
+    NODE_StoreInit();
+    if (!CALIB_Load(&nodeCalib)){
+      HalUARTPrintStr(HAL_UART_PORT_0, "CALIB: default\n");
+    }
+    if (SCHED_Load(&nodeSched)){
+      HalUARTPrintStr(HAL_UART_PORT_0, "SCHED: from FRAM\n");
+    }
   }
+  NODE_CoordInit();
 
-  /* Start scan */
-  HalUARTPrintStr(HAL_UART_PORT_0, "SCAN: start\n");
-  NWK_ScanReq(MAC_SCAN_ACTIVE, scanTimeOut);
+  /* Start scan: where the node was associated before the reset, if it was */
+  NODE_DeviceStartup();
+  NODE_Connect(NODE_CONN_ORPHAN);
 
   SS_Init(); /* Init Sensing module */
+  SS_SetCalib(&nodeCalib);
 
   stickDuration  = NODE_DEFAULT_STICK_DURATION;
   curStickTime   = 0;
-  preparingDelta = NODE_DEFAULT_PREPARING_DELTA;
-  sensingTime    = NODE_DEFAULT_SENSING_TIME;
   /* Start sensing timer */
-  if (SUCCESS == osal_start_reload_timer(NODE_TaskId, NODE_STICK_TIMER_EVENT, stickDuration)){
+  if (SUCCESS == NODE_StickStart()){
     HalUARTPrintStr(HAL_UART_PORT_0, "TIMER: start\n");
   }
   else{
@@ -259,23 +330,34 @@ void ProcessInitPeriEvent(void){
 }
 
 /********************************************/
+/* A step that found no coordinator goes on with the next one at once; after a full scan the
+ * node sleeps for rescanWaitTime, twice as long each time, up to rescanWaitMax, and never
+ * gives up: the results are kept in the store meanwhile */
 void ProcessScanFail(){
+  uint32 wait = rescanWaitTime;
+  uint8  i;
+
+  if (connStep < NODE_CONN_FULL){
+    NODE_Connect(connStep + 1);
+    return;
+  }
   curRescanNum++;
-  if (curRescanNum <= numRescanTry){
-    osal_start_timerEx(NODE_TaskId, NODE_RESCAN_EVENT, rescanWaitTime); /* Set time for next rescan */
-    HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "SCAN: wait ", rescanWaitTime, 10);
+  for (i = 1; (i < curRescanNum) && (wait < rescanWaitMax); i++){
+    wait <<= 1;
   }
-  else{
-    HalUARTPrintStr(HAL_UART_PORT_0, "SCAN: abort\n");
-    osal_pwrmgr_device( PWRMGR_BATTERY );
+  if (wait > rescanWaitMax){
+    wait = rescanWaitMax;
   }
+  NODE_RadioOff();
+  osal_start_timerEx(NODE_TaskId, NODE_RESCAN_EVENT, wait); /* Set time for next rescan */
+  HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "SCAN: wait ", wait, 10);
 }
 
 
 /********************************************/
 void ProcessScanConfirmEvent(macCbackEvent_t* pData){
   macMlmeScanCnf_t* scanCnf = &(pData->scanCnf);
-  uint8 numResult, i;
+  uint8 numResult, i, channel;
 
   if (scanCnf->hdr.status == MAC_NO_BEACON){
     HalUARTPrintStr(HAL_UART_PORT_0, "SCAN: no beacon\n");
@@ -286,13 +368,14 @@ void ProcessScanConfirmEvent(macCbackEvent_t* pData){
     ProcessScanFail();
   }
   else if (MAC_SCAN_ACTIVE == scanCnf->scanType){
+    isGWDetect = FALSE;
     numResult = scanCnf->resultListSize;
     HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "SCAN result: ", numResult, 10);
     for (i=0; i<numResult; i++){
       HalUARTPrintStrAndUInt(HAL_UART_PORT_0, "COOR: ", scanResult.panDesc[i].coordPanId, 16);
       HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "  channel: ", scanResult.panDesc[i].logicalChannel, 10);
 
-      if (NWK_PAN_ID == scanResult.panDesc[i].coordPanId){
+      if ((NWK_PAN_ID == scanResult.panDesc[i].coordPanId) && !isGWDetect){
         isGWDetect = TRUE;
         node_AssociateReq.logicalChannel = scanResult.panDesc[i].logicalChannel;
         node_AssociateReq.channelPage    = scanResult.panDesc[i].channelPage;
@@ -303,6 +386,8 @@ void ProcessScanConfirmEvent(macCbackEvent_t* pData){
         node_AssociateReq.sec.securityLevel     = MAC_SEC_LEVEL_NONE;
 
         /* MUST after setting node_AssosciateReq */
+        node_PanId          = NWK_PAN_ID;
+        node_CoordShortAddr = node_AssociateReq.coordAddress.addr.shortAddr;
         NODE_DeviceStartup(); /* Start the devive up */
         HalUARTPrintStr(HAL_UART_PORT_0, "ASSOC: request\n");
         MAC_MlmeAssociateReq(&node_AssociateReq);  /* Call Associate Req */
@@ -313,8 +398,15 @@ void ProcessScanConfirmEvent(macCbackEvent_t* pData){
       ProcessScanFail();
     }
   }
-  else if (MAC_SCAN_ORPHAN== scanCnf->scanType){
-    HalUARTPrintStr(HAL_UART_PORT_0, "Orphan scan\n");
+  else if (MAC_SCAN_ORPHAN == scanCnf->scanType){
+    /* The coordinator knew the node: the realignment gave the MAC the PAN, the channel and
+     * both short addresses, no association is needed */
+    MAC_MlmeGetReq(MAC_PAN_ID, &node_PanId);
+    MAC_MlmeGetReq(MAC_LOGICAL_CHANNEL, &channel);
+    MAC_MlmeGetReq(MAC_COORD_SHORT_ADDRESS, &node_CoordShortAddr);
+    MAC_MlmeGetReq(MAC_SHORT_ADDRESS, &node_DevShortAddr);
+    HalUARTPrintStr(HAL_UART_PORT_0, "ORPHAN: realigned\n");
+    NODE_Joined(channel);
   }
 }
 
@@ -322,16 +414,10 @@ void ProcessScanConfirmEvent(macCbackEvent_t* pData){
 /***************************/
 void ProcessAssocConfirmEvent(macCbackEvent_t *pData){
   if ((!isAssociated) && (pData->associateCnf.hdr.status == MAC_SUCCESS)){
-    isAssociated = TRUE;
-    numPollFail  = 0;
     node_DevShortAddr = pData->associateCnf.assocShortAddress; /* Retrieve MAC_SHORT_ADDRESS */
     MAC_MlmeSetReq(MAC_SHORT_ADDRESS, &node_DevShortAddr); /* Setup MAC_SHORT_ADDRESS - obtained from Association */
     HalUARTPrintStr(HAL_UART_PORT_0, "ASSOC: OK\n");
-    HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "ADDRESS: ", node_DevShortAddr, 16);
-    if (isPendData){
-      NODE_SendSensingResult();
-      isPendData = FALSE;
-    }
+    NODE_Joined(node_AssociateReq.logicalChannel);
   }
   else{
     /* IF COORDINATOR deny association, SNs will be exhaused energy for try assoc */
@@ -340,55 +426,120 @@ void ProcessAssocConfirmEvent(macCbackEvent_t *pData){
 }
 
 
+/* What is due at this stick goes out in one wake-up of the radio; on a sensing stick it waits
+ * for the result, so the alive packet and the poll go with it.  The timer is set for the next
+ * stick with work first, the sticks in between are slept through */
 void ProcessStickTimerEvent(){
-  curStickTime++;
+  uint32 slept = nextStickTime - curStickTime;
+  uint8  due;
+
+  curStickTime = nextStickTime;
+  NODE_StickStart();
+  due = SCHED_Due(&nodeSched, curStickTime);
+  replayBudget = NODE_REPLAY_BURST;
+  txBackoff = (txBackoff > slept) ? (uint8)(txBackoff - slept) : 0;
   //HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "TIMER: fire ", curStickTime, 10);
-  if (0 == (curStickTime % sensingTime)){
-    HalLedSet(HAL_LED_3, HAL_LED_MODE_ON);
-    HalUARTPrintStr(HAL_UART_PORT_0,"\nSENING: sensing\n");
-    SS_Measure(&(sensingPkt.pktPara.sensingPara.sensingData));
-    SS_Shutdown();
+  if (due & SCHED_ALIVE){
     if (isAssociated){
-      HalUARTPrintStr(HAL_UART_PORT_0, "SEND: senResult\n");
-      NODE_SendSensingResult();
+      txAliveDue = TRUE;
+      txPollDue  = TRUE;
     }
     else{
-      isPendData = TRUE;
-      HalUARTPrintStr(HAL_UART_PORT_0, "PEND: senResult\nSCAN: restart\n");
-      curRescanNum = 0;
-      NWK_ScanReq(MAC_SCAN_ACTIVE, scanTimeOut);
+      HalUARTPrintStr(HAL_UART_PORT_0, "PEND: alive\n");
     }
-    SS_Print(&(sensingPkt.pktPara.sensingPara.sensingData)); /* out result for debug */
   }
-  else{
-    if (0 == ((curStickTime-preparingDelta) % sensingTime)){
-      HalUARTPrintStr(HAL_UART_PORT_0,"SENING: prepare\n");
-      SS_Prepare();
-      HalLedSet(HAL_LED_3, HAL_LED_MODE_ON);
-    }
-    if (0 == (curStickTime % sendAliveTime)){
-      if (isAssociated){
-        HalUARTPrintStr(HAL_UART_PORT_0, "SEND: alive\n");
-        NODE_SendAlive();
-        HalUARTPrintStr(HAL_UART_PORT_0, "POLL: request\n");
-        NODE_PollRequest();
-      }
-      else{
-        HalUARTPrintStr(HAL_UART_PORT_0, "PEND: alive\n");
-      }
-    }
+  if (due & SCHED_SENSE){
+    HalLedSet(HAL_LED_3, HAL_LED_MODE_ON);
+    HalUARTPrintStr(HAL_UART_PORT_0,"\nSENING: sensing\n");
+    isSensing = TRUE;
+    SS_Start(NODE_TaskId, NODE_SENSED_EVENT); /* NODE_SENSED_EVENT when done */
+  }
+  else if (due & SCHED_PREPARE){
+    HalUARTPrintStr(HAL_UART_PORT_0,"SENING: prepare\n");
+    SS_Prepare();
+    HalLedSet(HAL_LED_3, HAL_LED_MODE_ON);
   }
   if (isAssociated){
+    NODE_TxRun();
     HalLedSet(HAL_LED_2, HAL_LED_MODE_TOGGLE);
   }
 }
 
 
 
+/**************************************************************************************************
+ * @brief   The ADC went through its samples: keep and send the result of the stick that
+ *          started them
+ **************************************************************************************************/
+void ProcessSensedEvent(void){
+  sensingPara_t *pSensing = &(sensingPkt.pktPara.sensingPara);
+
+  SS_Measure(&(pSensing->sensingData));
+  SS_Shutdown();
+  isSensing = FALSE;
+  pSensing->nodeId = nodeId;
+  pSensing->time   = storeTimeBase + curStickTime;
+  pSensing->run    = storeInfo.numReset;
+  if (isStoreActive){
+    pSensing->storeBlock = storeInfo.curBlock = STORE_Block(STORE_Head());
+    STORE_Append(pSensing->time, (uint8*) pSensing, sizeof(sensingPara_t));
+  }
+  isPendData = TRUE;                    /* without the store, the result to send */
+  if (isAssociated){
+    NODE_TxRun();
+  }
+  else{
+    HalUARTPrintStr(HAL_UART_PORT_0, "PEND: senResult\n");   /* the node is looking for the GW */
+  }
+  SS_Print(&(sensingPkt.pktPara.sensingPara.sensingData)); /* out result for debug */
+}
+
+
+
 /************************************/
+/* The gateway sends its commands for the node together, in a PKT_CMDS_TYPE packet */
 void ProcessReceivingPacket(macMcpsDataInd_t* pData){
+  const uint8 *pCmd;
+  uint8 off = 0;
+  uint8 len;
+
   HalUARTPrintStrAndUInt(HAL_UART_PORT_0, "POLL: linkQuality: ", pData->mac.mpduLinkQuality,10);
   HalUARTPrintnlStrAndInt(HAL_UART_PORT_0, " rssi: ", pData->mac.rssi, 10);
+
+  if ((pData->msdu.len != 0) && (PKT_CMDS_TYPE == pData->msdu.p[0])){
+    while ((pCmd = WIRE_CmdsNext(pData->msdu.p, pData->msdu.len, &off, &len)) != NULL){
+      ProcessCommand(pCmd, len);
+    }
+  }
+  else{
+    ProcessCommand(pData->msdu.p, pData->msdu.len);
+  }
+}
+
+void ProcessCommand(const uint8 *pBuf, uint8 len){
+  pkt_t pkt;
+
+  if (!WIRE_Decode(pBuf, len, &pkt)){
+    return;
+  }
+  /* New calibration: used from the next measurement on, and kept over resets */
+  if ((PKT_CALIB_TYPE == pkt.pktType) && CALIB_Valid(&(pkt.pktPara.calibPara))){
+    osal_memcpy(&nodeCalib, &(pkt.pktPara.calibPara), sizeof(calib_t));
+    SS_SetCalib(&nodeCalib);
+    if (isStoreActive){
+      CALIB_Save(&nodeCalib);
+    }
+    HalUARTPrintStr(HAL_UART_PORT_0, "CALIB: set\n");
+  }
+  /* New periods: from this stick on, and kept over resets */
+  else if ((PKT_SCHED_TYPE == pkt.pktType) && SCHED_Valid(&(pkt.pktPara.schedPara))){
+    osal_memcpy(&nodeSched, &(pkt.pktPara.schedPara), sizeof(sched_t));
+    if (isStoreActive){
+      SCHED_Save(&nodeSched);
+    }
+    NODE_StickSet(SCHED_Next(&nodeSched, curStickTime));
+    HalUARTPrintStr(HAL_UART_PORT_0, "SCHED: set\n");
+  }
 }
 /**************************************************************************************************
  * @brief   Update the timer per tick
@@ -397,12 +548,6 @@ void ProcessReceivingPacket(macMcpsDataInd_t* pData){
  **************************************************************************************************/
 void NODE_DeviceStartup()
 {
-  uint16 AtoD = 0;
-  AtoD = MAC_RADIO_RANDOM_WORD();
-  AtoD = macMcuPrecisionCount();
-  node_ExtAddr[6] = HI_UINT16( AtoD );
-  node_ExtAddr[7] = LO_UINT16( AtoD );
-
   /* Setup Ext address */
   MAC_MlmeSetReq(MAC_EXTENDED_ADDRESS, &node_ExtAddr);
   /* Setup MAC_BEACON_PAYLOAD_LENGTH */
@@ -416,53 +561,387 @@ void NODE_DeviceStartup()
   MAC_MlmeSetReq(MAC_SECURITY_ENABLED, &node_MACFalse);
   MAC_MlmeSetReq(MAC_PHY_TRANSMIT_POWER_SIGNED, &node_TxPower);
   /* Setup Coordinator short address */
-  MAC_MlmeSetReq(MAC_COORD_SHORT_ADDRESS, &node_AssociateReq.coordAddress.addr.shortAddr);
-  node_CoordShortAddr = node_AssociateReq.coordAddress.addr.shortAddr;
+  MAC_MlmeSetReq(MAC_COORD_SHORT_ADDRESS, &node_CoordShortAddr);
   HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "COOR: addr ", node_CoordShortAddr, 16);
   /* Power saving */
   NODE_PowerMgr (NODE_PWR_MGMT_ENABLED);
 }
 
 
-void NODE_SendDirect(pktType_t pktType, uint8* pktPara, uint8 paraLen, uint16 dstShortAddr){
+/**************************************************************************************************
+ * @brief   Take the extended address and the last association from the FRAM.  A node without
+ *          them draws its extended address, once: the gateway knows its devices by it, 32 bits
+ *          of it are drawn so two nodes hardly ever get the same.
+ * @return  None
+ **************************************************************************************************/
+void NODE_CoordInit(void){
+  uint16 AtoD = 0;
+
+  if (isStoreActive && COORD_Load(&nodeCoord)){
+    sAddrExtCpy(node_ExtAddr, nodeCoord.extAddr);
+    if (0 != nodeCoord.channel){
+      node_PanId          = nodeCoord.panId;
+      node_CoordShortAddr = nodeCoord.coordShortAddr;
+      node_DevShortAddr   = nodeCoord.shortAddr;
+      HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "COORD: from FRAM, channel ", nodeCoord.channel, 10);
+    }
+    return;
+  }
+  AtoD = MAC_RADIO_RANDOM_WORD();
+  node_ExtAddr[4] = HI_UINT16( AtoD );
+  node_ExtAddr[5] = LO_UINT16( AtoD );
+  AtoD = macMcuPrecisionCount();
+  node_ExtAddr[6] = HI_UINT16( AtoD );
+  node_ExtAddr[7] = LO_UINT16( AtoD );
+
+  osal_memset(&nodeCoord, 0, sizeof(coord_t));
+  sAddrExtCpy(nodeCoord.extAddr, node_ExtAddr);
+  if (isStoreActive){
+    COORD_Save(&nodeCoord);
+  }
+}
+
+
+/**************************************************************************************************
+ * @brief   Look for the coordinator from a step on.  The orphan scan and the scan of the one
+ *          channel take a fraction of the time of a full scan; a node that never associated
+ *          goes to the full scan.
+ * @param   step - NODE_CONN_xxx
+ * @return  None
+ **************************************************************************************************/
+void NODE_Connect(uint8 step){
+  uint32 channels = (uint32)1 << nodeCoord.channel;
+
+  if (0 == nodeCoord.channel){
+    step = NODE_CONN_FULL;
+  }
+  connStep = step;
+  NODE_RadioOn();
+  switch (step){
+    case NODE_CONN_ORPHAN:
+      HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "SCAN: orphan ", nodeCoord.channel, 10);
+      NWK_ScanChannelsReq(MAC_SCAN_ORPHAN, channels, scanTimeOut);
+      break;
+    case NODE_CONN_CHANNEL:
+      HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "SCAN: channel ", nodeCoord.channel, 10);
+      NWK_ScanChannelsReq(MAC_SCAN_ACTIVE, channels, scanTimeOut);
+      break;
+    default:
+      HalUARTPrintStr(HAL_UART_PORT_0, "SCAN: start\n");
+      NWK_ScanReq(MAC_SCAN_ACTIVE, scanTimeOut);
+      break;
+  }
+}
+
+
+/**************************************************************************************************
+ * @brief   The node is in the network, by an association or an orphan scan: what it measured
+ *          meanwhile goes out, and the network goes to the FRAM if it changed
+ * @param   channel - of the coordinator
+ * @return  None
+ **************************************************************************************************/
+void NODE_Joined(uint8 channel){
+  isAssociated = TRUE;
+  numPollFail  = 0;
+  curRescanNum = 0;
+  HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "ADDRESS: ", node_DevShortAddr, 16);
+  if ((nodeCoord.channel != channel) || (nodeCoord.panId != node_PanId) ||
+      (nodeCoord.coordShortAddr != node_CoordShortAddr) || (nodeCoord.shortAddr != node_DevShortAddr)){
+    nodeCoord.channel        = channel;
+    nodeCoord.panId          = node_PanId;
+    nodeCoord.coordShortAddr = node_CoordShortAddr;
+    nodeCoord.shortAddr      = node_DevShortAddr;
+    if (isStoreActive){
+      COORD_Save(&nodeCoord);
+    }
+  }
+  txAliveDue = TRUE;                    /* the gateway sees the node at once, and the poll */
+  txPollDue  = TRUE;                    /* takes what it holds for a new node: the periods */
+  NODE_TxRun();                         /* what was measured meanwhile */
+}
+
+
+/* A data request of 'len' bytes to the coordinator, msdu left to fill */
+macMcpsDataReq_t* NODE_DataAlloc(uint8 len, uint16 dstShortAddr){
   static uint8 msduHandle=0;
   macMcpsDataReq_t*  sentMACPkt    = NULL;
-  pkt_t *dstAppPkt;
 
-  MAC_PwrOnReq();
-  sentMACPkt = MAC_McpsDataAlloc(sizeof(pktType_t)+paraLen, MAC_SEC_LEVEL_NONE, MAC_KEY_ID_MODE_IMPLICIT );
+  sentMACPkt = MAC_McpsDataAlloc(len, MAC_SEC_LEVEL_NONE, MAC_KEY_ID_MODE_IMPLICIT );
   if ((NULL == sentMACPkt)){
     HalUARTPrintStr(HAL_UART_PORT_0, "MEM: deny\n");
-    return;
+    return NULL;
   }
 
   sentMACPkt->mac.srcAddrMode            = SADDR_MODE_SHORT;
   sentMACPkt->mac.dstAddr.addrMode       = SADDR_MODE_SHORT;
   sentMACPkt->mac.dstAddr.addr.shortAddr = dstShortAddr;
   sentMACPkt->mac.dstPanId               = node_PanId;
-  sentMACPkt->mac.txOptions              = MAC_TXOPTION_NO_RETRANS;
+  sentMACPkt->mac.txOptions              = MAC_TXOPTION_ACK;  /* retried by the MAC */
   //sentMACPkt->mac.channel                = 11;
   //sentMACPkt->mac.power                  = 0;
   sentMACPkt->sec.securityLevel          = MAC_SEC_LEVEL_NONE;
   //sentMACPkt->sec.keyIdMode              = MAC_KEY_ID_MODE_NONE;
   sentMACPkt->mac.msduHandle = msduHandle++;
-  //sentMACPkt->msdu.len = sizeof(pktType_t)+paraLen;
-  dstAppPkt = (pkt_t*) sentMACPkt->msdu.p;
-  dstAppPkt->pktType = pktType;
-  osal_memcpy(&(dstAppPkt->pktPara), pktPara, paraLen);
+  return sentMACPkt;
+}
+
+
+/* In the wire format, the same bytes whatever compiler built the receiver */
+bool NODE_SendDirect(pkt_t* pPkt, uint16 dstShortAddr){
+  macMcpsDataReq_t*  sentMACPkt;
+  uint8              len = WIRE_Len(pPkt->pktType);
+
+  if (NULL == (sentMACPkt = NODE_DataAlloc(len, dstShortAddr))){
+    return FALSE;
+  }
+  WIRE_Encode(pPkt, sentMACPkt->msdu.p, len);
   MAC_McpsDataReq(sentMACPkt);
+  return TRUE;
 }
 
-void NODE_SendAlive(void){
-  alivePkt.pktPara.alivePara.curTime = curStickTime;
-  alivePkt.pktPara.alivePara.nodeId  = nodeId;
-  NODE_SendDirect(PKT_ALIVE_TYPE, (uint8*) &(alivePkt.pktPara.alivePara), sizeof(alivePara_t), node_CoordShortAddr);
+/* Batches are packed to the byte, they go out as they are */
+bool NODE_SendBatch(batch_t *pBatch, uint16 dstShortAddr){
+  macMcpsDataReq_t*  sentMACPkt;
+
+  if (NULL == (sentMACPkt = NODE_DataAlloc(BATCH_Len(pBatch), dstShortAddr))){
+    return FALSE;
+  }
+  osal_memcpy(sentMACPkt->msdu.p, batchBuf, BATCH_Len(pBatch));
+  MAC_McpsDataReq(sentMACPkt);
+  return TRUE;
+}
+
+
+/**************************************************************************************************
+ * @brief   Open the store of sensing results.  A new store starts with everything sent; the
+ *          reset count goes up and the times go on from the newest record.
+ * @return  None
+ **************************************************************************************************/
+void NODE_StoreInit(void){
+  uint32 time;
+  uint8  len;
+
+  if (!STORE_Init(&storeInfo, sizeof(storeInfo))){
+    osal_memset(&storeInfo, 0, sizeof(storeInfo));
+    storeInfo.sentSeq = STORE_Head();
+    HalUARTPrintStr(HAL_UART_PORT_0, "STORE: new\n");
+  }
+  storeInfo.nodeId = nodeId;
+  storeInfo.numReset++;
+  STORE_Checkpoint();
+
+  if ((STORE_Head() > STORE_Oldest()) &&
+      (STORE_OK == STORE_Read(STORE_Head() - 1, &time, storeBuf, &len))){
+    storeTimeBase = time;
+  }
+  isStoreActive = TRUE;
+  HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "STORE: unsent ", STORE_Head() - storeInfo.sentSeq, 10);
+}
+
+
+/**************************************************************************************************
+ * @brief   Batch of the results to send: the oldest stored results the gateway has not
+ *          acknowledged, as many as fit, once batchPeriods of them are waiting or an alive
+ *          packet goes anyway; without the store, the result waiting.  The batch is the alive
+ *          packet too if one is due.  Results that were overwritten or do not read back are
+ *          skipped.
+ * @param   pBatch - the batch, in batchBuf
+ * @return  FALSE if there are no results to send
+ **************************************************************************************************/
+bool NODE_TxBuild(batch_t *pBatch){
+  sensingPara_t rec;
+  uint32  seq, time;
+  uint8   len;
+
+  BATCH_Start(pBatch, batchBuf, sizeof(batchBuf), nodeId, batchFields);
+  if (txAliveDue){
+    BATCH_SetAlive(pBatch, curStickTime);
+  }
+  if (!isStoreActive){
+    if (isPendData){
+      BATCH_Add(pBatch, &(sensingPkt.pktPara.sensingPara));
+    }
+    return (0 != BATCH_Count(pBatch));
+  }
+
+  if (storeInfo.sentSeq < STORE_Oldest()){
+    storeInfo.sentSeq = STORE_Oldest();
+  }
+  if ((STORE_Head() == storeInfo.sentSeq) ||
+      (!txAliveDue && (STORE_Head() - storeInfo.sentSeq < (uint32) ((batchPeriods > 0) ? batchPeriods : 1)))){
+    return FALSE;
+  }
+  for (seq = storeInfo.sentSeq; seq < STORE_Head(); seq++){
+    if ((STORE_OK != STORE_Read(seq, &time, storeBuf, &len)) || (len != sizeof(sensingPara_t))){
+      if (0 == BATCH_Count(pBatch)){
+        storeInfo.sentSeq = seq + 1;    /* none read back before it */
+      }
+      continue;
+    }
+    osal_memcpy(&rec, storeBuf, sizeof(rec));
+    if (!BATCH_Add(pBatch, &rec)){
+      break;
+    }
+  }
+  replaySeq = seq - 1;                  /* the last one in the batch */
+  return (0 != BATCH_Count(pBatch));
 }
 
 
-void NODE_SendSensingResult(void){
-  NODE_SendDirect(PKT_SENSING_TYPE, (uint8*) &(sensingPkt.pktPara.sensingPara),
-                  sizeof(sensingPara_t), node_CoordShortAddr);
+/**************************************************************************************************
+ * @brief   Send the next frame of this wake-up, if nothing is on the air: a batch of results,
+ *          which stands for the alive packet when one is due, else the alive packet alone, and
+ *          then the poll.  The confirm of each calls here again; once all is sent the radio
+ *          goes off.  Up to NODE_REPLAY_BURST batches go out per stick when catching up, and
+ *          none during a backoff; an alive packet due then stays due until it is sent.
+ * @return  None
+ **************************************************************************************************/
+void NODE_TxRun(void){
+  batch_t batch;
+
+  if (isTxBusy || isSensing){
+    return;
+  }
+
+  if (isAssociated && (0 == txBackoff) && (replayBudget > 0) && NODE_TxBuild(&batch)){
+    NODE_RadioOn();
+    replayBudget--;
+    if (NODE_SendBatch(&batch, node_CoordShortAddr)){
+      HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "SEND: results ", BATCH_Count(&batch), 10);
+      txAliveDue   = FALSE;
+      txHasResults = TRUE;
+      isTxBusy     = TRUE;
+      return;
+    }
+  }
+  if (isAssociated && txAliveDue && (0 == txBackoff)){
+    alivePkt.pktType = PKT_ALIVE_TYPE;
+    alivePkt.pktPara.alivePara.curTime = curStickTime;
+    alivePkt.pktPara.alivePara.nodeId  = nodeId;
+    NODE_RadioOn();
+    if (NODE_SendDirect(&alivePkt, node_CoordShortAddr)){
+      HalUARTPrintStr(HAL_UART_PORT_0, "SEND: alive\n");
+      txAliveDue = FALSE;
+      isTxBusy   = TRUE;
+      return;
+    }
+  }
+  if (isAssociated && txPollDue){
+    txPollDue = FALSE;
+    NODE_RadioOn();
+    HalUARTPrintStr(HAL_UART_PORT_0, "POLL: request\n");
+    NODE_PollRequest();
+    isTxBusy = TRUE;
+    return;
+  }
+  if (isAssociated){
+    if ((0 == replayBudget) && (0 == txBackoff) && NODE_TxBuild(&batch)){
+      NODE_StickSet(curStickTime + 1);  /* more to catch up with, at the next stick */
+    }
+    NODE_RadioOff();
+  }
+}
+
+
+/**************************************************************************************************
+ * @brief   Confirm of a frame of NODE_TxRun().  The results it carried are sent; a frame the
+ *          MAC gave up on after its retries holds the next ones back for 1, 2, 4 .. sticks, up
+ *          to NODE_TX_BACKOFF_MAX, while the poll still goes.
+ * @param   isSent - TRUE if the coordinator acknowledged the frame
+ * @return  None
+ **************************************************************************************************/
+void NODE_TxDone(bool isSent){
+  isTxBusy = FALSE;
+  if (isSent){
+    if (txHasResults && isStoreActive){
+      storeInfo.sentSeq = replaySeq + 1; /* saved with the next checkpoint */
+    }
+    else if (txHasResults){
+      isPendData = FALSE;
+    }
+    txBackoffLen = 1;
+  }
+  else{
+    txBackoff = txBackoffLen;
+    if (txBackoffLen < NODE_TX_BACKOFF_MAX){
+      txBackoffLen <<= 1;
+    }
+    HalUARTPrintnlStrAndUInt(HAL_UART_PORT_0, "SEND: backoff ", txBackoff, 10);
+    if (curStickTime + txBackoff < nextStickTime){
+      NODE_StickSet(curStickTime + txBackoff);
+    }
+  }
+  txHasResults = FALSE;
+  NODE_TxRun();
+}
+
+
+/**************************************************************************************************
+ * @brief   A poll or a frame to the coordinator failed, with no ACK or no clear channel.  After
+ *          more than NODE_POLL_FAIL_MAX in a row the coordinator is taken for lost, or moved to
+ *          another channel, and the node looks for it again from the orphan scan on.
+ * @return  None
+ **************************************************************************************************/
+void NODE_LinkFail(void){
+  if (NODE_POLL_FAIL_MAX != numPollFail++){
+    return;
+  }
+  isAssociated = FALSE;
+  HalUARTPrintStr(HAL_UART_PORT_0,"CONNECT: reset request\n");
+  curRescanNum = 0;
+  NODE_Connect(NODE_CONN_ORPHAN);       /* at once, not at the next measurement */
+}
+
+
+/**************************************************************************************************
+ * @brief   Set the stick timer for the next stick where something is due
+ * @return  SUCCESS or the error of the OSAL timer
+ **************************************************************************************************/
+uint8 NODE_StickStart(void){
+  nextStickTime = SCHED_Next(&nodeSched, curStickTime);
+  return osal_start_timerEx(NODE_TaskId, NODE_STICK_TIMER_EVENT,
+                            (nextStickTime - curStickTime) * stickDuration);
+}
+
+
+/**************************************************************************************************
+ * @brief   Move the wake-up the stick timer is set for to another stick.  The time left is
+ *          moved by whole sticks, so the sticks stay where they were.
+ * @param   stick - stick to wake up at, after curStickTime
+ * @return  None
+ **************************************************************************************************/
+void NODE_StickSet(uint32 stick){
+  uint32 left = osal_get_timeoutEx(NODE_TaskId, NODE_STICK_TIMER_EVENT);
+  uint32 shift;
+
+  if ((stick <= curStickTime) || (0 == left)){
+    return;
+  }
+  if (stick > nextStickTime){
+    left += (stick - nextStickTime) * stickDuration;
+  }
+  else{
+    shift = (nextStickTime - stick) * stickDuration;
+    left  = (left > shift) ? left - shift : 1;
+  }
+  nextStickTime = stick;
+  osal_start_timerEx(NODE_TaskId, NODE_STICK_TIMER_EVENT, left);
+}
+
+
+/* One radio-on period per wake-up */
+void NODE_RadioOn(void){
+  if (!isRadioOn){
+    MAC_PwrOnReq();
+    isRadioOn = TRUE;
+  }
+}
+
+
+void NODE_RadioOff(void){
+  if (isRadioOn && (MAC_SUCCESS == MAC_PwrOffReq(MAC_PWR_SLEEP_DEEP))){
+    isRadioOn = FALSE;
+  }
 }
 
 
@@ -528,30 +1007,16 @@ void NODE_UARTCallBack (uint8 port, uint8 event)
  *              The application must implement this function.  A typical
  *              implementation of this function would allocate an OSAL message,
  *              copy the event parameters to the message, and send the message
- *              to the application's OSAL event handler.  This function may be
+ *              to the application's OSAL event handler.  Here the events go
+ *              through the static slots of mac_callback.c instead of the heap,
+ *              so they have to be released with MACCB_Free().  This function may be
  *              executed from task or interrupt context and therefore must
  *              be reentrant.
  * @return      None.
  */
 void MAC_CbackEvent(macCbackEvent_t *pData)
 {
-  macCbackEvent_t *pMsg = NULL;
-
-  uint8 len = node_cbackSizeTable[pData->hdr.event];
-  switch (pData->hdr.event)
-  {
-    case MAC_MCPS_DATA_IND:
-      pMsg = pData;
-      break;
-    default:
-      if ((pMsg = (macCbackEvent_t *) osal_msg_allocate(len)) != NULL) {
-        osal_memcpy(pMsg, pData, len);
-      }
-      break;
-  }
-  if (pMsg != NULL) {
-    osal_msg_send(NODE_TaskId, (uint8 *) pMsg);
-  }
+  MACCB_Event(pData);
 }
 
 /**
@@ -17,25 +17,34 @@ extern "C"
 #ifdef __DEBUG
   #define NODE_DEFAULT_SCAN_TIME_OUT    3
   #define NODE_DEFAULT_RESCAN_WAIT_TIME 6000
-  #define NODE_DEFAULT_NUM_RESCAN_TRY   3
+  #define NODE_DEFAULT_RESCAN_WAIT_MAX  96000
   #define NODE_DEFAULT_STICK_DURATION   6000
   #define NODE_DEFAULT_PREPARING_DELTA  5
   #define NODE_DEFAULT_SENSING_TIME     10
-  #define NODE_DEFAULT_SEND_ALIVE_TIME  2 /* send alive time, must < sensing time */
+  #define NODE_DEFAULT_SEND_ALIVE_TIME  2
 #else
   #define NODE_DEFAULT_SCAN_TIME_OUT    4
-  #define NODE_DEFAULT_NUM_RESCAN_TRY   3
   #define NODE_DEFAULT_RESCAN_WAIT_TIME 60000
+  #define NODE_DEFAULT_RESCAN_WAIT_MAX  960000
   #define NODE_DEFAULT_STICK_DURATION   60000
   #define NODE_DEFAULT_PREPARING_DELTA  2
   #define NODE_DEFAULT_SENSING_TIME     30
-  #define NODE_DEFAULT_SEND_ALIVE_TIME  5 /* send alive time, must < sensing time */
+  #define NODE_DEFAULT_SEND_ALIVE_TIME  5
 #endif
+/* The SENSING_TIME, SEND_ALIVE_TIME and PREPARING_DELTA above, in sticks, are the periods until
+ * the FRAM or the gateway give others (sched.h).  A full scan that finds no gateway is tried
+ * again after RESCAN_WAIT_TIME ms, twice as long after each failure, up to RESCAN_WAIT_MAX */
+#define NODE_REPLAY_BURST               4 /* batches of stored results sent per stick when catching up */
+#define NODE_TX_BACKOFF_MAX             8 /* sticks a failed frame holds the next ones back, at most */
+#define NODE_DEFAULT_BATCH_PERIODS      1 /* stored results waited for before a batch is sent */
+#define NODE_DEFAULT_BATCH_FIELDS       (BATCH_DERIVED | BATCH_MEAN | BATCH_MINMAX)
+#define NODE_POLL_FAIL_MAX              5 /* polls and frames failed in a row before the node looks for the gateway */
 /**** Event IDs ****/
 #define NODE_STICK_TIMER_EVENT          0x0001
 #define NODE_SEND_EVENT                 0x0002
 #define NODE_RESCAN_EVENT               0x0004
 #define NODE_PREP_INIT_EVENT            0x0008
+#define NODE_SENSED_EVENT               0x0010
 
 /**** Application State ****/
 #define NODE_IDLE_STATE     0x00
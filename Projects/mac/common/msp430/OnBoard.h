@@ -106,6 +106,9 @@ extern void _itoa(uint16 num, uint8 *buf, uint8 radix);
 // Power conservation
 #define OSAL_SET_CPU_INTO_SLEEP(timeout) halSleep(timeout);  /* Called from OSAL_PwrMgr */
 
+// Clock of the OSAL task statistics: MAC backoffs, the unit of the MAC timing budget
+#define OSAL_TASK_STATS_CLOCK()  macMcuPrecisionCount()
+
 /* used by MT.c */
 uint8 OnBoard_SendKeys( uint8 keys, uint8 state );
 
@@ -124,6 +127,11 @@ extern void Onboard_soft_reset( void );
  */
 extern uint32 TimerElapsed( void );
 
+/*
+ * MAC backoffs since power-up
+ */
+extern uint32 macMcuPrecisionCount( void );
+
 /*********************************************************************
  */
 
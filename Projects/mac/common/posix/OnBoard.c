@@ -0,0 +1,104 @@
+/**************************************************************************************************
+  Filename:       OnBoard.c
+
+  Description:    This file contains the UI and control for the
+                  peripherals of a simulated board
+  Notes:          This file targets the POSIX host simulation
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "OnBoard.h"
+#include "mac_radio_defs.h"
+#include "ZComDef.h"
+#include "hal_sim.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn        Onboard_rand
+ *
+ * @brief    Random number generator
+ *
+ * @param   none
+ *
+ * @return  uint16 - new random number
+ *
+ *********************************************************************/
+uint16 Onboard_rand( void )
+{
+  return ( MAC_RADIO_RANDOM_WORD() );
+}
+
+/******************************************************************************
+ * @fn      Onboard_soft_reset
+ *
+ * @brief   Effect a soft reset.  The simulation restarts the image
+ *          from its power-on state, like a jump through the reset vector.
+ *
+ * @param   none
+ *
+ * @return  none
+ *
+ */
+void Onboard_soft_reset( void )
+{
+  HAL_DISABLE_INTERRUPTS();
+  halSimReset();
+}
+
+/******************************************************************************
+ * @fn      _itoa
+ *
+ * @brief   convert a 16bit number to ASCII
+ *
+ * @param   num -
+ *          buf -
+ *          radix -
+ *
+ * @return  void
+ *
+ **************************************************************************************************/
+void _itoa(uint16 num, byte *buf, byte radix)
+{
+  char c,i;
+  byte *p, rst[5];
+
+  p = rst;
+  for ( i=0; i<5; i++,p++ )
+  {
+    c = num % radix;  // Isolate a digit
+    *p = c + (( c < 10 ) ? '0' : '7');  // Convert to Ascii
+    num /= radix;
+    if ( !num )
+      break;
+  }
+
+  for ( c=0 ; c<=i; c++ )
+    *buf++ = *p--;  // Reverse character order
+
+  *buf = '\0';
+}
+
+/*********************************************************************
+*********************************************************************/